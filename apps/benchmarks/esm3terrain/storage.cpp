@@ -0,0 +1,114 @@
+#include <benchmark/benchmark.h>
+
+#include <components/esm3/loadland.hpp>
+#include <components/esm3terrain/storage.hpp>
+
+#include <osg/Array>
+
+#include <map>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    constexpr int cellsCount = 4;
+
+    class TestStorage final : public ESMTerrain::Storage
+    {
+    public:
+        template <typename Random>
+        explicit TestStorage(Random& random)
+            : ESMTerrain::Storage(nullptr)
+        {
+            std::uniform_real_distribution<float> heightDistribution(-1000.f, 1000.f);
+            std::uniform_int_distribution<int> normalXYDistribution(-64, 64);
+            std::uniform_int_distribution<int> normalZDistribution(32, 127);
+            std::uniform_int_distribution<int> colourDistribution(0, 255);
+
+            for (int cellX = 0; cellX < cellsCount; ++cellX)
+            {
+                for (int cellY = 0; cellY < cellsCount; ++cellY)
+                {
+                    auto land = std::make_unique<ESM::Land>();
+                    land->mX = cellX;
+                    land->mY = cellY;
+                    land->add(ESM::Land::DATA_VHGT | ESM::Land::DATA_VNML | ESM::Land::DATA_VCLR);
+                    ESM::Land::LandData& data = *land->getLandData();
+                    for (int i = 0; i < ESM::Land::LAND_NUM_VERTS; ++i)
+                    {
+                        data.mHeights[i] = heightDistribution(random);
+                        data.mNormals[i * 3] = static_cast<ESM::Land::VNML>(normalXYDistribution(random));
+                        data.mNormals[i * 3 + 1] = static_cast<ESM::Land::VNML>(normalXYDistribution(random));
+                        data.mNormals[i * 3 + 2] = static_cast<ESM::Land::VNML>(normalZDistribution(random));
+                        for (int j = 0; j < 3; ++j)
+                            data.mColours[i * 3 + j] = static_cast<unsigned char>(colourDistribution(random));
+                    }
+                    const int flags = ESM::Land::DATA_VHGT | ESM::Land::DATA_VNML | ESM::Land::DATA_VCLR;
+                    mLandObjects.emplace(std::make_pair(cellX, cellY), new ESMTerrain::LandObject(land.get(), flags));
+                    mLands.push_back(std::move(land));
+                }
+            }
+        }
+
+        osg::ref_ptr<const ESMTerrain::LandObject> getLand(int cellX, int cellY) override
+        {
+            const auto it = mLandObjects.find(std::make_pair(cellX, cellY));
+            if (it == mLandObjects.end())
+                return nullptr;
+            return it->second;
+        }
+
+        const ESM::LandTexture* getLandTexture(int /*index*/, short /*plugin*/) override
+        {
+            return nullptr;
+        }
+
+        void getBounds(float& minX, float& maxX, float& minY, float& maxY) override
+        {
+            minX = 0;
+            minY = 0;
+            maxX = cellsCount;
+            maxY = cellsCount;
+        }
+
+    private:
+        std::vector<std::unique_ptr<ESM::Land>> mLands;
+        std::map<std::pair<int, int>, osg::ref_ptr<const ESMTerrain::LandObject>> mLandObjects;
+    };
+
+    void fillVertexBuffers(benchmark::State& state)
+    {
+        const int lodLevel = static_cast<int>(state.range(0));
+        const float size = static_cast<float>(state.range(1));
+        const osg::Vec2f center(size / 2.f, size / 2.f);
+
+        std::minstd_rand random;
+        TestStorage storage(random);
+        osg::ref_ptr<osg::Vec3Array> positions = new osg::Vec3Array;
+        osg::ref_ptr<osg::Vec3Array> normals = new osg::Vec3Array;
+        osg::ref_ptr<osg::Vec4ubArray> colours = new osg::Vec4ubArray;
+
+        for (auto _ : state)
+        {
+            storage.fillVertexBuffers(lodLevel, size, center, positions, normals, colours);
+            benchmark::DoNotOptimize(positions->getDataPointer());
+            benchmark::DoNotOptimize(normals->getDataPointer());
+            benchmark::DoNotOptimize(colours->getDataPointer());
+        }
+        state.SetItemsProcessed(state.iterations() * positions->size());
+    }
+
+    void lodLevelsAndChunkSizes(benchmark::internal::Benchmark* benchmark)
+    {
+        // Every LOD level the terrain uses, from full detail to a single quad per cell, for chunks of 1 to 4 cells
+        for (int lodLevel = 0; lodLevel <= 6; ++lodLevel)
+            for (int size = 1; size <= cellsCount; size *= 2)
+                benchmark->Args({lodLevel, size});
+    }
+} // namespace
+
+BENCHMARK(fillVertexBuffers)->Apply(lodLevelsAndChunkSizes);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,117 @@
+#include <benchmark/benchmark.h>
+
+#include "../../openmw_test_suite/mwscript/test_utils.hpp"
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // Mimics a heavy global script: a long body of branches and arithmetic run every frame,
+    // with a loop adding more work per run.
+    std::string makeScript(int blocks)
+    {
+        std::ostringstream script;
+        script << "Begin heavy_global\n"
+               << "short state\n"
+               << "short i\n"
+               << "long sum\n"
+               << "float timer\n"
+               << "set timer to ( timer + 0.016 )\n"
+               << "set i to 0\n"
+               << "while ( i < 32 )\n"
+               << "    set sum to ( sum + i * 3 )\n"
+               << "    set i to ( i + 1 )\n"
+               << "endwhile\n";
+        for (int i = 0; i < blocks; ++i)
+            script << "if ( state == " << i << " )\n"
+                   << "    set sum to ( sum - " << i << " )\n"
+                   << "elseif ( timer > " << i << " )\n"
+                   << "    set state to ( state + 1 )\n"
+                   << "else\n"
+                   << "    set sum to ( sum + state * " << i << " )\n"
+                   << "endif\n";
+        script << "if ( state > " << blocks << " )\n"
+               << "    set state to 0\n"
+               << "    set timer to 0\n"
+               << "endif\n"
+               << "End\n";
+        return script.str();
+    }
+
+    std::vector<Interpreter::Type_Code> compile(const std::string& text)
+    {
+        TestErrorHandler errorHandler;
+        TestCompilerContext compilerContext;
+        Compiler::Extensions extensions;
+        Compiler::registerExtensions(extensions);
+        compilerContext.setExtensions(&extensions);
+        Compiler::FileParser parser(errorHandler, compilerContext);
+        std::istringstream input(text);
+        Compiler::Scanner scanner(errorHandler, input, compilerContext.getExtensions());
+        scanner.scan(parser);
+        if (!errorHandler.isGood())
+            throw std::runtime_error("Failed to compile benchmark script");
+        std::vector<Interpreter::Type_Code> code;
+        parser.getCode(code);
+        return code;
+    }
+
+    void runByteCode(benchmark::State& state)
+    {
+        const std::vector<Interpreter::Type_Code> code = compile(makeScript(static_cast<int>(state.range(0))));
+        Interpreter::Interpreter interpreter;
+        Interpreter::installOpcodes(interpreter);
+        TestInterpreterContext context;
+        for (auto _ : state)
+            interpreter.run(code.data(), static_cast<int>(code.size()), context);
+    }
+
+    void runProgram(benchmark::State& state)
+    {
+        Interpreter::Program program;
+        program.mCode = compile(makeScript(static_cast<int>(state.range(0))));
+        Interpreter::Interpreter interpreter;
+        Interpreter::installOpcodes(interpreter);
+        interpreter.decode(program);
+        TestInterpreterContext context;
+        for (auto _ : state)
+            interpreter.run(program, context);
+    }
+
+    void runProfiledProgram(benchmark::State& state)
+    {
+        Interpreter::Program program;
+        program.mCode = compile(makeScript(static_cast<int>(state.range(0))));
+        Interpreter::Interpreter interpreter;
+        Interpreter::installOpcodes(interpreter);
+        interpreter.decode(program);
+        Interpreter::Profile profile;
+        interpreter.setProfile(&profile);
+        TestInterpreterContext context;
+        for (auto _ : state)
+            interpreter.run(program, context);
+    }
+
+    void decodeProgram(benchmark::State& state)
+    {
+        Interpreter::Program program;
+        program.mCode = compile(makeScript(static_cast<int>(state.range(0))));
+        Interpreter::Interpreter interpreter;
+        Interpreter::installOpcodes(interpreter);
+        for (auto _ : state)
+        {
+            interpreter.decode(program);
+            benchmark::DoNotOptimize(program.mInstructions.data());
+        }
+    }
+}
+
+BENCHMARK(runByteCode)->Arg(10)->Arg(100)->Arg(1000);
+BENCHMARK(runProgram)->Arg(10)->Arg(100)->Arg(1000);
+BENCHMARK(runProfiledProgram)->Arg(10)->Arg(100)->Arg(1000);
+BENCHMARK(decodeProgram)->Arg(10)->Arg(100)->Arg(1000);
+
+BENCHMARK_MAIN();
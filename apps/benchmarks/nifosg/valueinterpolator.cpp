@@ -0,0 +1,145 @@
+#include <benchmark/benchmark.h>
+
+#include <components/nifosg/controller.hpp>
+
+#include <osg/Math>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+    using namespace NifOsg;
+
+    constexpr std::size_t tracksCount = 10000;
+    constexpr std::size_t keysPerTrack = 60;
+    constexpr float frameTime = 1.f / 60.f;
+
+    template <typename Random>
+    std::vector<float> generateTimes(Random& random)
+    {
+        std::uniform_real_distribution<float> distribution(0.01f, 0.1f);
+        std::vector<float> result;
+        result.reserve(keysPerTrack);
+        float time = 0;
+        for (std::size_t i = 0; i < keysPerTrack; ++i)
+        {
+            result.push_back(time);
+            time += distribution(random);
+        }
+        return result;
+    }
+
+    template <typename Random>
+    osg::Vec3f generateVec3f(Random& random)
+    {
+        std::uniform_real_distribution<float> distribution(-100.f, 100.f);
+        return osg::Vec3f(distribution(random), distribution(random), distribution(random));
+    }
+
+    template <typename Random>
+    osg::Quat generateQuat(Random& random)
+    {
+        std::uniform_real_distribution<float> distribution(-osg::PI, osg::PI);
+        return osg::Quat(distribution(random), osg::Vec3f(0, 0, 1));
+    }
+
+    template <typename Random>
+    std::vector<Vec3Interpolator> generateVec3Tracks(unsigned int type, Random& random)
+    {
+        std::vector<Vec3Interpolator> result;
+        result.reserve(tracksCount);
+        for (std::size_t i = 0; i < tracksCount; ++i)
+        {
+            auto keys = std::make_shared<Nif::Vector3KeyMap>();
+            keys->mInterpolationType = type;
+            keys->mTimes = generateTimes(random);
+            for (std::size_t j = 0; j < keysPerTrack; ++j)
+                keys->mValues.push_back(generateVec3f(random));
+            if (type == Nif::InterpolationType_Quadratic || type == Nif::InterpolationType_TBC)
+            {
+                for (std::size_t j = 0; j < keysPerTrack; ++j)
+                {
+                    keys->mInTans.push_back(generateVec3f(random));
+                    keys->mOutTans.push_back(generateVec3f(random));
+                }
+            }
+            result.emplace_back(std::move(keys));
+        }
+        return result;
+    }
+
+    template <typename Random>
+    std::vector<QuaternionInterpolator> generateQuatTracks(Random& random)
+    {
+        std::vector<QuaternionInterpolator> result;
+        result.reserve(tracksCount);
+        for (std::size_t i = 0; i < tracksCount; ++i)
+        {
+            auto keys = std::make_shared<Nif::QuaternionKeyMap>();
+            keys->mInterpolationType = Nif::InterpolationType_Linear;
+            keys->mTimes = generateTimes(random);
+            for (std::size_t j = 0; j < keysPerTrack; ++j)
+                keys->mValues.push_back(generateQuat(random));
+            result.emplace_back(std::move(keys));
+        }
+        return result;
+    }
+
+    template <class Interpolator>
+    void evaluateTracks(benchmark::State& state, const std::vector<Interpolator>& tracks)
+    {
+        float time = 0;
+        for (auto _ : state)
+        {
+            for (const Interpolator& track : tracks)
+                benchmark::DoNotOptimize(track.interpKey(time));
+            time += frameTime;
+            if (time > keysPerTrack * 0.05f)
+                time = 0;
+        }
+        state.SetItemsProcessed(state.iterations() * tracks.size());
+    }
+
+    template <unsigned int type>
+    void interpolateVec3Tracks(benchmark::State& state)
+    {
+        std::minstd_rand random;
+        evaluateTracks(state, generateVec3Tracks(type, random));
+    }
+
+    void interpolateQuatTracks(benchmark::State& state)
+    {
+        std::minstd_rand random;
+        evaluateTracks(state, generateQuatTracks(random));
+    }
+
+    void interpolateVec3TracksRandomTime(benchmark::State& state)
+    {
+        std::minstd_rand random;
+        const std::vector<Vec3Interpolator> tracks = generateVec3Tracks(Nif::InterpolationType_Linear, random);
+        std::uniform_real_distribution<float> distribution(0.f, keysPerTrack * 0.05f);
+        for (auto _ : state)
+        {
+            const float time = distribution(random);
+            for (const Vec3Interpolator& track : tracks)
+                benchmark::DoNotOptimize(track.interpKey(time));
+        }
+        state.SetItemsProcessed(state.iterations() * tracks.size());
+    }
+
+    constexpr auto interpolateVec3Tracks_constant = interpolateVec3Tracks<Nif::InterpolationType_Constant>;
+    constexpr auto interpolateVec3Tracks_linear = interpolateVec3Tracks<Nif::InterpolationType_Linear>;
+    constexpr auto interpolateVec3Tracks_quadratic = interpolateVec3Tracks<Nif::InterpolationType_Quadratic>;
+    constexpr auto interpolateVec3Tracks_tbc = interpolateVec3Tracks<Nif::InterpolationType_TBC>;
+} // namespace
+
+BENCHMARK(interpolateVec3Tracks_constant);
+BENCHMARK(interpolateVec3Tracks_linear);
+BENCHMARK(interpolateVec3Tracks_quadratic);
+BENCHMARK(interpolateVec3Tracks_tbc);
+BENCHMARK(interpolateQuatTracks);
+BENCHMARK(interpolateVec3TracksRandomTime);
+
+BENCHMARK_MAIN();
@@ -1,5 +1,8 @@
 ///Program to test .nif files both on the FileSystem and in BSA archives.
 
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
 #include <iostream>
 #include <filesystem>
 
@@ -15,6 +18,41 @@
 // Create local aliases for brevity
 namespace bpo = boost::program_options;
 
+/// Accumulated parsing statistics, reported with --benchmark
+struct ParseStats
+{
+    std::size_t mFiles = 0;
+    std::size_t mBytes = 0;
+    std::chrono::steady_clock::duration mTime {};
+};
+
+static ParseStats sParseStats;
+
+///Parse a single nif file and account for it in the statistics
+void readNIF(Files::IStreamPtr&& stream, const std::string& name)
+{
+    stream->seekg(0, std::ios_base::end);
+    const std::streamoff size = stream->tellg();
+    stream->seekg(0, std::ios_base::beg);
+
+    const auto start = std::chrono::steady_clock::now();
+    Nif::NIFFile temp_nif(std::move(stream), name);
+    sParseStats.mTime += std::chrono::steady_clock::now() - start;
+    sParseStats.mBytes += static_cast<std::size_t>(std::max<std::streamoff>(size, 0));
+    ++sParseStats.mFiles;
+}
+
+void printParseStats()
+{
+    const double seconds = std::chrono::duration<double>(sParseStats.mTime).count();
+    const double megabytes = sParseStats.mBytes / (1024.0 * 1024.0);
+    std::cout << "Parsed " << sParseStats.mFiles << " nif files, " << std::fixed << std::setprecision(2)
+              << megabytes << " MiB in " << std::setprecision(3) << seconds << " s";
+    if (seconds > 0)
+        std::cout << ", " << std::setprecision(2) << megabytes / seconds << " MiB/s";
+    std::cout << std::endl;
+}
+
 ///See if the file has the named extension
 bool hasExtension(std::string filename, std::string extensionToFind)
 {
@@ -48,7 +86,7 @@ void readVFS(VFS::Archive* anArchive,std::string archivePath = "")
             if(isNIF(name))
             {
             //           std::cout << "Decoding: " << name << std::endl;
-                Nif::NIFFile temp_nif(myManager.get(name),archivePath+name);
+                readNIF(myManager.get(name), archivePath+name);
             }
             else if(isBSA(name))
             {
@@ -67,15 +105,18 @@ void readVFS(VFS::Archive* anArchive,std::string archivePath = "")
     }
 }
 
-bool parseOptions (int argc, char** argv, std::vector<std::string>& files)
+bool parseOptions (int argc, char** argv, std::vector<std::string>& files, bool& benchmark)
 {
     bpo::options_description desc("Ensure that OpenMW can use the provided NIF and BSA files\n\n"
         "Usages:\n"
         "  niftool <nif files, BSA files, or directories>\n"
-        "      Scan the file or directories for nif errors.\n\n"
+        "      Scan the file or directories for nif errors.\n"
+        "  niftool --benchmark <nif files, BSA files, or directories>\n"
+        "      Also report the time spent parsing and the parsing throughput.\n\n"
         "Allowed options");
     desc.add_options()
         ("help,h", "print help message.")
+        ("benchmark,b", "report parsing time and throughput.")
         ("input-file", bpo::value< std::vector<std::string> >(), "input file")
         ;
 
@@ -95,6 +136,7 @@ bool parseOptions (int argc, char** argv, std::vector<std::string>& files)
             std::cout << desc << std::endl;
             return false;
         }
+        benchmark = variables.count("benchmark") > 0;
         if (variables.count("input-file"))
         {
             files = variables["input-file"].as< std::vector<std::string> >();
@@ -116,7 +158,8 @@ bool parseOptions (int argc, char** argv, std::vector<std::string>& files)
 int main(int argc, char **argv)
 {
     std::vector<std::string> files;
-    if(!parseOptions (argc, argv, files))
+    bool benchmark = false;
+    if(!parseOptions (argc, argv, files, benchmark))
         return 1;
 
     Nif::NIFFile::setLoadUnsupportedFiles(true);
@@ -130,7 +173,7 @@ int main(int argc, char **argv)
             if(isNIF(name))
             {
                 //std::cout << "Decoding: " << name << std::endl;
-                Nif::NIFFile temp_nif(Files::openConstrainedFileStream(name), name);
+                readNIF(Files::openConstrainedFileStream(name), name);
              }
              else if(isBSA(name))
              {
@@ -152,5 +195,8 @@ int main(int argc, char **argv)
             std::cerr << "ERROR, an exception has occurred:  " << e.what() << std::endl;
         }
      }
+
+     if (benchmark)
+         printParseStats();
      return 0;
 }
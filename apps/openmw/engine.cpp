@@ -25,9 +25,16 @@
 #include <components/sdlutil/sdlgraphicswindow.hpp>
 #include <components/sdlutil/imagetosurface.hpp>
 
+#include <components/resource/imagemanager.hpp>
 #include <components/resource/resourcesystem.hpp>
 #include <components/resource/scenemanager.hpp>
 #include <components/resource/stats.hpp>
+#include <components/resource/texturebudget.hpp>
+
+#include <components/shader/compileprograms.hpp>
+#include <components/shader/shadermanager.hpp>
+
+#include <components/loadinglistener/loadinglistener.hpp>
 
 #include <components/compiler/extensions0.hpp>
 
@@ -492,6 +499,12 @@ OMW::Engine::~Engine()
 
     mScriptContext = nullptr;
 
+    if (mResourceSystem)
+    {
+        mResourceSystem->getImageManager()->setWorkQueue(nullptr);
+        mResourceSystem->getSceneManager()->getTextureBudget().setWorkQueue(nullptr);
+        mResourceSystem->getSceneManager()->setDeformationWorkQueue(nullptr);
+    }
     mWorkQueue = nullptr;
 
     mViewer = nullptr;
@@ -745,12 +758,24 @@ void OMW::Engine::prepareEngine()
         Settings::Manager::getString("texture mipmap", "General"),
         Settings::Manager::getInt("anisotropy", "General")
     );
+    if (Settings::Manager::getBool("scene cache", "Models"))
+        mResourceSystem->getSceneManager()->setSceneCachePath((mCfgMgr.getCachePath() / "scenes").string());
     mEnvironment.setResourceSystem(*mResourceSystem);
 
     int numThreads = Settings::Manager::getInt("preload num threads", "Cells");
     if (numThreads <= 0)
         throw std::runtime_error("Invalid setting: 'preload num threads' must be >0");
     mWorkQueue = new SceneUtil::WorkQueue(numThreads);
+    mResourceSystem->getImageManager()->setWorkQueue(mWorkQueue);
+    mResourceSystem->getSceneManager()->getTextureBudget().setWorkQueue(mWorkQueue);
+    const int textureMemoryBudget = Settings::Manager::getInt("texture memory budget", "General");
+    if (textureMemoryBudget > 0)
+        mResourceSystem->getSceneManager()->getTextureBudget().setBudget(static_cast<std::size_t>(textureMemoryBudget) * 1024 * 1024);
+    mResourceSystem->getImageManager()->setSkipMipmapLevels(Settings::Manager::getInt("texture mipmap skip", "General"));
+
+    const int skinningThreads = Settings::Manager::getInt("skinning num threads", "General");
+    if (skinningThreads > 0)
+        mResourceSystem->getSceneManager()->setDeformationWorkQueue(new SceneUtil::WorkQueue(skinningThreads));
 
     mScreenCaptureOperation = new SceneUtil::AsyncScreenCaptureOperation(
         mWorkQueue,
@@ -804,6 +829,8 @@ void OMW::Engine::prepareEngine()
 
     // gui needs our shaders path before everything else
     mResourceSystem->getSceneManager()->setShaderPath((mResDir / "shaders").string());
+    if (Settings::Manager::getBool("shader cache", "Shaders"))
+        mResourceSystem->getSceneManager()->getShaderManager().setCachePath((mCfgMgr.getCachePath() / "shaders").string());
 
     osg::ref_ptr<osg::GLExtensions> exts = osg::GLExtensions::Get(0, false);
     bool shadersSupported = exts && (exts->glslLanguageVersion >= 1.2f);
@@ -844,15 +871,20 @@ void OMW::Engine::prepareEngine()
 
     // Create the world
     mWorld = std::make_unique<MWWorld::World>(mViewer, rootNode, mResourceSystem.get(), mWorkQueue.get(),
-        mFileCollections, mContentFiles, mGroundcoverFiles, mEncoder.get(), mActivationDistanceOverride, mCellName,
-        mStartupScript, mResDir.string(), mCfgMgr.getUserDataPath().string());
+        mFileCollections, mArchives, mContentFiles, mGroundcoverFiles, mEncoder.get(), mActivationDistanceOverride, mCellName,
+        mStartupScript, mResDir.string(), mCfgMgr.getUserDataPath().string(), mCfgMgr.getCachePath().string());
     mWorld->setupPlayer();
     mWorld->setRandomSeed(mRandomSeed);
+    if (Settings::Manager::getBool("local script scheduling", "Game"))
+        mWorld->getLocalScripts().setScheduling(
+            std::max(Settings::Manager::getInt("local script max interval", "Game"), 1), mScriptsEveryFrame);
     mEnvironment.setWorld(*mWorld);
 
     mWindowManager->setStore(mWorld->getStore());
     mWindowManager->initUI();
 
+    precompileShaders();
+
     //Load translation data
     mTranslationDataStorage.setEncoder(mEncoder.get());
     for (size_t i = 0; i < mContentFiles.size(); i++)
@@ -866,6 +898,7 @@ void OMW::Engine::prepareEngine()
 
     mScriptManager = std::make_unique<MWScript::ScriptManager>(mWorld->getStore(), *mScriptContext, mWarningsMode,
         mScriptBlacklistUse ? mScriptBlacklist : std::vector<std::string>());
+    mScriptManager->setProfilerEnabled(Settings::Manager::getBool("script profiler", "Game"));
     mEnvironment.setScriptManager(*mScriptManager);
 
     // Create game mechanics system
@@ -903,6 +936,29 @@ void OMW::Engine::prepareEngine()
     mLuaManager->loadPermanentStorage(mCfgMgr.getUserConfigPath().string());
 }
 
+void OMW::Engine::precompileShaders()
+{
+    osg::ref_ptr<Shader::CompileProgramsOperation> operation
+        = mResourceSystem->getSceneManager()->getShaderManager().createRecordedPrograms();
+    if (operation == nullptr)
+        return;
+
+    // The operation runs on the graphics context while the loading screen is drawn
+    Loading::Listener* listener = mWindowManager->getLoadingScreen();
+    Loading::ScopedLoad load(listener);
+    listener->setProgressRange(operation->getNumPrograms());
+    mViewer->getCamera()->getGraphicsContext()->add(operation);
+
+    std::size_t progress = 0;
+    while (!operation->isDone())
+    {
+        const std::size_t numCompiled = operation->getNumCompiled();
+        listener->increaseProgress(numCompiled - progress);
+        progress = numCompiled;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
 class OMW::Engine::LuaWorker
 {
 public:
@@ -1127,6 +1183,9 @@ void OMW::Engine::go()
 
     luaWorker.join();
 
+    mScriptManager->writeProfile((mCfgMgr.getUserDataPath() / "scriptprofile.csv").string());
+    mLuaManager->writeProfile((mCfgMgr.getUserDataPath() / "luaprofile.csv").string());
+
     // Save user settings
     Settings::Manager::saveUser((mCfgMgr.getUserConfigPath() / "settings.cfg").string());
     Settings::ShaderManager::get().save();
@@ -1185,6 +1244,11 @@ void OMW::Engine::setScriptBlacklistUse (bool use)
     mScriptBlacklistUse = use;
 }
 
+void OMW::Engine::setScriptsEveryFrame (const std::vector<std::string>& list)
+{
+    mScriptsEveryFrame = list;
+}
+
 void OMW::Engine::enableFontExport(bool exportFonts)
 {
     mExportFonts = exportFonts;
@@ -171,6 +171,7 @@ namespace OMW
             Translation::Storage mTranslationDataStorage;
             std::vector<std::string> mScriptBlacklist;
             bool mScriptBlacklistUse;
+            std::vector<std::string> mScriptsEveryFrame;
             bool mNewGame;
 
             // not implemented
@@ -187,6 +188,9 @@ namespace OMW
             void createWindow();
             void setWindowIcon();
 
+            /// Compile the shader programs recorded in previous sessions behind the loading screen
+            void precompileShaders();
+
         public:
             Engine(Files::ConfigurationManager& configurationManager);
             virtual ~Engine();
@@ -254,6 +258,9 @@ namespace OMW
 
             void setScriptBlacklistUse (bool use);
 
+            /// Local scripts which always run every frame, even if local script scheduling is enabled.
+            void setScriptsEveryFrame (const std::vector<std::string>& list);
+
             void enableFontExport(bool exportFonts);
 
             /// Set the save game file to load after initialising the engine.
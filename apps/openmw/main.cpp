@@ -148,6 +148,7 @@ bool parseOptions (int argc, char** argv, OMW::Engine& engine, Files::Configurat
     engine.setWarningsMode (variables["script-warn"].as<int>());
     engine.setScriptBlacklist (variables["script-blacklist"].as<StringsVector>());
     engine.setScriptBlacklistUse (variables["script-blacklist-use"].as<bool>());
+    engine.setScriptsEveryFrame (variables["script-every-frame"].as<StringsVector>());
     engine.setSaveGameFile (variables["load-savegame"].as<Files::MaybeQuotedPath>().string());
 
     // other settings
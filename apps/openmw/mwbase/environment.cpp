@@ -32,4 +32,5 @@ void MWBase::Environment::reportStats(unsigned int frameNumber, osg::Stats& stat
 {
     mMechanicsManager->reportStats(frameNumber, stats);
     mWorld->reportStats(frameNumber, stats);
+    mLuaManager->reportStats(frameNumber, stats);
 }
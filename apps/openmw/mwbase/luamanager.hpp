@@ -1,11 +1,17 @@
 #ifndef GAME_MWBASE_LUAMANAGER_H
 #define GAME_MWBASE_LUAMANAGER_H
 
+#include <string>
 #include <variant>
 #include <SDL_events.h>
 
 #include <components/sdlutil/events.hpp>
 
+namespace osg
+{
+    class Stats;
+}
+
 namespace MWWorld
 {
     class Ptr;
@@ -94,6 +100,11 @@ namespace MWBase
         virtual void reloadAllScripts() = 0;
 
         virtual void handleConsoleCommand(const std::string& consoleMode, const std::string& command, const MWWorld::Ptr& selectedPtr) = 0;
+
+        virtual void reportStats(unsigned int frameNumber, osg::Stats& stats) const = 0;
+
+        // Memory usage of Lua scripts, shown in the debug window.
+        virtual std::string formatResourceUsageStats() const = 0;
     };
 
 }
@@ -55,6 +55,12 @@ namespace MWBase
             virtual MWScript::GlobalScripts& getGlobalScripts() = 0;
 
             virtual const Compiler::Extensions& getExtensions() const = 0;
+
+            virtual bool toggleProfiler() = 0;
+            ///< \return Is the profiler enabled now?
+
+            virtual std::string getProfileReport (std::size_t count) const = 0;
+            ///< Return the \a count most expensive scripts and opcodes profiled so far.
    };
 }
 
@@ -8,6 +8,9 @@
 #include <components/debug/debugging.hpp>
 #include <components/settings/settings.hpp>
 
+#include "../mwbase/environment.hpp"
+#include "../mwbase/luamanager.hpp"
+
 #include <mutex>
 
 #ifndef BT_NO_PROFILE
@@ -96,6 +99,11 @@ namespace MWGui
                 ("LogEdit", MyGUI::FloatCoord(0,0,1,1), MyGUI::Align::Stretch);
         mLogView->setEditReadOnly(true);
 
+        MyGUI::TabItem* itemLuaProfiler = mTabControl->addItem("Lua Profiler");
+        mLuaProfiler = itemLuaProfiler->createWidgetReal<MyGUI::EditBox>
+                ("LogEdit", MyGUI::FloatCoord(0,0,1,1), MyGUI::Align::Stretch);
+        mLuaProfiler->setEditReadOnly(true);
+
 #ifndef BT_NO_PROFILE
         MyGUI::TabItem* item = mTabControl->addItem("Physics Profiler");
         mBulletProfilerEdit = item->createWidgetReal<MyGUI::EditBox>
@@ -189,6 +197,16 @@ namespace MWGui
             mLogView->setVScrollPosition(scrollPos);
     }
 
+    void DebugWindow::updateLuaProfile()
+    {
+        if (mLuaProfiler->isTextSelection()) // pause updating while user is trying to copy text
+            return;
+
+        size_t previousPos = mLuaProfiler->getVScrollPosition();
+        mLuaProfiler->setCaption(MWBase::Environment::get().getLuaManager()->formatResourceUsageStats());
+        mLuaProfiler->setVScrollPosition(std::min(previousPos, mLuaProfiler->getVScrollRange()-1));
+    }
+
     void DebugWindow::updateBulletProfile()
     {
 #ifndef BT_NO_PROFILE
@@ -212,9 +230,11 @@ namespace MWGui
             return;
         timer = 0.25;
 
-        if (mTabControl->getIndexSelected() == 0)
-            updateLogView();
-        else
-            updateBulletProfile();
+        switch (mTabControl->getIndexSelected())
+        {
+            case 0: updateLogView(); break;
+            case 1: updateLuaProfile(); break;
+            default: updateBulletProfile();
+        }
     }
 }
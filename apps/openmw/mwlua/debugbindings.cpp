@@ -46,6 +46,41 @@ namespace MWLua
             });
         };
 
+        sol::table profiler = context.mLua->newTable();
+        profiler["isEnabled"] = [manager = context.mLuaManager] { return manager->isProfilerEnabled(); };
+        profiler["setEnabled"] = [manager = context.mLuaManager] (bool enabled)
+        {
+            manager->addAction([manager, enabled] { manager->setProfilerEnabled(enabled); });
+        };
+        profiler["reset"] = [manager = context.mLuaManager] { manager->clearProfile(); };
+        profiler["getStats"] = [context] ()
+        {
+            const LuaManager* manager = context.mLuaManager;
+            sol::table res = context.mLua->newTable();
+            int count = 0;
+            auto addHandlers = [&](int scriptId, std::string_view type, const LuaUtil::ScriptsContainer::HandlerStatsMap& handlers)
+            {
+                for (const auto& [name, stats] : handlers)
+                {
+                    sol::table entry = context.mLua->newTable();
+                    entry["script"] = manager->getScriptPath(scriptId);
+                    entry["type"] = type;
+                    entry["handler"] = name;
+                    entry["calls"] = stats.mCalls;
+                    entry["time"] = std::chrono::duration<double>(stats.mTime).count();
+                    res[++count] = entry;
+                }
+            };
+            for (const auto& [scriptId, profile] : manager->getProfile())
+            {
+                addHandlers(scriptId, "engine", profile.mEngineHandlers);
+                addHandlers(scriptId, "event", profile.mEvents);
+                addHandlers(scriptId, "timer", profile.mTimers);
+            }
+            return res;
+        };
+        api["profiler"] = LuaUtil::makeReadOnly(profiler);
+
         return LuaUtil::makeReadOnly(api);
     }
 }
@@ -16,8 +16,9 @@ namespace MWLua
     {
         esm.writeHNString("LUAE", event.mEventName);
         dest.save(esm, true);
-        if (!event.mEventData.empty())
-            saveLuaBinaryData(esm, event.mEventData);
+        const LuaUtil::BinaryData data = event.mEventData.getBinaryData();
+        if (!data.empty())
+            saveLuaBinaryData(esm, data);
     }
 
     void loadEvents(sol::state& lua, ESM::ESMReader& esm, GlobalEventQueue& globalEvents, LocalEventQueue& localEvents,
@@ -42,10 +43,10 @@ namespace MWLua
                 auto it = contentFileMapping.find(dest.mContentFile);
                 if (it != contentFileMapping.end())
                     dest.mContentFile = it->second;
-                localEvents.push_back({dest, std::move(name), std::move(data)});
+                localEvents.push_back({dest, std::move(name), LuaUtil::EventData(std::move(data))});
             }
             else
-                globalEvents.push_back({std::move(name), std::move(data)});
+                globalEvents.push_back({std::move(name), LuaUtil::EventData(std::move(data))});
         }
     }
 
@@ -1,6 +1,8 @@
 #ifndef MWLUA_EVENTQUEUE_H
 #define MWLUA_EVENTQUEUE_H
 
+#include <components/lua/serialization.hpp>
+
 #include "object.hpp"
 
 namespace ESM
@@ -9,11 +11,6 @@ namespace ESM
     class ESMWriter;
 }
 
-namespace LuaUtil
-{
-    class UserdataSerializer;
-}
-
 namespace sol
 {
     class state;
@@ -24,13 +21,13 @@ namespace MWLua
     struct GlobalEvent
     {
         std::string mEventName;
-        std::string mEventData;
+        LuaUtil::EventData mEventData;
     };
     struct LocalEvent
     {
         ObjectId mDest;
         std::string mEventName;
-        std::string mEventData;
+        LuaUtil::EventData mEventData;
     };
     using GlobalEventQueue = std::vector<GlobalEvent>;
     using LocalEventQueue = std::vector<LocalEvent>;
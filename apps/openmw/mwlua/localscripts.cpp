@@ -83,6 +83,7 @@ namespace MWLua
 
         selfAPI["_getActiveAiPackage"] = [](SelfObject& self) -> sol::optional<std::shared_ptr<AiPackage>>
         {
+            const auto lock = self.lockWorld();
             const MWWorld::Ptr& ptr = self.ptr();
             MWMechanics::AiSequence& ai = ptr.getClass().getCreatureStats(ptr).getAiSequence();
             if (ai.isEmpty())
@@ -92,6 +93,7 @@ namespace MWLua
         };
         selfAPI["_iterateAndFilterAiSequence"] = [](SelfObject& self, sol::function callback)
         {
+            const auto lock = self.lockWorld();
             const MWWorld::Ptr& ptr = self.ptr();
             MWMechanics::AiSequence& ai = ptr.getClass().getCreatureStats(ptr).getAiSequence();
 
@@ -103,18 +105,21 @@ namespace MWLua
         };
         selfAPI["_startAiCombat"] = [](SelfObject& self, const LObject& target)
         {
+            const auto lock = self.lockWorld();
             const MWWorld::Ptr& ptr = self.ptr();
             MWMechanics::AiSequence& ai = ptr.getClass().getCreatureStats(ptr).getAiSequence();
             ai.stack(MWMechanics::AiCombat(target.ptr()), ptr);
         };
         selfAPI["_startAiPursue"] = [](SelfObject& self, const LObject& target)
         {
+            const auto lock = self.lockWorld();
             const MWWorld::Ptr& ptr = self.ptr();
             MWMechanics::AiSequence& ai = ptr.getClass().getCreatureStats(ptr).getAiSequence();
             ai.stack(MWMechanics::AiPursue(target.ptr()), ptr);
         };
         selfAPI["_startAiFollow"] = [](SelfObject& self, const LObject& target)
         {
+            const auto lock = self.lockWorld();
             const MWWorld::Ptr& ptr = self.ptr();
             MWMechanics::AiSequence& ai = ptr.getClass().getCreatureStats(ptr).getAiSequence();
             ai.stack(MWMechanics::AiFollow(target.ptr()), ptr);
@@ -122,6 +127,7 @@ namespace MWLua
         selfAPI["_startAiEscort"] = [](SelfObject& self, const LObject& target, LCell cell,
                                        float duration, const osg::Vec3f& dest)
         {
+            const auto lock = self.lockWorld();
             const MWWorld::Ptr& ptr = self.ptr();
             MWMechanics::AiSequence& ai = ptr.getClass().getCreatureStats(ptr).getAiSequence();
             // TODO: change AiEscort implementation to accept ptr instead of a non-unique refId.
@@ -135,6 +141,7 @@ namespace MWLua
         };
         selfAPI["_startAiWander"] = [](SelfObject& self, int distance, float duration)
         {
+            const auto lock = self.lockWorld();
             const MWWorld::Ptr& ptr = self.ptr();
             MWMechanics::AiSequence& ai = ptr.getClass().getCreatureStats(ptr).getAiSequence();
             int gameHoursDuration = static_cast<int>(std::ceil(duration / 3600.0));
@@ -142,6 +149,7 @@ namespace MWLua
         };
         selfAPI["_startAiTravel"] = [](SelfObject& self, const osg::Vec3f& target)
         {
+            const auto lock = self.lockWorld();
             const MWWorld::Ptr& ptr = self.ptr();
             MWMechanics::AiSequence& ai = ptr.getClass().getCreatureStats(ptr).getAiSequence();
             ai.stack(MWMechanics::AiTravel(target.x(), target.y(), target.z(), false), ptr);
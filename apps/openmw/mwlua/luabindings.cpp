@@ -55,7 +55,8 @@ namespace MWLua
         };
         api["sendGlobalEvent"] = [context](std::string eventName, const sol::object& eventData)
         {
-            context.mGlobalEventQueue->push_back({std::move(eventName), LuaUtil::serialize(eventData, context.mSerializer)});
+            context.mGlobalEventQueue->push_back(
+                {std::move(eventName), LuaUtil::EventData(context.mLua->sol(), eventData, context.mSerializer)});
         };
         addTimeBindings(api, context, false);
         api["l10n"] = [l10n=context.mL10n](const std::string& context, const sol::object &fallbackLocale) {
@@ -115,7 +116,10 @@ namespace MWLua
     sol::table initLocalStoragePackage(const Context& context, LuaUtil::LuaStorage* globalStorage)
     {
         sol::table res(context.mLua->sol(), sol::create);
-        res["globalSection"] = [globalStorage](std::string_view section) { return globalStorage->getReadOnlySection(section); };
+        res["globalSection"] = [globalStorage, lua=context.mLua](std::string_view section)
+        {
+            return globalStorage->getReadOnlySection(section, lua->sol());
+        };
         return LuaUtil::makeReadOnly(res);
     }
 
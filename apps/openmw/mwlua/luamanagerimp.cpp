@@ -1,6 +1,12 @@
 #include "luamanagerimp.hpp"
 
+#include <algorithm>
 #include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include <osg/Stats>
 
 #include <components/debug/debuglog.hpp>
 
@@ -30,6 +36,46 @@
 namespace MWLua
 {
 
+    namespace
+    {
+        double toMilliseconds(std::chrono::steady_clock::duration duration)
+        {
+            return std::chrono::duration<double, std::milli>(duration).count();
+        }
+
+        std::string quoteCsv(std::string_view value)
+        {
+            std::string result = "\"";
+            for (char c : value)
+            {
+                if (c == '"')
+                    result += '"';
+                result += c;
+            }
+            result += '"';
+            return result;
+        }
+
+        template <class T>
+        std::vector<const typename T::value_type*> sortByTime(const T& stats)
+        {
+            std::vector<const typename T::value_type*> result;
+            result.reserve(stats.size());
+            for (const auto& value : stats)
+                result.push_back(&value);
+            std::stable_sort(result.begin(), result.end(),
+                [](const auto* lhs, const auto* rhs) { return lhs->second.mTime > rhs->second.mTime; });
+            return result;
+        }
+
+        constexpr std::pair<std::string_view, LuaUtil::ScriptsContainer::HandlerStatsMap LuaManager::ScriptProfile::*>
+            handlerTypes[] = {
+                {"engine", &LuaManager::ScriptProfile::mEngineHandlers},
+                {"event", &LuaManager::ScriptProfile::mEvents},
+                {"timer", &LuaManager::ScriptProfile::mTimers},
+            };
+    }
+
     LuaManager::LuaManager(const VFS::Manager* vfs, const std::string& libsDir)
         : mLua(vfs, &mConfiguration)
         , mUiResourceManager(vfs)
@@ -37,6 +83,22 @@ namespace MWLua
     {
         Log(Debug::Info) << "Lua version: " << LuaUtil::getLuaVersion();
         mLua.addInternalLibSearchPath(libsDir);
+        const std::int64_t memorySoftLimit =
+            std::max<std::int64_t>(0, Settings::Manager::getInt64("lua memory soft limit", "Lua")) * 1024;
+        mLua.getAllocator().setDefaultSoftLimit(memorySoftLimit);
+        const int numThreads = Settings::Manager::getInt("lua num threads", "Lua");
+        for (int i = 1; i < numThreads; ++i)
+        {
+            Shard& shard = *mShards.emplace_back(std::make_unique<Shard>(vfs, &mConfiguration));
+            shard.mLua.addInternalLibSearchPath(libsDir);
+            shard.mLua.getAllocator().setDefaultSoftLimit(memorySoftLimit);
+        }
+        mLocalScriptsUpdates.resize(mShards.size() + 1);
+        if (!mShards.empty())
+            Log(Debug::Info) << "Local Lua scripts are distributed between " << mShards.size() + 1 << " Lua states";
+        mFrameBudget = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<float, std::milli>(std::max(0.f, Settings::Manager::getFloat("lua frame budget", "Lua"))));
+        setProfilerEnabled(Settings::Manager::getBool("lua profiler", "Lua"));
 
         mGlobalSerializer = createUserdataSerializer(false, mWorldView.getObjectRegistry());
         mLocalSerializer = createUserdataSerializer(true, mWorldView.getObjectRegistry());
@@ -46,6 +108,16 @@ namespace MWLua
         mGlobalScripts.setSerializer(mGlobalSerializer.get());
     }
 
+    LuaManager::~LuaManager()
+    {
+        if (mShardThreads.empty())
+            return;
+        mStopShardThreads = true;
+        mShardsStartBarrier->wait([] {});
+        for (std::thread& thread : mShardThreads)
+            thread.join();
+    }
+
     void LuaManager::initConfiguration()
     {
         mConfiguration.init(MWBase::Environment::get().getWorld()->getStore().getLuaScriptsCfg());
@@ -99,10 +171,115 @@ namespace MWLua
         mPostprocessingPackage = initPostprocessingPackage(localContext);
         mDebugPackage = initDebugPackage(localContext);
 
+        for (const std::unique_ptr<Shard>& shard : mShards)
+        {
+            shard->mL10n.init();
+            shard->mL10n.setPreferredLocales(preferredLocales);
+            initShard(*shard, localContext);
+        }
+        if (!mShards.empty())
+        {
+            mShardsStartBarrier = std::make_unique<Misc::Barrier>(static_cast<int>(mShards.size() + 1));
+            mShardsFinishBarrier = std::make_unique<Misc::Barrier>(static_cast<int>(mShards.size() + 1));
+            for (std::size_t i = 1; i <= mShards.size(); ++i)
+                mShardThreads.emplace_back([this, i] { runShardThread(i); });
+        }
+
         initConfiguration();
         mInitialized = true;
     }
 
+    void LuaManager::initShard(Shard& shard, const Context& localContext)
+    {
+        Context context = localContext;
+        context.mLua = &shard.mLua;
+        context.mL10n = &shard.mL10n;
+        context.mLocalEventQueue = &shard.mLocalEvents;
+        context.mGlobalEventQueue = &shard.mGlobalEvents;
+
+        initObjectBindingsForLocalScripts(context);
+        initCellBindingsForLocalScripts(context);
+        LocalScripts::initializeSelfPackage(context);
+        LuaUtil::LuaStorage::initLuaBindings(shard.mLua.sol());
+
+        shard.mLua.addCommonPackage("openmw.async", getAsyncPackageInitializer(context));
+        shard.mLua.addCommonPackage("openmw.util", LuaUtil::initUtilPackage(shard.mLua.sol()));
+        shard.mLua.addCommonPackage("openmw.core", initCorePackage(context));
+        shard.mLua.addCommonPackage("openmw.types", initTypesPackage(context));
+        shard.mNearbyPackage = initNearbyPackage(context);
+        shard.mLocalStoragePackage = initLocalStoragePackage(context, &mGlobalStorage);
+    }
+
+    void LuaManager::runShardThread(std::size_t index)
+    {
+        while (true)
+        {
+            mShardsStartBarrier->wait([] {});
+            if (mStopShardThreads)
+                return;
+            updateLocalScripts(mLocalScriptsUpdates[index]);
+            mShardsFinishBarrier->wait([] {});
+        }
+    }
+
+    std::size_t LuaManager::getLocalScriptsUpdateIndex(const LocalScripts& scripts) const
+    {
+        for (std::size_t i = 0; i < mShards.size(); ++i)
+            if (scripts.getLuaState() == &mShards[i]->mLua)
+                return i + 1;
+        return 0;
+    }
+
+    void LuaManager::updateLocalScripts(LocalScriptsUpdate& update)
+    {
+        // Runs in parallel for different Lua states, so can use only WorldView, the state's own scripts and
+        // bindings that lock the world (see `Object::lockWorld`).
+        try
+        {
+            if (!mWorldView.isPaused())
+            {
+                for (LocalScripts* scripts : update.mScripts)
+                    scripts->processTimers(mWorldView.getSimulationTime(), mWorldView.getGameTime());
+            }
+            for (auto& [scripts, e] : update.mEvents)
+                scripts->receiveEvent(e.mEventName, e.mEventData);
+            for (const auto& [scripts, e] : update.mEngineEvents)
+                scripts->receiveEngineEvent(e);
+            if (!mWorldView.isPaused())
+            {
+                const float frameDuration = MWBase::Environment::get().getFrameDuration();
+                for (LocalScripts* scripts : update.mScripts)
+                    scripts->update(frameDuration);
+            }
+        }
+        catch (const std::exception& e)
+        {
+            Log(Debug::Error) << "Failed to update local Lua scripts: " << e.what();
+        }
+        update.mScripts.clear();
+        update.mEvents.clear();
+        update.mEngineEvents.clear();
+    }
+
+    void LuaManager::collectShardEvents()
+    {
+        for (const std::unique_ptr<Shard>& shard : mShards)
+        {
+            std::move(shard->mGlobalEvents.begin(), shard->mGlobalEvents.end(), std::back_inserter(mGlobalEvents));
+            std::move(shard->mLocalEvents.begin(), shard->mLocalEvents.end(), std::back_inserter(mLocalEvents));
+            shard->mGlobalEvents.clear();
+            shard->mLocalEvents.clear();
+        }
+    }
+
+    std::vector<const LuaUtil::LuaState*> LuaManager::getLuaStates() const
+    {
+        std::vector<const LuaUtil::LuaState*> states{&mLua};
+        for (const std::unique_ptr<Shard>& shard : mShards)
+            states.push_back(&shard->mLua);
+        return states;
+    }
+
     void LuaManager::loadPermanentStorage(const std::string& userConfigPath)
     {
         auto globalPath = std::filesystem::path(userConfigPath) / "global_storage.bin";
@@ -140,6 +317,7 @@ namespace MWLua
 
         mWorldView.update();
 
+        collectShardEvents();
         std::vector<GlobalEvent> globalEvents = std::move(mGlobalEvents);
         std::vector<LocalEvent> localEvents = std::move(mLocalEvents);
         mGlobalEvents = std::vector<GlobalEvent>();
@@ -152,19 +330,26 @@ namespace MWLua
             double gameTime = mWorldView.getGameTime();
 
             mGlobalScripts.processTimers(simulationTime, gameTime);
-            for (LocalScripts* scripts : mActiveLocalScripts)
-                scripts->processTimers(simulationTime, gameTime);
         }
 
-        // Receive events
+        // Receive events. Event data is passed as a Lua value if the sender and the receiver share a Lua state,
+        // otherwise it is serialized here, while no other thread uses the sender's state.
         for (GlobalEvent& e : globalEvents)
+        {
+            if (!e.mEventData.isInLuaState(mLua.sol()))
+                e.mEventData.detach();
             mGlobalScripts.receiveEvent(e.mEventName, e.mEventData);
+        }
         for (LocalEvent& e : localEvents)
         {
             LObject obj(e.mDest, objectRegistry);
             LocalScripts* scripts = obj.isValid() ? obj.ptr().getRefData().getLuaScripts() : nullptr;
             if (scripts)
-                scripts->receiveEvent(e.mEventName, e.mEventData);
+            {
+                if (!e.mEventData.isInLuaState(scripts->getLuaState()->sol()))
+                    e.mEventData.detach();
+                mLocalScriptsUpdates[getLocalScriptsUpdateIndex(*scripts)].mEvents.emplace_back(scripts, std::move(e));
+            }
             else
                 Log(Debug::Debug) << "Ignored event " << e.mEventName << " to L" << idToString(e.mDest)
                                   << ". Object not found or has no attached scripts";
@@ -187,15 +372,19 @@ namespace MWLua
             }
             LocalScripts* scripts = obj.ptr().getRefData().getLuaScripts();
             if (scripts)
-                scripts->receiveEngineEvent(e.mEvent);
+                mLocalScriptsUpdates[getLocalScriptsUpdateIndex(*scripts)].mEngineEvents.emplace_back(scripts, e.mEvent);
         }
         mLocalEngineEvents.clear();
 
-        if (!mWorldView.isPaused())
-        {
-            for (LocalScripts* scripts : mActiveLocalScripts)
-                scripts->update(frameDuration);
-        }
+        // Timers, events and `onUpdate` of local scripts. Every shard is processed in its own thread.
+        for (LocalScripts* scripts : mActiveLocalScripts)
+            mLocalScriptsUpdates[getLocalScriptsUpdateIndex(*scripts)].mScripts.push_back(scripts);
+        if (!mShards.empty())
+            mShardsStartBarrier->wait([] {});
+        updateLocalScripts(mLocalScriptsUpdates[0]);
+        if (!mShards.empty())
+            mShardsFinishBarrier->wait([] {});
+        collectShardEvents();
 
         // Engine handlers in global scripts
         if (mPlayerChanged)
@@ -229,6 +418,8 @@ namespace MWLua
 
         if (!mWorldView.isPaused())
             mGlobalScripts.update(frameDuration);
+
+        finishProfilerFrame();
     }
 
     void LuaManager::synchronizedUpdate()
@@ -275,6 +466,11 @@ namespace MWLua
         mActiveLocalScripts.clear();
         mLocalEvents.clear();
         mGlobalEvents.clear();
+        for (const std::unique_ptr<Shard>& shard : mShards)
+        {
+            shard->mLocalEvents.clear();
+            shard->mGlobalEvents.clear();
+        }
         mInputEvents.clear();
         mObjectAddedEvents.clear();
         mLocalEngineEvents.clear();
@@ -358,6 +554,7 @@ namespace MWLua
         LocalScripts* localScripts = ptr.getRefData().getLuaScripts();
         if (localScripts)
         {
+            collectProfile(*localScripts);
             mActiveLocalScripts.erase(localScripts);
             if (!mWorldView.getObjectRegistry()->getPtr(getId(ptr), true).isEmpty())
                 mLocalEngineEvents.push_back({getId(ptr), LocalScripts::OnInactive{}});
@@ -424,16 +621,28 @@ namespace MWLua
             scripts->addPackage("openmw.storage", mPlayerStoragePackage);
             scripts->addPackage("openmw.postprocessing", mPostprocessingPackage);
             scripts->addPackage("openmw.debug", mDebugPackage);
+            scripts->addPackage("openmw.nearby", mNearbyPackage);
         }
         else
         {
-            scripts = std::make_shared<LocalScripts>(&mLua, LObject(getId(ptr), mWorldView.getObjectRegistry()));
+            LuaUtil::LuaState* lua = &mLua;
+            sol::table nearbyPackage = mNearbyPackage;
+            sol::table storagePackage = mLocalStoragePackage;
+            if (!mShards.empty())
+            {  // Distribute non-player objects between shards by id, so the shard doesn't depend on loading order.
+                const ObjectId& id = getId(ptr);
+                Shard& shard = *mShards[(id.mIndex * 31u + static_cast<std::uint32_t>(id.mContentFile)) % mShards.size()];
+                lua = &shard.mLua;
+                nearbyPackage = shard.mNearbyPackage;
+                storagePackage = shard.mLocalStoragePackage;
+            }
+            scripts = std::make_shared<LocalScripts>(lua, LObject(getId(ptr), mWorldView.getObjectRegistry()));
             if (!autoStartConf.has_value())
                 autoStartConf = mConfiguration.getLocalConf(type, ptr.getCellRef().getRefId(), getId(ptr));
             scripts->setAutoStartConf(std::move(*autoStartConf));
-            scripts->addPackage("openmw.storage", mLocalStoragePackage);
+            scripts->addPackage("openmw.storage", storagePackage);
+            scripts->addPackage("openmw.nearby", nearbyPackage);
         }
-        scripts->addPackage("openmw.nearby", mNearbyPackage);
         scripts->setSerializer(mLocalSerializer.get());
 
         MWWorld::RefData& refData = ptr.getRefData();
@@ -449,6 +658,7 @@ namespace MWLua
         ESM::LuaScripts globalScripts;
         mGlobalScripts.save(globalScripts);
         globalScripts.save(writer);
+        collectShardEvents();
         saveEvents(writer, mGlobalEvents, mLocalEvents);
 
         writer.endRecord(ESM::REC_LUAM);
@@ -506,6 +716,11 @@ namespace MWLua
         mUiResourceManager.clear();
         mLua.dropScriptCache();
         mL10n.clear();
+        for (const std::unique_ptr<Shard>& shard : mShards)
+        {
+            shard->mLua.dropScriptCache();
+            shard->mL10n.clear();
+        }
         initConfiguration();
 
         {  // Reload global scripts
@@ -589,9 +804,169 @@ namespace MWLua
         };
     }
 
-    void LuaManager::addAction(std::function<void()> action, std::string_view name)
+    void LuaManager::addAction(std::function<void()> action, std::string_view name, LuaUtil::LuaState* lua)
     {
-        mActionQueue.push_back(std::make_unique<FunctionAction>(&mLua, std::move(action), name));
+        addAction(std::make_unique<FunctionAction>(lua ? lua : &mLua, std::move(action), name));
+    }
+
+    void LuaManager::reportStats(unsigned int frameNumber, osg::Stats& stats) const
+    {
+        std::int64_t totalBytes = 0;
+        std::int64_t pooledBytes = 0;
+        for (const LuaUtil::LuaState* lua : getLuaStates())
+        {
+            totalBytes += lua->getAllocator().getTotalBytes();
+            pooledBytes += lua->getAllocator().getPooledBytes();
+        }
+        stats.setAttribute(frameNumber, "Lua Memory", totalBytes / (1024.0 * 1024.0));
+        stats.setAttribute(frameNumber, "Lua Pooled", pooledBytes / (1024.0 * 1024.0));
+    }
+
+    std::string LuaManager::formatResourceUsageStats() const
+    {
+        std::int64_t totalBytes = 0;
+        std::int64_t pooledBytes = 0;
+        std::vector<const LuaUtil::LuaAllocator::OwnerStats*> sorted;
+        for (const LuaUtil::LuaState* lua : getLuaStates())
+        {
+            const LuaUtil::LuaAllocator& allocator = lua->getAllocator();
+            totalBytes += allocator.getTotalBytes();
+            pooledBytes += allocator.getPooledBytes();
+            for (const LuaUtil::LuaAllocator::OwnerStats& owner : allocator.getOwners())
+                if (!owner.mRemoved || owner.mBytes > 0)
+                    sorted.push_back(&owner);
+        }
+        std::sort(sorted.begin(), sorted.end(), [](const auto* l, const auto* r) { return l->mBytes > r->mBytes; });
+
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(3);
+        out << "Lua memory: " << totalBytes / 1024 << " KiB, pooled: " << pooledBytes / 1024 << " KiB";
+        if (!mShards.empty())
+            out << ", " << mShards.size() + 1 << " Lua states";
+        out << "\n";
+        const std::int64_t softLimit = mLua.getAllocator().getDefaultSoftLimit();
+        if (softLimit > 0)
+            out << "Soft limit per scripts container: " << softLimit / 1024 << " KiB\n";
+        out << "\n" << std::setw(12) << "Memory, KiB" << std::setw(12) << "Peak, KiB" << std::setw(14) << "Allocations"
+            << "  Scripts\n";
+        for (const LuaUtil::LuaAllocator::OwnerStats* owner : sorted)
+        {
+            out << std::setw(12) << owner->mBytes / 1024 << std::setw(12) << owner->mPeakBytes / 1024
+                << std::setw(14) << owner->mAllocations << "  " << owner->mName;
+            if (owner->mRemoved)
+                out << " (removed)";
+            if (owner->mLimitExceeded)
+                out << " (over the soft limit)";
+            out << "\n";
+        }
+
+        if (!mProfilerEnabled && mProfile.empty())
+        {
+            out << "\nLua profiler is disabled, it can be enabled with the \"lua profiler\" setting.\n";
+            return out.str();
+        }
+        out << "\nLua profiler" << (mProfilerEnabled ? "" : " (disabled)") << ":\n";
+        out << std::setw(12) << "Time, ms" << std::setw(12) << "Calls" << std::setw(12) << "Average, us"
+            << "  Script / handler\n";
+        for (const auto* scriptValue : sortByTime(mProfile))
+        {
+            const auto& [scriptId, profile] = *scriptValue;
+            out << std::setw(12) << toMilliseconds(profile.mTime) << std::setw(24) << "" << "  "
+                << getScriptPath(scriptId) << "\n";
+            for (const auto& [type, handlers] : handlerTypes)
+            {
+                for (const auto* handlerValue : sortByTime(profile.*handlers))
+                {
+                    const auto& [name, stats] = *handlerValue;
+                    out << std::setw(12) << toMilliseconds(stats.mTime) << std::setw(12) << stats.mCalls
+                        << std::setw(12) << toMilliseconds(stats.mTime) * 1000 / std::max<std::uint64_t>(stats.mCalls, 1)
+                        << "      " << type << " " << name << "\n";
+                }
+            }
+        }
+        return out.str();
+    }
+
+    void LuaManager::setProfilerEnabled(bool enabled)
+    {
+        mProfilerEnabled = enabled;
+        // Handlers are timed for the frame budget as well.
+        LuaUtil::ScriptsContainer::setProfilerEnabled(enabled || mFrameBudget.count() > 0);
+    }
+
+    void LuaManager::collectProfile(LuaUtil::ScriptsContainer& container)
+    {
+        for (const auto& [scriptId, profile] : container.getProfile())
+        {
+            mFrameTimes[scriptId] += profile.mTime;
+            if (!mProfilerEnabled)
+                continue;
+            ScriptProfile& total = mProfile[scriptId];
+            total.mTime += profile.mTime;
+            for (const auto& [_, handlers] : handlerTypes)
+            {
+                for (const auto& [name, stats] : profile.*handlers)
+                {
+                    LuaUtil::ScriptsContainer::HandlerStats& totalStats = (total.*handlers)[name];
+                    totalStats.mTime += stats.mTime;
+                    totalStats.mCalls += stats.mCalls;
+                }
+            }
+        }
+        container.clearProfile();
+    }
+
+    void LuaManager::finishProfilerFrame()
+    {
+        if (!LuaUtil::ScriptsContainer::isProfilerEnabled() && mFrameTimes.empty())
+            return;
+        collectProfile(mGlobalScripts);
+        for (LocalScripts* scripts : mActiveLocalScripts)
+            collectProfile(*scripts);
+
+        std::chrono::steady_clock::duration frameTime{};
+        for (const auto& [_, time] : mFrameTimes)
+            frameTime += time;
+        const auto now = std::chrono::steady_clock::now();
+        if (mFrameBudget.count() > 0 && frameTime > mFrameBudget && now - mLastBudgetWarning > std::chrono::seconds(5))
+        {
+            mLastBudgetWarning = now;
+            std::vector<std::pair<int, std::chrono::steady_clock::duration>> scripts(mFrameTimes.begin(), mFrameTimes.end());
+            std::sort(scripts.begin(), scripts.end(), [](const auto& l, const auto& r) { return l.second > r.second; });
+            scripts.resize(std::min<std::size_t>(scripts.size(), 3));
+            Log log(Debug::Warning);
+            log << "Lua scripts took " << toMilliseconds(frameTime) << " ms in one frame, the budget is "
+                << toMilliseconds(mFrameBudget) << " ms. The most expensive scripts:";
+            for (const auto& [scriptId, time] : scripts)
+                log << " " << getScriptPath(scriptId) << " (" << toMilliseconds(time) << " ms)";
+        }
+        mFrameTimes.clear();
+    }
+
+    void LuaManager::writeProfile(const std::string& path) const
+    {
+        if (mProfile.empty())
+            return;
+
+        std::ofstream stream(path);
+        stream << "script,type,handler,calls,time ms\n";
+        for (const auto* scriptValue : sortByTime(mProfile))
+        {
+            const auto& [scriptId, profile] = *scriptValue;
+            for (const auto& [type, handlers] : handlerTypes)
+                for (const auto* handlerValue : sortByTime(profile.*handlers))
+                {
+                    const auto& [name, stats] = *handlerValue;
+                    stream << quoteCsv(getScriptPath(scriptId)) << ',' << type << ',' << quoteCsv(name) << ','
+                           << stats.mCalls << ',' << toMilliseconds(stats.mTime) << '\n';
+                }
+        }
+        stream.close();
+
+        if (!stream)
+            Log(Debug::Error) << "Failed to write Lua profile to " << path;
+        else
+            Log(Debug::Info) << "Lua profile is written to " << path;
     }
 
 }
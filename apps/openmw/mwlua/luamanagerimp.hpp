@@ -1,8 +1,11 @@
 #ifndef MWLUA_LUAMANAGERIMP_H
 #define MWLUA_LUAMANAGERIMP_H
 
+#include <chrono>
 #include <map>
+#include <mutex>
 #include <set>
+#include <thread>
 
 #include <components/lua/l10n.hpp>
 #include <components/lua/luastate.hpp>
@@ -10,6 +13,7 @@
 
 #include <components/lua_ui/resources.hpp>
 
+#include <components/misc/barrier.hpp>
 #include <components/misc/color.hpp>
 
 #include "../mwbase/luamanager.hpp"
@@ -28,6 +32,7 @@ namespace MWLua
     {
     public:
         LuaManager(const VFS::Manager* vfs, const std::string& libsDir);
+        ~LuaManager();
 
         // Called by engine.cpp when the environment is fully initialized.
         void init();
@@ -84,8 +89,14 @@ namespace MWLua
             std::string mCallerTraceback;
         };
 
-        void addAction(std::function<void()> action, std::string_view name = "");
-        void addAction(std::unique_ptr<Action>&& action) { mActionQueue.push_back(std::move(action)); }
+        // Thread safe; local scripts of different shards add actions in parallel.
+        // `lua` is the state of the calling script (used for tracebacks), the main state by default.
+        void addAction(std::function<void()> action, std::string_view name = "", LuaUtil::LuaState* lua = nullptr);
+        void addAction(std::unique_ptr<Action>&& action)
+        {
+            std::lock_guard<std::mutex> lock(mActionQueueMutex);
+            mActionQueue.push_back(std::move(action));
+        }
         void addTeleportPlayerAction(std::unique_ptr<Action>&& action) { mTeleportPlayerAction = std::move(action); }
 
         // Saving
@@ -102,6 +113,18 @@ namespace MWLua
 
         void handleConsoleCommand(const std::string& consoleMode, const std::string& command, const MWWorld::Ptr& selectedPtr) override;
 
+        void reportStats(unsigned int frameNumber, osg::Stats& stats) const override;
+        std::string formatResourceUsageStats() const override;
+
+        // Time of script handlers by script id. Collected from the scripts containers at the end of every `update`.
+        using ScriptProfile = LuaUtil::ScriptsContainer::ScriptProfile;
+        void setProfilerEnabled(bool enabled);
+        bool isProfilerEnabled() const { return mProfilerEnabled; }
+        const std::map<int, ScriptProfile>& getProfile() const { return mProfile; }
+        void clearProfile() { mProfile.clear(); }
+        const std::string& getScriptPath(int scriptId) const { return mConfiguration[scriptId].mScriptPath; }
+        void writeProfile(const std::string& path) const;
+
         // Used to call Lua callbacks from C++
         void queueCallback(LuaUtil::Callback callback, sol::object arg)
         {
@@ -122,7 +145,44 @@ namespace MWLua
         bool isProcessingInputEvents() const { return mProcessingInputEvents; }
 
     private:
+        // Local scripts of non-player objects are distributed between several Lua states ("shards") if
+        // "lua num threads" > 1. Shards are updated in parallel with each other and with local scripts of
+        // the main Lua state. Global and player scripts always work in the main Lua state.
+        // Shards communicate with the rest of the game only via WorldView, event queues and actions.
+        // Bindings that read objects through MWWorld::Class (stats, inventories, AI) serialize it with
+        // `Object::lockWorld`, because even reading can create custom data of an object.
+        struct Shard
+        {
+            Shard(const VFS::Manager* vfs, const LuaUtil::ScriptsConfiguration* conf)
+                : mLua(vfs, conf), mL10n(vfs, &mLua) {}
+
+            LuaUtil::LuaState mLua;
+            LuaUtil::L10nManager mL10n;
+            sol::table mNearbyPackage;
+            sol::table mLocalStoragePackage;
+
+            // Events sent by scripts of the shard, moved to the main queues after every update.
+            GlobalEventQueue mGlobalEvents;
+            LocalEventQueue mLocalEvents;
+        };
+
+        // Work of one frame for local scripts of a single Lua state.
+        struct LocalScriptsUpdate
+        {
+            std::vector<LocalScripts*> mScripts;
+            std::vector<std::pair<LocalScripts*, LocalEvent>> mEvents;
+            std::vector<std::pair<LocalScripts*, LocalScripts::EngineEvent>> mEngineEvents;
+        };
+
         void initConfiguration();
+        void initShard(Shard& shard, const Context& localContext);
+        void runShardThread(std::size_t index);
+        std::size_t getLocalScriptsUpdateIndex(const LocalScripts& scripts) const;
+        void updateLocalScripts(LocalScriptsUpdate& update);
+        void collectShardEvents();
+        std::vector<const LuaUtil::LuaState*> getLuaStates() const;
+        void collectProfile(LuaUtil::ScriptsContainer& container);
+        void finishProfilerFrame();
         LocalScripts* createLocalScripts(const MWWorld::Ptr& ptr,
                                          std::optional<LuaUtil::ScriptIdsWithInitializationData> autoStartConf = std::nullopt);
 
@@ -131,6 +191,8 @@ namespace MWLua
         bool mProcessingInputEvents = false;
         LuaUtil::ScriptsConfiguration mConfiguration;
         LuaUtil::LuaState mLua;
+        // Declared before everything that can hold references to Lua objects of the shards.
+        std::vector<std::unique_ptr<Shard>> mShards;
         LuaUi::ResourceManager mUiResourceManager;
         LuaUtil::L10nManager mL10n;
         sol::table mNearbyPackage;
@@ -179,12 +241,26 @@ namespace MWLua
 
         // Queued actions that should be done in main thread. Processed by applyQueuedChanges().
         std::vector<std::unique_ptr<Action>> mActionQueue;
+        std::mutex mActionQueueMutex;
         std::unique_ptr<Action> mTeleportPlayerAction;
         std::vector<std::string> mUIMessages;
         std::vector<std::pair<std::string, Misc::Color>> mInGameConsoleMessages;
 
         LuaUtil::LuaStorage mGlobalStorage{mLua.sol()};
         LuaUtil::LuaStorage mPlayerStorage{mLua.sol()};
+
+        bool mProfilerEnabled = false;
+        std::map<int, ScriptProfile> mProfile;
+        std::map<int, std::chrono::steady_clock::duration> mFrameTimes;
+        std::chrono::steady_clock::duration mFrameBudget{};
+        std::chrono::steady_clock::time_point mLastBudgetWarning;
+
+        // Index 0 is the main Lua state, index i is mShards[i - 1].
+        std::vector<LocalScriptsUpdate> mLocalScriptsUpdates;
+        std::unique_ptr<Misc::Barrier> mShardsStartBarrier;
+        std::unique_ptr<Misc::Barrier> mShardsFinishBarrier;
+        bool mStopShardThreads = false;
+        std::vector<std::thread> mShardThreads;
     };
 
 }
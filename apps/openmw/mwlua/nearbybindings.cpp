@@ -1,5 +1,7 @@
 #include "luabindings.hpp"
 
+#include <mutex>
+
 #include <components/lua/luastate.hpp>
 
 #include "../mwbase/environment.hpp"
@@ -17,6 +19,13 @@ namespace sol
 
 namespace MWLua
 {
+    namespace
+    {
+        // Local scripts of different shards can cast rays in parallel, but ray tests of the physics world
+        // are protected by its own lock only if physics works in several threads.
+        std::mutex sRayCastingMutex;
+    }
+
     sol::table initNearbyPackage(const Context& context)
     {
         sol::table api(context.mLua->sol(), sol::create);
@@ -73,6 +82,7 @@ namespace MWLua
                 radius = options->get<sol::optional<float>>("radius").value_or(0);
             }
             const MWPhysics::RayCastingInterface* rayCasting = MWBase::Environment::get().getWorld()->getRayCasting();
+            std::lock_guard<std::mutex> lock(sRayCastingMutex);
             if (radius <= 0)
                 return rayCasting->castRay(from, to, ignore, std::vector<MWWorld::Ptr>(), collisionType);
             else
@@ -107,14 +117,14 @@ namespace MWLua
             return res;
         };
         api["asyncCastRenderingRay"] =
-            [manager=context.mLuaManager](const LuaUtil::Callback& callback, const osg::Vec3f& from, const osg::Vec3f& to)
+            [manager=context.mLuaManager, lua=context.mLua](const LuaUtil::Callback& callback, const osg::Vec3f& from, const osg::Vec3f& to)
         {
             manager->addAction([manager, callback, from, to]
             {
                 MWPhysics::RayCastingResult res;
                 MWBase::Environment::get().getWorld()->castRenderingRay(res, from, to, false, false);
                 manager->queueCallback(callback, sol::make_object(callback.mFunc.lua_state(), res));
-            });
+            }, "asyncCastRenderingRay", lua);
         };
 
         api["activators"] = LObjectList{worldView->getActivatorsInScene()};
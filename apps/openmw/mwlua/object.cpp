@@ -64,6 +64,7 @@ namespace MWLua
 
     void ObjectRegistry::clear()
     {
+        std::lock_guard<std::mutex> lock(mMutex);
         mObjectMapping.clear();
         mChanged = false;
         mUpdateCounter = 0;
@@ -72,6 +73,7 @@ namespace MWLua
 
     MWWorld::Ptr ObjectRegistry::getPtr(ObjectId id, bool local)
     {
+        std::lock_guard<std::mutex> lock(mMutex);
         MWWorld::Ptr ptr;
         auto it = mObjectMapping.find(id);
         if (it != mObjectMapping.end())
@@ -90,6 +92,7 @@ namespace MWLua
 
     ObjectId ObjectRegistry::registerPtr(const MWWorld::Ptr& ptr)
     {
+        std::lock_guard<std::mutex> lock(mMutex);
         ObjectId id = ptr.getCellRef().getOrAssignRefNum(mLastAssignedId);
         mChanged = true;
         mObjectMapping[id] = ptr;
@@ -98,6 +101,7 @@ namespace MWLua
 
     ObjectId ObjectRegistry::deregisterPtr(const MWWorld::Ptr& ptr)
     {
+        std::lock_guard<std::mutex> lock(mMutex);
         ObjectId id = getId(ptr);
         mChanged = true;
         mObjectMapping.erase(id);
@@ -3,6 +3,7 @@
 
 #include <typeindex>
 #include <map>
+#include <mutex>
 
 #include <sol/sol.hpp>
 
@@ -21,6 +22,8 @@ namespace MWLua
     bool isMarker(const MWWorld::Ptr& ptr);
 
     // Holds a mapping ObjectId -> MWWord::Ptr.
+    // `registerPtr`, `deregisterPtr` and `getPtr` are thread safe (used by local scripts of different shards in parallel).
+    // It also owns the lock that serializes access of local scripts to MWWorld (see `Object::lockWorld`).
     class ObjectRegistry
     {
     public:
@@ -49,6 +52,8 @@ namespace MWLua
         int64_t mUpdateCounter = 0;
         std::map<ObjectId, MWWorld::Ptr> mObjectMapping;
         ObjectId mLastAssignedId;
+        std::mutex mMutex;
+        std::recursive_mutex mWorldMutex;
     };
 
     // Lua scripts can't use MWWorld::Ptr directly, because lifetime of a script can be longer than lifetime of Ptr.
@@ -69,6 +74,14 @@ namespace MWLua
         // Returns `true` if calling `ptr()` is safe.
         bool isValid() const;
 
+        // Local scripts of different shards run in parallel, but MWWorld is not thread safe: even reading
+        // e.g. stats or inventory of an object can create its custom data and marks its RefData as changed.
+        // Bindings hold this lock while they use MWWorld::Class or MWWorld::World functions on the object.
+        std::unique_lock<std::recursive_mutex> lockWorld() const
+        {
+            return std::unique_lock<std::recursive_mutex>(mObjectRegistry->mWorldMutex);
+        }
+
         virtual sol::object getObject(lua_State* lua, ObjectId id) const = 0;  // returns LObject or GOBject
         virtual sol::object getCell(lua_State* lua, MWWorld::CellStore* store) const = 0;  // returns LCell or GCell
 
@@ -173,7 +173,8 @@ namespace MWLua
             objectT[sol::meta_function::to_string] = &ObjectT::toString;
             objectT["sendEvent"] = [context](const ObjectT& dest, std::string eventName, const sol::object& eventData)
             {
-                context.mLocalEventQueue->push_back({dest.id(), std::move(eventName), LuaUtil::serialize(eventData, context.mSerializer)});
+                context.mLocalEventQueue->push_back(
+                    {dest.id(), std::move(eventName), LuaUtil::EventData(context.mLua->sol(), eventData, context.mSerializer)});
             };
 
             objectT["activateBy"] = [context](const ObjectT& o, const ObjectT& actor)
@@ -283,6 +284,7 @@ namespace MWLua
                 if (mask == -1)
                     throw std::runtime_error(std::string("Incorrect type argument in inventory:getAll: " + LuaUtil::toString(*type)));
 
+                const auto lock = inventory.mObj.lockWorld();
                 const MWWorld::Ptr& ptr = inventory.mObj.ptr();
                 MWWorld::ContainerStore& store = ptr.getClass().getContainerStore(ptr);
                 ObjectIdList list = std::make_shared<std::vector<ObjectId>>();
@@ -298,6 +300,7 @@ namespace MWLua
 
             inventoryT["countOf"] = [](const InventoryT& inventory, const std::string& recordId)
             {
+                const auto lock = inventory.mObj.lockWorld();
                 const MWWorld::Ptr& ptr = inventory.mObj.ptr();
                 MWWorld::ContainerStore& store = ptr.getClass().getContainerStore(ptr);
                 return store.count(recordId);
@@ -59,6 +59,7 @@ namespace
     template<class G>
     sol::object getValue(const MWLua::Context& context, const StatObject& obj, SelfObject::CachedStat::Setter setter, int index, std::string_view prop, G getter)
     {
+        const auto lock = getObject(obj)->lockWorld();
         return std::visit([&] (auto&& variant)
         {
             using T = std::decay_t<decltype(variant)>;
@@ -124,6 +125,7 @@ namespace MWLua
 
         sol::object getProgress(const Context& context) const
         {
+            const auto lock = getObject(mObject)->lockWorld();
             const auto& ptr = getObject(mObject)->ptr();
             if(!ptr.getClass().isNpc())
                 return sol::nil;
@@ -142,6 +142,7 @@ namespace MWLua
 
         actor["stance"] = [](const Object& o)
         {
+            const auto lock = o.lockWorld();
             const MWWorld::Class& cls = o.ptr().getClass();
             if (cls.isActor())
                 return cls.getCreatureStats(o.ptr()).getDrawState();
@@ -151,31 +152,37 @@ namespace MWLua
 
         actor["canMove"] = [](const Object& o)
         {
+            const auto lock = o.lockWorld();
             const MWWorld::Class& cls = o.ptr().getClass();
             return cls.getMaxSpeed(o.ptr()) > 0;
         };
         actor["runSpeed"] = [](const Object& o)
         {
+            const auto lock = o.lockWorld();
             const MWWorld::Class& cls = o.ptr().getClass();
             return cls.getRunSpeed(o.ptr());
         };
         actor["walkSpeed"] = [](const Object& o)
         {
+            const auto lock = o.lockWorld();
             const MWWorld::Class& cls = o.ptr().getClass();
             return cls.getWalkSpeed(o.ptr());
         };
         actor["currentSpeed"] = [](const Object& o)
         {
+            const auto lock = o.lockWorld();
             const MWWorld::Class& cls = o.ptr().getClass();
             return cls.getCurrentSpeed(o.ptr());
         };
 
         actor["isOnGround"] = [](const LObject& o)
         {
+            const auto lock = o.lockWorld();
             return MWBase::Environment::get().getWorld()->isOnGround(o.ptr());
         };
         actor["isSwimming"] = [](const LObject& o)
         {
+            const auto lock = o.lockWorld();
             return MWBase::Environment::get().getWorld()->isSwimming(o.ptr());
         };
 
@@ -185,6 +192,7 @@ namespace MWLua
         );
         auto getAllEquipment = [context](const Object& o)
         {
+            const auto lock = o.lockWorld();
             const MWWorld::Ptr& ptr = o.ptr();
             sol::table equipment(context.mLua->sol(), sol::create);
             if (!ptr.getClass().hasInventoryStore(ptr))
@@ -203,6 +211,7 @@ namespace MWLua
         };
         auto getEquipmentFromSlot = [context](const Object& o, int slot) -> sol::object
         {
+            const auto lock = o.lockWorld();
             const MWWorld::Ptr& ptr = o.ptr();
             sol::table equipment(context.mLua->sol(), sol::create);
             if (!ptr.getClass().hasInventoryStore(ptr))
@@ -217,6 +226,7 @@ namespace MWLua
         actor["equipment"] = sol::overload(getAllEquipment, getEquipmentFromSlot);
         actor["hasEquipped"] = [](const Object& o, const Object& item)
         {
+            const auto lock = o.lockWorld();
             const MWWorld::Ptr& ptr = o.ptr();
             if (!ptr.getClass().hasInventoryStore(ptr))
                 return false;
@@ -225,6 +235,7 @@ namespace MWLua
         };
         actor["setEquipment"] = [context](const SelfObject& obj, const sol::table& equipment)
         {
+            const auto lock = obj.lockWorld();
             if (!obj.ptr().getClass().hasInventoryStore(obj.ptr()))
             {
                 if (!equipment.empty())
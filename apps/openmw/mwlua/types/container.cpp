@@ -27,10 +27,12 @@ namespace MWLua
             [](const GObject& o) { containerPtr(o); return Inventory<GObject>{o}; }
         );
         container["encumbrance"] = [](const Object& obj) -> float {
+            const auto lock = obj.lockWorld();
             const MWWorld::Ptr& ptr = containerPtr(obj);
             return ptr.getClass().getEncumbrance(ptr);
         };
         container["capacity"] = [](const Object& obj) -> float {
+            const auto lock = obj.lockWorld();
             const MWWorld::Ptr& ptr = containerPtr(obj);
             return ptr.getClass().getCapacity(ptr);
         };
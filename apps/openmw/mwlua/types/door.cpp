@@ -32,6 +32,7 @@ namespace MWLua
         };
         door["destCell"] = [worldView=context.mWorldView](sol::this_state lua, const Object& o) -> sol::object
         {
+            const auto lock = o.lockWorld();
             const MWWorld::CellRef& cellRef = doorPtr(o).getCellRef();
             if (!cellRef.getTeleport())
                 return sol::nil;
@@ -1449,6 +1449,17 @@ namespace MWRender
             mInsert->addChild(mObjectRoot);
         }
 
+        if (mSkeleton && mPtr.getClass().isActor())
+        {
+            static const bool animationLod = Settings::Manager::getBool("animation lod", "Game");
+            if (animationLod)
+            {
+                static const float fullRatePixelSize = Settings::Manager::getFloat("animation lod full rate pixel size", "Game");
+                static const int maxUpdateInterval = Settings::Manager::getInt("animation lod max update interval", "Game");
+                mSkeleton->setUpdateLod(fullRatePixelSize, static_cast<unsigned int>(std::max(maxUpdateInterval, 1)));
+            }
+        }
+
         if (previousStateset)
             mObjectRoot->setStateSet(previousStateset);
 
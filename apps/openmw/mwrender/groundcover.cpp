@@ -21,56 +21,82 @@
 
 namespace MWRender
 {
+    /// Sets up the geometry of a chunk's copy of a groundcover prototype to draw all instances of the model in the chunk.
     class InstancingVisitor : public osg::NodeVisitor
     {
     public:
-        InstancingVisitor(std::vector<Groundcover::GroundcoverEntry>& instances, osg::Vec3f& chunkPosition)
+        InstancingVisitor(const std::vector<Groundcover::GroundcoverEntry>& instances, const osg::Vec3f& chunkPosition)
         : osg::NodeVisitor(TRAVERSE_ALL_CHILDREN)
-        , mInstances(instances)
-        , mChunkPosition(chunkPosition)
+        , mTransforms(new osg::Vec4Array(instances.size()))
+        , mRotations(new osg::Vec3Array(instances.size()))
         {
+            for (std::size_t i = 0; i < instances.size(); ++i)
+            {
+                const osg::Vec3f relativePos = instances[i].mPos.asVec3() - chunkPosition;
+                (*mTransforms)[i] = osg::Vec4f(relativePos, instances[i].mScale);
+                (*mRotations)[i] = instances[i].mPos.asRotationVec3();
+            }
+
+            // The per-instance attributes get a buffer object of their own, otherwise the geometry would
+            // add them to the buffer object of its vertex data, which is shared with the prototype and other chunks
+            osg::ref_ptr<osg::VertexBufferObject> vbo = new osg::VertexBufferObject;
+            mTransforms->setVertexBufferObject(vbo);
+            mRotations->setVertexBufferObject(vbo);
         }
 
         void apply(osg::Geometry& geom) override
         {
+            // Copied primitive sets lose the element buffer object of the prototype, without one the indices
+            // would be sourced from client memory on every draw
+            osg::ref_ptr<osg::ElementBufferObject> ebo;
             for (unsigned int i = 0; i < geom.getNumPrimitiveSets(); ++i)
             {
-                geom.getPrimitiveSet(i)->setNumInstances(mInstances.size());
+                osg::PrimitiveSet* primitiveSet = geom.getPrimitiveSet(i);
+                primitiveSet->setNumInstances(mTransforms->size());
+                osg::DrawElements* elements = primitiveSet->getDrawElements();
+                if (elements && !elements->getElementBufferObject())
+                {
+                    if (!ebo)
+                        ebo = new osg::ElementBufferObject;
+                    elements->setElementBufferObject(ebo);
+                }
             }
 
-            osg::ref_ptr<osg::Vec4Array> transforms = new osg::Vec4Array(mInstances.size());
             osg::BoundingBox box;
             float radius = geom.getBoundingBox().radius();
-            for (unsigned int i = 0; i < transforms->getNumElements(); i++)
+            for (const osg::Vec4f& transform : *mTransforms)
             {
-                osg::Vec3f pos(mInstances[i].mPos.asVec3());
-                osg::Vec3f relativePos = pos - mChunkPosition;
-                (*transforms)[i] = osg::Vec4f(relativePos, mInstances[i].mScale);
-
                 // Use an additional margin due to groundcover animation
-                float instanceRadius = radius * mInstances[i].mScale * 1.1f;
-                osg::BoundingSphere instanceBounds(relativePos, instanceRadius);
+                float instanceRadius = radius * transform.w() * 1.1f;
+                osg::BoundingSphere instanceBounds(osg::Vec3f(transform.x(), transform.y(), transform.z()), instanceRadius);
                 box.expandBy(instanceBounds);
             }
 
             geom.setInitialBound(box);
 
-            osg::ref_ptr<osg::Vec3Array> rotations = new osg::Vec3Array(mInstances.size());
-            for (unsigned int i = 0; i < rotations->getNumElements(); i++)
-            {
-                (*rotations)[i] = mInstances[i].mPos.asRotationVec3();
-            }
+            // All geometry of the model shares the same per-instance attributes
+            geom.setVertexAttribArray(6, mTransforms.get(), osg::Array::BIND_PER_VERTEX);
+            geom.setVertexAttribArray(7, mRotations.get(), osg::Array::BIND_PER_VERTEX);
+        }
+    private:
+        osg::ref_ptr<osg::Vec4Array> mTransforms;
+        osg::ref_ptr<osg::Vec3Array> mRotations;
+    };
+
+    class PrepareInstancingVisitor : public osg::NodeVisitor
+    {
+    public:
+        PrepareInstancingVisitor()
+        : osg::NodeVisitor(TRAVERSE_ALL_CHILDREN)
+        {
+        }
 
+        void apply(osg::Geometry& geom) override
+        {
             // Display lists do not support instancing in OSG 3.4
             geom.setUseDisplayList(false);
             geom.setUseVertexBufferObjects(true);
-
-            geom.setVertexAttribArray(6, transforms.get(), osg::Array::BIND_PER_VERTEX);
-            geom.setVertexAttribArray(7, rotations.get(), osg::Array::BIND_PER_VERTEX);
         }
-    private:
-        std::vector<Groundcover::GroundcoverEntry> mInstances;
-        osg::Vec3f mChunkPosition;
     };
 
     class DensityCalculator
@@ -127,7 +153,7 @@ namespace MWRender
         return true;
     }
 
-    osg::ref_ptr<osg::Node> Groundcover::getChunk(float size, const osg::Vec2f& center, unsigned char lod, unsigned int lodFlags, bool activeGrid, const osg::Vec3f& viewPoint, bool compile)
+    osg::ref_ptr<osg::Node> Groundcover::getChunk(float size, const osg::Vec2f& center, unsigned char lod, unsigned int lodFlags, bool activeGrid, const osg::Vec3f& viewPoint, bool compile, const std::atomic<bool>* abort)
     {
         if (lod > getMaxLodLevel())
             return nullptr;
@@ -151,6 +177,7 @@ namespace MWRender
          , mDensity(density)
          , mStateset(new osg::StateSet)
          , mGroundcoverStore(store)
+         , mPrototypeCache(new Resource::GenericObjectCache<std::string>)
     {
          setViewDistance(viewDistance);
          // MGE uses default alpha settings for groundcover, so we can not rely on alpha properties
@@ -171,6 +198,46 @@ namespace MWRender
     {
     }
 
+    void Groundcover::updateCache(double referenceTime)
+    {
+        GenericResourceManager<GroundcoverChunkId>::updateCache(referenceTime);
+
+        mPrototypeCache->updateTimeStampOfObjectsInCacheWithExternalReferences(referenceTime);
+        mPrototypeCache->removeExpiredObjectsInCache(referenceTime - mExpiryDelay);
+    }
+
+    void Groundcover::clearCache()
+    {
+        GenericResourceManager<GroundcoverChunkId>::clearCache();
+
+        mPrototypeCache->clear();
+    }
+
+    osg::ref_ptr<const osg::Node> Groundcover::getPrototype(const std::string& model)
+    {
+        osg::ref_ptr<osg::Object> obj = mPrototypeCache->getRefFromObjectCache(model);
+        if (obj)
+            return static_cast<const osg::Node*>(obj.get());
+
+        const osg::Node* temp = mSceneManager->getTemplate(model);
+        osg::ref_ptr<osg::Group> prototype = new osg::Group;
+        prototype->addChild(static_cast<osg::Node*>(temp->clone(osg::CopyOp::DEEP_COPY_NODES|osg::CopyOp::DEEP_COPY_DRAWABLES|osg::CopyOp::DEEP_COPY_USERDATA|osg::CopyOp::DEEP_COPY_ARRAYS|osg::CopyOp::DEEP_COPY_PRIMITIVES)));
+
+        // Keep link to original mesh to keep it in cache
+        prototype->getOrCreateUserDataContainer()->addUserObject(new Resource::TemplateRef(temp));
+
+        PrepareInstancingVisitor visitor;
+        prototype->accept(visitor);
+
+        // Shaders are created once per model, the chunks share them along with the vertex data
+        prototype->setStateSet(mStateset);
+        mSceneManager->recreateShaders(prototype, "groundcover", true, mProgramTemplate);
+        mSceneManager->shareState(prototype);
+
+        mPrototypeCache->addEntryToObjectCache(model, prototype);
+        return prototype;
+    }
+
     void Groundcover::collectInstances(InstanceMap& instances, float size, const osg::Vec2f& center)
     {
         if (mDensity <=0.f) return;
@@ -223,30 +290,32 @@ namespace MWRender
     {
         osg::ref_ptr<osg::Group> group = new osg::Group;
         osg::Vec3f worldCenter = osg::Vec3f(center.x(), center.y(), 0)*ESM::Land::REAL_SIZE;
+        osg::ref_ptr<Resource::TemplateMultiRef> prototypeRefs = new Resource::TemplateMultiRef;
         for (auto& pair : instances)
         {
-            const osg::Node* temp = mSceneManager->getTemplate(pair.first);
-            osg::ref_ptr<osg::Node> node = static_cast<osg::Node*>(temp->clone(osg::CopyOp::DEEP_COPY_NODES|osg::CopyOp::DEEP_COPY_DRAWABLES|osg::CopyOp::DEEP_COPY_USERDATA|osg::CopyOp::DEEP_COPY_ARRAYS|osg::CopyOp::DEEP_COPY_PRIMITIVES));
+            osg::ref_ptr<const osg::Node> prototype = getPrototype(pair.first);
+
+            // Only nodes, drawables and primitive sets are copied, which is enough to set the number of instances and
+            // the per-instance attributes. Vertex data, state and shaders stay shared with the prototype.
+            osg::ref_ptr<osg::Node> node = static_cast<osg::Node*>(prototype->clone(osg::CopyOp::DEEP_COPY_NODES|osg::CopyOp::DEEP_COPY_DRAWABLES|osg::CopyOp::DEEP_COPY_PRIMITIVES));
 
-            // Keep link to original mesh to keep it in cache
-            group->getOrCreateUserDataContainer()->addUserObject(new Resource::TemplateRef(temp));
+            // Keep the prototype in cache while the chunk uses it
+            prototypeRefs->addRef(prototype);
 
             InstancingVisitor visitor(pair.second, worldCenter);
             node->accept(visitor);
             group->addChild(node);
         }
+        group->getOrCreateUserDataContainer()->addUserObject(prototypeRefs);
 
         osg::ComputeBoundsVisitor cbv;
         group->accept(cbv);
         osg::BoundingBox box = cbv.getBoundingBox();
         group->addCullCallback(new ViewDistanceCallback(getViewDistance(), box));
 
-        group->setStateSet(mStateset);
         group->setNodeMask(Mask_Groundcover);
         if (mSceneManager->getLightingMethod() != SceneUtil::LightingMethod::FFP)
             group->addCullCallback(new SceneUtil::LightListCallback);
-        mSceneManager->recreateShaders(group, "groundcover", true, mProgramTemplate);
-        mSceneManager->shareState(group);
         group->getBound();
         return group;
     }
@@ -259,5 +328,6 @@ namespace MWRender
     void Groundcover::reportStats(unsigned int frameNumber, osg::Stats *stats) const
     {
         stats->setAttribute(frameNumber, "Groundcover Chunk", mCache->getCacheSize());
+        stats->setAttribute(frameNumber, "Groundcover Prototype", mPrototypeCache->getCacheSize());
     }
 }
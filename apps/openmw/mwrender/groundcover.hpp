@@ -24,10 +24,14 @@ namespace MWRender
         Groundcover(Resource::SceneManager* sceneManager, float density, float viewDistance, const MWWorld::GroundcoverStore& store);
         ~Groundcover();
 
-        osg::ref_ptr<osg::Node> getChunk(float size, const osg::Vec2f& center, unsigned char lod, unsigned int lodFlags, bool activeGrid, const osg::Vec3f& viewPoint, bool compile) override;
+        osg::ref_ptr<osg::Node> getChunk(float size, const osg::Vec2f& center, unsigned char lod, unsigned int lodFlags, bool activeGrid, const osg::Vec3f& viewPoint, bool compile, const std::atomic<bool>* abort) override;
 
         unsigned int getNodeMask() override;
 
+        void updateCache(double referenceTime) override;
+
+        void clearCache() override;
+
         void reportStats(unsigned int frameNumber, osg::Stats* stats) const override;
 
         struct GroundcoverEntry
@@ -45,6 +49,10 @@ namespace MWRender
         osg::ref_ptr<osg::StateSet> mStateset;
         osg::ref_ptr<osg::Program> mProgramTemplate;
         const MWWorld::GroundcoverStore& mGroundcoverStore;
+        osg::ref_ptr<Resource::GenericObjectCache<std::string>> mPrototypeCache;
+
+        /// Copy of a groundcover model with shaders set up for instancing, shared by all chunks.
+        osg::ref_ptr<const osg::Node> getPrototype(const std::string& model);
 
         typedef std::map<std::string, std::vector<GroundcoverEntry>> InstanceMap;
         osg::ref_ptr<osg::Node> createChunk(InstanceMap& instances, const osg::Vec2f& center);
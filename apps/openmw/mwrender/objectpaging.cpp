@@ -1,5 +1,10 @@
 #include "objectpaging.hpp"
 
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <numeric>
+#include <sstream>
 #include <unordered_map>
 
 #include <osg/LOD>
@@ -12,10 +17,13 @@
 #include <components/esm3/esmreader.hpp>
 #include <components/misc/resourcehelpers.hpp>
 #include <components/resource/scenemanager.hpp>
+#include <components/resource/texturebudget.hpp>
 #include <components/sceneutil/optimizer.hpp>
 #include <components/sceneutil/positionattitudetransform.hpp>
 #include <components/sceneutil/clone.hpp>
 #include <components/sceneutil/util.hpp>
+#include <components/sceneutil/workqueue.hpp>
+#include <components/terrain/diskcache.hpp>
 #include <components/vfs/manager.hpp>
 #include <components/esm3/readerscache.hpp>
 
@@ -34,11 +42,17 @@
 #include "apps/openmw/mwbase/world.hpp"
 
 #include "vismask.hpp"
+#include "pagingcache.hpp"
 
 #include <condition_variable>
 
 namespace MWRender
 {
+    // Enough vertices to copy and merge per job to outweigh its overhead
+    constexpr std::size_t sMinBatchVertices = 20000;
+
+    // Bump when the merged geometry of a chunk changes in a way that invalidates previously cached chunks
+    constexpr unsigned int sDiskCacheVersion = 1;
 
     bool typeFilter(int type, bool far)
     {
@@ -73,7 +87,7 @@ namespace MWRender
         }
     }
 
-    osg::ref_ptr<osg::Node> ObjectPaging::getChunk(float size, const osg::Vec2f& center, unsigned char lod, unsigned int lodFlags, bool activeGrid, const osg::Vec3f& viewPoint, bool compile)
+    osg::ref_ptr<osg::Node> ObjectPaging::getChunk(float size, const osg::Vec2f& center, unsigned char lod, unsigned int lodFlags, bool activeGrid, const osg::Vec3f& viewPoint, bool compile, const std::atomic<bool>* abort)
     {
         if (activeGrid && !mActiveGrid)
             return nullptr;
@@ -85,8 +99,9 @@ namespace MWRender
             return static_cast<osg::Node*>(obj.get());
         else
         {
-            osg::ref_ptr<osg::Node> node = createChunk(size, center, activeGrid, viewPoint, compile);
-            mCache->addEntryToObjectCache(id, node.get());
+            osg::ref_ptr<osg::Node> node = createChunk(size, center, activeGrid, viewPoint, compile, abort);
+            if (node)
+                mCache->addEntryToObjectCache(id, node.get());
             return node;
         }
     }
@@ -181,6 +196,10 @@ namespace MWRender
         {
             for (const osg::Callback* callback = node->getCullCallback(); callback != nullptr; callback = callback->getNestedCallback())
             {
+                // Would keep the optimizer from merging the chunk, the finished chunk is tracked by the texture budget again
+                if (callback->className() == std::string("TextureUsageCallback"))
+                    continue;
+
                 if (callback->className() == std::string("BillboardCallback"))
                 {
                     if (mOptimizeBillboards)
@@ -397,9 +416,176 @@ namespace MWRender
         }
     };
 
+    class CellRefs : public osg::Object
+    {
+    public:
+        CellRefs(){}
+        CellRefs(const CellRefs& copy, const osg::CopyOp&) : mRefs(copy.mRefs), mDeleted(copy.mDeleted) {}
+        META_Object(MWRender, CellRefs)
+        std::map<ESM::RefNum, ESM::CellRef> mRefs;
+        // Also hide the references of the cells read before this one
+        std::vector<ESM::RefNum> mDeleted;
+    };
+
+    /// Part of a chunk that runs on the work queue, or on the thread waiting for it if no worker has started it yet,
+    /// so waiting never depends on other work items.
+    class ChunkJob : public SceneUtil::WorkItem
+    {
+    public:
+        ChunkJob(std::function<void()>&& function, const std::atomic<bool>* abort)
+            : mFunction(std::move(function))
+            , mAbort(abort)
+            , mStarted(false)
+            , mFinished(false)
+        {
+        }
+
+        void doWork() override
+        {
+            run();
+        }
+
+        void wait()
+        {
+            run();
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [&] { return mFinished; });
+            if (mException)
+                std::rethrow_exception(mException);
+        }
+
+    private:
+        void run()
+        {
+            if (mStarted.exchange(true))
+                return;
+            std::exception_ptr exception;
+            try
+            {
+                if (!mAbort || !*mAbort)
+                    mFunction();
+            }
+            catch (...)
+            {
+                exception = std::current_exception();
+            }
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mException = exception;
+                mFinished = true;
+            }
+            mCondition.notify_all();
+        }
+
+        std::function<void()> mFunction;
+        const std::atomic<bool>* mAbort;
+        std::atomic_bool mStarted;
+        bool mFinished;
+        std::exception_ptr mException;
+        std::mutex mMutex;
+        std::condition_variable mCondition;
+    };
+
+    void runJobs(SceneUtil::WorkQueue* workQueue, const std::vector<osg::ref_ptr<ChunkJob>>& jobs)
+    {
+        if (workQueue && jobs.size() > 1)
+        {
+            for (const auto& job : jobs)
+                workQueue->addWorkItem(job);
+        }
+        // Jobs reference locals of the caller, so all of them have to finish before an error leaves its scope.
+        std::exception_ptr exception;
+        for (const auto& job : jobs)
+        {
+            try
+            {
+                job->wait();
+            }
+            catch (...)
+            {
+                if (!exception)
+                    exception = std::current_exception();
+            }
+        }
+        if (exception)
+            std::rethrow_exception(exception);
+    }
+
+    osg::ref_ptr<CellRefs> readCellRefs(const ESM::Cell& cell, const MWWorld::ESMStore& store)
+    {
+        osg::ref_ptr<CellRefs> cellRefs = new CellRefs;
+        // Cells are read from the paging work queue threads, keep the content files open per thread
+        static thread_local ESM::ReadersCache readers;
+        for (size_t i=0; i<cell.mContextList.size(); ++i)
+        {
+            try
+            {
+                const std::size_t index = static_cast<std::size_t>(cell.mContextList[i].index);
+                const ESM::ReadersCache::BusyItem reader = readers.get(index);
+                cell.restore(*reader, i);
+                ESM::CellRef ref;
+                ref.mRefNum.unset();
+                ESM::MovedCellRef cMRef;
+                cMRef.mRefNum.mIndex = 0;
+                bool deleted = false;
+                bool moved = false;
+                while (ESM::Cell::getNextRef(*reader, ref, deleted, cMRef, moved, ESM::Cell::GetNextRefMode::LoadOnlyNotMoved))
+                {
+                    if (moved)
+                        continue;
+
+                    if (std::find(cell.mMovedRefs.begin(), cell.mMovedRefs.end(), ref.mRefNum) != cell.mMovedRefs.end())
+                        continue;
+
+                    Misc::StringUtils::lowerCaseInPlace(ref.mRefID);
+                    int type = store.findStatic(ref.mRefID);
+                    if (!typeFilter(type,false)) continue;
+                    if (deleted)
+                    {
+                        cellRefs->mRefs.erase(ref.mRefNum);
+                        cellRefs->mDeleted.push_back(ref.mRefNum);
+                        continue;
+                    }
+                    cellRefs->mRefs[ref.mRefNum] = std::move(ref);
+                }
+            }
+            catch (std::exception&)
+            {
+                continue;
+            }
+        }
+        for (auto [ref, deleted] : cell.mLeasedRefs)
+        {
+            if (deleted)
+            {
+                cellRefs->mRefs.erase(ref.mRefNum);
+                cellRefs->mDeleted.push_back(ref.mRefNum);
+                continue;
+            }
+            Misc::StringUtils::lowerCaseInPlace(ref.mRefID);
+            int type = store.findStatic(ref.mRefID);
+            if (!typeFilter(type,false)) continue;
+            cellRefs->mRefs[ref.mRefNum] = std::move(ref);
+        }
+        return cellRefs;
+    }
+
+    void optimizeMergeGroup(osg::Group& mergeGroup, float size, const osg::Vec3f& relativeViewPoint, unsigned int options)
+    {
+        SceneUtil::Optimizer optimizer;
+        if (size > 1/8.f)
+        {
+            optimizer.setViewPoint(relativeViewPoint);
+            optimizer.setMergeAlphaBlending(true);
+        }
+        optimizer.setIsOperationPermissibleForObjectCallback(new CanOptimizeCallback);
+        optimizer.optimize(&mergeGroup, options);
+    }
+
     ObjectPaging::ObjectPaging(Resource::SceneManager* sceneManager)
             : GenericResourceManager<ChunkId>(nullptr)
          , mSceneManager(sceneManager)
+         , mCellRefsCache(new Resource::GenericObjectCache<std::pair<int, int>>)
          , mRefTrackerLocked(false)
     {
         mActiveGrid = Settings::Manager::getBool("object paging active grid", "Terrain");
@@ -408,70 +594,84 @@ namespace MWRender
         mMinSize = Settings::Manager::getFloat("object paging min size", "Terrain");
         mMinSizeMergeFactor = Settings::Manager::getFloat("object paging min size merge factor", "Terrain");
         mMinSizeCostMultiplier = Settings::Manager::getFloat("object paging min size cost multiplier", "Terrain");
+
+        const int numThreads = Settings::Manager::getInt("object paging num threads", "Terrain");
+        if (numThreads > 0)
+            mWorkQueue = new SceneUtil::WorkQueue(numThreads);
+    }
+
+    ObjectPaging::~ObjectPaging() = default;
+
+    void ObjectPaging::updateCache(double referenceTime)
+    {
+        GenericResourceManager<ChunkId>::updateCache(referenceTime);
+
+        mCellRefsCache->updateTimeStampOfObjectsInCacheWithExternalReferences(referenceTime);
+        mCellRefsCache->removeExpiredObjectsInCache(referenceTime - mExpiryDelay);
+    }
+
+    void ObjectPaging::clearCache()
+    {
+        GenericResourceManager<ChunkId>::clearCache();
+
+        mCellRefsCache->clear();
+    }
+
+    void ObjectPaging::setDiskCache(Terrain::DiskCache* diskCache)
+    {
+        mDiskCache = diskCache;
     }
 
-    osg::ref_ptr<osg::Node> ObjectPaging::createChunk(float size, const osg::Vec2f& center, bool activeGrid, const osg::Vec3f& viewPoint, bool compile)
+    osg::ref_ptr<const CellRefs> ObjectPaging::getCellRefs(const ESM::Cell& cell)
+    {
+        const std::pair<int, int> key(cell.getGridX(), cell.getGridY());
+        osg::ref_ptr<osg::Object> obj = mCellRefsCache->getRefFromObjectCache(key);
+        if (obj)
+            return static_cast<const CellRefs*>(obj.get());
+
+        osg::ref_ptr<CellRefs> cellRefs = readCellRefs(cell, MWBase::Environment::get().getWorld()->getStore());
+        mCellRefsCache->addEntryToObjectCache(key, cellRefs);
+        return cellRefs;
+    }
+
+    osg::ref_ptr<osg::Node> ObjectPaging::createChunk(float size, const osg::Vec2f& center, bool activeGrid, const osg::Vec3f& viewPoint, bool compile, const std::atomic<bool>* abort)
     {
         osg::Vec2i startCell = osg::Vec2i(std::floor(center.x() - size/2.f), std::floor(center.y() - size/2.f));
 
         osg::Vec3f worldCenter = osg::Vec3f(center.x(), center.y(), 0)*ESM::Land::REAL_SIZE;
         osg::Vec3f relativeViewPoint = viewPoint - worldCenter;
 
-        std::map<ESM::RefNum, ESM::CellRef> refs;
-        ESM::ReadersCache readers;
         const MWWorld::ESMStore& store = MWBase::Environment::get().getWorld()->getStore();
 
+        // Read the references of each cell in parallel
+        std::vector<osg::ref_ptr<const CellRefs>> cellRefs;
+        std::vector<osg::ref_ptr<ChunkJob>> jobs;
         for (int cellX = startCell.x(); cellX < startCell.x() + size; ++cellX)
         {
             for (int cellY = startCell.y(); cellY < startCell.y() + size; ++cellY)
             {
                 const ESM::Cell* cell = store.get<ESM::Cell>().searchStatic(cellX, cellY);
                 if (!cell) continue;
-                for (size_t i=0; i<cell->mContextList.size(); ++i)
-                {
-                    try
-                    {
-                        const std::size_t index = static_cast<std::size_t>(cell->mContextList[i].index);
-                        const ESM::ReadersCache::BusyItem reader = readers.get(index);
-                        cell->restore(*reader, i);
-                        ESM::CellRef ref;
-                        ref.mRefNum.unset();
-                        ESM::MovedCellRef cMRef;
-                        cMRef.mRefNum.mIndex = 0;
-                        bool deleted = false;
-                        bool moved = false;
-                        while (ESM::Cell::getNextRef(*reader, ref, deleted, cMRef, moved, ESM::Cell::GetNextRefMode::LoadOnlyNotMoved))
-                        {
-                            if (moved)
-                                continue;
-
-                            if (std::find(cell->mMovedRefs.begin(), cell->mMovedRefs.end(), ref.mRefNum) != cell->mMovedRefs.end())
-                                continue;
+                const std::size_t index = cellRefs.size();
+                cellRefs.emplace_back();
+                jobs.push_back(new ChunkJob([this, cell, index, &cellRefs] { cellRefs[index] = getCellRefs(*cell); }, abort));
+            }
+        }
+        runJobs(mWorkQueue, jobs);
+        jobs.clear();
+        if (abort && *abort)
+            return nullptr;
 
-                            Misc::StringUtils::lowerCaseInPlace(ref.mRefID);
-                            int type = store.findStatic(ref.mRefID);
-                            if (!typeFilter(type,size>=2)) continue;
-                            if (deleted) { refs.erase(ref.mRefNum); continue; }
-                            refs[ref.mRefNum] = std::move(ref);
-                        }
-                    }
-                    catch (std::exception&)
-                    {
-                        continue;
-                    }
-                }
-                for (auto [ref, deleted] : cell->mLeasedRefs)
-                {
-                    if (deleted)
-                    {
-                        refs.erase(ref.mRefNum);
-                        continue;
-                    }
-                    Misc::StringUtils::lowerCaseInPlace(ref.mRefID);
-                    int type = store.findStatic(ref.mRefID);
-                    if (!typeFilter(type,size>=2)) continue;
-                    refs[ref.mRefNum] = std::move(ref);
-                }
+        const bool far = size >= 2;
+        std::map<ESM::RefNum, const ESM::CellRef*> refs;
+        for (const osg::ref_ptr<const CellRefs>& cell : cellRefs)
+        {
+            for (const ESM::RefNum& refNum : cell->mDeleted)
+                refs.erase(refNum);
+            for (const auto& [refNum, ref] : cell->mRefs)
+            {
+                if (far && !typeFilter(store.findStatic(ref.mRefID), far)) continue;
+                refs[refNum] = &ref;
             }
         }
 
@@ -486,6 +686,7 @@ namespace MWRender
         osg::Vec2f maxBound = (center + osg::Vec2f(size/2.f, size/2.f));
         struct InstanceList
         {
+            std::string mModel;
             std::vector<const ESM::CellRef*> mInstances;
             AnalyzeVisitor::Result mAnalyzeResult;
             bool mNeedCompile = false;
@@ -507,8 +708,7 @@ namespace MWRender
             minSize *= mMinSizeMergeFactor;
         for (const auto& pair : refs)
         {
-            const ESM::CellRef& ref = pair.second;
-
+            const ESM::CellRef& ref = *pair.second;
             osg::Vec3f pos = ref.mPos.asVec3();
             if (size < 1.f)
             {
@@ -574,6 +774,7 @@ namespace MWRender
             auto emplaced = nodes.emplace(cnode, InstanceList());
             if (emplaced.second)
             {
+                emplaced.first->second.mModel = model;
                 const_cast<osg::Node*>(cnode.get())->accept(analyzeVisitor); // const-trickery required because there is no const version of NodeVisitor
                 emplaced.first->second.mAnalyzeResult = analyzeVisitor.retrieveResult();
                 emplaced.first->second.mNeedCompile = compile && cnode->referenceCount() <= 3;
@@ -583,17 +784,22 @@ namespace MWRender
             emplaced.first->second.mInstances.push_back(&ref);
         }
 
-        osg::ref_ptr<osg::Group> group = new osg::Group;
-        osg::ref_ptr<osg::Group> mergeGroup = new osg::Group;
-        osg::ref_ptr<Resource::TemplateMultiRef> templateRefs = new Resource::TemplateMultiRef;
-        osgUtil::StateToCompile stateToCompile(0, nullptr);
-        CopyOp copyop;
-        copyop.mCopyMask = copyMask;
-        for (const auto& pair : nodes)
+        struct Batch
         {
-            const osg::Node* cnode = pair.first;
+            std::vector<NodeMap::const_iterator> mTemplates;
+            std::vector<bool> mMerge;
+            std::vector<std::vector<const ESM::CellRef*>> mInstances;
+            std::vector<unsigned int> mNumInstances;
+            osg::ref_ptr<osg::Group> mGroup = new osg::Group;
+            osg::ref_ptr<osg::Group> mMergeGroup = new osg::Group;
+        };
 
-            const AnalyzeVisitor::Result& analyzeResult = pair.second.mAnalyzeResult;
+        // Copy the instances of a few templates per batch, flattening and merging each batch on its own
+        std::vector<Batch> batches(1);
+        std::size_t batchVertices = 0;
+        for (auto it = nodes.cbegin(); it != nodes.cend(); ++it)
+        {
+            const AnalyzeVisitor::Result& analyzeResult = it->second.mAnalyzeResult;
 
             float mergeCost = analyzeResult.mNumVerts * size;
             float mergeBenefit = analyzeVisitor.getMergeBenefit(analyzeResult) * mMergeFactor;
@@ -605,81 +811,204 @@ namespace MWRender
             if (minSizeMergeFactor2 > 0)
                 minSizeMerged *= minSizeMergeFactor2;
 
-            unsigned int numinstances = 0;
-            for (auto cref : pair.second.mInstances)
+            std::vector<const ESM::CellRef*> instances;
+            for (const ESM::CellRef* cref : it->second.mInstances)
             {
-                const ESM::CellRef& ref = *cref;
-                osg::Vec3f pos = ref.mPos.asVec3();
-
-                if (!activeGrid && minSizeMerged != minSize && cnode->getBound().radius2() * cref->mScale*cref->mScale < (viewPoint-pos).length2()*minSizeMerged*minSizeMerged)
+                if (!activeGrid && minSizeMerged != minSize && it->first->getBound().radius2() * cref->mScale*cref->mScale < (viewPoint-cref->mPos.asVec3()).length2()*minSizeMerged*minSizeMerged)
                     continue;
+                instances.push_back(cref);
+            }
+            if (instances.empty())
+                continue;
+
+            if (batchVertices >= sMinBatchVertices)
+            {
+                batches.emplace_back();
+                batchVertices = 0;
+            }
+            Batch& batch = batches.back();
+            batchVertices += analyzeResult.mNumVerts * instances.size();
+            batch.mTemplates.push_back(it);
+            batch.mMerge.push_back(merge);
+            batch.mInstances.push_back(std::move(instances));
+            batch.mNumInstances.push_back(0);
+        }
 
-                osg::Vec3f nodePos = pos - worldCenter;
-                osg::Quat nodeAttitude = osg::Quat(ref.mPos.rot[2], osg::Vec3f(0,0,-1)) *
-                                        osg::Quat(ref.mPos.rot[1], osg::Vec3f(0,-1,0)) *
-                                        osg::Quat(ref.mPos.rot[0], osg::Vec3f(-1,0,0));
-                osg::Vec3f nodeScale = osg::Vec3f(ref.mScale, ref.mScale, ref.mScale);
+        // The merged geometry only depends on the merged instances, so look it up in the disk cache by them
+        std::vector<const osg::Node*> mergedTemplates;
+        std::string cacheFileName;
+        osg::ref_ptr<osg::Group> cachedMergeGroup;
+        bool writeCache = false;
+        if (mDiskCache && !activeGrid)
+        {
+            std::vector<std::pair<const std::string*, const Batch*>> merged;
+            std::vector<std::size_t> mergedIndices;
+            for (const Batch& batch : batches)
+            {
+                for (std::size_t i = 0; i < batch.mTemplates.size(); ++i)
+                {
+                    if (batch.mMerge[i])
+                    {
+                        merged.emplace_back(&batch.mTemplates[i]->second.mModel, &batch);
+                        mergedIndices.push_back(i);
+                    }
+                }
+            }
 
-                osg::ref_ptr<osg::Group> trans;
-                if (merge)
+            if (!merged.empty())
+            {
+                // Templates are ordered by model, so the key and state set references do not depend on where templates are in memory
+                std::vector<std::size_t> order(merged.size());
+                std::iota(order.begin(), order.end(), 0);
+                std::sort(order.begin(), order.end(), [&] (std::size_t lhs, std::size_t rhs) { return *merged[lhs].first < *merged[rhs].first; });
+
+                std::ostringstream key;
+                key << "objectpaging " << sDiskCacheVersion << ' ' << center.x() << ' ' << center.y() << ' ' << size;
+                for (std::size_t index : order)
                 {
-                    // Optimizer currently supports only MatrixTransforms.
-                    osg::Matrixf matrix;
-                    matrix.preMultTranslate(nodePos);
-                    matrix.preMultRotate(nodeAttitude);
-                    matrix.preMultScale(nodeScale);
-                    trans = new osg::MatrixTransform(matrix);
-                    trans->setDataVariance(osg::Object::STATIC);
+                    const Batch& batch = *merged[index].second;
+                    const std::size_t i = mergedIndices[index];
+                    mergedTemplates.push_back(batch.mTemplates[i]->first);
+                    key << '\n' << *merged[index].first;
+                    for (const ESM::CellRef* ref : batch.mInstances[i])
+                    {
+                        key << ' ' << ref->mRefNum.mIndex << ' ' << ref->mRefNum.mContentFile << ' ';
+                        key.write(reinterpret_cast<const char*>(&ref->mPos), sizeof(ref->mPos));
+                        key.write(reinterpret_cast<const char*>(&ref->mScale), sizeof(ref->mScale));
+                    }
                 }
-                else
+
+                cacheFileName = mDiskCache->getFileName(key.str(), ".chunk");
+                std::string data;
+                if (!mDiskCache->read(cacheFileName, data))
+                    writeCache = true;
+                else if (!data.empty()) // An empty file records a chunk that could not be cached
                 {
-                    trans = new SceneUtil::PositionAttitudeTransform;
-                    SceneUtil::PositionAttitudeTransform* pat = static_cast<SceneUtil::PositionAttitudeTransform*>(trans.get());
-                    pat->setPosition(nodePos);
-                    pat->setScale(nodeScale);
-                    pat->setAttitude(nodeAttitude);
+                    cachedMergeGroup = deserializeMergedChunk(data, mergedTemplates);
+                    writeCache = !cachedMergeGroup;
                 }
+            }
+        }
 
-                // DO NOT COPY AND PASTE THIS CODE. Cloning osg::Geometry without also cloning its contained Arrays is generally unsafe.
-                // In this specific case the operation is safe under the following two assumptions:
-                // - When Arrays are removed or replaced in the cloned geometry, the original Arrays in their place must outlive the cloned geometry regardless. (ensured by TemplateMultiRef)
-                // - Arrays that we add or replace in the cloned geometry must be explicitely forbidden from reusing BufferObjects of the original geometry. (ensured by needvbo() in optimizer.cpp)
-                copyop.setCopyFlags(merge ? osg::CopyOp::DEEP_COPY_NODES|osg::CopyOp::DEEP_COPY_DRAWABLES : osg::CopyOp::DEEP_COPY_NODES);
-                copyop.mOptimizeBillboards = (size > 1/4.f);
-                copyop.mNodePath.push_back(trans);
-                copyop.mSqrDistance = (viewPoint - pos).length2();
-                copyop.mViewVector = (viewPoint - worldCenter);
-                copyop.copy(cnode, trans);
-                copyop.mNodePath.pop_back();
-
-                if (activeGrid)
+        for (Batch& batch : batches)
+        {
+            jobs.push_back(new ChunkJob([&] ()
+            {
+                CopyOp copyop;
+                copyop.mCopyMask = copyMask;
+                for (std::size_t i = 0; i < batch.mTemplates.size(); ++i)
                 {
-                    if (merge)
+                    const osg::Node* cnode = batch.mTemplates[i]->first;
+                    const bool merge = batch.mMerge[i];
+
+                    if (merge && cachedMergeGroup)
                     {
-                        AddRefnumMarkerVisitor visitor(ref.mRefNum);
-                        trans->accept(visitor);
+                        // Already part of the cached merged geometry
+                        batch.mNumInstances[i] = batch.mInstances[i].size();
+                        continue;
                     }
-                    else
+
+                    unsigned int numinstances = 0;
+                    for (auto cref : batch.mInstances[i])
                     {
-                        osg::ref_ptr<RefnumMarker> marker = new RefnumMarker; marker->mRefnum = ref.mRefNum;
-                        trans->getOrCreateUserDataContainer()->addUserObject(marker);
+                        const ESM::CellRef& ref = *cref;
+                        osg::Vec3f pos = ref.mPos.asVec3();
+
+                        osg::Vec3f nodePos = pos - worldCenter;
+                        osg::Quat nodeAttitude = osg::Quat(ref.mPos.rot[2], osg::Vec3f(0,0,-1)) *
+                                                osg::Quat(ref.mPos.rot[1], osg::Vec3f(0,-1,0)) *
+                                                osg::Quat(ref.mPos.rot[0], osg::Vec3f(-1,0,0));
+                        osg::Vec3f nodeScale = osg::Vec3f(ref.mScale, ref.mScale, ref.mScale);
+
+                        osg::ref_ptr<osg::Group> trans;
+                        if (merge)
+                        {
+                            // Optimizer currently supports only MatrixTransforms.
+                            osg::Matrixf matrix;
+                            matrix.preMultTranslate(nodePos);
+                            matrix.preMultRotate(nodeAttitude);
+                            matrix.preMultScale(nodeScale);
+                            trans = new osg::MatrixTransform(matrix);
+                            trans->setDataVariance(osg::Object::STATIC);
+                        }
+                        else
+                        {
+                            trans = new SceneUtil::PositionAttitudeTransform;
+                            SceneUtil::PositionAttitudeTransform* pat = static_cast<SceneUtil::PositionAttitudeTransform*>(trans.get());
+                            pat->setPosition(nodePos);
+                            pat->setScale(nodeScale);
+                            pat->setAttitude(nodeAttitude);
+                        }
+
+                        // DO NOT COPY AND PASTE THIS CODE. Cloning osg::Geometry without also cloning its contained Arrays is generally unsafe.
+                        // In this specific case the operation is safe under the following two assumptions:
+                        // - When Arrays are removed or replaced in the cloned geometry, the original Arrays in their place must outlive the cloned geometry regardless. (ensured by TemplateMultiRef)
+                        // - Arrays that we add or replace in the cloned geometry must be explicitely forbidden from reusing BufferObjects of the original geometry. (ensured by needvbo() in optimizer.cpp)
+                        copyop.setCopyFlags(merge ? osg::CopyOp::DEEP_COPY_NODES|osg::CopyOp::DEEP_COPY_DRAWABLES : osg::CopyOp::DEEP_COPY_NODES);
+                        copyop.mOptimizeBillboards = (size > 1/4.f);
+                        copyop.mNodePath.push_back(trans);
+                        copyop.mSqrDistance = (viewPoint - pos).length2();
+                        copyop.mViewVector = (viewPoint - worldCenter);
+                        copyop.copy(cnode, trans);
+                        copyop.mNodePath.pop_back();
+
+                        if (activeGrid)
+                        {
+                            if (merge)
+                            {
+                                AddRefnumMarkerVisitor visitor(ref.mRefNum);
+                                trans->accept(visitor);
+                            }
+                            else
+                            {
+                                osg::ref_ptr<RefnumMarker> marker = new RefnumMarker; marker->mRefnum = ref.mRefNum;
+                                trans->getOrCreateUserDataContainer()->addUserObject(marker);
+                            }
+                        }
+
+                        osg::Group* attachTo = merge ? batch.mMergeGroup : batch.mGroup;
+                        attachTo->addChild(trans);
+                        ++numinstances;
                     }
+                    batch.mNumInstances[i] = numinstances;
                 }
 
-                osg::Group* attachTo = merge ? mergeGroup : group;
-                attachTo->addChild(trans);
-                ++numinstances;
-            }
-            if (numinstances > 0)
+                if (batch.mMergeGroup->getNumChildren())
+                    optimizeMergeGroup(*batch.mMergeGroup, size, relativeViewPoint,
+                        SceneUtil::Optimizer::FLATTEN_STATIC_TRANSFORMS|SceneUtil::Optimizer::REMOVE_REDUNDANT_NODES|SceneUtil::Optimizer::MERGE_GEOMETRY);
+            }, abort));
+        }
+        runJobs(mWorkQueue, jobs);
+        jobs.clear();
+        if (abort && *abort)
+            return nullptr;
+
+        osg::ref_ptr<osg::Group> group = new osg::Group;
+        osg::ref_ptr<osg::Group> mergeGroup = cachedMergeGroup ? cachedMergeGroup : osg::ref_ptr<osg::Group>(new osg::Group);
+        osg::ref_ptr<Resource::TemplateMultiRef> templateRefs = new Resource::TemplateMultiRef;
+        osgUtil::StateToCompile stateToCompile(0, nullptr);
+        for (const Batch& batch : batches)
+        {
+            for (unsigned int i = 0; i < batch.mGroup->getNumChildren(); ++i)
+                group->addChild(batch.mGroup->getChild(i));
+            for (unsigned int i = 0; i < batch.mMergeGroup->getNumChildren(); ++i)
+                mergeGroup->addChild(batch.mMergeGroup->getChild(i));
+
+            for (std::size_t i = 0; i < batch.mTemplates.size(); ++i)
             {
+                if (batch.mNumInstances[i] == 0)
+                    continue;
+
+                const osg::Node* cnode = batch.mTemplates[i]->first;
+
                 // add a ref to the original template to help verify the safety of shallow cloning operations
                 // in addition, we hint to the cache that it's still being used and should be kept in cache
                 templateRefs->addRef(cnode);
 
-                if (pair.second.mNeedCompile)
+                if (batch.mTemplates[i]->second.mNeedCompile)
                 {
                     int mode = osgUtil::GLObjectsVisitor::COMPILE_STATE_ATTRIBUTES;
-                    if (!merge)
+                    if (!batch.mMerge[i])
                         mode |= osgUtil::GLObjectsVisitor::COMPILE_DISPLAY_LISTS;
                     stateToCompile._mode = mode;
                     const_cast<osg::Node*>(cnode)->accept(stateToCompile);
@@ -689,16 +1018,18 @@ namespace MWRender
 
         if (mergeGroup->getNumChildren())
         {
-            SceneUtil::Optimizer optimizer;
-            if (size > 1/8.f)
+            // Batches are already flattened, so only geometry sharing state across batches is left to merge
+            if (batches.size() > 1 && !cachedMergeGroup)
+                optimizeMergeGroup(*mergeGroup, size, relativeViewPoint,
+                    SceneUtil::Optimizer::REMOVE_REDUNDANT_NODES|SceneUtil::Optimizer::MERGE_GEOMETRY);
+
+            if (writeCache)
             {
-                optimizer.setViewPoint(relativeViewPoint);
-                optimizer.setMergeAlphaBlending(true);
+                std::string data;
+                if (!serializeMergedChunk(*mergeGroup, mergedTemplates, data))
+                    data.clear();
+                mDiskCache->write(cacheFileName, std::move(data));
             }
-            optimizer.setIsOperationPermissibleForObjectCallback(new CanOptimizeCallback);
-            unsigned int options = SceneUtil::Optimizer::FLATTEN_STATIC_TRANSFORMS|SceneUtil::Optimizer::REMOVE_REDUNDANT_NODES|SceneUtil::Optimizer::MERGE_GEOMETRY;
-
-            optimizer.optimize(mergeGroup, options);
 
             group->addChild(mergeGroup);
 
@@ -722,6 +1053,8 @@ namespace MWRender
             ico->add(compileSet, false);
         }
 
+        mSceneManager->getTextureBudget().track(group);
+
         group->getBound();
         group->setNodeMask(Mask_Static);
         osg::UserDataContainer* udc = group->getOrCreateUserDataContainer();
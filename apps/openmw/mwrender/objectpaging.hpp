@@ -5,12 +5,21 @@
 #include <components/resource/resourcemanager.hpp>
 #include <components/esm3/loadcell.hpp>
 
+#include <atomic>
 #include <mutex>
 
 namespace Resource
 {
     class SceneManager;
 }
+namespace SceneUtil
+{
+    class WorkQueue;
+}
+namespace Terrain
+{
+    class DiskCache;
+}
 namespace MWWorld
 {
     class ESMStore;
@@ -21,15 +30,26 @@ namespace MWRender
 
     typedef std::tuple<osg::Vec2f, float, bool> ChunkId; // Center, Size, ActiveGrid
 
+    class CellRefs;
+
     class ObjectPaging : public Resource::GenericResourceManager<ChunkId>, public Terrain::QuadTreeWorld::ChunkManager
     {
     public:
         ObjectPaging(Resource::SceneManager* sceneManager);
-        ~ObjectPaging() = default;
+        ~ObjectPaging();
 
-        osg::ref_ptr<osg::Node> getChunk(float size, const osg::Vec2f& center, unsigned char lod, unsigned int lodFlags, bool activeGrid, const osg::Vec3f& viewPoint, bool compile) override;
+        osg::ref_ptr<osg::Node> getChunk(float size, const osg::Vec2f& center, unsigned char lod, unsigned int lodFlags, bool activeGrid, const osg::Vec3f& viewPoint, bool compile, const std::atomic<bool>* abort) override;
 
-        osg::ref_ptr<osg::Node> createChunk(float size, const osg::Vec2f& center, bool activeGrid, const osg::Vec3f& viewPoint, bool compile);
+        /// Build the chunk in parts, running them on the object paging work queue when there is one.
+        /// @return nullptr if aborted.
+        osg::ref_ptr<osg::Node> createChunk(float size, const osg::Vec2f& center, bool activeGrid, const osg::Vec3f& viewPoint, bool compile, const std::atomic<bool>* abort);
+
+        void updateCache(double referenceTime) override;
+
+        void clearCache() override;
+
+        /// Load the merged geometry of chunks from this cache when possible, and store newly merged geometry in it.
+        void setDiskCache(Terrain::DiskCache* diskCache);
 
         unsigned int getNodeMask() override;
 
@@ -50,7 +70,13 @@ namespace MWRender
         void getPagedRefnums(const osg::Vec4i &activeGrid, std::set<ESM::RefNum> &out);
 
     private:
+        /// References of a cell, read once and shared by all chunks containing the cell.
+        osg::ref_ptr<const CellRefs> getCellRefs(const ESM::Cell& cell);
+
         Resource::SceneManager* mSceneManager;
+        osg::ref_ptr<SceneUtil::WorkQueue> mWorkQueue;
+        osg::ref_ptr<Terrain::DiskCache> mDiskCache;
+        osg::ref_ptr<Resource::GenericObjectCache<std::pair<int, int>>> mCellRefsCache;
         bool mActiveGrid;
         bool mDebugBatches;
         float mMergeFactor;
@@ -43,6 +43,7 @@ void Objects::insertBegin(const MWWorld::Ptr& ptr)
     {
         cellnode = new osg::Group;
         cellnode->setName("Cell Root");
+        cellnode->setCullCallback(mCellCullCallback);
         mRootNode->addChild(cellnode);
         mCellSceneNodes[ptr.getCell()] = cellnode;
     }
@@ -162,6 +163,13 @@ void Objects::removeCell(const MWWorld::CellStore* store)
     }
 }
 
+void Objects::setCellCullCallback(osg::Callback* callback)
+{
+    mCellCullCallback = callback;
+    for (const auto& [cell, node] : mCellSceneNodes)
+        node->setCullCallback(callback);
+}
+
 void Objects::updatePtr(const MWWorld::Ptr &old, const MWWorld::Ptr &cur)
 {
     osg::ref_ptr<osg::Node> objectNode = cur.getRefData().getBaseNode();
@@ -11,6 +11,7 @@
 
 namespace osg
 {
+    class Callback;
     class Group;
 }
 
@@ -59,6 +60,7 @@ class Objects
     PtrAnimationMap mObjects;
 
     osg::ref_ptr<osg::Group> mRootNode;
+    osg::ref_ptr<osg::Callback> mCellCullCallback;
 
     Resource::ResourceSystem* mResourceSystem;
 
@@ -83,6 +85,9 @@ public:
 
     void removeCell(const MWWorld::CellStore* store);
 
+    /// Set a cull callback on the scene node of each cell, e.g. to cull its objects.
+    void setCellCullCallback(osg::Callback* callback);
+
     /// Updates containing cell for object rendering data
     void updatePtr(const MWWorld::Ptr &old, const MWWorld::Ptr &cur);
 
@@ -0,0 +1,367 @@
+#include "occlusionculling.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#include <osg/BlendFunc>
+#include <osg/Camera>
+#include <osg/Geometry>
+#include <osg/LOD>
+#include <osg/Sequence>
+#include <osg/Stats>
+#include <osg/Switch>
+#include <osg/TriangleIndexFunctor>
+#include <osg/Viewport>
+
+#include <osgUtil/CullVisitor>
+
+#include <components/debug/debuglog.hpp>
+#include <components/esm3/loadland.hpp>
+#include <components/esm3/loadstat.hpp>
+#include <components/misc/resourcehelpers.hpp>
+#include <components/resource/scenemanager.hpp>
+#include <components/sceneutil/nodecallback.hpp>
+#include <components/stereo/stereomanager.hpp>
+
+#include "../mwworld/cellstore.hpp"
+#include "../mwworld/ptr.hpp"
+
+#include "terrainstorage.hpp"
+
+namespace MWRender
+{
+    namespace
+    {
+        // Larger meshes take too long to rasterize for what they hide
+        constexpr std::size_t sMaxOccluderTriangles = 4096;
+
+        // Land vertices per terrain occluder vertex
+        constexpr int sTerrainStep = 4;
+
+        bool isSeeThrough(const osg::StateSet* stateset)
+        {
+            if (!stateset)
+                return false;
+            return stateset->getRenderingHint() == osg::StateSet::TRANSPARENT_BIN
+                || stateset->getAttribute(osg::StateAttribute::BLENDFUNC) != nullptr
+                || stateset->getAttribute(osg::StateAttribute::ALPHAFUNC) != nullptr
+                || (stateset->getMode(GL_BLEND) & osg::StateAttribute::ON);
+        }
+
+        struct CollectTriangles
+        {
+            std::vector<unsigned int>* mIndices = nullptr;
+            unsigned int mNumVertices = 0;
+            unsigned int mOffset = 0;
+
+            void operator()(unsigned int i1, unsigned int i2, unsigned int i3)
+            {
+                if (i1 >= mNumVertices || i2 >= mNumVertices || i3 >= mNumVertices)
+                    return;
+                mIndices->push_back(mOffset + i1);
+                mIndices->push_back(mOffset + i2);
+                mIndices->push_back(mOffset + i3);
+            }
+        };
+
+        /// Collects the opaque, static triangles of a scene graph in the space of its root.
+        class CollectOccluderVisitor : public osg::NodeVisitor
+        {
+        public:
+            CollectOccluderVisitor()
+                : osg::NodeVisitor(TRAVERSE_ACTIVE_CHILDREN)
+            {
+            }
+
+            void apply(osg::Node& node) override
+            {
+                if (isSeeThrough(node.getStateSet()))
+                    return;
+                traverse(node);
+            }
+
+            // The visible child may change, and a lower detail level could be larger than what is rendered
+            void apply(osg::Switch&) override {}
+            void apply(osg::LOD&) override {}
+            void apply(osg::Sequence&) override {}
+
+            void apply(osg::Geometry& geometry) override
+            {
+                if (isSeeThrough(geometry.getStateSet()))
+                    return;
+
+                const osg::Vec3Array* vertices = dynamic_cast<const osg::Vec3Array*>(geometry.getVertexArray());
+                if (!vertices || vertices->empty())
+                    return;
+
+                const osg::Matrixf matrix = osg::computeLocalToWorld(getNodePath());
+
+                osg::TriangleIndexFunctor<CollectTriangles> functor;
+                functor.mIndices = &mMesh.mIndices;
+                functor.mNumVertices = static_cast<unsigned int>(vertices->size());
+                functor.mOffset = static_cast<unsigned int>(mMesh.mVertices.size());
+                geometry.accept(functor);
+
+                for (const osg::Vec3f& vertex : *vertices)
+                    mMesh.mVertices.push_back(vertex * matrix);
+            }
+
+            SceneUtil::OccluderMesh mMesh;
+        };
+    }
+
+    class CellOcclusionCallback : public SceneUtil::NodeCallback<CellOcclusionCallback, osg::Group*, osgUtil::CullVisitor*>
+    {
+    public:
+        CellOcclusionCallback(OcclusionCulling* occlusionCulling)
+            : mOcclusionCulling(occlusionCulling)
+        {
+        }
+
+        void operator()(osg::Group* group, osgUtil::CullVisitor* cv)
+        {
+            const SceneUtil::OcclusionBuffer* buffer = mOcclusionCulling->getBuffer(cv);
+            if (!buffer)
+            {
+                traverse(group, cv);
+                return;
+            }
+
+            for (unsigned int i = 0; i < group->getNumChildren(); ++i)
+            {
+                osg::Node* child = group->getChild(i);
+                const osg::BoundingSphere& bound = child->getBound();
+                if (bound.valid())
+                {
+                    osg::BoundingBox box;
+                    box.expandBy(bound);
+                    const bool culled = buffer->isOccluded(box);
+                    mOcclusionCulling->countTest(culled);
+                    if (culled)
+                        continue;
+                }
+                child->accept(*cv);
+            }
+        }
+
+    private:
+        OcclusionCulling* mOcclusionCulling;
+    };
+
+    OcclusionCulling::OcclusionCulling(Resource::SceneManager* sceneManager, TerrainStorage* terrainStorage, osg::Camera* camera, int bufferWidth, float minOccluderSize)
+        : mSceneManager(sceneManager)
+        , mTerrainStorage(terrainStorage)
+        , mCamera(camera)
+        , mBufferWidth(std::max(bufferWidth, SceneUtil::OcclusionBuffer::sTileSize))
+        , mMinOccluderSize(minOccluderSize)
+        , mBufferFrame(std::numeric_limits<unsigned int>::max())
+        , mNumOccluders(0)
+        , mTested(0)
+        , mCulled(0)
+        , mLastTested(0)
+        , mLastCulled(0)
+        , mLastOccluders(0)
+        , mCellCullCallback(new CellOcclusionCallback(this))
+    {
+    }
+
+    OcclusionCulling::~OcclusionCulling() = default;
+
+    void OcclusionCulling::addCell(const MWWorld::CellStore* store)
+    {
+        std::map<const MWWorld::LiveCellRefBase*, Occluder> occluders;
+        for (const auto& ref : store->getReadOnlyStatics().mList)
+        {
+            if (!ref.mData.isEnabled() || ref.mData.isDeleted() || ref.mData.getCount() <= 0)
+                continue;
+            if (Misc::ResourceHelpers::isHiddenMarker(ref.mBase->mId))
+                continue;
+
+            const OccluderTemplate& occluderTemplate = getOccluderTemplate(ref.mBase->mModel);
+            const float scale = ref.mRef.getScale();
+            if (!occluderTemplate.mMesh || occluderTemplate.mRadius * scale < mMinOccluderSize)
+                continue;
+
+            const ESM::Position& pos = ref.mData.getPosition();
+            const osg::Quat attitude = osg::Quat(pos.rot[2], osg::Vec3f(0, 0, -1))
+                * osg::Quat(pos.rot[1], osg::Vec3f(0, -1, 0))
+                * osg::Quat(pos.rot[0], osg::Vec3f(-1, 0, 0));
+
+            Occluder occluder;
+            occluder.mMesh = occluderTemplate.mMesh;
+            occluder.mMatrix.preMultTranslate(pos.asVec3());
+            occluder.mMatrix.preMultRotate(attitude);
+            occluder.mMatrix.preMultScale(osg::Vec3f(scale, scale, scale));
+            occluders.emplace(&ref, std::move(occluder));
+        }
+
+        Occluder terrain;
+        if (store->getCell()->isExterior())
+        {
+            const int cellX = store->getCell()->getGridX();
+            const int cellY = store->getCell()->getGridY();
+            terrain.mMesh = createTerrainMesh(cellX, cellY);
+            terrain.mMatrix.makeTranslate(cellX * ESM::Land::REAL_SIZE, cellY * ESM::Land::REAL_SIZE, 0);
+        }
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        mOccluders[store] = std::move(occluders);
+        if (terrain.mMesh)
+            mTerrainOccluders[store] = std::move(terrain);
+    }
+
+    void OcclusionCulling::removeCell(const MWWorld::CellStore* store)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mOccluders.erase(store);
+        mTerrainOccluders.erase(store);
+    }
+
+    void OcclusionCulling::removeObject(const MWWorld::Ptr& ptr)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto found = mOccluders.find(ptr.getCell());
+        if (found != mOccluders.end())
+            found->second.erase(ptr.getBase());
+    }
+
+    osg::Callback* OcclusionCulling::getCellCullCallback() const
+    {
+        return mCellCullCallback.get();
+    }
+
+    void OcclusionCulling::reportStats(unsigned int frameNumber, osg::Stats* stats) const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        stats->setAttribute(frameNumber, "Occlusion Tested", mLastTested);
+        stats->setAttribute(frameNumber, "Occlusion Culled", mLastCulled);
+        stats->setAttribute(frameNumber, "Occluders", mLastOccluders);
+    }
+
+    const OcclusionCulling::OccluderTemplate& OcclusionCulling::getOccluderTemplate(const std::string& model)
+    {
+        const std::string path = model.empty() ? std::string() : Misc::ResourceHelpers::correctMeshPath(model, mSceneManager->getVFS());
+        auto found = mTemplates.find(path);
+        if (found != mTemplates.end())
+            return found->second;
+
+        OccluderTemplate& occluderTemplate = mTemplates[path];
+        if (path.empty())
+            return occluderTemplate;
+
+        try
+        {
+            osg::ref_ptr<const osg::Node> node = mSceneManager->getTemplate(path, false);
+            // Animated parts may move out of where they were when collected
+            if (node->getNumChildrenRequiringUpdateTraversal() == 0)
+            {
+                CollectOccluderVisitor visitor;
+                const_cast<osg::Node*>(node.get())->accept(visitor); // const-trickery required because there is no const version of NodeVisitor
+                if (!visitor.mMesh.mIndices.empty() && visitor.mMesh.mIndices.size() / 3 <= sMaxOccluderTriangles)
+                {
+                    occluderTemplate.mMesh = std::make_shared<SceneUtil::OccluderMesh>(std::move(visitor.mMesh));
+                    occluderTemplate.mRadius = node->getBound().radius();
+                }
+            }
+        }
+        catch (const std::exception& e)
+        {
+            Log(Debug::Warning) << "Failed to create occluder for " << path << ": " << e.what();
+        }
+
+        return occluderTemplate;
+    }
+
+    std::shared_ptr<const SceneUtil::OccluderMesh> OcclusionCulling::createTerrainMesh(int cellX, int cellY) const
+    {
+        osg::ref_ptr<const ESMTerrain::LandObject> land = mTerrainStorage->getLand(cellX, cellY);
+        const ESM::Land::LandData* data = land ? land->getData(ESM::Land::DATA_VHGT) : nullptr;
+        if (!data)
+            return nullptr;
+
+        // Each vertex takes the lowest height around it, so the coarse surface never rises above the rendered terrain
+        constexpr int numVerts = (ESM::Land::LAND_SIZE - 1) / sTerrainStep + 1;
+        constexpr float vertexSize = static_cast<float>(ESM::Land::REAL_SIZE) / (ESM::Land::LAND_SIZE - 1);
+
+        auto mesh = std::make_shared<SceneUtil::OccluderMesh>();
+        mesh->mVertices.reserve(numVerts * numVerts);
+        for (int y = 0; y < numVerts; ++y)
+        {
+            const int startY = std::max(0, (y - 1) * sTerrainStep);
+            const int endY = std::min(ESM::Land::LAND_SIZE - 1, (y + 1) * sTerrainStep);
+            for (int x = 0; x < numVerts; ++x)
+            {
+                const int startX = std::max(0, (x - 1) * sTerrainStep);
+                const int endX = std::min(ESM::Land::LAND_SIZE - 1, (x + 1) * sTerrainStep);
+                float height = std::numeric_limits<float>::max();
+                for (int landY = startY; landY <= endY; ++landY)
+                    for (int landX = startX; landX <= endX; ++landX)
+                        height = std::min(height, data->mHeights[landY * ESM::Land::LAND_SIZE + landX]);
+                mesh->mVertices.emplace_back(x * sTerrainStep * vertexSize, y * sTerrainStep * vertexSize, height);
+            }
+        }
+
+        mesh->mIndices.reserve((numVerts - 1) * (numVerts - 1) * 6);
+        for (int y = 0; y < numVerts - 1; ++y)
+        {
+            for (int x = 0; x < numVerts - 1; ++x)
+            {
+                const unsigned int index = y * numVerts + x;
+                mesh->mIndices.insert(mesh->mIndices.end(), {
+                    index, index + 1, index + numVerts + 1,
+                    index, index + numVerts + 1, index + numVerts,
+                });
+            }
+        }
+        return mesh;
+    }
+
+    const SceneUtil::OcclusionBuffer* OcclusionCulling::getBuffer(osgUtil::CullVisitor* cv)
+    {
+        if (cv->getCurrentCamera() != mCamera || Stereo::getStereo())
+            return nullptr;
+
+        const osg::Viewport* viewport = cv->getViewport();
+        if (!viewport || viewport->width() <= 0 || viewport->height() <= 0)
+            return nullptr;
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        const unsigned int frameNumber = cv->getFrameStamp()->getFrameNumber();
+        if (mBufferFrame != frameNumber)
+        {
+            mBufferFrame = frameNumber;
+            mLastTested = mTested.exchange(0);
+            mLastCulled = mCulled.exchange(0);
+            mLastOccluders = mNumOccluders;
+
+            const int height = std::max(1, static_cast<int>(mBufferWidth * viewport->height() / viewport->width()));
+            // Cell roots are not transformed, so this is the view matrix
+            mBuffer.reset(mBufferWidth, height, osg::Matrixd(*cv->getModelViewMatrix()) * *cv->getProjectionMatrix());
+
+            mNumOccluders = 0;
+            for (const auto& [store, terrain] : mTerrainOccluders)
+            {
+                mBuffer.addOccluder(*terrain.mMesh, terrain.mMatrix);
+                ++mNumOccluders;
+            }
+            for (const auto& [store, occluders] : mOccluders)
+            {
+                for (const auto& [ref, occluder] : occluders)
+                {
+                    mBuffer.addOccluder(*occluder.mMesh, occluder.mMatrix);
+                    ++mNumOccluders;
+                }
+            }
+            mBuffer.finish();
+        }
+        return &mBuffer;
+    }
+
+    void OcclusionCulling::countTest(bool culled)
+    {
+        ++mTested;
+        if (culled)
+            ++mCulled;
+    }
+
+}
@@ -0,0 +1,116 @@
+#ifndef OPENMW_MWRENDER_OCCLUSIONCULLING_H
+#define OPENMW_MWRENDER_OCCLUSIONCULLING_H
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <osg/Matrixf>
+#include <osg/ref_ptr>
+
+#include <components/sceneutil/occlusionbuffer.hpp>
+
+namespace osg
+{
+    class Callback;
+    class Camera;
+    class Stats;
+}
+
+namespace osgUtil
+{
+    class CullVisitor;
+}
+
+namespace Resource
+{
+    class SceneManager;
+}
+
+namespace MWWorld
+{
+    class CellStore;
+    class LiveCellRefBase;
+    class Ptr;
+}
+
+namespace MWRender
+{
+    class TerrainStorage;
+
+    /// @brief Culls objects of the active cells hidden behind the terrain and large statics.
+    /// @par Occluders are rasterized into a small OcclusionBuffer once per frame, the first time a cell root is culled by the main camera.
+    /// The children of each cell root are then tested against the buffer before being traversed.
+    class OcclusionCulling
+    {
+    public:
+        /// @param camera Only the cull traversals of this camera are tested.
+        /// @param bufferWidth Width of the occlusion buffer in pixels, the height follows the aspect ratio of the viewport.
+        /// @param minOccluderSize Statics with a smaller bounding radius do not occlude.
+        OcclusionCulling(Resource::SceneManager* sceneManager, TerrainStorage* terrainStorage, osg::Camera* camera, int bufferWidth, float minOccluderSize);
+        ~OcclusionCulling();
+
+        void addCell(const MWWorld::CellStore* store);
+        void removeCell(const MWWorld::CellStore* store);
+
+        /// Stop using the object as an occluder, it was moved, rotated, scaled or removed.
+        void removeObject(const MWWorld::Ptr& ptr);
+
+        /// To be set as the cull callback of cell roots.
+        osg::Callback* getCellCullCallback() const;
+
+        void reportStats(unsigned int frameNumber, osg::Stats* stats) const;
+
+    private:
+        struct Occluder
+        {
+            std::shared_ptr<const SceneUtil::OccluderMesh> mMesh;
+            osg::Matrixf mMatrix;
+        };
+
+        struct OccluderTemplate
+        {
+            std::shared_ptr<const SceneUtil::OccluderMesh> mMesh;
+            float mRadius = 0.f;
+        };
+
+        /// @return The occluder of a model, without a mesh if the model can not occlude.
+        const OccluderTemplate& getOccluderTemplate(const std::string& model);
+        std::shared_ptr<const SceneUtil::OccluderMesh> createTerrainMesh(int cellX, int cellY) const;
+
+        /// @return The occlusion buffer of the current frame, or nullptr if \a cv should not be tested.
+        const SceneUtil::OcclusionBuffer* getBuffer(osgUtil::CullVisitor* cv);
+
+        void countTest(bool culled);
+
+        friend class CellOcclusionCallback;
+
+        Resource::SceneManager* mSceneManager;
+        TerrainStorage* mTerrainStorage;
+        osg::Camera* mCamera;
+        int mBufferWidth;
+        float mMinOccluderSize;
+
+        mutable std::mutex mMutex;
+        std::map<const MWWorld::CellStore*, std::map<const MWWorld::LiveCellRefBase*, Occluder>> mOccluders;
+        std::map<const MWWorld::CellStore*, Occluder> mTerrainOccluders;
+        std::map<std::string, OccluderTemplate> mTemplates;
+
+        SceneUtil::OcclusionBuffer mBuffer;
+        unsigned int mBufferFrame;
+        unsigned int mNumOccluders;
+
+        std::atomic<unsigned int> mTested;
+        std::atomic<unsigned int> mCulled;
+        unsigned int mLastTested;
+        unsigned int mLastCulled;
+        unsigned int mLastOccluders;
+
+        osg::ref_ptr<osg::Callback> mCellCullCallback;
+    };
+
+}
+
+#endif
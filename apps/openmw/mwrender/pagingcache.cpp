@@ -0,0 +1,502 @@
+#include "pagingcache.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+
+#include <osg/Geometry>
+#include <osg/MatrixTransform>
+#include <osg/NodeVisitor>
+
+#include <components/debug/debuglog.hpp>
+#include <components/sceneutil/morphgeometry.hpp>
+#include <components/sceneutil/riggeometry.hpp>
+
+namespace MWRender
+{
+    namespace
+    {
+        enum class NodeType : std::uint8_t
+        {
+            Group,
+            MatrixTransform,
+            Geometry
+        };
+
+        /// Collects the state sets of a template scene in a stable order, including those the copy operation
+        /// takes from the source geometry of rigged and morphed drawables.
+        class CollectStateSetsVisitor : public osg::NodeVisitor
+        {
+        public:
+            CollectStateSetsVisitor()
+                : osg::NodeVisitor(TRAVERSE_ALL_CHILDREN)
+            {
+            }
+
+            void apply(osg::Node& node) override
+            {
+                add(node.getStateSet());
+                traverse(node);
+            }
+
+            void apply(osg::Drawable& drawable) override
+            {
+                add(drawable.getStateSet());
+                if (const SceneUtil::RigGeometry* rig = dynamic_cast<const SceneUtil::RigGeometry*>(&drawable))
+                    add(rig->getSourceGeometry()->getStateSet());
+                else if (const SceneUtil::MorphGeometry* morph = dynamic_cast<const SceneUtil::MorphGeometry*>(&drawable))
+                    add(morph->getSourceGeometry()->getStateSet());
+            }
+
+            std::vector<osg::StateSet*> mStateSets;
+
+        private:
+            void add(osg::StateSet* stateset)
+            {
+                if (stateset)
+                    mStateSets.push_back(stateset);
+            }
+        };
+
+        std::vector<std::vector<osg::StateSet*>> collectStateSets(const std::vector<const osg::Node*>& templates)
+        {
+            std::vector<std::vector<osg::StateSet*>> statesets;
+            statesets.reserve(templates.size());
+            for (const osg::Node* node : templates)
+            {
+                CollectStateSetsVisitor visitor;
+                const_cast<osg::Node*>(node)->accept(visitor); // const-trickery required because there is no const version of NodeVisitor
+                statesets.push_back(std::move(visitor.mStateSets));
+            }
+            return statesets;
+        }
+
+        bool isStockObject(const osg::Object& object, std::string_view className)
+        {
+            return std::string_view(object.libraryName()) == "osg" && std::string_view(object.className()) == className;
+        }
+
+        class Writer
+        {
+        public:
+            Writer(std::string& data, const std::vector<std::vector<osg::StateSet*>>& templateStateSets)
+                : mData(data)
+            {
+                for (std::uint32_t i = 0; i < templateStateSets.size(); ++i)
+                {
+                    for (std::uint32_t j = 0; j < templateStateSets[i].size(); ++j)
+                        mStateSets.emplace(templateStateSets[i][j], std::make_pair(i, j));
+                }
+            }
+
+            template <class T>
+            void write(const T& value)
+            {
+                static_assert(std::is_trivially_copyable_v<T>);
+                mData.append(reinterpret_cast<const char*>(&value), sizeof(T));
+            }
+
+            void write(const void* data, std::size_t size)
+            {
+                if (size != 0)
+                    mData.append(static_cast<const char*>(data), size);
+            }
+
+            bool writeNode(const osg::Node& node)
+            {
+                if (node.getUpdateCallback() || node.getEventCallback() || node.getCullCallback() || node.getUserDataContainer())
+                    return false;
+
+                NodeType type;
+                if (isStockObject(node, "Group"))
+                    type = NodeType::Group;
+                else if (isStockObject(node, "MatrixTransform"))
+                    type = NodeType::MatrixTransform;
+                else if (isStockObject(node, "Geometry"))
+                    type = NodeType::Geometry;
+                else
+                    return false;
+
+                write(type);
+                write(static_cast<std::uint32_t>(node.getNodeMask()));
+                if (!writeStateSet(node.getStateSet()))
+                    return false;
+
+                if (type == NodeType::Geometry)
+                    return writeGeometry(static_cast<const osg::Geometry&>(node));
+
+                if (type == NodeType::MatrixTransform)
+                {
+                    const osg::Matrixd matrix = static_cast<const osg::MatrixTransform&>(node).getMatrix();
+                    write(matrix.ptr(), sizeof(double) * 16);
+                }
+
+                const osg::Group& group = static_cast<const osg::Group&>(node);
+                write(static_cast<std::uint32_t>(group.getNumChildren()));
+                for (unsigned int i = 0; i < group.getNumChildren(); ++i)
+                {
+                    if (!writeNode(*group.getChild(i)))
+                        return false;
+                }
+                return true;
+            }
+
+        private:
+            bool writeStateSet(const osg::StateSet* stateset)
+            {
+                if (!stateset)
+                {
+                    write(std::uint8_t(0));
+                    return true;
+                }
+                auto found = mStateSets.find(stateset);
+                if (found == mStateSets.end())
+                    return false;
+                write(std::uint8_t(1));
+                write(found->second.first);
+                write(found->second.second);
+                return true;
+            }
+
+            bool writeArray(const osg::Array* array)
+            {
+                if (!array)
+                {
+                    write(std::uint8_t(0));
+                    return true;
+                }
+                switch (array->getType())
+                {
+                    case osg::Array::FloatArrayType:
+                    case osg::Array::Vec2ArrayType:
+                    case osg::Array::Vec3ArrayType:
+                    case osg::Array::Vec4ArrayType:
+                    case osg::Array::Vec4ubArrayType:
+                        break;
+                    default:
+                        return false;
+                }
+                if (std::string_view(array->libraryName()) != "osg" || array->getUserDataContainer())
+                    return false;
+
+                write(std::uint8_t(1));
+                write(static_cast<std::int32_t>(array->getType()));
+                write(static_cast<std::int32_t>(array->getBinding()));
+                write(static_cast<std::uint8_t>(array->getNormalize()));
+                write(static_cast<std::uint32_t>(array->getNumElements()));
+                write(array->getDataPointer(), array->getTotalDataSize());
+                return true;
+            }
+
+            bool writePrimitiveSet(const osg::PrimitiveSet& primitiveSet)
+            {
+                if (primitiveSet.getNumInstances() != 0 || std::string_view(primitiveSet.libraryName()) != "osg")
+                    return false;
+
+                switch (primitiveSet.getType())
+                {
+                    case osg::PrimitiveSet::DrawArraysPrimitiveType:
+                    {
+                        const osg::DrawArrays& drawArrays = static_cast<const osg::DrawArrays&>(primitiveSet);
+                        write(static_cast<std::int32_t>(primitiveSet.getType()));
+                        write(static_cast<std::uint32_t>(primitiveSet.getMode()));
+                        write(static_cast<std::int32_t>(drawArrays.getFirst()));
+                        write(static_cast<std::int32_t>(drawArrays.getCount()));
+                        return true;
+                    }
+                    case osg::PrimitiveSet::DrawElementsUBytePrimitiveType:
+                    case osg::PrimitiveSet::DrawElementsUShortPrimitiveType:
+                    case osg::PrimitiveSet::DrawElementsUIntPrimitiveType:
+                        write(static_cast<std::int32_t>(primitiveSet.getType()));
+                        write(static_cast<std::uint32_t>(primitiveSet.getMode()));
+                        write(static_cast<std::uint32_t>(primitiveSet.getNumIndices()));
+                        write(primitiveSet.getDataPointer(), primitiveSet.getTotalDataSize());
+                        return true;
+                    default:
+                        return false;
+                }
+            }
+
+            bool writeGeometry(const osg::Geometry& geometry)
+            {
+                if (geometry.getDrawCallback() || geometry.getComputeBoundingBoxCallback())
+                    return false;
+
+                write(static_cast<std::uint8_t>(geometry.getUseDisplayList()));
+                write(static_cast<std::uint8_t>(geometry.getUseVertexBufferObjects()));
+
+                if (!writeArray(geometry.getVertexArray()) || !writeArray(geometry.getNormalArray())
+                    || !writeArray(geometry.getColorArray()) || !writeArray(geometry.getSecondaryColorArray())
+                    || !writeArray(geometry.getFogCoordArray()))
+                    return false;
+
+                write(static_cast<std::uint32_t>(geometry.getNumTexCoordArrays()));
+                for (unsigned int i = 0; i < geometry.getNumTexCoordArrays(); ++i)
+                {
+                    if (!writeArray(geometry.getTexCoordArray(i)))
+                        return false;
+                }
+
+                write(static_cast<std::uint32_t>(geometry.getNumVertexAttribArrays()));
+                for (unsigned int i = 0; i < geometry.getNumVertexAttribArrays(); ++i)
+                {
+                    if (!writeArray(geometry.getVertexAttribArray(i)))
+                        return false;
+                }
+
+                write(static_cast<std::uint32_t>(geometry.getNumPrimitiveSets()));
+                for (unsigned int i = 0; i < geometry.getNumPrimitiveSets(); ++i)
+                {
+                    if (!writePrimitiveSet(*geometry.getPrimitiveSet(i)))
+                        return false;
+                }
+                return true;
+            }
+
+            std::string& mData;
+            std::unordered_map<const osg::StateSet*, std::pair<std::uint32_t, std::uint32_t>> mStateSets;
+        };
+
+        class Reader
+        {
+        public:
+            Reader(std::string_view data, const std::vector<std::vector<osg::StateSet*>>& templateStateSets)
+                : mData(data)
+                , mTemplateStateSets(templateStateSets)
+            {
+            }
+
+            template <class T>
+            T read()
+            {
+                static_assert(std::is_trivially_copyable_v<T>);
+                T value;
+                std::memcpy(&value, take(sizeof(T)), sizeof(T));
+                return value;
+            }
+
+            const char* take(std::size_t size)
+            {
+                if (size > mData.size())
+                    throw std::runtime_error("unexpected end of data");
+                const char* result = mData.data();
+                mData.remove_prefix(size);
+                return result;
+            }
+
+            /// Check that \a count elements of \a elementSize bytes remain, before allocating space for them.
+            void checkRemaining(std::size_t count, std::size_t elementSize) const
+            {
+                if (elementSize != 0 && count > mData.size() / elementSize)
+                    throw std::runtime_error("unexpected end of data");
+            }
+
+            bool atEnd() const { return mData.empty(); }
+
+            osg::ref_ptr<osg::Node> readNode()
+            {
+                const NodeType type = read<NodeType>();
+                const osg::Node::NodeMask nodeMask = read<std::uint32_t>();
+                osg::StateSet* stateset = readStateSet();
+
+                osg::ref_ptr<osg::Node> node;
+                if (type == NodeType::Geometry)
+                    node = readGeometry();
+                else if (type == NodeType::Group || type == NodeType::MatrixTransform)
+                {
+                    osg::ref_ptr<osg::Group> group;
+                    if (type == NodeType::MatrixTransform)
+                    {
+                        double matrix[16];
+                        std::memcpy(matrix, take(sizeof(matrix)), sizeof(matrix));
+                        group = new osg::MatrixTransform(osg::Matrixd(matrix));
+                    }
+                    else
+                        group = new osg::Group;
+
+                    const std::uint32_t numChildren = read<std::uint32_t>();
+                    for (std::uint32_t i = 0; i < numChildren; ++i)
+                        group->addChild(readNode());
+                    node = group;
+                }
+                else
+                    throw std::runtime_error("invalid node type");
+
+                node->setNodeMask(nodeMask);
+                node->setStateSet(stateset);
+                node->setDataVariance(osg::Object::STATIC);
+                return node;
+            }
+
+        private:
+            osg::StateSet* readStateSet()
+            {
+                if (read<std::uint8_t>() == 0)
+                    return nullptr;
+                const std::uint32_t templateIndex = read<std::uint32_t>();
+                const std::uint32_t statesetIndex = read<std::uint32_t>();
+                if (templateIndex >= mTemplateStateSets.size() || statesetIndex >= mTemplateStateSets[templateIndex].size())
+                    throw std::runtime_error("invalid state set reference");
+                return mTemplateStateSets[templateIndex][statesetIndex];
+            }
+
+            template <class ArrayT>
+            osg::ref_ptr<osg::Array> readArrayData(std::uint32_t numElements)
+            {
+                checkRemaining(numElements, sizeof(typename ArrayT::ElementDataType));
+                osg::ref_ptr<ArrayT> array = new ArrayT(numElements);
+                const std::size_t size = numElements * sizeof(typename ArrayT::ElementDataType);
+                if (size != 0)
+                    std::memcpy(&(*array)[0], take(size), size);
+                return array;
+            }
+
+            osg::ref_ptr<osg::Array> readArray()
+            {
+                if (read<std::uint8_t>() == 0)
+                    return nullptr;
+
+                const auto type = static_cast<osg::Array::Type>(read<std::int32_t>());
+                const auto binding = static_cast<osg::Array::Binding>(read<std::int32_t>());
+                const bool normalize = read<std::uint8_t>() != 0;
+                const std::uint32_t numElements = read<std::uint32_t>();
+
+                osg::ref_ptr<osg::Array> array;
+                switch (type)
+                {
+                    case osg::Array::FloatArrayType: array = readArrayData<osg::FloatArray>(numElements); break;
+                    case osg::Array::Vec2ArrayType: array = readArrayData<osg::Vec2Array>(numElements); break;
+                    case osg::Array::Vec3ArrayType: array = readArrayData<osg::Vec3Array>(numElements); break;
+                    case osg::Array::Vec4ArrayType: array = readArrayData<osg::Vec4Array>(numElements); break;
+                    case osg::Array::Vec4ubArrayType: array = readArrayData<osg::Vec4ubArray>(numElements); break;
+                    default:
+                        throw std::runtime_error("invalid array type");
+                }
+                array->setBinding(binding);
+                array->setNormalize(normalize);
+                return array;
+            }
+
+            template <class DrawElementsT>
+            osg::ref_ptr<osg::PrimitiveSet> readDrawElements(GLenum mode)
+            {
+                const std::uint32_t numIndices = read<std::uint32_t>();
+                checkRemaining(numIndices, sizeof(typename DrawElementsT::value_type));
+                osg::ref_ptr<DrawElementsT> drawElements = new DrawElementsT(mode, numIndices);
+                const std::size_t size = numIndices * sizeof(typename DrawElementsT::value_type);
+                if (size != 0)
+                    std::memcpy(&(*drawElements)[0], take(size), size);
+                return drawElements;
+            }
+
+            osg::ref_ptr<osg::PrimitiveSet> readPrimitiveSet()
+            {
+                const auto type = static_cast<osg::PrimitiveSet::Type>(read<std::int32_t>());
+                const GLenum mode = read<std::uint32_t>();
+                switch (type)
+                {
+                    case osg::PrimitiveSet::DrawArraysPrimitiveType:
+                    {
+                        const std::int32_t first = read<std::int32_t>();
+                        const std::int32_t count = read<std::int32_t>();
+                        return new osg::DrawArrays(mode, first, count);
+                    }
+                    case osg::PrimitiveSet::DrawElementsUBytePrimitiveType: return readDrawElements<osg::DrawElementsUByte>(mode);
+                    case osg::PrimitiveSet::DrawElementsUShortPrimitiveType: return readDrawElements<osg::DrawElementsUShort>(mode);
+                    case osg::PrimitiveSet::DrawElementsUIntPrimitiveType: return readDrawElements<osg::DrawElementsUInt>(mode);
+                    default:
+                        throw std::runtime_error("invalid primitive set type");
+                }
+            }
+
+            osg::ref_ptr<osg::Geometry> readGeometry()
+            {
+                osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
+                const bool useDisplayList = read<std::uint8_t>() != 0;
+                const bool useVertexBufferObjects = read<std::uint8_t>() != 0;
+
+                geometry->setVertexArray(readArray());
+                geometry->setNormalArray(readArray());
+                geometry->setColorArray(readArray());
+                geometry->setSecondaryColorArray(readArray());
+                geometry->setFogCoordArray(readArray());
+
+                const std::uint32_t numTexCoordArrays = read<std::uint32_t>();
+                for (std::uint32_t i = 0; i < numTexCoordArrays; ++i)
+                {
+                    if (osg::ref_ptr<osg::Array> array = readArray())
+                        geometry->setTexCoordArray(i, array);
+                }
+
+                const std::uint32_t numVertexAttribArrays = read<std::uint32_t>();
+                for (std::uint32_t i = 0; i < numVertexAttribArrays; ++i)
+                {
+                    if (osg::ref_ptr<osg::Array> array = readArray())
+                        geometry->setVertexAttribArray(i, array);
+                }
+
+                const std::uint32_t numPrimitiveSets = read<std::uint32_t>();
+                for (std::uint32_t i = 0; i < numPrimitiveSets; ++i)
+                    geometry->addPrimitiveSet(readPrimitiveSet());
+
+                geometry->setUseDisplayList(useDisplayList);
+                geometry->setUseVertexBufferObjects(useVertexBufferObjects);
+                return geometry;
+            }
+
+            std::string_view mData;
+            const std::vector<std::vector<osg::StateSet*>>& mTemplateStateSets;
+        };
+    }
+
+    bool serializeMergedChunk(const osg::Group& group, const std::vector<const osg::Node*>& templates, std::string& data)
+    {
+        const std::vector<std::vector<osg::StateSet*>> templateStateSets = collectStateSets(templates);
+
+        data.clear();
+        Writer writer(data, templateStateSets);
+
+        // Stored to detect templates that changed since the chunk was written
+        writer.write(static_cast<std::uint32_t>(templateStateSets.size()));
+        for (const std::vector<osg::StateSet*>& statesets : templateStateSets)
+            writer.write(static_cast<std::uint32_t>(statesets.size()));
+
+        return writer.writeNode(group);
+    }
+
+    osg::ref_ptr<osg::Group> deserializeMergedChunk(std::string_view data, const std::vector<const osg::Node*>& templates)
+    {
+        const std::vector<std::vector<osg::StateSet*>> templateStateSets = collectStateSets(templates);
+
+        try
+        {
+            Reader reader(data, templateStateSets);
+
+            if (reader.read<std::uint32_t>() != templateStateSets.size())
+                return nullptr;
+            for (const std::vector<osg::StateSet*>& statesets : templateStateSets)
+            {
+                if (reader.read<std::uint32_t>() != statesets.size())
+                    return nullptr;
+            }
+
+            osg::ref_ptr<osg::Node> node = reader.readNode();
+            if (!reader.atEnd())
+                throw std::runtime_error("unexpected data after the chunk");
+
+            osg::ref_ptr<osg::Group> group = node->asGroup();
+            if (!group || node->asTransform())
+                throw std::runtime_error("unexpected root node");
+            return group;
+        }
+        catch (const std::exception& e)
+        {
+            Log(Debug::Warning) << "Failed to read cached object paging chunk: " << e.what();
+            return nullptr;
+        }
+    }
+
+}
@@ -0,0 +1,31 @@
+#ifndef OPENMW_MWRENDER_PAGINGCACHE_H
+#define OPENMW_MWRENDER_PAGINGCACHE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <osg/ref_ptr>
+
+namespace osg
+{
+    class Group;
+    class Node;
+}
+
+namespace MWRender
+{
+
+    /// Serialize the merged geometry of an object paging chunk for the chunk disk cache.
+    /// @par State sets are not stored, they are referenced by their position in the \a templates they were copied from,
+    /// so a loaded chunk shares state and shader programs with the scenes in the SceneManager.
+    /// @return false if the group contains anything besides plain groups, transforms and geometry, or state not found in the templates.
+    bool serializeMergedChunk(const osg::Group& group, const std::vector<const osg::Node*>& templates, std::string& data);
+
+    /// @param templates The same templates, in the same order, as were passed to serializeMergedChunk.
+    /// @return nullptr if the data is invalid or does not match the templates.
+    osg::ref_ptr<osg::Group> deserializeMergedChunk(std::string_view data, const std::vector<const osg::Node*>& templates);
+
+}
+
+#endif
@@ -27,6 +27,7 @@
 #include <components/resource/resourcesystem.hpp>
 #include <components/resource/imagemanager.hpp>
 #include <components/resource/keyframemanager.hpp>
+#include <components/resource/texturebudget.hpp>
 
 #include <components/shader/removedalphafunc.hpp>
 #include <components/shader/shadermanager.hpp>
@@ -78,6 +79,7 @@
 #include "recastmesh.hpp"
 #include "fogmanager.hpp"
 #include "objectpaging.hpp"
+#include "occlusionculling.hpp"
 #include "screenshotmanager.hpp"
 #include "groundcover.hpp"
 #include "postprocessor.hpp"
@@ -527,6 +529,10 @@ namespace MWRender
 
         mTerrain->setTargetFrameRate(Settings::Manager::getFloat("target framerate", "Cells"));
 
+        // Shadow casting renders terrain with a shader that can't decode compact vertices
+        const bool terrainShadows = Settings::Manager::getBool("enable shadows", "Shadows") && Settings::Manager::getBool("terrain shadows", "Shadows");
+        mTerrain->setCompactVertices(Settings::Manager::getBool("compact vertices", "Terrain") && !terrainShadows);
+
         if (groundcover)
         {
             float density = Settings::Manager::getFloat("density", "Groundcover");
@@ -609,6 +615,13 @@ namespace MWRender
         mViewer->getCamera()->setCullingMode(cullingMode);
         mViewer->getCamera()->setName(Constants::SceneCamera);
 
+        if (Settings::Manager::getBool("occlusion culling", "Camera"))
+        {
+            mOcclusionCulling = std::make_unique<OcclusionCulling>(mResourceSystem->getSceneManager(), mTerrainStorage.get(), mViewer->getCamera(),
+                Settings::Manager::getInt("occlusion buffer width", "Camera"), Settings::Manager::getFloat("occluder min size", "Camera"));
+            mObjects->setCellCullCallback(mOcclusionCulling->getCellCullCallback());
+        }
+
         auto mask = ~(Mask_UpdateVisitor | Mask_SimpleWater);
         MWBase::Environment::get().getWindowManager()->setCullMask(mask);
         NifOsg::Loader::setHiddenNodeMask(Mask_UpdateVisitor);
@@ -669,6 +682,13 @@ namespace MWRender
         return mTerrain.get();
     }
 
+    void RenderingManager::setChunkDiskCache(Terrain::DiskCache* diskCache)
+    {
+        mTerrain->setDiskCache(diskCache);
+        if (mObjectPaging)
+            mObjectPaging->setDiskCache(diskCache);
+    }
+
     void RenderingManager::preloadCommonAssets()
     {
         osg::ref_ptr<PreloadCommonAssetsWorkItem> workItem (new PreloadCommonAssetsWorkItem(mResourceSystem));
@@ -797,6 +817,9 @@ namespace MWRender
 
         mWater->changeCell(store);
 
+        if (mOcclusionCulling)
+            mOcclusionCulling->addCell(store);
+
         if (store->getCell()->isExterior())
         {
             mTerrain->loadCell(store->getCell()->getGridX(), store->getCell()->getGridY());
@@ -808,6 +831,9 @@ namespace MWRender
         mActorsPaths->removeCell(store);
         mObjects->removeCell(store);
 
+        if (mOcclusionCulling)
+            mOcclusionCulling->removeCell(store);
+
         if (store->getCell()->isExterior())
         {
             mTerrain->unloadCell(store->getCell()->getGridX(), store->getCell()->getGridY());
@@ -901,6 +927,9 @@ namespace MWRender
     {
         reportStats();
 
+        mResourceSystem->getSceneManager()->getTextureBudget().update(mViewer->getFrameStamp()->getFrameNumber(),
+            mViewer->getCamera()->getGraphicsContext());
+
         float rainIntensity = mSky->getPrecipitationAlpha();
         mWater->setRainIntensity(rainIntensity);
 
@@ -977,17 +1006,26 @@ namespace MWRender
         }
 
         ptr.getRefData().getBaseNode()->setAttitude(rot);
+
+        if (mOcclusionCulling)
+            mOcclusionCulling->removeObject(ptr);
     }
 
     void RenderingManager::moveObject(const MWWorld::Ptr &ptr, const osg::Vec3f &pos)
     {
         ptr.getRefData().getBaseNode()->setPosition(pos);
+
+        if (mOcclusionCulling)
+            mOcclusionCulling->removeObject(ptr);
     }
 
     void RenderingManager::scaleObject(const MWWorld::Ptr &ptr, const osg::Vec3f &scale)
     {
         ptr.getRefData().getBaseNode()->setScale(scale);
 
+        if (mOcclusionCulling)
+            mOcclusionCulling->removeObject(ptr);
+
         if (ptr == mCamera->getTrackingPtr()) // update height of camera
             mCamera->processViewChange();
     }
@@ -997,6 +1035,9 @@ namespace MWRender
         mActorsPaths->remove(ptr);
         mObjects->removeObject(ptr);
         mWater->removeEmitter(ptr);
+
+        if (mOcclusionCulling)
+            mOcclusionCulling->removeObject(ptr);
     }
 
     void RenderingManager::setWaterEnabled(bool enabled)
@@ -1166,6 +1207,9 @@ namespace MWRender
     {
         mObjects->updatePtr(old, updated);
         mActorsPaths->updatePtr(old, updated);
+
+        if (mOcclusionCulling)
+            mOcclusionCulling->removeObject(old);
     }
 
     void RenderingManager::spawnEffect(const std::string &model, const std::string &texture, const osg::Vec3f &worldPosition, float scale, bool isMagicVFX)
@@ -1361,6 +1405,8 @@ namespace MWRender
         if (stats->collectStats("resource"))
         {
             mTerrain->reportStats(frameNumber, stats);
+            if (mOcclusionCulling)
+                mOcclusionCulling->reportStats(frameNumber, stats);
         }
     }
 
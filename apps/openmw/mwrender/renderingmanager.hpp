@@ -48,6 +48,7 @@ namespace ESM
 namespace Terrain
 {
     class World;
+    class DiskCache;
 }
 
 namespace Fallback
@@ -94,6 +95,7 @@ namespace MWRender
     class ActorsPaths;
     class RecastMesh;
     class ObjectPaging;
+    class OcclusionCulling;
     class Groundcover;
     class PostProcessor;
 
@@ -114,6 +116,10 @@ namespace MWRender
         SceneUtil::WorkQueue* getWorkQueue();
         Terrain::World* getTerrain();
 
+        /// Load and store composite maps and merged object paging geometry in this cache.
+        /// @note Call before any chunk is loaded.
+        void setChunkDiskCache(Terrain::DiskCache* diskCache);
+
         void preloadCommonAssets();
 
         double getReferenceTime() const;
@@ -289,6 +295,7 @@ namespace MWRender
         std::unique_ptr<ActorsPaths> mActorsPaths;
         std::unique_ptr<RecastMesh> mRecastMesh;
         std::unique_ptr<Pathgrid> mPathgrid;
+        std::unique_ptr<OcclusionCulling> mOcclusionCulling;
         std::unique_ptr<Objects> mObjects;
         std::unique_ptr<Water> mWater;
         std::unique_ptr<Terrain::World> mTerrain;
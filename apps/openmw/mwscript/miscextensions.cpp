@@ -1618,6 +1618,29 @@ namespace MWScript
                 }
         };
 
+        class OpToggleScriptProfiler : public Interpreter::Opcode0
+        {
+            public:
+
+                void execute (Interpreter::Runtime& runtime) override
+                {
+                    bool enabled = MWBase::Environment::get().getScriptManager()->toggleProfiler();
+
+                    runtime.getContext().report (enabled ?
+                        "Script Profiler -> On" : "Script Profiler -> Off");
+                }
+        };
+
+        class OpShowScriptProfile : public Interpreter::Opcode0
+        {
+            public:
+
+                void execute (Interpreter::Runtime& runtime) override
+                {
+                    runtime.getContext().report (MWBase::Environment::get().getScriptManager()->getProfileReport (10));
+                }
+        };
+
         void installOpcodes (Interpreter::Interpreter& interpreter)
         {
             interpreter.installSegment5<OpMenuMode>(Compiler::Misc::opcodeMenuMode);
@@ -1739,6 +1762,8 @@ namespace MWScript
             interpreter.installSegment5<OpToggleRecastMesh>(Compiler::Misc::opcodeToggleRecastMesh);
             interpreter.installSegment5<OpHelp>(Compiler::Misc::opcodeHelp);
             interpreter.installSegment5<OpReloadLua>(Compiler::Misc::opcodeReloadLua);
+            interpreter.installSegment5<OpToggleScriptProfiler>(Compiler::Misc::opcodeToggleScriptProfiler);
+            interpreter.installSegment5<OpShowScriptProfile>(Compiler::Misc::opcodeShowScriptProfile);
         }
     }
 }
@@ -28,7 +28,7 @@ namespace MWScript
         const std::vector<std::string>& scriptBlacklist)
     : mErrorHandler(), mStore (store),
       mCompilerContext (compilerContext), mParser (mErrorHandler, mCompilerContext),
-      mOpcodesInstalled (false), mGlobalScripts (store)
+      mOpcodesInstalled (false), mGlobalScripts (store), mProfiler (mInterpreter)
     {
         mErrorHandler.setWarningsMode (warningsMode);
 
@@ -80,7 +80,12 @@ namespace MWScript
             {
                 std::vector<Interpreter::Type_Code> code;
                 mParser.getCode(code);
-                mScripts.emplace(name, CompiledScript(code, mParser.getLocals()));
+
+                // Decode the instructions once, so running the script does not need to look up its opcodes
+                installOpcodes();
+                CompiledScript compiled(code, mParser.getLocals());
+                mInterpreter.decode(compiled.mProgram);
+                mScripts.emplace(name, std::move(compiled));
 
                 return true;
             }
@@ -110,16 +115,13 @@ namespace MWScript
 
         // execute script
         std::string target = Misc::StringUtils::lowerCase(interpreterContext.getTarget());
-        if (!iter->second.mByteCode.empty() && iter->second.mInactive.find(target) == iter->second.mInactive.end())
+        if (!iter->second.mProgram.mCode.empty() && iter->second.mInactive.find(target) == iter->second.mInactive.end())
+        {
+            const ScriptProfiler::Scope profile (mProfiler, name, mGlobalScripts);
+
             try
             {
-                if (!mOpcodesInstalled)
-                {
-                    installOpcodes (mInterpreter);
-                    mOpcodesInstalled = true;
-                }
-
-                mInterpreter.run (&iter->second.mByteCode[0], iter->second.mByteCode.size(), interpreterContext);
+                mInterpreter.run (iter->second.mProgram, interpreterContext);
                 return true;
             }
             catch (const MissingImplicitRefError& e)
@@ -132,9 +134,19 @@ namespace MWScript
 
                 iter->second.mInactive.insert(target); // don't execute again.
             }
+        }
         return false;
     }
 
+    void ScriptManager::installOpcodes()
+    {
+        if (!mOpcodesInstalled)
+        {
+            MWScript::installOpcodes (mInterpreter);
+            mOpcodesInstalled = true;
+        }
+    }
+
     void ScriptManager::clear()
     {
         for (auto& script : mScripts)
@@ -224,4 +236,26 @@ namespace MWScript
     {
         return *mCompilerContext.getExtensions();
     }
+
+    bool ScriptManager::toggleProfiler()
+    {
+        setProfilerEnabled (!mProfiler.isEnabled());
+        return mProfiler.isEnabled();
+    }
+
+    std::string ScriptManager::getProfileReport (std::size_t count) const
+    {
+        return mProfiler.getReport (count, getExtensions());
+    }
+
+    void ScriptManager::setProfilerEnabled (bool enabled)
+    {
+        mProfiler.setEnabled (enabled);
+    }
+
+    void ScriptManager::writeProfile (const std::string& path) const
+    {
+        if (!mProfiler.isEmpty())
+            mProfiler.writeCsv (path, getExtensions());
+    }
 }
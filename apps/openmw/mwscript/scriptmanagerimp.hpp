@@ -14,6 +14,7 @@
 #include "../mwbase/scriptmanager.hpp"
 
 #include "globalscripts.hpp"
+#include "scriptprofiler.hpp"
 
 namespace MWWorld
 {
@@ -44,13 +45,16 @@ namespace MWScript
 
             struct CompiledScript
             {
-                std::vector<Interpreter::Type_Code> mByteCode;
+                // Byte code with its instructions decoded by mInterpreter
+                Interpreter::Program mProgram;
                 Compiler::Locals mLocals;
                 std::set<std::string> mInactive;
 
                 CompiledScript(const std::vector<Interpreter::Type_Code>& code, const Compiler::Locals& locals):
-                    mByteCode(code), mLocals(locals)
-                {}
+                    mLocals(locals)
+                {
+                    mProgram.mCode = code;
+                }
             };
 
             typedef std::map<std::string, CompiledScript> ScriptCollection;
@@ -59,6 +63,9 @@ namespace MWScript
             GlobalScripts mGlobalScripts;
             std::map<std::string, Compiler::Locals> mOtherLocals;
             std::vector<std::string> mScriptBlacklist;
+            ScriptProfiler mProfiler;
+
+            void installOpcodes();
 
         public:
 
@@ -85,6 +92,15 @@ namespace MWScript
             GlobalScripts& getGlobalScripts() override;
 
             const Compiler::Extensions& getExtensions() const override;
+
+            bool toggleProfiler() override;
+
+            std::string getProfileReport (std::size_t count) const override;
+
+            void setProfilerEnabled (bool enabled);
+
+            void writeProfile (const std::string& path) const;
+            ///< Write the collected statistics in CSV format, if there are any.
     };
 }
 
@@ -0,0 +1,162 @@
+#include "scriptprofiler.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+#include <components/compiler/extensions.hpp>
+#include <components/debug/debuglog.hpp>
+#include <components/interpreter/interpreter.hpp>
+
+#include "globalscripts.hpp"
+
+namespace MWScript
+{
+    namespace
+    {
+        double toMilliseconds (std::chrono::steady_clock::duration duration)
+        {
+            return std::chrono::duration<double, std::milli> (duration).count();
+        }
+
+        std::string getOpcodeName (Interpreter::Type_Code id, const Compiler::Extensions& extensions)
+        {
+            const int segment = Interpreter::getSegment (id);
+            const int opcode = Interpreter::getOpcode (id);
+
+            if (segment==3 || segment==5)
+            {
+                std::string keyword = extensions.findKeyword (segment, opcode);
+                if (!keyword.empty())
+                    return keyword;
+            }
+
+            return "segment " + std::to_string (segment) + " opcode " + std::to_string (opcode);
+        }
+
+        std::string quoteCsv (const std::string& value)
+        {
+            std::string result = "\"";
+            for (char c : value)
+            {
+                if (c=='"')
+                    result += '"';
+                result += c;
+            }
+            result += '"';
+            return result;
+        }
+
+        template <class T>
+        std::vector<const typename T::value_type*> sortByTime (const T& stats)
+        {
+            std::vector<const typename T::value_type*> result;
+            result.reserve (stats.size());
+            for (const auto& value : stats)
+                result.push_back (&value);
+            std::stable_sort (result.begin(), result.end(),
+                [] (const auto* lhs, const auto* rhs) { return lhs->second.mTime > rhs->second.mTime; });
+            return result;
+        }
+    }
+
+    ScriptProfiler::Scope::Scope (ScriptProfiler& profiler, const std::string& name, const GlobalScripts& globalScripts)
+    : mProfiler (profiler.isEnabled() ? &profiler : nullptr), mName (name), mGlobal (false), mInstructions (0)
+    {
+        if (mProfiler==nullptr)
+            return;
+
+        mGlobal = globalScripts.isRunning (name);
+        mInstructions = mProfiler->mProfile.mInstructions;
+        mStart = std::chrono::steady_clock::now();
+    }
+
+    ScriptProfiler::Scope::~Scope()
+    {
+        if (mProfiler==nullptr)
+            return;
+
+        ScriptStats& stats = mProfiler->mScripts[mName];
+        stats.mTime += std::chrono::steady_clock::now() - mStart;
+        ++stats.mCalls;
+        stats.mInstructions += mProfiler->mProfile.mInstructions - mInstructions;
+        stats.mGlobal = stats.mGlobal || mGlobal;
+    }
+
+    ScriptProfiler::ScriptProfiler (Interpreter::Interpreter& interpreter)
+    : mInterpreter (interpreter), mEnabled (false)
+    {}
+
+    bool ScriptProfiler::isEnabled() const
+    {
+        return mEnabled;
+    }
+
+    void ScriptProfiler::setEnabled (bool enabled)
+    {
+        mEnabled = enabled;
+        mInterpreter.setProfile (enabled ? &mProfile : nullptr);
+    }
+
+    bool ScriptProfiler::isEmpty() const
+    {
+        return mScripts.empty() && mProfile.mOpcodes.empty();
+    }
+
+    std::string ScriptProfiler::getReport (std::size_t count, const Compiler::Extensions& extensions) const
+    {
+        std::ostringstream stream;
+        stream << std::fixed << std::setprecision (3);
+        stream << "Scripts by time (" << mScripts.size() << " profiled):";
+
+        const auto scripts = sortByTime (mScripts);
+        for (std::size_t i = 0; i < std::min (count, scripts.size()); ++i)
+        {
+            const auto& [name, stats] = *scripts[i];
+            stream << "\n  " << name << (stats.mGlobal ? " (global): " : " (local): ")
+                << toMilliseconds (stats.mTime) << " ms, " << stats.mCalls << " runs, "
+                << stats.mInstructions << " instructions";
+        }
+
+        stream << "\nOpcodes by time (" << mProfile.mInstructions << " instructions executed):";
+
+        const auto opcodes = sortByTime (mProfile.mOpcodes);
+        for (std::size_t i = 0; i < std::min (count, opcodes.size()); ++i)
+        {
+            const auto& [id, stats] = *opcodes[i];
+            stream << "\n  " << getOpcodeName (id, extensions) << ": "
+                << toMilliseconds (stats.mTime) << " ms, " << stats.mCount << " calls";
+        }
+
+        return stream.str();
+    }
+
+    void ScriptProfiler::writeCsv (const std::string& path, const Compiler::Extensions& extensions) const
+    {
+        std::ofstream stream (path);
+        stream << "type,name,calls,instructions,time ms\n";
+
+        for (const auto* value : sortByTime (mScripts))
+        {
+            const auto& [name, stats] = *value;
+            stream << (stats.mGlobal ? "global" : "local") << ',' << quoteCsv (name) << ','
+                << stats.mCalls << ',' << stats.mInstructions << ',' << toMilliseconds (stats.mTime) << '\n';
+        }
+
+        for (const auto* value : sortByTime (mProfile.mOpcodes))
+        {
+            const auto& [id, stats] = *value;
+            stream << "opcode," << quoteCsv (getOpcodeName (id, extensions)) << ','
+                << stats.mCount << ',' << stats.mCount << ',' << toMilliseconds (stats.mTime) << '\n';
+        }
+
+        stream.close();
+
+        if (!stream)
+            Log(Debug::Error) << "Failed to write script profile to " << path;
+        else
+            Log(Debug::Info) << "Script profile is written to " << path;
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef GAME_SCRIPT_SCRIPTPROFILER_H
+#define GAME_SCRIPT_SCRIPTPROFILER_H
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include <components/interpreter/profile.hpp>
+
+namespace Compiler
+{
+    class Extensions;
+}
+
+namespace Interpreter
+{
+    class Interpreter;
+}
+
+namespace MWScript
+{
+    class GlobalScripts;
+
+    /// \brief Time spent in each script and opcode, collected while enabled
+    class ScriptProfiler
+    {
+        public:
+
+            struct ScriptStats
+            {
+                std::chrono::steady_clock::duration mTime {};
+                std::uint64_t mCalls = 0;
+                std::uint64_t mInstructions = 0;
+                bool mGlobal = false;
+            };
+
+            /// \brief Adds the time of one script run to the profiler, if it is enabled
+            class Scope
+            {
+                    ScriptProfiler *mProfiler;
+                    const std::string& mName;
+                    bool mGlobal;
+                    std::chrono::steady_clock::time_point mStart;
+                    std::uint64_t mInstructions;
+
+                public:
+
+                    Scope (ScriptProfiler& profiler, const std::string& name, const GlobalScripts& globalScripts);
+
+                    ~Scope();
+
+                    Scope (const Scope&) = delete;
+                    Scope& operator= (const Scope&) = delete;
+            };
+
+            explicit ScriptProfiler (Interpreter::Interpreter& interpreter);
+
+            bool isEnabled() const;
+
+            void setEnabled (bool enabled);
+            ///< Collected statistics are kept when disabled.
+
+            bool isEmpty() const;
+
+            std::string getReport (std::size_t count, const Compiler::Extensions& extensions) const;
+            ///< Return the \a count most expensive scripts and opcodes.
+
+            void writeCsv (const std::string& path, const Compiler::Extensions& extensions) const;
+
+        private:
+
+            Interpreter::Interpreter& mInterpreter;
+            bool mEnabled;
+            Interpreter::Profile mProfile;
+            std::map<std::string, ScriptStats> mScripts;
+    };
+}
+
+#endif
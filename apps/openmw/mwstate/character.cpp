@@ -164,6 +164,32 @@ const MWState::Slot *MWState::Character::updateSlot (const Slot *slot, const ESM
     return &mSlots.back();
 }
 
+const MWState::Slot *MWState::Character::findSlot (const boost::filesystem::path& path) const
+{
+    for (const Slot& slot : mSlots)
+        if (slot.mPath == path)
+            return &slot;
+
+    return nullptr;
+}
+
+const MWState::Slot *MWState::Character::restoreSlot (const Slot *slot, const Slot& previous)
+{
+    int index = slot - &mSlots[0];
+
+    if (index<0 || index>=static_cast<int> (mSlots.size()))
+    {
+        // sanity check; not entirely reliable
+        throw std::logic_error ("slot not found");
+    }
+
+    mSlots[index] = previous;
+
+    std::sort (mSlots.begin(), mSlots.end());
+
+    return findSlot (previous.mPath);
+}
+
 MWState::Character::SlotIterator MWState::Character::begin() const
 {
     return mSlots.rbegin();
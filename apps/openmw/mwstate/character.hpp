@@ -55,6 +55,16 @@ namespace MWState
             ///
             /// \attention The \a slot pointer will be invalidated by this call.
 
+            const Slot *findSlot (const boost::filesystem::path& path) const;
+            ///< Return the slot of the given saved game file, or nullptr if there is none.
+
+            const Slot *restoreSlot (const Slot *slot, const Slot& previous);
+            ///< Replace \a slot with its state before updateSlot, e.g. when the saved game could not be written.
+            ///
+            /// \note Slot must belong to this character.
+            ///
+            /// \attention The \a slot pointer will be invalidated by this call.
+
             SlotIterator begin() const;
             ///<  Any call to createSlot and updateSlot can invalidate the returned iterator.
 
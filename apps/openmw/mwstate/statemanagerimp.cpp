@@ -1,14 +1,18 @@
 #include "statemanagerimp.hpp"
 
 #include <filesystem>
+#include <sstream>
 
 #include <components/debug/debuglog.hpp>
 
 #include <components/esm3/esmwriter.hpp>
 #include <components/esm3/esmreader.hpp>
 #include <components/esm3/cellid.hpp>
+#include <components/esm3/compressedrecords.hpp>
 #include <components/esm3/loadcell.hpp>
 
+#include <components/files/memorystream.hpp>
+
 #include <components/loadinglistener/loadinglistener.hpp>
 
 #include <components/settings/settings.hpp>
@@ -90,12 +94,60 @@ std::map<int, int> MWState::StateManager::buildContentFileIndexMap (const ESM::E
     return map;
 }
 
+namespace
+{
+    /// @param headerSize The file header and the saved game profile are written uncompressed, so listing saved games stays fast.
+    /// @param breaks Offsets in the remaining records where the data of another subsystem begins.
+    void writeSaveFile(const boost::filesystem::path& path, const std::string& data, std::size_t headerSize,
+        const std::vector<std::size_t>& breaks)
+    {
+        // Write to a temporary file first. If the write fails, we don't want to trash the existing save file we are overwriting.
+        boost::filesystem::path tmpPath = path;
+        tmpPath += ".tmp";
+
+        boost::filesystem::ofstream filestream (tmpPath, std::ios::binary | std::ios::trunc);
+        filestream.write(data.data(), headerSize);
+
+        ESM::ESMWriter writer;
+        writer.saveRecords(filestream);
+        ESM::writeCompressedRecords(writer, std::string_view(data).substr(headerSize), breaks);
+        writer.close();
+
+        filestream.close();
+
+        if (filestream.fail())
+        {
+            boost::system::error_code ec;
+            boost::filesystem::remove(tmpPath, ec);
+            throw std::runtime_error("Write operation failed (file stream)");
+        }
+
+        boost::filesystem::rename(tmpPath, path);
+    }
+}
+
 MWState::StateManager::StateManager (const boost::filesystem::path& saves, const std::vector<std::string>& contentFiles)
 : mQuitRequest (false), mAskLoadRecent(false), mState (State_NoGame), mCharacterManager (saves, contentFiles), mTimePlayed (0)
 {
 
 }
 
+MWState::StateManager::~StateManager()
+{
+    // Other subsystems may be gone already, so only wait for the file to be written
+    if (mPendingSave)
+    {
+        try
+        {
+            mPendingSave->mResult.get();
+        }
+        catch (const std::exception& e)
+        {
+            Log(Debug::Error) << "Failed to save game: " << e.what();
+        }
+    }
+}
+
 void MWState::StateManager::requestQuit()
 {
     mQuitRequest = true;
@@ -188,6 +240,17 @@ void MWState::StateManager::saveGame (const std::string& description, const Slot
 {
     MWState::Character* character = getCurrentCharacter();
 
+    // Only one saved game is written at a time, and the slot of the previous one may be replaced.
+    // Finishing it can move or remove slots, so look the slot up again afterwards.
+    if (mPendingSave)
+    {
+        const boost::filesystem::path path = slot ? slot->mPath : boost::filesystem::path();
+        finishPendingSave(true);
+        slot = !path.empty() && character ? character->findSlot(path) : nullptr;
+    }
+
+    std::optional<Slot> previousSlot;
+
     try
     {
         const auto start = std::chrono::steady_clock::now();
@@ -231,15 +294,17 @@ void MWState::StateManager::saveGame (const std::string& description, const Slot
         if (!slot)
             slot = character->createSlot (profile);
         else
+        {
+            previousSlot = *slot;
             slot = character->updateSlot (slot, profile);
+        }
 
         // Make sure the animation state held by references is up to date before saving the game.
         MWBase::Environment::get().getMechanicsManager()->persistAnimationStates();
 
         Log(Debug::Info) << "Writing saved game '" << description << "' for character '" << profile.mPlayerName << "'";
 
-        // Write to a memory stream first. If there is an exception during the save process, we don't want to trash the
-        // existing save file we are overwriting.
+        // Capture the game state in a memory stream on this thread, the file is written by a worker thread.
         std::stringstream stream;
 
         ESM::ESMWriter writer;
@@ -264,7 +329,8 @@ void MWState::StateManager::saveGame (const std::string& description, const Slot
                 +MWBase::Environment::get().getMechanicsManager()->countSavedGameRecords()
                 +MWBase::Environment::get().getInputManager()->countSavedGameRecords()
                 +MWBase::Environment::get().getWindowManager()->countSavedGameRecords();
-        writer.setRecordCount (recordCount);
+        // Only the saved game header and the record of compressed chunks are written to the file
+        writer.setRecordCount (2);
 
         writer.save (stream);
 
@@ -279,15 +345,28 @@ void MWState::StateManager::saveGame (const std::string& description, const Slot
         slot->mProfile.save (writer);
         writer.endRecord (ESM::REC_SAVE);
 
+        // The remaining records are compressed in chunks that don't span subsystems. Loading reads every subsystem
+        // in order, so the chunks are stored one after another in a single record without a directory of offsets.
+        const std::size_t headerSize = static_cast<std::size_t>(stream.tellp());
+        std::vector<std::size_t> breaks;
+        const auto addBreak = [&] { breaks.push_back(static_cast<std::size_t>(stream.tellp()) - headerSize); };
+
         MWBase::Environment::get().getJournal()->write (writer, listener);
+        addBreak();
         MWBase::Environment::get().getDialogueManager()->write (writer, listener);
+        addBreak();
         // LuaManager::write should be called before World::write because world also saves
         // local scripts that depend on LuaManager.
         MWBase::Environment::get().getLuaManager()->write(writer, listener);
+        addBreak();
         MWBase::Environment::get().getWorld()->write (writer, listener);
+        addBreak();
         MWBase::Environment::get().getScriptManager()->getGlobalScripts().write (writer, listener);
+        addBreak();
         MWBase::Environment::get().getMechanicsManager()->write(writer, listener);
+        addBreak();
         MWBase::Environment::get().getInputManager()->write(writer, listener);
+        addBreak();
         MWBase::Environment::get().getWindowManager()->write(writer, listener);
 
         // Ensure we have written the number of records that was estimated
@@ -299,20 +378,19 @@ void MWState::StateManager::saveGame (const std::string& description, const Slot
         if (stream.fail())
             throw std::runtime_error("Write operation failed (memory stream)");
 
-        // All good, write to file
-        boost::filesystem::ofstream filestream (slot->mPath, std::ios::binary);
-        filestream << stream.rdbuf();
+        const auto captured = std::chrono::steady_clock::now();
 
-        if (filestream.fail())
-            throw std::runtime_error("Write operation failed (file stream)");
-
-        Settings::Manager::setString ("character", "Saves",
-            slot->mPath.parent_path().filename().string());
-
-        const auto finish = std::chrono::steady_clock::now();
+        Log(Debug::Info) << '\'' << description << "' is captured in "
+            << std::chrono::duration_cast<std::chrono::duration<float, std::milli>>(captured - start).count() << "ms";
 
-        Log(Debug::Info) << '\'' << description << "' is saved in "
-            << std::chrono::duration_cast<std::chrono::duration<float, std::milli>>(finish - start).count() << "ms";
+        PendingSave pendingSave;
+        pendingSave.mResult = std::async(std::launch::async, writeSaveFile, slot->mPath, stream.str(), headerSize, std::move(breaks));
+        pendingSave.mCharacter = character;
+        pendingSave.mPath = slot->mPath;
+        pendingSave.mPreviousSlot = std::move(previousSlot);
+        pendingSave.mDescription = description;
+        pendingSave.mStart = start;
+        mPendingSave = std::move(pendingSave);
     }
     catch (const std::exception& e)
     {
@@ -325,12 +403,8 @@ void MWState::StateManager::saveGame (const std::string& description, const Slot
         buttons.emplace_back("#{sOk}");
         MWBase::Environment::get().getWindowManager()->interactiveMessageBox(error.str(), buttons);
 
-        // If no file was written, clean up the slot
-        if (character && slot && !boost::filesystem::exists(slot->mPath))
-        {
-            character->deleteSlot(slot);
-            character->cleanup();
-        }
+        if (character && slot)
+            revertSlot(character, slot->mPath, previousSlot);
     }
 }
 
@@ -386,6 +460,9 @@ void MWState::StateManager::loadGame(const std::string& filepath)
 
 void MWState::StateManager::loadGame (const Character *character, const std::string& filepath)
 {
+    // The file may still be being written
+    finishPendingSave(true);
+
     try
     {
         cleanup();
@@ -410,7 +487,8 @@ void MWState::StateManager::loadGame (const Character *character, const std::str
 
         bool firstPersonCam = false;
 
-        size_t total = reader.getFileSize();
+        // Decompressed records, read after the saved game header
+        std::string records;
         int currentPercent = 0;
         while (reader.hasMoreRecs())
         {
@@ -503,13 +581,18 @@ void MWState::StateManager::loadGame (const Character *character, const std::str
                     MWBase::Environment::get().getLuaManager()->readRecord(reader, n.toInt());
                     break;
 
+                case ESM::REC_CHNK:
+                    records = ESM::readCompressedRecords(reader);
+                    reader.openRecords(std::make_unique<Files::IMemStream>(records.data(), records.size()));
+                    break;
+
                 default:
 
                     // ignore invalid records
                     Log(Debug::Warning) << "Warning: Ignoring unknown record: " << n.toStringView();
                     reader.skipRecord();
             }
-            int progressPercent = static_cast<int>(float(reader.getFileOffset())/total*100);
+            int progressPercent = static_cast<int>(float(reader.getFileOffset())/reader.getFileSize()*100);
             if (progressPercent > currentPercent)
             {
                 listener.increaseProgress(progressPercent-currentPercent);
@@ -601,6 +684,17 @@ void MWState::StateManager::quickLoad()
 
 void MWState::StateManager::deleteGame(const MWState::Character *character, const MWState::Slot *slot)
 {
+    // Deleting the last slot deletes the character, which the pending save refers to
+    if (mPendingSave && mPendingSave->mCharacter == character)
+    {
+        // Finishing the save can move or remove slots, so look the slot up again afterwards
+        const boost::filesystem::path path = slot->mPath;
+        finishPendingSave(true);
+        slot = character->findSlot(path);
+        if (!slot)
+            return;
+    }
+
     mCharacterManager.deleteSlot(character, slot);
 }
 
@@ -623,6 +717,8 @@ void MWState::StateManager::update (float duration)
 {
     mTimePlayed += duration;
 
+    finishPendingSave(false);
+
     // Note: It would be nicer to trigger this from InputManager, i.e. the very beginning of the frame update.
     if (mAskLoadRecent)
     {
@@ -670,6 +766,62 @@ bool MWState::StateManager::verifyProfile(const ESM::SavedGame& profile) const
     return true;
 }
 
+void MWState::StateManager::finishPendingSave (bool wait)
+{
+    if (!mPendingSave)
+        return;
+    if (!wait && mPendingSave->mResult.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return;
+
+    PendingSave pendingSave = std::move(*mPendingSave);
+    mPendingSave.reset();
+
+    try
+    {
+        pendingSave.mResult.get();
+
+        Settings::Manager::setString ("character", "Saves",
+            pendingSave.mPath.parent_path().filename().string());
+
+        const auto finish = std::chrono::steady_clock::now();
+
+        Log(Debug::Info) << '\'' << pendingSave.mDescription << "' is saved in "
+            << std::chrono::duration_cast<std::chrono::duration<float, std::milli>>(finish - pendingSave.mStart).count() << "ms";
+    }
+    catch (const std::exception& e)
+    {
+        std::stringstream error;
+        error << "Failed to save game: " << e.what();
+
+        Log(Debug::Error) << error.str();
+
+        std::vector<std::string> buttons;
+        buttons.emplace_back("#{sOk}");
+        MWBase::Environment::get().getWindowManager()->interactiveMessageBox(error.str(), buttons);
+
+        revertSlot(pendingSave.mCharacter, pendingSave.mPath, pendingSave.mPreviousSlot);
+    }
+}
+
+void MWState::StateManager::revertSlot (Character* character, const boost::filesystem::path& path, const std::optional<Slot>& previous)
+{
+    const Slot* slot = character->findSlot(path);
+    if (!slot)
+        return;
+
+    if (!boost::filesystem::exists(path))
+    {
+        // No file was written, clean up the slot
+        character->deleteSlot(slot);
+        character->cleanup();
+    }
+    else if (previous)
+    {
+        // The previous file is kept when writing the new one fails
+        character->restoreSlot(slot, *previous);
+    }
+}
+
 void MWState::StateManager::writeScreenshot(std::vector<char> &imageData) const
 {
     int screenshotW = 259*2, screenshotH = 133*2; // *2 to get some nice antialiasing
@@ -1,7 +1,10 @@
 #ifndef GAME_STATE_STATEMANAGER_H
 #define GAME_STATE_STATEMANAGER_H
 
+#include <chrono>
+#include <future>
 #include <map>
+#include <optional>
 
 #include "../mwbase/statemanager.hpp"
 
@@ -19,6 +22,21 @@ namespace MWState
             CharacterManager mCharacterManager;
             double mTimePlayed;
 
+            /// A saved game captured in memory, written to its file by a worker thread
+            struct PendingSave
+            {
+                std::future<void> mResult;
+                /// \note Deleting the character has to wait for the save to finish
+                Character* mCharacter;
+                boost::filesystem::path mPath;
+                /// The slot that is overwritten, restored if the file can not be written
+                std::optional<Slot> mPreviousSlot;
+                std::string mDescription;
+                std::chrono::steady_clock::time_point mStart;
+            };
+
+            std::optional<PendingSave> mPendingSave;
+
         private:
 
             void cleanup (bool force = false);
@@ -29,10 +47,20 @@ namespace MWState
 
             std::map<int, int> buildContentFileIndexMap (const ESM::ESMReader& reader) const;
 
+            /// Undo the slot changes of a saved game that could not be written.
+            /// \param previous The overwritten slot, if any.
+            void revertSlot (Character* character, const boost::filesystem::path& path, const std::optional<Slot>& previous);
+
+            /// Report the result of the saved game being written, if any.
+            /// \param wait Wait for the file to be written, otherwise only report it if it is done.
+            void finishPendingSave (bool wait);
+
         public:
 
             StateManager (const boost::filesystem::path& saves, const std::vector<std::string>& contentFiles);
 
+            ~StateManager() override;
+
             void requestQuit() override;
 
             bool hasQuitRequest() const override;
@@ -57,6 +85,7 @@ namespace MWState
             ///< Write a saved game to \a slot or create a new slot if \a slot == 0.
             ///
             /// \note Slot must belong to the current character.
+            /// \note The game state is captured before returning, the file is written in the background.
 
             ///Saves a file, using supplied filename, overwritting if needed
             /** This is mostly used for quicksaving and autosaving, for they use the same name over and over again
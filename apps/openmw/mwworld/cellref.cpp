@@ -24,12 +24,14 @@ namespace MWWorld
             }
             mCellRef.mRefNum = lastAssignedRefNum;
             mChanged = true;
+            mDirty = true;
         }
         return mCellRef.mRefNum;
     }
 
     void CellRef::unsetRefNum()
     {
+        mDirty = true;
         mCellRef.mRefNum.unset();
     }
 
@@ -38,6 +40,7 @@ namespace MWWorld
         if (scale != mCellRef.mScale)
         {
             mChanged = true;
+            mDirty = true;
             mCellRef.mScale = scale;
         }
     }
@@ -45,6 +48,7 @@ namespace MWWorld
     void CellRef::setPosition(const ESM::Position &position)
     {
         mChanged = true;
+        mDirty = true;
         mCellRef.mPos = position;
     }
 
@@ -69,6 +73,7 @@ namespace MWWorld
         if (charge != mCellRef.mEnchantmentCharge)
         {
             mChanged = true;
+            mDirty = true;
             mCellRef.mEnchantmentCharge = charge;
         }
     }
@@ -78,12 +83,14 @@ namespace MWWorld
         if (charge != mCellRef.mChargeInt)
         {
             mChanged = true;
+            mDirty = true;
             mCellRef.mChargeInt = charge;
         }
     }
 
     void CellRef::applyChargeRemainderToBeSubtracted(float chargeRemainder)
     {
+        mDirty = true;
         mCellRef.mChargeIntRemainder += std::abs(chargeRemainder);
         if (mCellRef.mChargeIntRemainder > 1.0f)
         {
@@ -105,6 +112,7 @@ namespace MWWorld
         if (charge != mCellRef.mChargeFloat)
         {
             mChanged = true;
+            mDirty = true;
             mCellRef.mChargeFloat = charge;
         }
     }
@@ -114,6 +122,7 @@ namespace MWWorld
         if (!mCellRef.mGlobalVariable.empty())
         {
             mChanged = true;
+            mDirty = true;
             mCellRef.mGlobalVariable.erase();
         }
     }
@@ -123,6 +132,7 @@ namespace MWWorld
         if (factionRank != mCellRef.mFactionRank)
         {
             mChanged = true;
+            mDirty = true;
             mCellRef.mFactionRank = factionRank;
         }
     }
@@ -132,6 +142,7 @@ namespace MWWorld
         if (owner != mCellRef.mOwner)
         {
             mChanged = true;
+            mDirty = true;
             mCellRef.mOwner = owner;
         }
     }
@@ -141,6 +152,7 @@ namespace MWWorld
         if (soul != mCellRef.mSoul)
         {
             mChanged = true;
+            mDirty = true;
             mCellRef.mSoul = soul;
         }
     }
@@ -150,6 +162,7 @@ namespace MWWorld
         if (faction != mCellRef.mFaction)
         {
             mChanged = true;
+            mDirty = true;
             mCellRef.mFaction = faction;
         }
     }
@@ -159,6 +172,7 @@ namespace MWWorld
         if (lockLevel != mCellRef.mLockLevel)
         {
             mChanged = true;
+            mDirty = true;
             mCellRef.mLockLevel = lockLevel;
         }
     }
@@ -181,6 +195,7 @@ namespace MWWorld
         if (trap != mCellRef.mTrap)
         {
             mChanged = true;
+            mDirty = true;
             mCellRef.mTrap = trap;
         }
     }
@@ -190,6 +205,7 @@ namespace MWWorld
         if (value != mCellRef.mGoldValue)
         {
             mChanged = true;
+            mDirty = true;
             mCellRef.mGoldValue = value;
         }
     }
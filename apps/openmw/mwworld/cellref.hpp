@@ -20,6 +20,7 @@ namespace MWWorld
             : mCellRef(ref)
         {
             mChanged = false;
+            mDirty = true;
         }
 
         // Note: Currently unused for items in containers
@@ -120,8 +121,13 @@ namespace MWWorld
         // Has this CellRef changed since it was originally loaded?
         bool hasChanged() const { return mChanged; }
 
+        // Has this CellRef possibly changed since it was last written to a saved game?
+        bool isDirty() const { return mDirty; }
+        void clearDirty() { mDirty = false; }
+
     private:
         bool mChanged;
+        bool mDirty;
         ESM::CellRef mCellRef;
     };
 
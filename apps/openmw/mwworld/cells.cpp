@@ -89,6 +89,7 @@ void MWWorld::Cells::clear()
 {
     mInteriors.clear();
     mExteriors.clear();
+    mWrittenCells.clear();
     std::fill(mIdCache.begin(), mIdCache.end(), std::make_pair("", (MWWorld::CellStore*)nullptr));
     mIdCacheIndex = 0;
 }
@@ -110,18 +111,24 @@ MWWorld::Ptr MWWorld::Cells::getPtrAndCache (const std::string& name, CellStore&
 
 void MWWorld::Cells::writeCell (ESM::ESMWriter& writer, CellStore& cell) const
 {
-    if (cell.getState()!=CellStore::State_Loaded)
-        cell.load ();
+    const std::string& data = mWrittenCells.get(&cell, cell.isDirty(), [&] (ESM::ESMWriter& cellWriter)
+    {
+        if (cell.getState()!=CellStore::State_Loaded)
+            cell.load ();
+
+        ESM::CellState cellState;
 
-    ESM::CellState cellState;
+        cell.saveState (cellState);
 
-    cell.saveState (cellState);
+        cellState.mId.save (cellWriter);
+        cellState.save (cellWriter);
+        cell.writeFog(cellWriter);
+        cell.writeReferences (cellWriter);
+    });
+    cell.clearDirty();
 
     writer.startRecord (ESM::REC_CSTA);
-    cellState.mId.save (writer);
-    cellState.save (writer);
-    cell.writeFog(writer);
-    cell.writeReferences (writer);
+    writer.write (data.data(), data.size());
     writer.endRecord (ESM::REC_CSTA);
 }
 
@@ -6,6 +6,7 @@
 #include <string>
 
 #include "ptr.hpp"
+#include "writtenrecordcache.hpp"
 
 namespace ESM
 {
@@ -34,6 +35,8 @@ namespace MWWorld
             ESM::ReadersCache& mReaders;
             mutable std::map<std::string, CellStore> mInteriors;
             mutable std::map<std::pair<int, int>, CellStore> mExteriors;
+            // Saved game records of the cells as of the last time they were written, without the record header
+            mutable WrittenRecordCache<const CellStore*> mWrittenCells;
             IdCache mIdCache;
             std::size_t mIdCacheIndex;
 
@@ -46,6 +49,7 @@ namespace MWWorld
 
             Ptr getPtr(CellStore& cellStore, const std::string& id, const ESM::RefNum& refNum);
 
+            /// @note Cells that did not change since they were last written are written from mWrittenCells.
             void writeCell (ESM::ESMWriter& writer, CellStore& cell) const;
 
         public:
@@ -108,6 +108,25 @@ namespace
         }
     }
 
+    template<typename T>
+    bool isDirtyList (const MWWorld::CellRefList<T>& collection)
+    {
+        for (const MWWorld::LiveCellRef<T>& ref : collection.mList)
+            if (ref.mData.isDirty() || ref.mRef.isDirty())
+                return true;
+        return false;
+    }
+
+    template<typename T>
+    void clearDirtyList (MWWorld::CellRefList<T>& collection)
+    {
+        for (MWWorld::LiveCellRef<T>& ref : collection.mList)
+        {
+            ref.mData.clearDirty();
+            ref.mRef.clearDirty();
+        }
+    }
+
     template<class RecordType, class T>
     void fixRestockingImpl(const T* base, RecordType& state)
     {
@@ -280,6 +299,7 @@ namespace MWWorld
             load();
 
         mHasState = true;
+        mDirty = true;
         MovedRefTracker::iterator found = mMovedToAnotherCell.find(object.getBase());
         if (found != mMovedToAnotherCell.end())
         {
@@ -307,6 +327,8 @@ namespace MWWorld
         if (searchViaRefNum(object.getCellRef().getRefNum()).isEmpty())
             throw std::runtime_error("moveTo: object is not in this cell");
 
+        mDirty = true;
+
         MWBase::Environment::get().getLuaManager()->registerObject(MWWorld::Ptr(object.getBase(), cellToMoveTo));
 
         MovedRefTracker::iterator found = mMovedHere.find(object.getBase());
@@ -394,6 +416,7 @@ namespace MWWorld
         , mCell(cell)
         , mState(State_Unloaded)
         , mHasState(false)
+        , mDirty(true)
         , mLastRespawn(0, 0)
         , mRechargingItemsUpToDate(false)
     {
@@ -420,6 +443,68 @@ namespace MWWorld
         return mHasState;
     }
 
+    bool CellStore::isDirty() const
+    {
+        return mDirty ||
+            isDirtyList (mActivators) ||
+            isDirtyList (mPotions) ||
+            isDirtyList (mAppas) ||
+            isDirtyList (mArmors) ||
+            isDirtyList (mBooks) ||
+            isDirtyList (mClothes) ||
+            isDirtyList (mContainers) ||
+            isDirtyList (mCreatures) ||
+            isDirtyList (mDoors) ||
+            isDirtyList (mIngreds) ||
+            isDirtyList (mCreatureLists) ||
+            isDirtyList (mItemLists) ||
+            isDirtyList (mLights) ||
+            isDirtyList (mLockpicks) ||
+            isDirtyList (mMiscItems) ||
+            isDirtyList (mNpcs) ||
+            isDirtyList (mProbes) ||
+            isDirtyList (mRepairs) ||
+            isDirtyList (mStatics) ||
+            isDirtyList (mWeapons) ||
+            isDirtyList (mBodyParts);
+    }
+
+    void CellStore::setDirty()
+    {
+        mDirty = true;
+
+        // Also covers references owned by another cell, so that cell is written as well
+        for (LiveCellRefBase* ref : mMergedRefs)
+            ref->mData.setDirty();
+    }
+
+    void CellStore::clearDirty()
+    {
+        mDirty = false;
+
+        clearDirtyList (mActivators);
+        clearDirtyList (mPotions);
+        clearDirtyList (mAppas);
+        clearDirtyList (mArmors);
+        clearDirtyList (mBooks);
+        clearDirtyList (mClothes);
+        clearDirtyList (mContainers);
+        clearDirtyList (mCreatures);
+        clearDirtyList (mDoors);
+        clearDirtyList (mIngreds);
+        clearDirtyList (mCreatureLists);
+        clearDirtyList (mItemLists);
+        clearDirtyList (mLights);
+        clearDirtyList (mLockpicks);
+        clearDirtyList (mMiscItems);
+        clearDirtyList (mNpcs);
+        clearDirtyList (mProbes);
+        clearDirtyList (mRepairs);
+        clearDirtyList (mStatics);
+        clearDirtyList (mWeapons);
+        clearDirtyList (mBodyParts);
+    }
+
     bool CellStore::hasId (const std::string& id) const
     {
         if (mState==State_Unloaded)
@@ -520,6 +605,7 @@ namespace MWWorld
     {
         mWaterLevel = level;
         mHasState = true;
+        mDirty = true;
     }
 
     std::size_t CellStore::count() const
@@ -769,6 +855,7 @@ namespace MWWorld
     void CellStore::loadState (const ESM::CellState& state)
     {
         mHasState = true;
+        mDirty = true;
 
         if (mCell->mData.mFlags & ESM::Cell::Interior && mCell->mData.mFlags & ESM::Cell::HasWater)
             mWaterLevel = state.mWaterLevel;
@@ -799,6 +886,7 @@ namespace MWWorld
     {
         mFogState = std::make_unique<ESM::FogState>();
         mFogState->load(reader);
+        mDirty = true;
     }
 
     void CellStore::writeReferences (ESM::ESMWriter& writer) const
@@ -838,6 +926,7 @@ namespace MWWorld
     void CellStore::readReferences (ESM::ESMReader& reader, const std::map<int, int>& contentFileMap, GetCellStoreCallback* callback)
     {
         mHasState = true;
+        mDirty = true;
 
         while (reader.isNextSub ("OBJE"))
         {
@@ -1037,6 +1126,7 @@ namespace MWWorld
     void CellStore::setFog(std::unique_ptr<ESM::FogState>&& fog)
     {
         mFogState = std::move(fog);
+        mDirty = true;
     }
 
     ESM::FogState* CellStore::getFog() const
@@ -1125,6 +1215,7 @@ namespace MWWorld
             if (MWBase::Environment::get().getWorld()->getTimeStamp() - mLastRespawn > 24*30*iMonthsToRespawn)
             {
                 mLastRespawn = MWBase::Environment::get().getWorld()->getTimeStamp();
+                mDirty = true;
                 for (CellRefList<ESM::Container>::List::iterator it (mContainers.mList.begin()); it!=mContainers.mList.end(); ++it)
                 {
                     Ptr ptr = getCurrentPtr(&*it);
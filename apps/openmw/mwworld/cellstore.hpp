@@ -72,6 +72,7 @@ namespace MWWorld
             const ESM::Cell *mCell;
             State mState;
             bool mHasState;
+            bool mDirty;
             std::vector<std::string> mIds;
             float mWaterLevel;
 
@@ -205,6 +206,7 @@ namespace MWWorld
             LiveCellRefBase* insert(const LiveCellRef<T>* ref)
             {
                 mHasState = true;
+                mDirty = true;
                 CellRefList<T>& list = get<T>();
                 LiveCellRefBase* ret = &list.insert(*ref);
                 updateMergedRefs();
@@ -224,6 +226,17 @@ namespace MWWorld
             bool hasState() const;
             ///< Does this cell have state that needs to be stored in a saved game file?
 
+            bool isDirty() const;
+            ///< Has the state of this cell or of any reference owned by it possibly changed since it was last
+            /// written to a saved game file?
+
+            void setDirty();
+            ///< Treat this cell and all references currently in it as changed, e.g. because they are active and
+            /// change in ways that are not tracked.
+
+            void clearDirty();
+            ///< To be called after writing the state of this cell to a saved game file.
+
             bool hasId (const std::string& id) const;
             ///< May return true for deleted IDs when in preload state. Will return false, if cell is
             /// unloaded.
@@ -1,6 +1,9 @@
 #include "localscripts.hpp"
 
+#include <algorithm>
+
 #include <components/debug/debuglog.hpp>
+#include <components/misc/stringops.hpp>
 
 #include "esmstore.hpp"
 #include "cellstore.hpp"
@@ -9,6 +12,8 @@
 
 namespace
 {
+    // Number of runs without a change before a script moves to the next tier
+    constexpr unsigned int sIdleRunsPerTier = 4;
 
     struct AddScriptsVisitor
     {
@@ -64,23 +69,97 @@ namespace
 
 }
 
-MWWorld::LocalScripts::LocalScripts (const MWWorld::ESMStore& store) : mStore (store)
+MWWorld::LocalScripts::LocalScripts (const MWWorld::ESMStore& store)
+    : mStore (store), mScheduling (false), mMaxInterval (1), mFrame (0), mNextPhase (0)
 {
     mIter = mScripts.end();
 }
 
+void MWWorld::LocalScripts::setScheduling (unsigned int maxInterval, const std::vector<std::string>& everyFrame)
+{
+    mMaxInterval = std::max(maxInterval, 1u);
+    mScheduling = mMaxInterval > 1;
+
+    mEveryFrame.clear();
+    for (const std::string& name : everyFrame)
+        mEveryFrame.insert(Misc::StringUtils::lowerCase(name));
+
+    for (Script& script : mScripts)
+    {
+        script.mEveryFrame = mEveryFrame.count(Misc::StringUtils::lowerCase(script.mName)) > 0;
+        script.mObserved = false;
+        script.mInterval = 1;
+        script.mIdleRuns = 0;
+    }
+}
+
 void MWWorld::LocalScripts::startIteration()
 {
     mIter = mScripts.begin();
+    ++mFrame;
+}
+
+bool MWWorld::LocalScripts::isDue (Script& script)
+{
+    if (!mScheduling || script.mEveryFrame)
+        return true;
+
+    const RefData& data = script.mPtr.getRefData();
+    const MWScript::Locals& locals = data.getLocals();
+    ObservedState& state = script.mState;
+
+    const bool changed = !script.mObserved
+        || data.isActivationPending()
+        || state.mShorts != locals.mShorts
+        || state.mLongs != locals.mLongs
+        || state.mFloats != locals.mFloats
+        || state.mPosition != data.getPosition()
+        || state.mScale != script.mPtr.getCellRef().getScale()
+        || state.mCount != data.getCount(false)
+        || state.mEnabled != data.isEnabled();
+
+    if (changed)
+    {
+        script.mInterval = 1;
+        script.mIdleRuns = 0;
+    }
+    else
+    {
+        // Spread the scripts of a tier evenly over its frames
+        if ((mFrame + script.mPhase) % script.mInterval != 0)
+            return false;
+
+        if (++script.mIdleRuns >= sIdleRunsPerTier && script.mInterval < mMaxInterval)
+        {
+            script.mInterval = std::min(script.mInterval * 2, mMaxInterval);
+            script.mIdleRuns = 0;
+        }
+    }
+
+    // Compared before the next run, so changes made by this run count as well
+    state.mShorts = locals.mShorts;
+    state.mLongs = locals.mLongs;
+    state.mFloats = locals.mFloats;
+    state.mPosition = data.getPosition();
+    state.mScale = script.mPtr.getCellRef().getScale();
+    state.mCount = data.getCount(false);
+    state.mEnabled = data.isEnabled();
+    script.mObserved = true;
+
+    return true;
 }
 
 bool MWWorld::LocalScripts::getNext(std::pair<std::string, Ptr>& script)
 {
-    if (mIter!=mScripts.end())
+    while (mIter!=mScripts.end())
     {
-        std::list<std::pair<std::string, Ptr> >::iterator iter = mIter++;
-        script = *iter;
-        return true;
+        std::list<Script>::iterator iter = mIter++;
+        if (isDue(*iter))
+        {
+            script.first = iter->mName;
+            script.second = iter->mPtr;
+            return true;
+        }
     }
     return false;
 }
@@ -93,15 +172,19 @@ void MWWorld::LocalScripts::add (const std::string& scriptName, const Ptr& ptr)
         {
             ptr.getRefData().setLocals (*script);
 
-            for (std::list<std::pair<std::string, Ptr> >::iterator iter = mScripts.begin(); iter!=mScripts.end(); ++iter)
-                if (iter->second==ptr)
+            for (std::list<Script>::iterator iter = mScripts.begin(); iter!=mScripts.end(); ++iter)
+                if (iter->mPtr==ptr)
                 {
                     Log(Debug::Warning) << "Error: tried to add local script twice for " << ptr.getCellRef().getRefId();
                     remove(ptr);
                     break;
                 }
 
-            mScripts.emplace_back (scriptName, ptr);
+            Script& added = mScripts.emplace_back();
+            added.mName = scriptName;
+            added.mPtr = ptr;
+            added.mEveryFrame = mEveryFrame.count(Misc::StringUtils::lowerCase(scriptName)) > 0;
+            added.mPhase = mNextPhase++;
         }
         catch (const std::exception& exception)
         {
@@ -134,11 +217,11 @@ void MWWorld::LocalScripts::clear()
 
 void MWWorld::LocalScripts::clearCell (CellStore *cell)
 {
-    std::list<std::pair<std::string, Ptr> >::iterator iter = mScripts.begin();
+    std::list<Script>::iterator iter = mScripts.begin();
 
     while (iter!=mScripts.end())
     {
-        if (iter->second.mCell==cell)
+        if (iter->mPtr.mCell==cell)
         {
             if (iter==mIter)
                ++mIter;
@@ -152,9 +235,9 @@ void MWWorld::LocalScripts::clearCell (CellStore *cell)
 
 void MWWorld::LocalScripts::remove (RefData *ref)
 {
-    for (std::list<std::pair<std::string, Ptr> >::iterator iter = mScripts.begin();
+    for (std::list<Script>::iterator iter = mScripts.begin();
         iter!=mScripts.end(); ++iter)
-        if (&(iter->second.getRefData()) == ref)
+        if (&(iter->mPtr.getRefData()) == ref)
         {
             if (iter==mIter)
                 ++mIter;
@@ -166,9 +249,9 @@ void MWWorld::LocalScripts::remove (RefData *ref)
 
 void MWWorld::LocalScripts::remove (const Ptr& ptr)
 {
-    for (std::list<std::pair<std::string, Ptr> >::iterator iter = mScripts.begin();
+    for (std::list<Script>::iterator iter = mScripts.begin();
         iter!=mScripts.end(); ++iter)
-        if (iter->second==ptr)
+        if (iter->mPtr==ptr)
         {
             if (iter==mIter)
                 ++mIter;
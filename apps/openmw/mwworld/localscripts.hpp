@@ -2,7 +2,12 @@
 #define GAME_MWWORLD_LOCALSCRIPTS_H
 
 #include <list>
+#include <set>
 #include <string>
+#include <vector>
+
+#include <components/esm/defs.hpp>
+#include <components/interpreter/types.hpp>
 
 #include "ptr.hpp"
 
@@ -13,21 +18,61 @@ namespace MWWorld
     class RefData;
 
     /// \brief List of active local scripts
+    ///
+    /// With scheduling enabled, scripts which did not change the state of their reference for a while are run
+    /// less often, in tiers of doubling frame intervals. A change of the locals, position, scale, count or
+    /// enabled state of the reference, or a pending activation, puts a script back to running every frame.
     class LocalScripts
     {
-            std::list<std::pair<std::string, Ptr> > mScripts;
-            std::list<std::pair<std::string, Ptr> >::iterator mIter;
+            /// State of a reference observed by the scheduler
+            struct ObservedState
+            {
+                std::vector<Interpreter::Type_Short> mShorts;
+                std::vector<Interpreter::Type_Integer> mLongs;
+                std::vector<Interpreter::Type_Float> mFloats;
+                ESM::Position mPosition;
+                float mScale = 1.f;
+                int mCount = 0;
+                bool mEnabled = false;
+            };
+
+            struct Script
+            {
+                std::string mName;
+                Ptr mPtr;
+                bool mEveryFrame = false;
+                bool mObserved = false;
+                unsigned int mInterval = 1;
+                unsigned int mPhase = 0;
+                unsigned int mIdleRuns = 0;
+                ObservedState mState;
+            };
+
+            std::list<Script> mScripts;
+            std::list<Script>::iterator mIter;
             const MWWorld::ESMStore& mStore;
+            bool mScheduling;
+            unsigned int mMaxInterval;
+            std::set<std::string> mEveryFrame;
+            unsigned int mFrame;
+            unsigned int mNextPhase;
+
+            bool isDue (Script& script);
+            ///< Update the schedule of \a script and return if it should run in this frame.
 
         public:
 
             LocalScripts (const MWWorld::ESMStore& store);
 
+            void setScheduling (unsigned int maxInterval, const std::vector<std::string>& everyFrame);
+            ///< Run idle scripts at most every \a maxInterval frames (1 disables scheduling).
+            /// \param everyFrame Names of the scripts that always run every frame.
+
             void startIteration();
-            ///< Set the iterator to the begin of the script list.
+            ///< Set the iterator to the begin of the script list and advance to the next frame.
 
             bool getNext(std::pair<std::string, Ptr>& script);
-            ///< Get next local script
+            ///< Get next local script to run in the current frame
             /// @return Did we get a script?
 
             void add (const std::string& scriptName, const Ptr& ptr);
@@ -26,6 +26,7 @@ namespace MWWorld
     void RefData::setLuaScripts(std::shared_ptr<MWLua::LocalScripts>&& scripts)
     {
         mChanged = true;
+        mDirty = true;
         mLuaScripts = std::move(scripts);
     }
 
@@ -37,6 +38,7 @@ namespace MWWorld
         mCount = refData.mCount;
         mPosition = refData.mPosition;
         mChanged = refData.mChanged;
+        mDirty = true;
         mDeletedByContentFile = refData.mDeletedByContentFile;
         mFlags = refData.mFlags;
         mPhysicsPostponed = refData.mPhysicsPostponed;
@@ -55,7 +57,7 @@ namespace MWWorld
     }
 
     RefData::RefData()
-    : mBaseNode(nullptr), mDeletedByContentFile(false), mEnabled (true), mPhysicsPostponed(false), mCount (1), mCustomData (nullptr), mChanged(false), mFlags(0)
+    : mBaseNode(nullptr), mDeletedByContentFile(false), mEnabled (true), mPhysicsPostponed(false), mCount (1), mCustomData (nullptr), mChanged(false), mDirty(true), mFlags(0)
     {
         for (int i=0; i<3; ++i)
         {
@@ -68,7 +70,7 @@ namespace MWWorld
     : mBaseNode(nullptr), mDeletedByContentFile(false), mEnabled (true), mPhysicsPostponed(false), 
       mCount (1), mPosition (cellRef.mPos),
       mCustomData (nullptr),
-      mChanged(false), mFlags(0) // Loading from ESM/ESP files -> assume unchanged
+      mChanged(false), mDirty(true), mFlags(0) // Loading from ESM/ESP files -> assume unchanged, but not saved yet
     {
     }
 
@@ -79,7 +81,7 @@ namespace MWWorld
       mPosition (objectState.mPosition),
       mAnimationState(objectState.mAnimationState),
       mCustomData (nullptr),
-      mChanged(true), mFlags(objectState.mFlags) // Loading from a savegame -> assume changed
+      mChanged(true), mDirty(true), mFlags(objectState.mFlags) // Loading from a savegame -> assume changed
     {
         // "Note that the ActivationFlag_UseEnabled is saved to the reference,
         // which will result in permanently suppressed activation if the reference script is removed.
@@ -168,7 +170,10 @@ namespace MWWorld
     void RefData::setLocals (const ESM::Script& script)
     {
         if (mLocals.configure (script) && !mLocals.isEmpty())
+        {
             mChanged = true;
+            mDirty = true;
+        }
     }
 
     void RefData::setCount (int count)
@@ -178,6 +183,8 @@ namespace MWWorld
 
         mChanged = true;
 
+        mDirty = true;
+
         mCount = count;
     }
 
@@ -197,6 +204,12 @@ namespace MWWorld
     }
 
     MWScript::Locals& RefData::getLocals()
+    {
+        mDirty = true;
+        return mLocals;
+    }
+
+    const MWScript::Locals& RefData::getLocals() const
     {
         return mLocals;
     }
@@ -211,6 +224,7 @@ namespace MWWorld
         if (!mEnabled)
         {
             mChanged = true;
+            mDirty = true;
             mEnabled = true;
         }
     }
@@ -220,6 +234,7 @@ namespace MWWorld
         if (mEnabled)
         {
             mChanged = true;
+            mDirty = true;
             mEnabled = false;
         }
     }
@@ -227,6 +242,7 @@ namespace MWWorld
     void RefData::setPosition(const ESM::Position& pos)
     {
         mChanged = true;
+        mDirty = true;
         mPosition = pos;
     }
 
@@ -238,11 +254,14 @@ namespace MWWorld
     void RefData::setCustomData(std::unique_ptr<CustomData>&& value) noexcept
     {
         mChanged = true; // We do not currently track CustomData, so assume anything with a CustomData is changed
+        mDirty = true;
         mCustomData = std::move(value);
     }
 
     CustomData *RefData::getCustomData()
     {
+        // We do not track changes to CustomData either, so assume it is changed through non-const access
+        mDirty = true;
         return mCustomData.get();
     }
 
@@ -256,8 +275,24 @@ namespace MWWorld
         return mChanged || !mAnimationState.empty();
     }
 
+    bool RefData::isDirty() const
+    {
+        return mDirty;
+    }
+
+    void RefData::setDirty()
+    {
+        mDirty = true;
+    }
+
+    void RefData::clearDirty()
+    {
+        mDirty = false;
+    }
+
     bool RefData::activateByScript()
     {
+        mDirty = true;
         bool ret = (mFlags & Flag_ActivationBuffered);
         mFlags &= ~(Flag_SuppressActivate|Flag_OnActivate);
         return ret;
@@ -267,6 +302,7 @@ namespace MWWorld
     {
         if (mFlags & Flag_SuppressActivate)
         {
+            mDirty = true;
             mFlags |= Flag_OnActivate|Flag_ActivationBuffered;
             return false;
         }
@@ -278,12 +314,18 @@ namespace MWWorld
 
     bool RefData::onActivate()
     {
+        mDirty = true;
         bool ret = mFlags & Flag_OnActivate;
         mFlags |= Flag_SuppressActivate;
         mFlags &= (~Flag_OnActivate);
         return ret;
     }
 
+    bool RefData::isActivationPending() const
+    {
+        return mFlags & Flag_OnActivate;
+    }
+
     const ESM::AnimationState& RefData::getAnimationState() const
     {
         return mAnimationState;
@@ -291,6 +333,7 @@ namespace MWWorld
 
     ESM::AnimationState& RefData::getAnimationState()
     {
+        mDirty = true;
         return mAnimationState;
     }
 
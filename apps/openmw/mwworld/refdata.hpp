@@ -63,6 +63,8 @@ namespace MWWorld
 
             bool mChanged;
 
+            bool mDirty;
+
             unsigned int mFlags;
 
         public:
@@ -102,7 +104,7 @@ namespace MWWorld
 
             void setLocals (const ESM::Script& script);
 
-            MWLua::LocalScripts* getLuaScripts() { return mLuaScripts.get(); }
+            MWLua::LocalScripts* getLuaScripts() { mDirty = true; return mLuaScripts.get(); }
             void setLuaScripts(std::shared_ptr<MWLua::LocalScripts>&&);
 
             void setCount (int count);
@@ -123,6 +125,8 @@ namespace MWWorld
 
             MWScript::Locals& getLocals();
 
+            const MWScript::Locals& getLocals() const;
+
             bool isEnabled() const;
 
             void enable();
@@ -145,11 +149,22 @@ namespace MWWorld
 
             bool onActivate();
 
+            bool isActivationPending() const;
+            ///< Was an activation redirected to the OnActivate function of the local script?
+
             bool activateByScript();
 
             bool hasChanged() const;
             ///< Has this RefData changed since it was originally loaded?
 
+            bool isDirty() const;
+            ///< Has this RefData possibly changed since it was last written to a saved game?
+            /// \note Non-const access to locals, custom data and Lua scripts counts as a change.
+
+            void setDirty();
+
+            void clearDirty();
+
             const ESM::AnimationState& getAnimationState() const;
             ESM::AnimationState& getAnimationState();
     };
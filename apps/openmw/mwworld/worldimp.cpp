@@ -4,6 +4,10 @@
 #include <osg/ComputeBoundsVisitor>
 #include <osg/Timer>
 
+#include <sstream>
+
+#include <boost/filesystem/operations.hpp>
+
 #include <MyGUI_TextIterator.h>
 
 #include <LinearMath/btAabbUtil2.h>
@@ -34,6 +38,10 @@
 
 #include <components/loadinglistener/loadinglistener.hpp>
 
+#include <components/terrain/diskcache.hpp>
+
+#include <components/vfs/manager.hpp>
+
 #include "../mwbase/environment.hpp"
 #include "../mwbase/soundmanager.hpp"
 #include "../mwbase/mechanicsmanager.hpp"
@@ -124,6 +132,49 @@ namespace MWWorld
         }
     };
 
+    namespace
+    {
+        void addFileToKey(std::ostream& key, const boost::filesystem::path& path)
+        {
+            boost::system::error_code ec;
+            key << path.string() << ' ' << boost::filesystem::file_size(path, ec) << ' ' << boost::filesystem::last_write_time(path, ec) << '\n';
+        }
+
+        /// Describe the data directories, archives, content files and the meshes and textures they provide,
+        /// so cached chunks are not reused after any of them changed.
+        std::string getChunkCacheContentKey(const Files::Collections& fileCollections, const std::vector<std::string>& archives,
+            const std::vector<std::string>& contentFiles, const VFS::Manager& vfs)
+        {
+            std::ostringstream key;
+            for (const boost::filesystem::path& dir : fileCollections.getPaths())
+                key << dir.string() << '\n';
+            for (const std::string& archive : archives)
+            {
+                if (fileCollections.doesExist(archive))
+                    addFileToKey(key, fileCollections.getPath(archive));
+            }
+            for (const std::string& file : contentFiles)
+            {
+                const Files::MultiDirCollection& col = fileCollections.getCollection(boost::filesystem::path(file).extension().string());
+                if (col.doesExist(file))
+                    addFileToKey(key, col.getPath(file));
+            }
+            // Files inside archives are covered by the archives; loose files are identified by their own size and time
+            for (const char* dir : {"meshes/", "textures/"})
+            {
+                for (const std::string& name : vfs.getRecursiveDirectoryIterator(dir))
+                {
+                    const boost::filesystem::path path = vfs.getAbsoluteFileName(name);
+                    if (path.is_absolute())
+                        addFileToKey(key, path);
+                    else
+                        key << name << '\n';
+                }
+            }
+            return key.str();
+        }
+    }
+
     void World::adjustSky()
     {
         if (mSky && (isCellExterior() || isCellQuasiExterior()))
@@ -140,11 +191,12 @@ namespace MWWorld
         osg::ref_ptr<osg::Group> rootNode,
         Resource::ResourceSystem* resourceSystem, SceneUtil::WorkQueue* workQueue,
         const Files::Collections& fileCollections,
+        const std::vector<std::string>& archives,
         const std::vector<std::string>& contentFiles,
         const std::vector<std::string>& groundcoverFiles,
         ToUTF8::Utf8Encoder* encoder, int activationDistanceOverride,
         const std::string& startCell, const std::string& startupScript,
-        const std::string& resourcePath, const std::string& userDataPath)
+        const std::string& resourcePath, const std::string& userDataPath, const std::string& cachePath)
     : mResourceSystem(resourceSystem), mLocalScripts(mStore),
       mCells(mStore, mReaders), mSky(true),
       mGodMode(false), mScriptsEnabled(true), mDiscardMovements(true), mContentFiles (contentFiles),
@@ -188,6 +240,9 @@ namespace MWWorld
         }
 
         mRendering = std::make_unique<MWRender::RenderingManager>(viewer, rootNode, resourceSystem, workQueue, resourcePath, *mNavigator, mGroundcoverStore);
+        if (Settings::Manager::getBool("chunk cache", "Terrain"))
+            mRendering->setChunkDiskCache(new Terrain::DiskCache((boost::filesystem::path(cachePath) / "chunks").string(),
+                getChunkCacheContentKey(fileCollections, archives, contentFiles, *resourceSystem->getVFS())));
         mProjectileManager = std::make_unique<ProjectileManager>(mRendering->getLightRoot()->asGroup(), resourceSystem, mRendering.get(), mPhysics.get());
         mRendering->preloadCommonAssets();
 
@@ -339,10 +394,12 @@ namespace MWWorld
         writer.writeHNOString("RAND", Misc::Rng::serialize(mPrng));
         writer.endRecord(ESM::REC_RAND);
 
-        // Active cells could have a dirty fog of war, sync it to the CellStore first
+        // Active cells could have a dirty fog of war, sync it to the CellStore first.
+        // Their objects also change in ways that are not tracked, e.g. through their Lua scripts.
         for (CellStore* cellstore : mWorldScene->getActiveCells())
         {
             MWBase::Environment::get().getWindowManager()->writeFog(cellstore);
+            cellstore->setDirty();
         }
 
         MWMechanics::CreatureStats::writeActorIdCounter(writer);
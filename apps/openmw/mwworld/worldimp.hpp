@@ -191,11 +191,12 @@ namespace MWWorld
                 osg::ref_ptr<osg::Group> rootNode,
                 Resource::ResourceSystem* resourceSystem, SceneUtil::WorkQueue* workQueue,
                 const Files::Collections& fileCollections,
+                const std::vector<std::string>& archives,
                 const std::vector<std::string>& contentFiles,
                 const std::vector<std::string>& groundcoverFiles,
                 ToUTF8::Utf8Encoder* encoder, int activationDistanceOverride,
                 const std::string& startCell, const std::string& startupScript,
-                const std::string& resourcePath, const std::string& userDataPath);
+                const std::string& resourcePath, const std::string& userDataPath, const std::string& cachePath);
 
             virtual ~World();
 
@@ -0,0 +1,46 @@
+#ifndef GAME_MWWORLD_WRITTENRECORDCACHE_H
+#define GAME_MWWORLD_WRITTENRECORDCACHE_H
+
+#include <map>
+#include <sstream>
+#include <string>
+
+#include <components/esm3/esmwriter.hpp>
+
+namespace MWWorld
+{
+    /// \brief Saved game record bodies (without the record header) as of the last time they were written
+    ///
+    /// Lets objects that did not change since the previous save be written again without re-serializing them.
+    template <class Key>
+    class WrittenRecordCache
+    {
+        public:
+
+            /// Return the record body of \a key. \a write(ESM::ESMWriter&) is called to refresh it if it is not
+            /// cached yet or if \a changed.
+            template <class Function>
+            const std::string& get(const Key& key, bool changed, Function&& write)
+            {
+                std::string& data = mRecords[key];
+                if (data.empty() || changed)
+                {
+                    std::ostringstream stream;
+                    ESM::ESMWriter writer;
+                    writer.saveRecords(stream);
+                    write(writer);
+                    writer.close();
+                    data = stream.str();
+                }
+                return data;
+            }
+
+            void clear() { mRecords.clear(); }
+
+        private:
+
+            std::map<Key, std::string> mRecords;
+    };
+}
+
+#endif
@@ -71,6 +71,9 @@ namespace OpenMW
             ("script-blacklist-use", bpo::value<bool>()->implicit_value(true)
                 ->default_value(true), "enable script blacklisting")
 
+            ("script-every-frame", bpo::value<StringsVector>()->default_value(StringsVector(), "")
+                ->multitoken()->composing(), "always run the specified local script every frame (if local script scheduling is enabled)")
+
             ("load-savegame", bpo::value<Files::MaybeQuotedPath>()->default_value(Files::MaybeQuotedPath(), ""),
                 "load a save game file on game startup (specify an absolute filename or a filename relative to the current working directory)")
 
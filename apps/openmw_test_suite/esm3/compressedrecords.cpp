@@ -0,0 +1,100 @@
+#include <components/esm/defs.hpp>
+#include <components/esm3/compressedrecords.hpp>
+#include <components/esm3/esmreader.hpp>
+#include <components/esm3/esmwriter.hpp>
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+namespace
+{
+    using namespace testing;
+    using namespace ESM;
+
+    std::string writeRecords(std::size_t count, std::size_t size)
+    {
+        std::ostringstream stream;
+        ESMWriter writer;
+        writer.saveRecords(stream);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            writer.startRecord(REC_GLOB);
+            writer.writeHNT("INDX", static_cast<std::uint32_t>(i));
+            writer.writeHNString("DATA", std::string(size, static_cast<char>('a' + i % 26)));
+            writer.endRecord(REC_GLOB);
+        }
+        writer.close();
+        return stream.str();
+    }
+
+    std::string roundTrip(const std::string& records, const std::vector<std::size_t>& breaks, std::size_t chunkSize,
+        std::size_t& chunks)
+    {
+        auto stream = std::make_unique<std::stringstream>();
+        ESMWriter writer;
+        writer.saveRecords(*stream);
+        writeCompressedRecords(writer, records, breaks, chunkSize);
+        writer.close();
+
+        ESMReader reader;
+        reader.openRaw(std::move(stream), "compressed");
+        EXPECT_EQ(reader.getRecName().toInt(), REC_CHNK);
+        reader.getRecHeader();
+        const ESM_Context context = reader.getContext();
+        chunks = 0;
+        while (reader.hasMoreSubs())
+        {
+            reader.getSubName();
+            if (reader.retSubName().toInt() == fourCC("DATA"))
+                ++chunks;
+            reader.skipHSub();
+        }
+        reader.restoreContext(context);
+        std::string result = readCompressedRecords(reader);
+        EXPECT_FALSE(reader.hasMoreRecs());
+        return result;
+    }
+
+    TEST(ESM3CompressedRecordsTest, roundTripShouldRestoreRecords)
+    {
+        const std::string records = writeRecords(100, 1000);
+        std::size_t chunks = 0;
+        EXPECT_EQ(roundTrip(records, {}, 1 << 20, chunks), records);
+        EXPECT_EQ(chunks, 1);
+    }
+
+    TEST(ESM3CompressedRecordsTest, roundTripShouldSplitRecordsIntoChunks)
+    {
+        const std::string records = writeRecords(100, 1000);
+        std::size_t chunks = 0;
+        EXPECT_EQ(roundTrip(records, {}, 10000, chunks), records);
+        EXPECT_GT(chunks, 5);
+        EXPECT_LT(chunks, 15);
+    }
+
+    TEST(ESM3CompressedRecordsTest, roundTripShouldStartChunksAtBreaks)
+    {
+        const std::string records = writeRecords(2, 10);
+        std::size_t chunks = 0;
+        EXPECT_EQ(roundTrip(records, {records.size() / 2, records.size()}, 1 << 20, chunks), records);
+        EXPECT_EQ(chunks, 2);
+    }
+
+    TEST(ESM3CompressedRecordsTest, roundTripShouldSupportNoRecords)
+    {
+        std::size_t chunks = 0;
+        EXPECT_EQ(roundTrip(std::string(), {}, 1 << 20, chunks), std::string());
+        EXPECT_EQ(chunks, 0);
+    }
+
+    TEST(ESM3CompressedRecordsTest, writeShouldThrowOnIncompleteRecord)
+    {
+        const std::string records = writeRecords(2, 10);
+        std::ostringstream stream;
+        ESMWriter writer;
+        writer.saveRecords(stream);
+        EXPECT_THROW(writeCompressedRecords(writer, std::string_view(records).substr(0, records.size() - 1), {}),
+            std::runtime_error);
+    }
+}
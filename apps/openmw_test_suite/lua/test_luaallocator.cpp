@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+
+#include <components/lua/luaallocator.hpp>
+
+namespace
+{
+    using namespace testing;
+    using LuaUtil::LuaAllocator;
+
+    void* allocate(LuaAllocator& allocator, std::size_t size)
+    {
+        return LuaAllocator::alloc(&allocator, nullptr, 0, size);
+    }
+
+    void* reallocate(LuaAllocator& allocator, void* ptr, std::size_t osize, std::size_t nsize)
+    {
+        return LuaAllocator::alloc(&allocator, ptr, osize, nsize);
+    }
+
+    TEST(LuaAllocatorTest, ShouldReturnAlignedBlocks)
+    {
+        LuaAllocator allocator;
+        for (std::size_t size : {1, 7, 8, 24, 100, 248, 249, 1000, 100000})
+        {
+            void* ptr = allocate(allocator, size);
+            ASSERT_NE(ptr, nullptr);
+            EXPECT_EQ(reinterpret_cast<std::uintptr_t>(ptr) % 8, 0u) << size;
+            std::memset(ptr, 0xff, size);
+            EXPECT_EQ(reallocate(allocator, ptr, size, 0), nullptr);
+        }
+        EXPECT_EQ(allocator.getTotalBytes(), 0);
+    }
+
+    TEST(LuaAllocatorTest, ShouldReuseFreedSmallBlocks)
+    {
+        LuaAllocator allocator;
+        void* first = allocate(allocator, 32);
+        reallocate(allocator, first, 32, 0);
+        EXPECT_EQ(allocate(allocator, 30), first);
+        EXPECT_EQ(allocator.getPooledBytes(), static_cast<std::int64_t>(LuaAllocator::sChunkSize));
+    }
+
+    TEST(LuaAllocatorTest, ShouldNotPoolLargeBlocks)
+    {
+        LuaAllocator allocator;
+        void* ptr = allocate(allocator, LuaAllocator::sMaxPooledSize);
+        EXPECT_EQ(allocator.getPooledBytes(), 0);
+        reallocate(allocator, ptr, LuaAllocator::sMaxPooledSize, 0);
+    }
+
+    TEST(LuaAllocatorTest, ShouldKeepContentOnReallocation)
+    {
+        LuaAllocator allocator;
+        char* ptr = static_cast<char*>(allocate(allocator, 10));
+        std::memcpy(ptr, "abcdefghij", 10);
+        for (std::size_t size : {12, 100, 1000, 5000, 200, 10})
+        {
+            ptr = static_cast<char*>(reallocate(allocator, ptr, allocator.getTotalBytes(), size));
+            ASSERT_NE(ptr, nullptr);
+            EXPECT_EQ(std::memcmp(ptr, "abcdefghij", 10), 0) << size;
+            EXPECT_EQ(allocator.getTotalBytes(), static_cast<std::int64_t>(size));
+        }
+        reallocate(allocator, ptr, 10, 0);
+        EXPECT_EQ(allocator.getTotalBytes(), 0);
+    }
+
+    TEST(LuaAllocatorTest, ShouldAccountBlocksToOwnerOfScope)
+    {
+        LuaAllocator allocator;
+        const LuaAllocator::OwnerId first = allocator.addOwner("first");
+        const LuaAllocator::OwnerId second = allocator.addOwner("second");
+        void* common = allocate(allocator, 10);
+        void* firstBlock;
+        void* secondBlock;
+        {
+            LuaAllocator::OwnerScope firstScope(allocator, first);
+            firstBlock = allocate(allocator, 100);
+            {
+                LuaAllocator::OwnerScope secondScope(allocator, second);
+                secondBlock = allocate(allocator, 1000);
+            }
+            // Reallocated blocks stay with their owner
+            secondBlock = reallocate(allocator, secondBlock, 1000, 20);
+        }
+        EXPECT_EQ(allocator.getOwners()[LuaAllocator::sCommonOwner].mBytes, 10);
+        EXPECT_EQ(allocator.getOwners()[first].mBytes, 100);
+        EXPECT_EQ(allocator.getOwners()[second].mBytes, 20);
+        EXPECT_GE(allocator.getOwners()[second].mPeakBytes, 1000);
+        EXPECT_EQ(allocator.getTotalBytes(), 130);
+
+        // Blocks are freed from the owner they were allocated by, regardless of the scope
+        reallocate(allocator, firstBlock, 100, 0);
+        reallocate(allocator, secondBlock, 20, 0);
+        reallocate(allocator, common, 10, 0);
+        EXPECT_EQ(allocator.getOwners()[first].mBytes, 0);
+        EXPECT_EQ(allocator.getOwners()[second].mBytes, 0);
+    }
+
+    TEST(LuaAllocatorTest, ShouldReuseOwnerIdOnlyAfterAllBlocksAreFreed)
+    {
+        LuaAllocator allocator;
+        const LuaAllocator::OwnerId owner = allocator.addOwner("owner");
+        void* block;
+        {
+            LuaAllocator::OwnerScope scope(allocator, owner);
+            block = allocate(allocator, 64);
+        }
+        allocator.removeOwner(owner);
+        EXPECT_TRUE(allocator.getOwners()[owner].mRemoved);
+        EXPECT_NE(allocator.addOwner("other"), owner);
+        reallocate(allocator, block, 64, 0);
+        EXPECT_EQ(allocator.addOwner("reused"), owner);
+        EXPECT_EQ(allocator.getOwners()[owner].mName, "reused");
+        EXPECT_FALSE(allocator.getOwners()[owner].mRemoved);
+    }
+
+    TEST(LuaAllocatorTest, ShouldMarkOwnerExceedingSoftLimit)
+    {
+        LuaAllocator allocator;
+        const LuaAllocator::OwnerId owner = allocator.addOwner("owner");
+        const LuaAllocator::OwnerId limited = allocator.addOwner("limited", 3000);
+        allocator.setDefaultSoftLimit(1000);
+        void* block;
+        void* limitedBlock;
+        {
+            LuaAllocator::OwnerScope scope(allocator, owner);
+            block = allocate(allocator, 2000);
+        }
+        {
+            LuaAllocator::OwnerScope scope(allocator, limited);
+            limitedBlock = allocate(allocator, 2000);
+        }
+        EXPECT_TRUE(allocator.getOwners()[owner].mLimitExceeded);
+        EXPECT_FALSE(allocator.getOwners()[limited].mLimitExceeded);
+        reallocate(allocator, block, 2000, 0);
+        reallocate(allocator, limitedBlock, 2000, 0);
+        EXPECT_FALSE(allocator.getOwners()[owner].mLimitExceeded);
+    }
+}
@@ -448,6 +448,48 @@ CUSTOM, PLAYER: useInterface.lua
         EXPECT_EQ(counter4, 25);
     }
 
+    TEST_F(LuaScriptsContainerTest, Profiler)
+    {
+        using TimerType = LuaUtil::ScriptsContainer::TimerType;
+        LuaUtil::ScriptsContainer scripts(&mLua, "Test");
+        int test1Id = *mCfg.findId("test1.lua");
+        int test2Id = *mCfg.findId("test2.lua");
+        testing::internal::CaptureStdout();
+        EXPECT_TRUE(scripts.addCustomScript(test1Id));
+        EXPECT_TRUE(scripts.addCustomScript(test2Id));
+        scripts.registerTimerCallback(test1Id, "A", sol::make_object(mLua.sol(), [](int) {}));
+        std::string X = LuaUtil::serialize(mLua.sol().create_table_with("x", 0.5));
+
+        scripts.update(1.5f);
+        EXPECT_TRUE(scripts.getProfile().empty());
+
+        LuaUtil::ScriptsContainer::setProfilerEnabled(true);
+        scripts.update(1.5f);
+        scripts.update(1.5f);
+        scripts.receiveEvent("Event1", X);
+        scripts.setupSerializableTimer(TimerType::SIMULATION_TIME, 5, test1Id, "A", sol::make_object(mLua.sol(), 1));
+        scripts.setupUnsavableTimer(TimerType::SIMULATION_TIME, 5, test2Id, sol::make_object(mLua.sol(), [] {}));
+        scripts.processTimers(6, 6);
+        LuaUtil::ScriptsContainer::setProfilerEnabled(false);
+        scripts.update(1.5f);
+        internal::GetCapturedStdout();
+
+        const auto& profile = scripts.getProfile();
+        ASSERT_EQ(profile.size(), 2u);
+        const LuaUtil::ScriptsContainer::ScriptProfile& test1 = profile.at(test1Id);
+        EXPECT_EQ(test1.mEngineHandlers.at("onUpdate").mCalls, 2u);
+        EXPECT_EQ(test1.mEvents.at("Event1").mCalls, 1u);
+        EXPECT_EQ(test1.mTimers.at("A").mCalls, 1u);
+        EXPECT_GE(test1.mTime, test1.mEngineHandlers.at("onUpdate").mTime);
+        const LuaUtil::ScriptsContainer::ScriptProfile& test2 = profile.at(test2Id);
+        EXPECT_EQ(test2.mEngineHandlers.at("onUpdate").mCalls, 2u);
+        EXPECT_EQ(test2.mEvents.at("Event1").mCalls, 1u);
+        EXPECT_EQ(test2.mTimers.at("<temporary>").mCalls, 1u);
+
+        scripts.clearProfile();
+        EXPECT_TRUE(scripts.getProfile().empty());
+    }
+
     TEST_F(LuaScriptsContainerTest, CallbackWrapper)
     {
         LuaUtil::Callback callback{mLua.sol()["print"], mLua.newTable()};
@@ -271,4 +271,90 @@ namespace
         EXPECT_EQ(ry.b, 3);
     }
 
+    TEST(LuaSerializationTest, RepeatedStrings)
+    {
+        sol::state lua;
+        sol::table table(lua, sol::create);
+        for (int i = 1; i <= 300; ++i)
+        {
+            sol::table item(lua, sol::create);
+            item["name"] = "item";
+            item["count"] = i;
+            table[i] = item;
+        }
+
+        std::string serialized = LuaUtil::serialize(table);
+        // version, table start and end, 300 * (index, item table start and end, count),
+        // "name", "item", "count" in the first item, and 2 bytes per string reference in other items.
+        EXPECT_EQ(serialized.size(), 3 + 300 * (9 + 2 + 9) + (5 + 5 + 6) + 299 * 3 * 2);
+        sol::table res = LuaUtil::deserialize(lua, serialized);
+        ASSERT_EQ(res.size(), 300);
+        for (int i = 1; i <= 300; ++i)
+        {
+            EXPECT_EQ(res.get<sol::table>(i).get<std::string>("name"), "item");
+            EXPECT_EQ(res.get<sol::table>(i).get<int>("count"), i);
+        }
+    }
+
+    TEST(LuaSerializationTest, PreviousFormatVersion)
+    {
+        sol::state lua;
+        std::string serialized = LuaUtil::serialize(sol::make_object<std::string_view>(lua, "abcd"));
+        serialized[0] = 0;
+        EXPECT_EQ(LuaUtil::deserialize(lua, serialized).as<std::string>(), "abcd");
+        serialized[0] = 2;
+        EXPECT_ERROR(LuaUtil::deserialize(lua, serialized), "Incorrect version of Lua serialization format: 2");
+    }
+
+    TEST(LuaSerializationTest, EventDataInSameLuaState)
+    {
+        sol::state lua;
+        sol::table table(lua, sol::create);
+        table["x"] = 1;
+        table["v"] = osg::Vec2f(1, 2);
+        LuaUtil::EventData data(lua, table, nullptr);
+        EXPECT_TRUE(data.isInLuaState(lua));
+        table["x"] = 2;
+
+        sol::table res = data.get(lua, nullptr);
+        EXPECT_EQ(res.get<int>("x"), 1);
+        EXPECT_EQ(res.get<osg::Vec2f>("v"), osg::Vec2f(1, 2));
+        EXPECT_EQ(LuaUtil::deserialize(lua, data.getBinaryData()).as<sol::table>().get<int>("x"), 1);
+
+        EXPECT_EQ(LuaUtil::EventData(lua, sol::nil, nullptr).get(lua, nullptr), sol::nil);
+        EXPECT_ERROR(LuaUtil::EventData(lua, lua.safe_script("return function() end").get<sol::object>(), nullptr),
+                     "Functions are not allowed to be serialized.");
+        table["s"] = TestStruct1{1.5, 2.5};
+        EXPECT_ERROR(LuaUtil::EventData(lua, table, nullptr), "Value is not serializable.");
+    }
+
+    TEST(LuaSerializationTest, EventDataWithUserdata)
+    {
+        sol::state lua;
+        sol::table table(lua, sol::create);
+        table["x"] = TestStruct1{1.5, 2.5};
+        TestSerializer serializer;
+        LuaUtil::EventData data(lua, table, &serializer);
+
+        sol::table res = data.get(lua, &serializer);
+        EXPECT_EQ(res.get<TestStruct1>("x").b, 2.5);
+        EXPECT_ERROR(data.get(lua, nullptr), "Unknown type in serialized data:");
+    }
+
+    TEST(LuaSerializationTest, DetachedEventData)
+    {
+        sol::state lua1;
+        sol::state lua2;
+        sol::table table(lua1, sol::create);
+        table["x"] = "abcd";
+        LuaUtil::EventData data(lua1, table, nullptr);
+        EXPECT_FALSE(data.isInLuaState(lua2));
+        EXPECT_THROW(data.get(lua2, nullptr), std::logic_error);
+
+        data.detach();
+        EXPECT_FALSE(data.isInLuaState(lua1));
+        sol::table res = data.get(lua2, nullptr);
+        EXPECT_EQ(res.get<std::string>("x"), "abcd");
+    }
+
 }
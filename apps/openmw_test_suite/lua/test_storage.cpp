@@ -76,6 +76,27 @@ namespace
         EXPECT_EQ(get<std::string>(mLua, "ro:get('x').y"), "abc");
     }
 
+    TEST(LuaUtilStorageTest, AnotherLuaState)
+    {
+        sol::state mLua;
+        sol::state otherLua;
+        LuaUtil::LuaStorage::initLuaBindings(mLua);
+        LuaUtil::LuaStorage::initLuaBindings(otherLua);
+        LuaUtil::LuaStorage storage(mLua);
+        mLua["mutable"] = storage.getMutableSection("test");
+        otherLua["ro"] = storage.getReadOnlySection("test", otherLua);
+
+        mLua.safe_script("mutable:set('x', { y = 'abc' })");
+        EXPECT_EQ(get<std::string>(mLua, "mutable:get('x').y"), "abc");
+        EXPECT_EQ(get<std::string>(otherLua, "ro:get('x').y"), "abc");
+        EXPECT_EQ(get<std::string>(otherLua, "ro:asTable().x.y"), "abc");
+        EXPECT_THROW(otherLua.safe_script("ro:get('x').y = 'def'"), std::exception);
+
+        mLua.safe_script("mutable:set('x', { y = 'def' })");
+        EXPECT_EQ(get<std::string>(otherLua, "ro:get('x').y"), "def");
+        EXPECT_TRUE(get<bool>(otherLua, "ro:get('z') == nil"));
+    }
+
     TEST(LuaUtilStorageTest, Saving)
     {
         sol::state mLua;
@@ -1,4 +1,5 @@
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <sstream>
 
 #include "test_utils.hpp"
@@ -49,6 +50,19 @@ namespace
             mInterpreter.run(&script.mByteCode[0], static_cast<int>(script.mByteCode.size()), context);
         }
 
+        void runDecoded(const CompiledScript& script, TestInterpreterContext& context)
+        {
+            Interpreter::Program program;
+            program.mCode = script.mByteCode;
+            mInterpreter.decode(program);
+            mInterpreter.run(program, context);
+        }
+
+        void setProfile(Interpreter::Profile* profile)
+        {
+            mInterpreter.setProfile(profile);
+        }
+
         template<typename T, typename ...TArgs>
         void installOpcode(int code, TArgs&& ...args)
         {
@@ -529,6 +543,104 @@ messagebox,"this is a %g",a
         }
     }
 
+    TEST_F(MWScriptTest, mwscript_test_decoded_loop)
+    {
+        if(const auto script = compile(sScript1))
+        {
+            for(int i = 0; i < 10; ++i)
+            {
+                TestInterpreterContext context;
+                context.setLocalShort(1, i);
+                runDecoded(*script, context);
+                EXPECT_EQ(context.getLocalShort(0), std::max(i, 1));
+            }
+        }
+        else
+        {
+            FAIL();
+        }
+    }
+
+    TEST_F(MWScriptTest, mwscript_test_decoded_math)
+    {
+        if(const auto script = compile(sScript3))
+        {
+            TestInterpreterContext context;
+            for(int i = 1; i < 1000; ++i)
+            {
+                context.setLocalShort(0, i);
+                runDecoded(*script, context);
+                EXPECT_EQ(context.getLocalShort(1), i + 1);
+                EXPECT_EQ(context.getLocalShort(2), i - 1);
+                EXPECT_EQ(context.getLocalShort(3), (i + 1) * (i - 1));
+                EXPECT_EQ(context.getLocalShort(4), (i + 1) * (i - 1) / i);
+            }
+        }
+        else
+        {
+            FAIL();
+        }
+    }
+
+    TEST_F(MWScriptTest, mwscript_test_decoded_unknown_opcode_should_throw_only_when_executed)
+    {
+        registerExtensions();
+        if(const auto script = compile(sIssue6363))
+        {
+            TestInterpreterContext context;
+            context.setLocalShort(0, 0);
+            EXPECT_NO_THROW(runDecoded(*script, context));
+            context.setLocalShort(0, 1);
+            EXPECT_THROW(runDecoded(*script, context), std::runtime_error);
+        }
+        else
+        {
+            FAIL();
+        }
+    }
+
+    TEST_F(MWScriptTest, mwscript_test_profile_should_count_executed_instructions)
+    {
+        if(const auto script = compile(sScript1))
+        {
+            Interpreter::Profile byteCode;
+            Interpreter::Profile decoded;
+            TestInterpreterContext context;
+            context.setLocalShort(1, 5);
+            setProfile(&byteCode);
+            run(*script, context);
+            context.setLocalShort(1, 5);
+            setProfile(&decoded);
+            runDecoded(*script, context);
+            setProfile(nullptr);
+            runDecoded(*script, context);
+
+            EXPECT_GT(decoded.mInstructions, 0u);
+            EXPECT_EQ(decoded.mInstructions, byteCode.mInstructions);
+            std::uint64_t count = 0;
+            for (const auto& [id, stats] : decoded.mOpcodes)
+            {
+                EXPECT_EQ(Interpreter::getOpcodeId(id), id);
+                EXPECT_EQ(stats.mCount, byteCode.mOpcodes[id].mCount);
+                count += stats.mCount;
+            }
+            EXPECT_EQ(count, decoded.mInstructions);
+        }
+        else
+        {
+            FAIL();
+        }
+    }
+
+    TEST(MWScriptExtensionsTest, find_keyword_should_return_longest_keyword_generating_opcode)
+    {
+        Compiler::Extensions extensions;
+        Compiler::registerExtensions(extensions);
+        EXPECT_EQ(extensions.findKeyword(5, Compiler::Misc::opcodeToggleBorders), "toggleborders");
+        EXPECT_EQ(extensions.findKeyword(3, Compiler::Misc::opcodeShowSceneGraphExplicit), "showscenegraph");
+        EXPECT_EQ(extensions.findKeyword(5, 0x3ffffff), "");
+    }
+
     TEST_F(MWScriptTest, mwscript_test_forum_thread)
     {
         registerExtensions();
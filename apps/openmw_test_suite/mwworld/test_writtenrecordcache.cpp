@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+
+#include <components/esm3/cellref.hpp>
+#include <components/esm3/esmwriter.hpp>
+
+#include "apps/openmw/mwworld/cellref.hpp"
+#include "apps/openmw/mwworld/writtenrecordcache.hpp"
+
+namespace
+{
+    using namespace testing;
+    using namespace MWWorld;
+
+    struct WrittenRecordCacheTest : Test
+    {
+        WrittenRecordCache<int> mCache;
+        CellRef mRef = makeCellRef();
+        int mWriteCount = 0;
+
+        static CellRef makeCellRef()
+        {
+            ESM::CellRef ref;
+            ref.blank();
+            return CellRef(ref);
+        }
+
+        // Mirrors Cells::writeCell: the record is refreshed only if the reference possibly changed since the last save
+        const std::string& save()
+        {
+            const std::string& data = mCache.get(0, mRef.isDirty(), [&] (ESM::ESMWriter& writer)
+            {
+                ++mWriteCount;
+                writer.writeHNT("DATA", mRef.getPosition());
+            });
+            mRef.clearDirty();
+            return data;
+        }
+    };
+
+    TEST_F(WrittenRecordCacheTest, unchanged_reference_should_be_written_from_cache)
+    {
+        const std::string first = save();
+        const std::string second = save();
+        EXPECT_EQ(mWriteCount, 1);
+        EXPECT_EQ(first, second);
+        EXPECT_FALSE(first.empty());
+    }
+
+    TEST_F(WrittenRecordCacheTest, changed_reference_should_be_written_again)
+    {
+        const std::string first = save();
+        ESM::Position position = mRef.getPosition();
+        position.pos[0] = 42;
+        mRef.setPosition(position);
+        EXPECT_TRUE(mRef.isDirty());
+        const std::string second = save();
+        EXPECT_EQ(mWriteCount, 2);
+        EXPECT_NE(first, second);
+        EXPECT_FALSE(mRef.isDirty());
+    }
+
+    TEST_F(WrittenRecordCacheTest, clear_should_drop_cached_records)
+    {
+        save();
+        mCache.clear();
+        save();
+        EXPECT_EQ(mWriteCount, 2);
+    }
+}
@@ -0,0 +1,63 @@
+#include <components/nifosg/controller.hpp>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+namespace
+{
+    using namespace testing;
+    using namespace NifOsg;
+
+    std::shared_ptr<Nif::FloatKeyMap> makeLinearKeys(unsigned int type)
+    {
+        auto keys = std::make_shared<Nif::FloatKeyMap>();
+        keys->mInterpolationType = type;
+        keys->mTimes = { 0.f, 1.f, 2.f, 4.f };
+        keys->mValues = { 0.f, 2.f, 4.f, 8.f };
+        return keys;
+    }
+
+    TEST(NifOsgValueInterpolatorTest, emptyInterpolatorShouldReturnDefaultValue)
+    {
+        const FloatInterpolator interpolator(Nif::FloatKeyMapPtr(), 42.f);
+        EXPECT_TRUE(interpolator.empty());
+        EXPECT_EQ(interpolator.interpKey(1.f), 42.f);
+    }
+
+    TEST(NifOsgValueInterpolatorTest, shouldClampToFirstAndLastKey)
+    {
+        const FloatInterpolator interpolator(makeLinearKeys(Nif::InterpolationType_Linear));
+        EXPECT_EQ(interpolator.interpKey(-1.f), 0.f);
+        EXPECT_EQ(interpolator.interpKey(5.f), 8.f);
+    }
+
+    TEST(NifOsgValueInterpolatorTest, linearInterpolationShouldNotDependOnEvaluationOrder)
+    {
+        const FloatInterpolator interpolator(makeLinearKeys(Nif::InterpolationType_Linear));
+        for (float time : { 0.5f, 1.5f, 3.f, 0.25f, 3.5f, 1.f, 2.f, 0.75f })
+            EXPECT_FLOAT_EQ(interpolator.interpKey(time), 2.f * time) << time;
+    }
+
+    TEST(NifOsgValueInterpolatorTest, constantInterpolationShouldPickNearestKey)
+    {
+        const FloatInterpolator interpolator(makeLinearKeys(Nif::InterpolationType_Constant));
+        EXPECT_EQ(interpolator.interpKey(0.25f), 0.f);
+        EXPECT_EQ(interpolator.interpKey(0.75f), 2.f);
+        EXPECT_EQ(interpolator.interpKey(3.5f), 8.f);
+    }
+
+    TEST(NifOsgValueInterpolatorTest, quadraticInterpolationShouldUseTangents)
+    {
+        auto keys = std::make_shared<Nif::Vector3KeyMap>();
+        keys->mInterpolationType = Nif::InterpolationType_Quadratic;
+        keys->mTimes = { 0.f, 1.f };
+        keys->mValues = { osg::Vec3f(0, 0, 0), osg::Vec3f(1, 1, 1) };
+        keys->mInTans = { osg::Vec3f(0, 0, 0), osg::Vec3f(0, 0, 0) };
+        keys->mOutTans = { osg::Vec3f(0, 0, 0), osg::Vec3f(0, 0, 0) };
+        const Vec3Interpolator interpolator(keys);
+        // Zero tangents give a smoothstep curve
+        EXPECT_FLOAT_EQ(interpolator.interpKey(0.5f).x(), 0.5f);
+        EXPECT_FLOAT_EQ(interpolator.interpKey(0.25f).x(), 0.15625f);
+    }
+}
@@ -0,0 +1,86 @@
+#include <components/resource/stateregistry.hpp>
+
+#include <osg/Group>
+#include <osg/StateSet>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+    using namespace testing;
+    using namespace Resource;
+
+    struct ResourceStateRegistryTest : Test
+    {
+        StateRegistry mRegistry;
+    };
+
+    TEST_F(ResourceStateRegistryTest, equal_uniforms_should_be_shared)
+    {
+        osg::ref_ptr<osg::Uniform> first = new osg::Uniform("colorMode", 2);
+        osg::ref_ptr<osg::Uniform> second = new osg::Uniform("colorMode", 2);
+        EXPECT_EQ(mRegistry.getUniform(first), first);
+        EXPECT_EQ(mRegistry.getUniform(second), first);
+        EXPECT_EQ(mRegistry.getNumUniforms(), 1u);
+        EXPECT_EQ(mRegistry.getNumUniformHits(), 1u);
+    }
+
+    TEST_F(ResourceStateRegistryTest, uniforms_with_different_values_should_not_be_shared)
+    {
+        osg::ref_ptr<osg::Uniform> first = new osg::Uniform("alphaRef", 0.5f);
+        osg::ref_ptr<osg::Uniform> second = new osg::Uniform("alphaRef", 0.25f);
+        EXPECT_EQ(mRegistry.getUniform(first), first);
+        EXPECT_EQ(mRegistry.getUniform(second), second);
+        EXPECT_EQ(mRegistry.getNumUniformHits(), 0u);
+    }
+
+    TEST_F(ResourceStateRegistryTest, uniforms_with_different_names_should_not_be_shared)
+    {
+        osg::ref_ptr<osg::Uniform> first = new osg::Uniform("emissiveMult", 1.f);
+        osg::ref_ptr<osg::Uniform> second = new osg::Uniform("specStrength", 1.f);
+        EXPECT_EQ(mRegistry.getUniform(first), first);
+        EXPECT_EQ(mRegistry.getUniform(second), second);
+    }
+
+    TEST_F(ResourceStateRegistryTest, canonicalize_should_replace_uniforms_of_statesets)
+    {
+        osg::ref_ptr<osg::Group> root = new osg::Group;
+        osg::ref_ptr<osg::Group> first = new osg::Group;
+        osg::ref_ptr<osg::Group> second = new osg::Group;
+        root->addChild(first);
+        root->addChild(second);
+        first->getOrCreateStateSet()->addUniform(new osg::Uniform("colorMode", 2));
+        second->getOrCreateStateSet()->addUniform(new osg::Uniform("colorMode", 2));
+
+        mRegistry.canonicalize(*root);
+
+        EXPECT_EQ(first->getStateSet()->getUniform("colorMode"), second->getStateSet()->getUniform("colorMode"));
+        EXPECT_EQ(first->getStateSet()->compare(*second->getStateSet(), true), 0);
+    }
+
+    TEST_F(ResourceStateRegistryTest, canonicalize_should_skip_dynamic_uniforms)
+    {
+        osg::ref_ptr<osg::Group> root = new osg::Group;
+        osg::ref_ptr<osg::Group> first = new osg::Group;
+        osg::ref_ptr<osg::Group> second = new osg::Group;
+        root->addChild(first);
+        root->addChild(second);
+        osg::ref_ptr<osg::Uniform> dynamicUniform = new osg::Uniform("colorMode", 2);
+        dynamicUniform->setDataVariance(osg::Object::DYNAMIC);
+        first->getOrCreateStateSet()->addUniform(new osg::Uniform("colorMode", 2));
+        second->getOrCreateStateSet()->addUniform(dynamicUniform);
+
+        mRegistry.canonicalize(*root);
+
+        EXPECT_EQ(second->getStateSet()->getUniform("colorMode"), dynamicUniform);
+    }
+
+    TEST_F(ResourceStateRegistryTest, prune_should_remove_unused_objects)
+    {
+        osg::ref_ptr<osg::Uniform> uniform = new osg::Uniform("colorMode", 2);
+        mRegistry.getUniform(uniform);
+        uniform = nullptr;
+        mRegistry.prune();
+        EXPECT_EQ(mRegistry.getNumUniforms(), 0u);
+    }
+}
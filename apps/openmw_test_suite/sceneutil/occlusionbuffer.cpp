@@ -0,0 +1,106 @@
+#include <components/sceneutil/occlusionbuffer.hpp>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+    using namespace testing;
+    using namespace SceneUtil;
+
+    struct SceneUtilOcclusionBufferTest : Test
+    {
+        OcclusionBuffer mBuffer;
+        // Looking down the -z axis from the origin
+        const osg::Matrixd mViewProjection = osg::Matrixd::perspective(90, 2, 1, 10000);
+
+        static OccluderMesh makeQuad(float halfSize, float z)
+        {
+            OccluderMesh mesh;
+            mesh.mVertices = {
+                osg::Vec3f(-halfSize, -halfSize, z),
+                osg::Vec3f(halfSize, -halfSize, z),
+                osg::Vec3f(halfSize, halfSize, z),
+                osg::Vec3f(-halfSize, halfSize, z),
+            };
+            mesh.mIndices = { 0, 1, 2, 0, 2, 3 };
+            return mesh;
+        }
+
+        void addOccluders(const std::vector<OccluderMesh>& meshes, const osg::Matrixf& matrix = osg::Matrixf())
+        {
+            mBuffer.reset(64, 32, mViewProjection);
+            for (const OccluderMesh& mesh : meshes)
+                mBuffer.addOccluder(mesh, matrix);
+            mBuffer.finish();
+        }
+    };
+
+    TEST_F(SceneUtilOcclusionBufferTest, empty_buffer_should_not_occlude)
+    {
+        addOccluders({});
+        EXPECT_FALSE(mBuffer.isOccluded(osg::BoundingBox(-10, -10, -200, 10, 10, -150)));
+    }
+
+    TEST_F(SceneUtilOcclusionBufferTest, should_store_inverse_w_of_occluder)
+    {
+        addOccluders({ makeQuad(100, -50) });
+        EXPECT_FLOAT_EQ(mBuffer.getDepth(32, 16), 1.f / 50);
+    }
+
+    TEST_F(SceneUtilOcclusionBufferTest, box_behind_occluder_should_be_occluded)
+    {
+        addOccluders({ makeQuad(100, -50) });
+        EXPECT_TRUE(mBuffer.isOccluded(osg::BoundingBox(-10, -10, -200, 10, 10, -150)));
+    }
+
+    TEST_F(SceneUtilOcclusionBufferTest, box_in_front_of_occluder_should_not_be_occluded)
+    {
+        addOccluders({ makeQuad(100, -50) });
+        EXPECT_FALSE(mBuffer.isOccluded(osg::BoundingBox(-10, -10, -40, 10, 10, -30)));
+    }
+
+    TEST_F(SceneUtilOcclusionBufferTest, box_intersecting_occluder_should_not_be_occluded)
+    {
+        addOccluders({ makeQuad(100, -50) });
+        EXPECT_FALSE(mBuffer.isOccluded(osg::BoundingBox(-10, -10, -60, 10, 10, -40)));
+    }
+
+    TEST_F(SceneUtilOcclusionBufferTest, box_partially_behind_occluder_should_not_be_occluded)
+    {
+        addOccluders({ makeQuad(10, -50) });
+        EXPECT_FALSE(mBuffer.isOccluded(osg::BoundingBox(0, -10, -200, 100, 10, -150)));
+    }
+
+    TEST_F(SceneUtilOcclusionBufferTest, box_crossing_near_plane_should_not_be_occluded)
+    {
+        addOccluders({ makeQuad(100, -50) });
+        EXPECT_FALSE(mBuffer.isOccluded(osg::BoundingBox(-10, -10, -5, 10, 10, 5)));
+    }
+
+    TEST_F(SceneUtilOcclusionBufferTest, occluder_crossing_near_plane_should_be_clipped)
+    {
+        OccluderMesh mesh;
+        mesh.mVertices = {
+            osg::Vec3f(-1000, -1000, -150),
+            osg::Vec3f(1000, -1000, -150),
+            osg::Vec3f(1000, 1000, 50),
+            osg::Vec3f(-1000, 1000, 50),
+        };
+        mesh.mIndices = { 0, 1, 2, 0, 2, 3 };
+        addOccluders({ mesh });
+        EXPECT_TRUE(mBuffer.isOccluded(osg::BoundingBox(-10, -10, -2000, 10, 10, -1900)));
+    }
+
+    TEST_F(SceneUtilOcclusionBufferTest, occluder_behind_camera_should_not_occlude)
+    {
+        addOccluders({ makeQuad(100, 50) });
+        EXPECT_FALSE(mBuffer.isOccluded(osg::BoundingBox(-10, -10, -200, 10, 10, -150)));
+    }
+
+    TEST_F(SceneUtilOcclusionBufferTest, occluder_should_be_transformed_by_matrix)
+    {
+        addOccluders({ makeQuad(100, -50) }, osg::Matrixf::translate(0, 0, -1000));
+        EXPECT_FALSE(mBuffer.isOccluded(osg::BoundingBox(-10, -10, -200, 10, 10, -150)));
+        EXPECT_TRUE(mBuffer.isOccluded(osg::BoundingBox(-1, -1, -1200, 1, 1, -1150)));
+    }
+}
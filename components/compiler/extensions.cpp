@@ -207,4 +207,30 @@ namespace Compiler
         for (const auto & mKeyword : mKeywords)
             keywords.push_back (mKeyword.first);
     }
+
+    std::string Extensions::findKeyword (int segment, int code) const
+    {
+        auto generates = [&] (int keyword)
+        {
+            auto function = mFunctions.find (keyword);
+            if (function!=mFunctions.end())
+                return function->second.mSegment==segment &&
+                    (function->second.mCode==code || function->second.mCodeExplicit==code);
+
+            auto instruction = mInstructions.find (keyword);
+            if (instruction!=mInstructions.end())
+                return instruction->second.mSegment==segment &&
+                    (instruction->second.mCode==code || instruction->second.mCodeExplicit==code);
+
+            return false;
+        };
+
+        std::string result;
+
+        for (const auto& keyword : mKeywords)
+            if (keyword.first.size()>result.size() && generates (keyword.second))
+                result = keyword.first;
+
+        return result;
+    }
 }
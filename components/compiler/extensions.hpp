@@ -109,6 +109,10 @@ namespace Compiler
 
             void listKeywords (std::vector<std::string>& keywords) const;
             ///< Append all known keywords to \a kaywords.
+
+            std::string findKeyword (int segment, int code) const;
+            ///< Return the keyword generating \a code in \a segment or an empty string if there is none.
+            /// - the longest keyword is returned if there are several (e.g. "toggleborders" for "tb").
     };
 }
 
@@ -339,6 +339,9 @@ namespace Compiler
             extensions.registerInstruction ("togglerecastmesh", "", opcodeToggleRecastMesh);
             extensions.registerInstruction ("help", "", opcodeHelp);
             extensions.registerInstruction ("reloadlua", "", opcodeReloadLua);
+            extensions.registerInstruction ("togglescriptprofiler", "", opcodeToggleScriptProfiler);
+            extensions.registerInstruction ("tsp", "", opcodeToggleScriptProfiler);
+            extensions.registerInstruction ("showscriptprofile", "", opcodeShowScriptProfile);
         }
     }
 
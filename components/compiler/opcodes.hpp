@@ -320,6 +320,8 @@ namespace Compiler
         const int opcodeStartScriptExplicit = 0x200031d;
         const int opcodeHelp = 0x2000320;
         const int opcodeReloadLua = 0x2000321;
+        const int opcodeToggleScriptProfiler = 0x2000322;
+        const int opcodeShowScriptProfile = 0x2000323;
     }
 
     namespace Sky
@@ -111,7 +111,8 @@ bool Config::GameSettings::readFile(QTextStream &stream, QMultiMap<QString, QStr
                 && key != QLatin1String("fallback-archive")
                 && key != QLatin1String("content")
                 && key != QLatin1String("groundcover")
-                && key != QLatin1String("script-blacklist"))
+                && key != QLatin1String("script-blacklist")
+                && key != QLatin1String("script-every-frame"))
                 settings.remove(key);
 
             if (key == QLatin1String("data")
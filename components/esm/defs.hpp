@@ -181,6 +181,9 @@ enum RecNameInts : unsigned int
 
     // format 21 - Random state in saved games.
     REC_RAND = fourCC("RAND"),  // Random state.
+
+    // format 22 - Compressed records in saved games.
+    REC_CHNK = fourCC("CHNK"),  // Compressed chunks of records.
 };
 
 /// Common subrecords
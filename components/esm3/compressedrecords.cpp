@@ -0,0 +1,142 @@
+#include "compressedrecords.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <stdexcept>
+#include <thread>
+
+#include <lz4.h>
+
+#include "components/esm/defs.hpp"
+
+#include "esmreader.hpp"
+#include "esmwriter.hpp"
+
+namespace ESM
+{
+    namespace
+    {
+        // Name, size, unused and flags
+        constexpr std::size_t sRecordHeaderSize = 16;
+
+        struct Chunk
+        {
+            std::size_t mOffset = 0;
+            std::size_t mSize = 0;
+            std::string mData;
+        };
+
+        template <class Function>
+        void runParallel(std::size_t count, Function&& function)
+        {
+            const std::size_t threads = std::min<std::size_t>(count, std::max(1u, std::thread::hardware_concurrency()));
+            std::atomic<std::size_t> next(0);
+            const auto work = [&]
+            {
+                for (std::size_t i = next++; i < count; i = next++)
+                    function(i);
+            };
+
+            std::vector<std::future<void>> results;
+            for (std::size_t i = 1; i < threads; ++i)
+                results.push_back(std::async(std::launch::async, work));
+            work();
+            for (std::future<void>& result : results)
+                result.get();
+        }
+
+        std::vector<Chunk> splitRecords(std::string_view records, const std::vector<std::size_t>& breaks, std::size_t chunkSize)
+        {
+            std::vector<Chunk> chunks;
+            auto nextBreak = breaks.begin();
+            std::size_t begin = 0;
+            std::size_t offset = 0;
+            while (offset < records.size())
+            {
+                if (records.size() - offset < sRecordHeaderSize)
+                    throw std::runtime_error("Incomplete record header at offset " + std::to_string(offset));
+                std::uint32_t size;
+                std::memcpy(&size, records.data() + offset + 4, sizeof(size));
+                offset += sRecordHeaderSize + size;
+                if (offset > records.size())
+                    throw std::runtime_error("Incomplete record at offset " + std::to_string(offset));
+
+                while (nextBreak != breaks.end() && *nextBreak < offset)
+                    ++nextBreak;
+                const bool isBreak = nextBreak != breaks.end() && *nextBreak == offset;
+                if (offset - begin >= chunkSize || isBreak || offset == records.size())
+                {
+                    Chunk chunk;
+                    chunk.mOffset = begin;
+                    chunk.mSize = offset - begin;
+                    chunks.push_back(std::move(chunk));
+                    begin = offset;
+                }
+            }
+            return chunks;
+        }
+    }
+
+    void writeCompressedRecords(ESMWriter& writer, std::string_view records, const std::vector<std::size_t>& breaks,
+        std::size_t chunkSize)
+    {
+        std::vector<Chunk> chunks = splitRecords(records, breaks, chunkSize);
+
+        runParallel(chunks.size(), [&] (std::size_t i)
+        {
+            Chunk& chunk = chunks[i];
+            chunk.mData.resize(static_cast<std::size_t>(LZ4_compressBound(static_cast<int>(chunk.mSize))));
+            const int size = LZ4_compress_default(records.data() + chunk.mOffset, chunk.mData.data(),
+                static_cast<int>(chunk.mSize), static_cast<int>(chunk.mData.size()));
+            if (size == 0)
+                throw std::runtime_error("Failed to compress records");
+            chunk.mData.resize(static_cast<std::size_t>(size));
+        });
+
+        writer.startRecord(REC_CHNK);
+        for (const Chunk& chunk : chunks)
+        {
+            writer.writeHNT("SIZE", static_cast<std::uint32_t>(chunk.mSize));
+            writer.startSubRecord("DATA");
+            writer.write(chunk.mData.data(), chunk.mData.size());
+            writer.endRecord("DATA");
+        }
+        writer.endRecord(REC_CHNK);
+    }
+
+    std::string readCompressedRecords(ESMReader& reader)
+    {
+        std::vector<Chunk> chunks;
+        std::size_t total = 0;
+        while (reader.hasMoreSubs())
+        {
+            std::uint32_t size;
+            reader.getHNT(size, "SIZE");
+            reader.getSubNameIs("DATA");
+            reader.getSubHeader();
+
+            Chunk chunk;
+            chunk.mOffset = total;
+            chunk.mSize = size;
+            chunk.mData.resize(reader.getSubSize());
+            reader.getExact(chunk.mData.data(), static_cast<int>(chunk.mData.size()));
+            total += size;
+            chunks.push_back(std::move(chunk));
+        }
+
+        std::string records(total, '\0');
+        runParallel(chunks.size(), [&] (std::size_t i)
+        {
+            Chunk& chunk = chunks[i];
+            const int size = LZ4_decompress_safe(chunk.mData.data(), records.data() + chunk.mOffset,
+                static_cast<int>(chunk.mData.size()), static_cast<int>(chunk.mSize));
+            if (size < 0 || static_cast<std::size_t>(size) != chunk.mSize)
+                throw std::runtime_error("Failed to decompress records");
+            std::string().swap(chunk.mData);
+        });
+        return records;
+    }
+}
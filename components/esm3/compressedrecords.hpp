@@ -0,0 +1,30 @@
+#ifndef OPENMW_ESM_COMPRESSEDRECORDS_H
+#define OPENMW_ESM_COMPRESSEDRECORDS_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ESM
+{
+    class ESMReader;
+    class ESMWriter;
+
+    // format 22, saved games only
+
+    /// Split \a records, as written by an ESMWriter, into chunks of whole records, compress the chunks in parallel
+    /// and write them as a single REC_CHNK record.
+    /// The chunks are only ever read back in sequence, so there is no directory: each one is a SIZE subrecord holding
+    /// its uncompressed size followed by a DATA subrecord holding the compressed records.
+    /// @param breaks Offsets in \a records to start a new chunk at, e.g. where the data of another subsystem begins.
+    /// Must be record boundaries.
+    void writeCompressedRecords(ESMWriter& writer, std::string_view records, const std::vector<std::size_t>& breaks,
+        std::size_t chunkSize = 1 << 20);
+
+    /// Read the chunks of a REC_CHNK record and decompress them in parallel.
+    /// @return The records the chunks were written from, to be read with ESMReader::openRecords.
+    std::string readCompressedRecords(ESMReader& reader);
+}
+
+#endif
@@ -97,6 +97,18 @@ void ESMReader::openRaw(std::unique_ptr<std::istream>&& stream, std::string_view
     mEsm->seekg(0, mEsm->beg);
 }
 
+void ESMReader::openRecords(std::unique_ptr<std::istream>&& stream)
+{
+    if (mCtx.leftRec != 0)
+        fail("Unread data left in record");
+    mEsm = std::move(stream);
+    mEsm->seekg(0, mEsm->end);
+    mCtx.leftFile = mFileSize = mEsm->tellg();
+    mEsm->seekg(0, mEsm->beg);
+    mCtx.leftSub = 0;
+    mCtx.subCached = false;
+}
+
 void ESMReader::openRaw(std::string_view filename)
 {
     openRaw(Files::openBinaryInputFileStream(std::string(filename)), filename);
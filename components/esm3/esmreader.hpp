@@ -66,6 +66,10 @@ public:
   /// parse the header.
   void openRaw(std::unique_ptr<std::istream>&& stream, std::string_view name);
 
+  /// Continue reading records from another stream, e.g. records decompressed
+  /// from the current file. Keeps the header of the current file.
+  void openRecords(std::unique_ptr<std::istream>&& stream);
+
   /// Load ES file from a new stream, parses the header. Closes the
   /// currently open file first, if any.
   void open(std::unique_ptr<std::istream>&& stream, const std::string &name);
@@ -55,6 +55,9 @@ class ESMWriter
         void save(std::ostream& file);
         ///< Start saving a file by writing the TES3 header.
 
+        void saveRecords(std::ostream& file);
+        ///< Start saving records without a TES3 header, e.g. to append them to a file.
+
         void close();
         ///< \note Does not close the stream.
 
@@ -1,5 +1,8 @@
 #include "storage.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <set>
 
 #include <osg/Image>
@@ -45,6 +48,72 @@ namespace ESMTerrain
 
     const float defaultHeight = ESM::Land::DEFAULT_HEIGHT;
 
+    namespace
+    {
+        /// Vertex data of one source row of a cell, kept in separate arrays so the per vertex math can be vectorized.
+        struct RowBuffer
+        {
+            std::array<float, ESM::Land::LAND_SIZE> mHeights;
+            std::array<float, ESM::Land::LAND_SIZE> mNormalX;
+            std::array<float, ESM::Land::LAND_SIZE> mNormalY;
+            std::array<float, ESM::Land::LAND_SIZE> mNormalZ;
+            std::array<osg::Vec4ub, ESM::Land::LAND_SIZE> mColours;
+
+            void setNormal(int i, const osg::Vec3f& normal)
+            {
+                mNormalX[i] = normal.x();
+                mNormalY[i] = normal.y();
+                mNormalZ[i] = normal.z();
+            }
+        };
+
+        void gatherNormals(const ESM::Land::LandData* data, int index, int step, int count, RowBuffer& row, int offset)
+        {
+            if (!data)
+            {
+                std::fill_n(row.mNormalX.begin() + offset, count, 0.f);
+                std::fill_n(row.mNormalY.begin() + offset, count, 0.f);
+                std::fill_n(row.mNormalZ.begin() + offset, count, 1.f);
+                return;
+            }
+            const ESM::Land::VNML* src = data->mNormals + index*3;
+            for (int i = 0; i < count; ++i, src += step*3)
+            {
+                row.mNormalX[offset + i] = src[0];
+                row.mNormalY[offset + i] = src[1];
+                row.mNormalZ[offset + i] = src[2];
+            }
+        }
+
+        void normalizeNormals(RowBuffer& row, int count)
+        {
+            // No branches or function calls, so the compiler can turn this into SIMD code
+            float* x = row.mNormalX.data();
+            float* y = row.mNormalY.data();
+            float* z = row.mNormalZ.data();
+            for (int i = 0; i < count; ++i)
+            {
+                const float length2 = x[i]*x[i] + y[i]*y[i] + z[i]*z[i];
+                const float inverse = length2 > 0.f ? 1.f / std::sqrt(length2) : 1.f;
+                x[i] *= inverse;
+                y[i] *= inverse;
+                z[i] *= inverse;
+            }
+        }
+
+        void gatherColours(const ESM::Land::LandData* data, int index, int step, int count, RowBuffer& row, int offset)
+        {
+            if (!data)
+            {
+                std::fill_n(row.mColours.begin() + offset, count, osg::Vec4ub(255, 255, 255, 255));
+                return;
+            }
+            const unsigned char* src = data->mColours + index*3;
+            for (int i = 0; i < count; ++i, src += step*3)
+                row.mColours[offset + i] = osg::Vec4ub(src[0], src[1], src[2], 255);
+        }
+    }
+
     Storage::Storage(const VFS::Manager *vfs, const std::string& normalMapPattern, const std::string& normalHeightMapPattern, bool autoUseNormalMaps, const std::string& specularMapPattern, bool autoUseSpecularMaps)
         : mVFS(vfs)
         , mNormalMapPattern(normalMapPattern)
@@ -142,35 +211,6 @@ namespace ESMTerrain
         normal.normalize();
     }
 
-    void Storage::fixColour (osg::Vec4ub& color, int cellX, int cellY, int col, int row, LandCache& cache)
-    {
-        if (col == ESM::Land::LAND_SIZE-1)
-        {
-            ++cellY;
-            col = 0;
-        }
-        if (row == ESM::Land::LAND_SIZE-1)
-        {
-            ++cellX;
-            row = 0;
-        }
-
-        const LandObject* land = getLand(cellX, cellY, cache);
-        const ESM::Land::LandData* data = land ? land->getData(ESM::Land::DATA_VCLR) : nullptr;
-        if (data)
-        {
-            color.r() = data->mColours[col*ESM::Land::LAND_SIZE*3+row*3];
-            color.g() = data->mColours[col*ESM::Land::LAND_SIZE*3+row*3+1];
-            color.b() = data->mColours[col*ESM::Land::LAND_SIZE*3+row*3+2];
-        }
-        else
-        {
-            color.r() = 255;
-            color.g() = 255;
-            color.b() = 255;
-        }
-    }
-
     void Storage::fillVertexBuffers (int lodLevel, float size, const osg::Vec2f& center,
                                             osg::ref_ptr<osg::Vec3Array> positions,
                                             osg::ref_ptr<osg::Vec3Array> normals,
@@ -190,8 +230,7 @@ namespace ESMTerrain
         normals->resize(numVerts*numVerts);
         colours->resize(numVerts*numVerts);
 
-        osg::Vec3f normal;
-        osg::Vec4ub color;
+        RowBuffer rowBuffer;
 
         float vertY = 0;
         float vertX = 0;
@@ -233,73 +272,100 @@ namespace ESMTerrain
                 int rowEnd = std::min(static_cast<int>(rowStart + std::min(1.f, size) * (ESM::Land::LAND_SIZE-1) + 1), static_cast<int>(ESM::Land::LAND_SIZE));
                 int colEnd = std::min(static_cast<int>(colStart + std::min(1.f, size) * (ESM::Land::LAND_SIZE-1) + 1), static_cast<int>(ESM::Land::LAND_SIZE));
 
-                vertY = vertY_;
-                for (int col=colStart; col<colEnd; col += increment)
+                const int step = static_cast<int>(increment);
+                const int numRowVerts = rowStart < rowEnd ? (rowEnd - rowStart + step - 1) / step : 0;
+                const bool stitchLastRow = numRowVerts > 0 && rowStart + (numRowVerts - 1) * step == ESM::Land::LAND_SIZE-1;
+                const bool stitchLastCol = colStart < colEnd && (ESM::Land::LAND_SIZE-1 - colStart) % step == 0
+                    && colEnd == ESM::Land::LAND_SIZE;
+
+                // Normals apparently don't connect seamlessly between cells, and colours don't always either,
+                // so the last row and column take them from the first row and column of the neighbouring cells.
+                // Indexed by [col == LAND_SIZE-1][row == LAND_SIZE-1].
+                const ESM::Land::LandData* stitchNormals[2][2] = {{normalData, nullptr}, {nullptr, nullptr}};
+                const ESM::Land::LandData* stitchColours[2][2] = {{colourData, nullptr}, {nullptr, nullptr}};
+                for (int dy = 0; dy < 2; ++dy)
                 {
-                    vertX = vertX_;
-                    for (int row=rowStart; row<rowEnd; row += increment)
+                    for (int dx = 0; dx < 2; ++dx)
                     {
-                        int srcArrayIndex = col*ESM::Land::LAND_SIZE*3+row*3;
-
-                        assert(row >= 0 && row < ESM::Land::LAND_SIZE);
-                        assert(col >= 0 && col < ESM::Land::LAND_SIZE);
-
-                        assert (vertX < numVerts);
-                        assert (vertY < numVerts);
-
-                        float height = defaultHeight;
-                        if (heightData)
-                            height = heightData->mHeights[col*ESM::Land::LAND_SIZE + row];
-                        if (alteration)
-                            height += getAlteredHeight(col, row);
-                        (*positions)[static_cast<unsigned int>(vertX*numVerts + vertY)]
-                            = osg::Vec3f((vertX / float(numVerts - 1) - 0.5f) * size * Constants::CellSizeInUnits,
-                                         (vertY / float(numVerts - 1) - 0.5f) * size * Constants::CellSizeInUnits,
-                                         height);
+                        if ((dx == 0 && dy == 0) || (dx != 0 && !stitchLastRow) || (dy != 0 && !stitchLastCol))
+                            continue;
+                        const LandObject* neighbour = getLand(cellX + dx, cellY + dy, cache);
+                        if (!neighbour)
+                            continue;
+                        stitchNormals[dy][dx] = neighbour->getData(ESM::Land::DATA_VNML);
+                        stitchColours[dy][dx] = neighbour->getData(ESM::Land::DATA_VCLR);
+                    }
+                }
 
-                        if (normalData)
-                        {
-                            for (int i=0; i<3; ++i)
-                                normal[i] = normalData->mNormals[srcArrayIndex+i];
+                const int numInnerVerts = numRowVerts - (stitchLastRow ? 1 : 0);
 
-                            normal.normalize();
-                        }
-                        else
-                            normal = osg::Vec3f(0,0,1);
+                vertY = vertY_;
+                for (int col=colStart; col<colEnd; col += increment)
+                {
+                    assert(col >= 0 && col < ESM::Land::LAND_SIZE);
+                    assert(vertY < numVerts);
 
-                        // Normals apparently don't connect seamlessly between cells
-                        if (col == ESM::Land::LAND_SIZE-1 || row == ESM::Land::LAND_SIZE-1)
-                            fixNormal(normal, cellX, cellY, col, row, cache);
+                    const int stitchCol = col == ESM::Land::LAND_SIZE-1 ? 1 : 0;
+                    const int srcCol = stitchCol ? 0 : col;
 
-                        // some corner normals appear to be complete garbage (z < 0)
-                        if ((row == 0 || row == ESM::Land::LAND_SIZE-1) && (col == 0 || col == ESM::Land::LAND_SIZE-1))
-                            averageNormal(normal, cellX, cellY, col, row, cache);
+                    if (heightData)
+                    {
+                        const float* heights = heightData->mHeights + col*ESM::Land::LAND_SIZE + rowStart;
+                        for (int i = 0; i < numRowVerts; ++i)
+                            rowBuffer.mHeights[i] = heights[i*step];
+                    }
+                    else
+                        std::fill_n(rowBuffer.mHeights.begin(), numRowVerts, defaultHeight);
+                    if (alteration)
+                    {
+                        for (int i = 0; i < numRowVerts; ++i)
+                            rowBuffer.mHeights[i] += getAlteredHeight(col, rowStart + i*step);
+                    }
 
-                        assert(normal.z() > 0);
+                    gatherNormals(stitchNormals[stitchCol][0], srcCol*ESM::Land::LAND_SIZE + rowStart, step, numInnerVerts, rowBuffer, 0);
+                    if (stitchLastRow)
+                        gatherNormals(stitchNormals[stitchCol][1], srcCol*ESM::Land::LAND_SIZE, 0, 1, rowBuffer, numInnerVerts);
+                    normalizeNormals(rowBuffer, numRowVerts);
 
-                        (*normals)[static_cast<unsigned int>(vertX*numVerts + vertY)] = normal;
+                    gatherColours(stitchColours[stitchCol][0], srcCol*ESM::Land::LAND_SIZE + rowStart, step, numInnerVerts, rowBuffer, 0);
+                    if (stitchLastRow)
+                        gatherColours(stitchColours[stitchCol][1], srcCol*ESM::Land::LAND_SIZE, 0, 1, rowBuffer, numInnerVerts);
+                    if (alteration)
+                    {
+                        // Does nothing by default, override in OpenMW-CS. Border colours are taken from the neighbour cells as is.
+                        const int numAdjusted = stitchCol ? 0 : numInnerVerts;
+                        for (int i = 0; i < numAdjusted; ++i)
+                            adjustColor(col, rowStart + i*step, heightData, rowBuffer.mColours[i]);
+                    }
 
-                        if (colourData)
+                    // some corner normals appear to be complete garbage (z < 0)
+                    if (col == 0 || col == ESM::Land::LAND_SIZE-1)
+                    {
+                        osg::Vec3f normal;
+                        if (rowStart == 0 && numRowVerts > 0)
                         {
-                            for (int i=0; i<3; ++i)
-                                color[i] = colourData->mColours[srcArrayIndex+i];
+                            averageNormal(normal, cellX, cellY, col, 0, cache);
+                            rowBuffer.setNormal(0, normal);
                         }
-                        else
+                        if (stitchLastRow)
                         {
-                            color.r() = 255;
-                            color.g() = 255;
-                            color.b() = 255;
+                            averageNormal(normal, cellX, cellY, col, ESM::Land::LAND_SIZE-1, cache);
+                            rowBuffer.setNormal(numRowVerts - 1, normal);
                         }
-                        if (alteration)
-                            adjustColor(col, row, heightData, color); //Does nothing by default, override in OpenMW-CS
-
-                        // Unlike normals, colors mostly connect seamlessly between cells, but not always...
-                        if (col == ESM::Land::LAND_SIZE-1 || row == ESM::Land::LAND_SIZE-1)
-                            fixColour(color, cellX, cellY, col, row, cache);
-
-                        color.a() = 255;
+                    }
 
-                        (*colours)[static_cast<unsigned int>(vertX*numVerts + vertY)] = color;
+                    vertX = vertX_;
+                    for (int i = 0; i < numRowVerts; ++i)
+                    {
+                        assert(vertX < numVerts);
+                        assert(rowBuffer.mNormalZ[i] > 0);
+
+                        const unsigned int index = static_cast<unsigned int>(vertX*numVerts + vertY);
+                        (*positions)[index] = osg::Vec3f((vertX / float(numVerts - 1) - 0.5f) * size * Constants::CellSizeInUnits,
+                                                         (vertY / float(numVerts - 1) - 0.5f) * size * Constants::CellSizeInUnits,
+                                                         rowBuffer.mHeights[i]);
+                        (*normals)[index] = osg::Vec3f(rowBuffer.mNormalX[i], rowBuffer.mNormalY[i], rowBuffer.mNormalZ[i]);
+                        (*colours)[index] = rowBuffer.mColours[i];
 
                         ++vertX;
                     }
@@ -115,7 +115,6 @@ namespace ESMTerrain
         const VFS::Manager* mVFS;
 
         inline void fixNormal (osg::Vec3f& normal, int cellX, int cellY, int col, int row, LandCache& cache);
-        inline void fixColour (osg::Vec4ub& colour, int cellX, int cellY, int col, int row, LandCache& cache);
         inline void averageNormal (osg::Vec3f& normal, int cellX, int cellY, int col, int row, LandCache& cache);
 
         inline const LandObject* getLand(int cellX, int cellY, LandCache& cache);
@@ -1,8 +1,10 @@
 #include "interpreter.hpp"
 
 #include <cassert>
+#include <chrono>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 
 #include "opcodes.hpp"
 
@@ -20,18 +22,42 @@ namespace Interpreter
         throw std::runtime_error(error);
     }
 
-    template<typename T>
-    auto& getDispatcher(const T& segment, unsigned int seg, int opcode)
+    static void executeOpcode0(const Instruction& instruction, Runtime& runtime)
     {
-        auto it = segment.find(opcode);
-        if (it == segment.end())
+        static_cast<Opcode0*>(instruction.mOpcode)->execute(runtime);
+    }
+
+    static void executeOpcode1(const Instruction& instruction, Runtime& runtime)
+    {
+        static_cast<Opcode1*>(instruction.mOpcode)->execute(runtime, instruction.mArg0);
+    }
+
+    // mArg0 holds the segment in the upper 6 bits and the opcode in the lower 26 bits
+    static void executeUnknownCode(const Instruction& instruction, Runtime& /*runtime*/)
+    {
+        abortUnknownCode(instruction.mArg0 >> 26, instruction.mArg0 & 0x3ffffff);
+    }
+
+    // mArg0 holds the whole code
+    static void executeUnknownSegment(const Instruction& instruction, Runtime& /*runtime*/)
+    {
+        abortUnknownSegment(instruction.mArg0);
+    }
+
+    template<typename TOpcode>
+    Instruction makeInstruction(const OpcodeTable<TOpcode>& segment, unsigned int seg, int opcode, unsigned int arg0)
+    {
+        if (TOpcode* dispatcher = segment.find(opcode))
         {
-            abortUnknownCode(seg, opcode);
+            if constexpr (std::is_same_v<TOpcode, Opcode0>)
+                return Instruction {&executeOpcode0, dispatcher, arg0};
+            else
+                return Instruction {&executeOpcode1, dispatcher, arg0};
         }
-        return it->second;
+        return Instruction {&executeUnknownCode, nullptr, (seg << 26) | static_cast<unsigned int>(opcode)};
     }
 
-    void Interpreter::execute (Type_Code code)
+    Instruction Interpreter::decode (Type_Code code) const
     {
         unsigned int segSpec = code >> 30;
 
@@ -42,7 +68,7 @@ namespace Interpreter
                 const int opcode = code >> 24;
                 const unsigned int arg0 = code & 0xffffff;
 
-                return getDispatcher(mSegment0, 0, opcode)->execute(mRuntime, arg0);
+                return makeInstruction(mSegment0, 0, opcode, arg0);
             }
 
             case 2:
@@ -50,7 +76,7 @@ namespace Interpreter
                 const int opcode = (code >> 20) & 0x3ff;
                 const unsigned int arg0 = code & 0xfffff;
 
-                return getDispatcher(mSegment2, 2, opcode)->execute(mRuntime, arg0);
+                return makeInstruction(mSegment2, 2, opcode, arg0);
             }
         }
 
@@ -63,18 +89,52 @@ namespace Interpreter
                 const int opcode = (code >> 8) & 0x3ffff;
                 const unsigned int arg0 = code & 0xff;
 
-                return getDispatcher(mSegment3, 3, opcode)->execute(mRuntime, arg0);
+                return makeInstruction(mSegment3, 3, opcode, arg0);
             }
 
             case 0x32:
             {
                 const int opcode = code & 0x3ffffff;
 
-                return getDispatcher(mSegment5, 5, opcode)->execute(mRuntime);
+                return makeInstruction(mSegment5, 5, opcode, 0);
             }
         }
 
-        abortUnknownSegment (code);
+        return Instruction {&executeUnknownSegment, nullptr, code};
+    }
+
+    void Interpreter::decode (Program& program) const
+    {
+        assert (program.mCode.size()>=4);
+
+        const int opcodes = static_cast<int> (program.mCode[0]);
+        const Type_Code *codeBlock = program.mCode.data() + 4;
+
+        program.mInstructions.clear();
+        program.mInstructions.reserve(opcodes);
+
+        for (int i = 0; i < opcodes; ++i)
+            program.mInstructions.push_back(decode(codeBlock[i]));
+    }
+
+    void Interpreter::execute (Type_Code code)
+    {
+        const Instruction instruction = decode(code);
+        if (mProfile == nullptr)
+            instruction.mExecute(instruction, mRuntime);
+        else
+            execute(instruction, code, *mProfile);
+    }
+
+    void Interpreter::execute (const Instruction& instruction, Type_Code code, Profile& profile)
+    {
+        // profile is kept even if the instruction stops profiling
+        const auto start = std::chrono::steady_clock::now();
+        instruction.mExecute(instruction, mRuntime);
+        OpcodeStats& stats = profile.mOpcodes[getOpcodeId(code)];
+        stats.mTime += std::chrono::steady_clock::now() - start;
+        ++stats.mCount;
+        ++profile.mInstructions;
     }
 
     void Interpreter::begin()
@@ -104,9 +164,14 @@ namespace Interpreter
         }
     }
 
-    Interpreter::Interpreter() : mRunning (false)
+    Interpreter::Interpreter() : mRunning (false), mProfile (nullptr)
     {}
 
+    void Interpreter::setProfile (Profile *profile)
+    {
+        mProfile = profile;
+    }
+
     void Interpreter::run (const Type_Code *code, int codeSize, Context& context)
     {
         assert (codeSize>=4);
@@ -136,4 +201,51 @@ namespace Interpreter
 
         end();
     }
+
+    void Interpreter::run (const Program& program, Context& context)
+    {
+        assert (program.mCode.size()>=4);
+
+        begin();
+
+        try
+        {
+            mRuntime.configure (program.mCode.data(), static_cast<int> (program.mCode.size()), context);
+
+            const int opcodes = static_cast<int> (program.mInstructions.size());
+
+            const Instruction *instructions = program.mInstructions.data();
+
+            // The instructions are executed in their threaded form, without decoding and looking them up.
+            // Whether to profile is only checked once per run to keep the loop as small as possible.
+            if (mProfile == nullptr)
+            {
+                for (int pc = mRuntime.getPC(); pc>=0 && pc<opcodes; pc = mRuntime.getPC())
+                {
+                    const Instruction& instruction = instructions[pc];
+                    mRuntime.setPC (pc+1);
+                    instruction.mExecute (instruction, mRuntime);
+                }
+            }
+            else
+            {
+                Profile& profile = *mProfile;
+                const Type_Code *codeBlock = program.mCode.data() + 4;
+
+                for (int pc = mRuntime.getPC(); pc>=0 && pc<opcodes; pc = mRuntime.getPC())
+                {
+                    const Instruction& instruction = instructions[pc];
+                    mRuntime.setPC (pc+1);
+                    execute (instruction, codeBlock[pc], profile);
+                }
+            }
+        }
+        catch (...)
+        {
+            end();
+            throw;
+        }
+
+        end();
+    }
 }
@@ -10,6 +10,9 @@
 #include "runtime.hpp"
 #include "types.hpp"
 #include "opcodes.hpp"
+#include "opcodetable.hpp"
+#include "profile.hpp"
+#include "program.hpp"
 
 namespace Interpreter
 {
@@ -18,10 +21,11 @@ namespace Interpreter
             std::stack<Runtime> mCallstack;
             bool mRunning;
             Runtime mRuntime;
-            std::map<int, std::unique_ptr<Opcode1>> mSegment0;
-            std::map<int, std::unique_ptr<Opcode1>> mSegment2;
-            std::map<int, std::unique_ptr<Opcode1>> mSegment3;
-            std::map<int, std::unique_ptr<Opcode0>> mSegment5;
+            OpcodeTable<Opcode1> mSegment0;
+            OpcodeTable<Opcode1> mSegment2;
+            OpcodeTable<Opcode1> mSegment3;
+            OpcodeTable<Opcode0> mSegment5;
+            Profile *mProfile;
 
             // not implemented
             Interpreter (const Interpreter&);
@@ -29,6 +33,8 @@ namespace Interpreter
 
             void execute (Type_Code code);
 
+            void execute (const Instruction& instruction, Type_Code code, Profile& profile);
+
             void begin();
 
             void end();
@@ -36,8 +42,7 @@ namespace Interpreter
             template<typename TSeg, typename TOp>
             void installSegment(TSeg& seg, int code, TOp&& op)
             {
-                assert(seg.find(code) == seg.end());
-                seg.emplace(code, std::move(op));
+                seg.install(code, std::move(op));
             }
 
         public:
@@ -68,7 +73,20 @@ namespace Interpreter
                 installSegment(mSegment5, code, std::make_unique<T>(std::forward<TArgs>(args)...));
             }
 
+            Instruction decode (Type_Code code) const;
+            ///< Look up the opcode executing \a code. Unknown opcodes are only reported when executed.
+
+            void decode (Program& program) const;
+            ///< Decode the instructions of program.mCode, so it can be run without looking up its opcodes.
+
+            void setProfile (Profile *profile);
+            ///< Time each executed instruction into \a profile, until set to a nullptr.
+            /// \note The ownership of \a profile is not transferred.
+
             void run (const Type_Code *code, int codeSize, Context& context);
+
+            void run (const Program& program, Context& context);
+            ///< \a program must have been decoded by this interpreter after all opcodes were installed.
     };
 }
 
@@ -0,0 +1,79 @@
+#ifndef INTERPRETER_OPCODETABLE_H_INCLUDED
+#define INTERPRETER_OPCODETABLE_H_INCLUDED
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <vector>
+
+namespace Interpreter
+{
+    /// \brief Opcodes of a segment, indexed by code
+    ///
+    /// The codes of a segment are clustered in a few ranges (e.g. the generic opcodes and the
+    /// ones of the extensions), so each range is stored as a dense array of its own.
+    template<typename TOpcode>
+    class OpcodeTable
+    {
+            struct Range
+            {
+                int mFirst;
+                std::vector<std::unique_ptr<TOpcode>> mOpcodes;
+            };
+
+            // Codes closer than this to a range are added to it rather than starting a new one
+            static constexpr int sMaxGap = 1024;
+
+            std::vector<Range> mRanges;
+
+            Range* findRange (int code, int gap)
+            {
+                for (Range& range : mRanges)
+                    if (code >= range.mFirst - gap
+                        && code < range.mFirst + static_cast<int>(range.mOpcodes.size()) + gap)
+                        return &range;
+                return nullptr;
+            }
+
+        public:
+
+            void install (int code, std::unique_ptr<TOpcode>&& opcode)
+            {
+                Range* range = findRange(code, 0);
+                if (range == nullptr)
+                    range = findRange(code, sMaxGap);
+
+                if (range == nullptr)
+                    range = &mRanges.emplace_back(Range {code, {}});
+                else if (code < range->mFirst)
+                {
+                    const std::size_t shift = static_cast<std::size_t>(range->mFirst - code);
+                    std::vector<std::unique_ptr<TOpcode>> opcodes(shift + range->mOpcodes.size());
+                    std::move(range->mOpcodes.begin(), range->mOpcodes.end(), opcodes.begin() + shift);
+                    range->mOpcodes = std::move(opcodes);
+                    range->mFirst = code;
+                }
+
+                const std::size_t index = static_cast<std::size_t>(code - range->mFirst);
+                if (index >= range->mOpcodes.size())
+                    range->mOpcodes.resize(index + 1);
+
+                assert(range->mOpcodes[index] == nullptr);
+                range->mOpcodes[index] = std::move(opcode);
+            }
+
+            /// \return nullptr if no opcode with this code is installed.
+            TOpcode* find (int code) const
+            {
+                for (const Range& range : mRanges)
+                {
+                    const std::size_t index = static_cast<std::size_t>(code - range.mFirst);
+                    if (code >= range.mFirst && index < range.mOpcodes.size() && range.mOpcodes[index] != nullptr)
+                        return range.mOpcodes[index].get();
+                }
+                return nullptr;
+            }
+    };
+}
+
+#endif
@@ -0,0 +1,46 @@
+#include "profile.hpp"
+
+namespace Interpreter
+{
+    Type_Code getOpcodeId (Type_Code code)
+    {
+        switch (getSegment (code))
+        {
+            case 0: return code & 0xff000000;
+            case 2: return code & 0xfff00000;
+            case 3: return code & 0xffffff00;
+        }
+
+        return code;
+    }
+
+    int getSegment (Type_Code code)
+    {
+        switch (code >> 30)
+        {
+            case 0: return 0;
+            case 2: return 2;
+        }
+
+        switch (code >> 26)
+        {
+            case 0x30: return 3;
+            case 0x32: return 5;
+        }
+
+        return -1;
+    }
+
+    int getOpcode (Type_Code code)
+    {
+        switch (getSegment (code))
+        {
+            case 0: return code >> 24;
+            case 2: return (code >> 20) & 0x3ff;
+            case 3: return (code >> 8) & 0x3ffff;
+            case 5: return code & 0x3ffffff;
+        }
+
+        return static_cast<int> (code);
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef INTERPRETER_PROFILE_H_INCLUDED
+#define INTERPRETER_PROFILE_H_INCLUDED
+
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+
+#include "types.hpp"
+
+namespace Interpreter
+{
+    /// \brief Time spent executing the instructions of one opcode
+    struct OpcodeStats
+    {
+        std::chrono::steady_clock::duration mTime {};
+        std::uint64_t mCount = 0;
+    };
+
+    /// \brief Statistics collected by an Interpreter while profiling (see Interpreter::setProfile)
+    ///
+    /// \note The time of an instruction running another script includes the time of that script.
+    struct Profile
+    {
+        /// Indexed by the code of the executed instructions without their arguments (see getOpcodeId)
+        std::unordered_map<Type_Code, OpcodeStats> mOpcodes;
+        std::uint64_t mInstructions = 0;
+    };
+
+    Type_Code getOpcodeId (Type_Code code);
+    ///< Return \a code with the bits of its arguments cleared.
+
+    int getSegment (Type_Code code);
+    ///< Return the segment of \a code or -1 if it is outside of the allocated segments.
+
+    int getOpcode (Type_Code code);
+    ///< Return the opcode of \a code within its segment.
+}
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef INTERPRETER_PROGRAM_H_INCLUDED
+#define INTERPRETER_PROGRAM_H_INCLUDED
+
+#include <vector>
+
+#include "types.hpp"
+
+namespace Interpreter
+{
+    class Runtime;
+
+    /// \brief Instruction decoded into the opcode that executes it
+    struct Instruction
+    {
+        void (*mExecute) (const Instruction& instruction, Runtime& runtime);
+        void *mOpcode;
+        unsigned int mArg0;
+    };
+
+    /// \brief Compiled script together with its decoded instructions
+    ///
+    /// \note The instructions are only valid for the Interpreter that decoded them (see
+    /// Interpreter::decode) and only as long as it exists.
+    struct Program
+    {
+        std::vector<Type_Code> mCode;
+        std::vector<Instruction> mInstructions;
+    };
+}
+
+#endif
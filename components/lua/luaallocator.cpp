@@ -0,0 +1,183 @@
+#include "luaallocator.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+
+#include <components/debug/debuglog.hpp>
+
+namespace LuaUtil
+{
+
+    LuaAllocator::LuaAllocator()
+    {
+        mFreeLists.fill(nullptr);
+        mOwners.emplace_back().mName = "Common";
+    }
+
+    LuaAllocator::~LuaAllocator() = default;
+
+    std::uint32_t LuaAllocator::getSizeClass(std::size_t size)
+    {
+        const std::size_t blockSize = size + sizeof(Header);
+        if (blockSize > sMaxPooledSize)
+            return sLargeBlock;
+        return static_cast<std::uint32_t>((blockSize + sSizeClassStep - 1) / sSizeClassStep - 1);
+    }
+
+    void* LuaAllocator::alloc(void* ud, void* ptr, std::size_t osize, std::size_t nsize)
+    {
+        LuaAllocator& self = *static_cast<LuaAllocator*>(ud);
+        if (nsize == 0)
+        {
+            if (ptr != nullptr)
+                self.deallocate(ptr, osize);
+            return nullptr;
+        }
+        if (ptr == nullptr)
+            return self.allocate(nsize, self.mCurrentOwner);
+        return self.reallocate(ptr, osize, nsize);
+    }
+
+    void LuaAllocator::addChunk(std::uint32_t sizeClass)
+    {
+        const std::size_t blockSize = (sizeClass + 1) * sSizeClassStep;
+        char* chunk = mChunks.emplace_back(new char[sChunkSize]).get();
+        FreeBlock* next = mFreeLists[sizeClass];
+        for (std::size_t offset = sChunkSize / blockSize * blockSize; offset > 0; offset -= blockSize)
+        {
+            FreeBlock* block = reinterpret_cast<FreeBlock*>(chunk + offset - blockSize);
+            block->mNext = next;
+            next = block;
+        }
+        mFreeLists[sizeClass] = next;
+    }
+
+    void* LuaAllocator::allocate(std::size_t size, OwnerId owner)
+    {
+        const std::uint32_t sizeClass = getSizeClass(size);
+        Header* header;
+        if (sizeClass == sLargeBlock)
+        {
+            header = static_cast<Header*>(std::malloc(size + sizeof(Header)));
+            if (header == nullptr)
+                return nullptr;
+        }
+        else
+        {
+            if (mFreeLists[sizeClass] == nullptr)
+                addChunk(sizeClass);
+            FreeBlock* block = mFreeLists[sizeClass];
+            mFreeLists[sizeClass] = block->mNext;
+            header = reinterpret_cast<Header*>(block);
+        }
+        header->mOwner = owner;
+        header->mSizeClass = sizeClass;
+        ++mOwners[owner].mAllocations;
+        account(owner, static_cast<std::int64_t>(size));
+        return header + 1;
+    }
+
+    void LuaAllocator::deallocate(void* ptr, std::size_t size)
+    {
+        Header* header = static_cast<Header*>(ptr) - 1;
+        const OwnerId owner = header->mOwner;
+        const std::uint32_t sizeClass = header->mSizeClass;
+        assert(sizeClass == getSizeClass(size));
+        if (sizeClass == sLargeBlock)
+            std::free(header);
+        else
+        {
+            FreeBlock* block = reinterpret_cast<FreeBlock*>(header);
+            block->mNext = mFreeLists[sizeClass];
+            mFreeLists[sizeClass] = block;
+        }
+        account(owner, -static_cast<std::int64_t>(size));
+    }
+
+    void* LuaAllocator::reallocate(void* ptr, std::size_t osize, std::size_t nsize)
+    {
+        Header* header = static_cast<Header*>(ptr) - 1;
+        const OwnerId owner = header->mOwner;
+        const std::uint32_t oldClass = header->mSizeClass;
+        const std::uint32_t newClass = getSizeClass(nsize);
+        assert(oldClass == getSizeClass(osize));
+        if (oldClass == newClass && oldClass != sLargeBlock)
+        {
+            account(owner, static_cast<std::int64_t>(nsize) - static_cast<std::int64_t>(osize));
+            return ptr;
+        }
+        if (oldClass == sLargeBlock && newClass == sLargeBlock)
+        {
+            header = static_cast<Header*>(std::realloc(header, nsize + sizeof(Header)));
+            if (header == nullptr)
+                return nullptr;
+            account(owner, static_cast<std::int64_t>(nsize) - static_cast<std::int64_t>(osize));
+            return header + 1;
+        }
+        // Reallocated blocks stay with their owner.
+        void* result = allocate(nsize, owner);
+        if (result == nullptr)
+            return nullptr;
+        std::memcpy(result, ptr, std::min(osize, nsize));
+        deallocate(ptr, osize);
+        return result;
+    }
+
+    void LuaAllocator::account(OwnerId owner, std::int64_t bytes)
+    {
+        mTotalBytes += bytes;
+        OwnerStats& stats = mOwners[owner];
+        stats.mBytes += bytes;
+        const std::int64_t softLimit = getSoftLimit(stats);
+        if (bytes > 0)
+        {
+            stats.mPeakBytes = std::max(stats.mPeakBytes, stats.mBytes);
+            if (softLimit > 0 && stats.mBytes > softLimit && !stats.mLimitExceeded)
+            {
+                stats.mLimitExceeded = true;
+                Log(Debug::Warning) << stats.mName << " uses " << stats.mBytes / 1024
+                                    << " KiB of Lua memory, exceeding the soft limit of " << softLimit / 1024 << " KiB";
+            }
+        }
+        else
+        {
+            // Only warn again after dropping well below the limit.
+            if (stats.mLimitExceeded && stats.mBytes < softLimit / 4 * 3)
+                stats.mLimitExceeded = false;
+            if (stats.mRemoved && stats.mBytes == 0)
+                mFreeOwnerIds.push_back(owner);
+        }
+    }
+
+    LuaAllocator::OwnerId LuaAllocator::addOwner(std::string name, std::int64_t softLimit)
+    {
+        OwnerId id;
+        if (mFreeOwnerIds.empty())
+        {
+            id = static_cast<OwnerId>(mOwners.size());
+            mOwners.emplace_back();
+        }
+        else
+        {
+            id = mFreeOwnerIds.back();
+            mFreeOwnerIds.pop_back();
+            mOwners[id] = OwnerStats();
+        }
+        OwnerStats& stats = mOwners[id];
+        stats.mName = std::move(name);
+        stats.mSoftLimit = softLimit;
+        return id;
+    }
+
+    void LuaAllocator::removeOwner(OwnerId owner)
+    {
+        assert(owner != sCommonOwner && owner < mOwners.size());
+        OwnerStats& stats = mOwners[owner];
+        stats.mRemoved = true;
+        if (stats.mBytes == 0)
+            mFreeOwnerIds.push_back(owner);
+    }
+
+}
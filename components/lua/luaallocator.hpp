@@ -0,0 +1,124 @@
+#ifndef COMPONENTS_LUA_LUAALLOCATOR_H
+#define COMPONENTS_LUA_LUAALLOCATOR_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace LuaUtil
+{
+
+    // Memory allocator of a Lua state (its `alloc` function has the signature of lua_Alloc).
+    // Provides additional features:
+    //   - Small blocks are served from size-class pools, which are allocated in large chunks
+    //         and kept until the allocator is destroyed;
+    //   - Every block is accounted to an owner (e.g. a scripts container). The owner of new blocks
+    //         is set by `OwnerScope`, blocks allocated out of any scope belong to `sCommonOwner`;
+    //   - Optional soft limits per owner. Exceeding a soft limit is only logged.
+    // Not thread safe, like the Lua state itself.
+    class LuaAllocator
+    {
+    public:
+        using OwnerId = std::uint32_t;
+        static constexpr OwnerId sCommonOwner = 0;
+
+        // Blocks with a size (including an 8-byte header) up to this are pooled.
+        static constexpr std::size_t sMaxPooledSize = 256;
+        static constexpr std::size_t sChunkSize = 64 * 1024;
+
+        struct OwnerStats
+        {
+            std::string mName;
+            std::int64_t mBytes = 0;  // Memory requested by Lua, without headers and pool overhead.
+            std::int64_t mPeakBytes = 0;
+            std::uint64_t mAllocations = 0;
+            std::int64_t mSoftLimit = 0;  // 0 means the default soft limit
+            bool mLimitExceeded = false;
+            bool mRemoved = false;  // The stats of removed owners are kept until all their blocks are freed.
+        };
+
+        class OwnerScope
+        {
+        public:
+            OwnerScope(LuaAllocator& allocator, OwnerId owner)
+                : mAllocator(allocator), mPrevious(allocator.mCurrentOwner)
+            {
+                allocator.mCurrentOwner = owner;
+            }
+            ~OwnerScope() { mAllocator.mCurrentOwner = mPrevious; }
+
+            OwnerScope(const OwnerScope&) = delete;
+            OwnerScope& operator=(const OwnerScope&) = delete;
+
+        private:
+            LuaAllocator& mAllocator;
+            OwnerId mPrevious;
+        };
+
+        LuaAllocator();
+        ~LuaAllocator();
+
+        LuaAllocator(const LuaAllocator&) = delete;
+        LuaAllocator& operator=(const LuaAllocator&) = delete;
+
+        // lua_Alloc; `ud` should point to a LuaAllocator.
+        static void* alloc(void* ud, void* ptr, std::size_t osize, std::size_t nsize);
+
+        // `softLimit` in bytes, 0 means the default soft limit.
+        OwnerId addOwner(std::string name, std::int64_t softLimit = 0);
+
+        // The id is reused only after all blocks of the owner are freed.
+        void removeOwner(OwnerId owner);
+
+        // Used for all owners without an own soft limit; 0 means no limit.
+        void setDefaultSoftLimit(std::int64_t softLimit) { mDefaultSoftLimit = softLimit; }
+        std::int64_t getDefaultSoftLimit() const { return mDefaultSoftLimit; }
+        std::int64_t getSoftLimit(const OwnerStats& stats) const
+        {
+            return stats.mSoftLimit > 0 ? stats.mSoftLimit : mDefaultSoftLimit;
+        }
+
+        const std::vector<OwnerStats>& getOwners() const { return mOwners; }
+        std::int64_t getTotalBytes() const { return mTotalBytes; }
+
+        // Memory in pool chunks, used or not.
+        std::int64_t getPooledBytes() const { return static_cast<std::int64_t>(mChunks.size() * sChunkSize); }
+
+    private:
+        struct Header
+        {
+            OwnerId mOwner;
+            std::uint32_t mSizeClass;  // sLargeBlock if not pooled
+        };
+        static constexpr std::uint32_t sLargeBlock = ~std::uint32_t(0);
+        static constexpr std::size_t sSizeClassStep = 16;
+        static constexpr std::size_t sNumSizeClasses = sMaxPooledSize / sSizeClassStep;
+
+        struct FreeBlock
+        {
+            FreeBlock* mNext;
+        };
+
+        static std::uint32_t getSizeClass(std::size_t size);
+
+        void* allocate(std::size_t size, OwnerId owner);
+        void deallocate(void* ptr, std::size_t size);
+        void* reallocate(void* ptr, std::size_t osize, std::size_t nsize);
+        void addChunk(std::uint32_t sizeClass);
+        void account(OwnerId owner, std::int64_t bytes);
+
+        std::array<FreeBlock*, sNumSizeClasses> mFreeLists;
+        std::vector<std::unique_ptr<char[]>> mChunks;
+        std::vector<OwnerStats> mOwners;
+        std::vector<OwnerId> mFreeOwnerIds;
+        OwnerId mCurrentOwner = sCommonOwner;
+        std::int64_t mTotalBytes = 0;
+        std::int64_t mDefaultSoftLimit = 0;
+    };
+
+}
+
+#endif // COMPONENTS_LUA_LUAALLOCATOR_H
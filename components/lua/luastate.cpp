@@ -49,7 +49,21 @@ namespace LuaUtil
         "type", "unpack", "xpcall", "rawequal", "rawget", "rawset", "setmetatable"};
     static const std::string safePackages[] = {"coroutine", "math", "string", "table"};
 
-    LuaState::LuaState(const VFS::Manager* vfs, const ScriptsConfiguration* conf) : mConf(conf), mVFS(vfs)
+    static sol::state createLuaState(LuaAllocator& allocator)
+    {
+        // 64-bit LuaJIT without GC64 doesn't support custom allocators, lua_newstate returns NULL there.
+        lua_State* probe = lua_newstate(&LuaAllocator::alloc, &allocator);
+        if (probe == nullptr)
+        {
+            Log(Debug::Verbose) << "Custom Lua allocators are not supported, Lua memory is not pooled and not accounted";
+            return sol::state();
+        }
+        lua_close(probe);
+        return sol::state(sol::default_at_panic, &LuaAllocator::alloc, &allocator);
+    }
+
+    LuaState::LuaState(const VFS::Manager* vfs, const ScriptsConfiguration* conf)
+        : mLua(createLuaState(mAllocator)), mConf(conf), mVFS(vfs)
     {
         mLua.open_libraries(sol::lib::base, sol::lib::coroutine, sol::lib::math, sol::lib::bit32,
                             sol::lib::string, sol::lib::table, sol::lib::os, sol::lib::debug);
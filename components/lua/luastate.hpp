@@ -8,6 +8,7 @@
 #include <components/vfs/manager.hpp>
 
 #include "configuration.hpp"
+#include "luaallocator.hpp"
 
 namespace LuaUtil
 {
@@ -26,6 +27,7 @@ namespace LuaUtil
     //         Lua libraries (only source, no dll's) in the virtual filesystem;
     //   - Make `print` to add the script name to every message and
     //         write to the Log rather than directly to stdout;
+    //   - Pool small allocations and account memory to owners (see LuaAllocator);
     class LuaState
     {
     public:
@@ -35,6 +37,9 @@ namespace LuaUtil
         // Returns underlying sol::state.
         sol::state& sol() { return mLua; }
 
+        LuaAllocator& getAllocator() { return mAllocator; }
+        const LuaAllocator& getAllocator() const { return mAllocator; }
+
         // Can be used by a C++ function that is called from Lua to get the Lua traceback.
         // Makes no sense if called not from Lua code.
         // Note: It is a slow function, should be used for debug purposes only.
@@ -89,6 +94,7 @@ namespace LuaUtil
 
         sol::function loadScriptAndCache(const std::string& path);
 
+        LuaAllocator mAllocator;  // Should be destructed after mLua.
         sol::state mLua;
         const ScriptsConfiguration* mConf;
         sol::table mSandboxEnv;
@@ -15,9 +15,38 @@ namespace LuaUtil
     static constexpr std::string_view HANDLER_LOAD = "onLoad";
     static constexpr std::string_view HANDLER_INTERFACE_OVERRIDE = "onInterfaceOverride";
 
+    static constexpr std::string_view TEMPORARY_TIMER = "<temporary>";
+
+    bool ScriptsContainer::sProfilerEnabled = false;
+
+    ScriptsContainer::ProfilerScope::ProfilerScope(ScriptsContainer& container, int scriptId,
+                                                   HandlerStatsMap ScriptProfile::*handlers, std::string_view name)
+    {
+        if (!sProfilerEnabled)
+            return;
+        mProfile = &container.mProfile[scriptId];
+        HandlerStatsMap& stats = (*mProfile).*handlers;
+        auto it = stats.find(name);
+        if (it == stats.end())
+            it = stats.emplace(name, HandlerStats()).first;
+        mStats = &it->second;
+        mStart = std::chrono::steady_clock::now();
+    }
+
+    ScriptsContainer::ProfilerScope::~ProfilerScope()
+    {
+        if (mStats == nullptr)
+            return;
+        const auto time = std::chrono::steady_clock::now() - mStart;
+        mStats->mTime += time;
+        ++mStats->mCalls;
+        mProfile->mTime += time;
+    }
+
     ScriptsContainer::ScriptsContainer(LuaUtil::LuaState* lua, std::string_view namePrefix)
-        : mNamePrefix(namePrefix), mLua(*lua)
+        : mNamePrefix(namePrefix), mLua(*lua), mMemoryOwner(lua->getAllocator().addOwner(std::string(namePrefix)))
     {
+        const LuaAllocator::OwnerScope memoryScope(mLua.getAllocator(), mMemoryOwner);
         registerEngineHandlers({&mUpdateHandlers});
         mPublicInterfaces = sol::table(lua->sol(), sol::create);
         addPackage("openmw.interfaces", mPublicInterfaces);
@@ -60,6 +89,7 @@ namespace LuaUtil
         assert(scriptId >= 0 && scriptId < static_cast<int>(mLua.getConfiguration().size()));
         if (mScripts.count(scriptId) != 0)
             return false;  // already present
+        const LuaAllocator::OwnerScope memoryScope(mLua.getAllocator(), mMemoryOwner);
 
         const std::string& path = scriptPath(scriptId);
         std::string debugName = mNamePrefix;
@@ -256,8 +286,9 @@ namespace LuaUtil
                    list.end());
     }
 
-    void ScriptsContainer::receiveEvent(std::string_view eventName, std::string_view eventData)
+    void ScriptsContainer::receiveEvent(std::string_view eventName, const EventData& eventData)
     {
+        const LuaAllocator::OwnerScope memoryScope(mLua.getAllocator(), mMemoryOwner);
         auto it = mEventHandlers.find(eventName);
         if (it == mEventHandlers.end())
         {
@@ -267,7 +298,7 @@ namespace LuaUtil
         sol::object data;
         try
         {
-            data = LuaUtil::deserialize(mLua.sol(), eventData, mSerializer);
+            data = eventData.get(mLua.sol(), mSerializer);
         }
         catch (std::exception& e)
         {
@@ -277,6 +308,7 @@ namespace LuaUtil
         EventHandlerList& list = it->second;
         for (int i = list.size() - 1; i >= 0; --i)
         {
+            const ProfilerScope profilerScope(*this, list[i].mScriptId, &ScriptProfile::mEvents, eventName);
             try
             {
                 sol::object res = LuaUtil::call(list[i].mFn, data);
@@ -299,6 +331,7 @@ namespace LuaUtil
 
     void ScriptsContainer::callOnInit(int scriptId, const sol::function& onInit, std::string_view data)
     {
+        const LuaAllocator::OwnerScope memoryScope(mLua.getAllocator(), mMemoryOwner);
         try
         {
             LuaUtil::call(onInit, deserialize(mLua.sol(), data, mSerializer));
@@ -308,6 +341,7 @@ namespace LuaUtil
 
     void ScriptsContainer::save(ESM::LuaScripts& data)
     {
+        const LuaAllocator::OwnerScope memoryScope(mLua.getAllocator(), mMemoryOwner);
         std::map<int, std::vector<ESM::LuaTimer>> timers;
         auto saveTimerFn = [&](const Timer& timer, TimerType timerType)
         {
@@ -350,6 +384,7 @@ namespace LuaUtil
     void ScriptsContainer::load(const ESM::LuaScripts& data)
     {
         removeAllScripts();
+        const LuaAllocator::OwnerScope memoryScope(mLua.getAllocator(), mMemoryOwner);
         const ScriptsConfiguration& cfg = mLua.getConfiguration();
 
         struct ScriptInfo
@@ -431,6 +466,7 @@ namespace LuaUtil
     {
         for (auto& [_, script] : mScripts)
             script.mHiddenData[sScriptIdKey] = sol::nil;
+        mLua.getAllocator().removeOwner(mMemoryOwner);
     }
 
     // Note: shouldn't be called from destructor because mEngineHandlers has pointers on
@@ -496,6 +532,9 @@ namespace LuaUtil
 
     void ScriptsContainer::callTimer(const Timer& t)
     {
+        const LuaAllocator::OwnerScope memoryScope(mLua.getAllocator(), mMemoryOwner);
+        const ProfilerScope profilerScope(*this, t.mScriptId, &ScriptProfile::mTimers,
+            t.mSerializable ? std::string_view(std::get<std::string>(t.mCallback)) : TEMPORARY_TIMER);
         try
         {
             Script& script = getScript(t.mScriptId);
@@ -1,6 +1,8 @@
 #ifndef COMPONENTS_LUA_SCRIPTSCONTAINER_H
 #define COMPONENTS_LUA_SCRIPTSCONTAINER_H
 
+#include <chrono>
+#include <cstdint>
 #include <map>
 #include <set>
 #include <string>
@@ -75,6 +77,22 @@ namespace LuaUtil
         };
         using TimerType = ESM::LuaTimer::Type;
 
+        struct HandlerStats
+        {
+            std::chrono::steady_clock::duration mTime{};
+            std::uint64_t mCalls = 0;
+        };
+        using HandlerStatsMap = std::map<std::string, HandlerStats, std::less<>>;
+
+        // Time spent in the handlers of one script, by handler name.
+        struct ScriptProfile
+        {
+            HandlerStatsMap mEngineHandlers;
+            HandlerStatsMap mEvents;
+            HandlerStatsMap mTimers;  // By callback name, unsavable timers are named "<temporary>".
+            std::chrono::steady_clock::duration mTime{};  // Sum of all handlers.
+        };
+
         // `namePrefix` is a common prefix for all scripts in the container. Used in logs for error messages and `print` output.
         // `autoStartScripts` specifies the list of scripts that should be autostarted in this container;
         //     the script names themselves are stored in ScriptsConfiguration.
@@ -87,6 +105,8 @@ namespace LuaUtil
         void setAutoStartConf(ScriptIdsWithInitializationData conf) { mAutoStartScripts = std::move(conf); }
         const ScriptIdsWithInitializationData& getAutoStartConf() const { return mAutoStartScripts; }
 
+        LuaState* getLuaState() const { return &mLua; }
+
         // Adds package that will be available (via `require`) for all scripts in the container.
         // Automatically applies LuaUtil::makeReadOnly to the package.
         void addPackage(std::string packageName, sol::object package);
@@ -110,7 +130,10 @@ namespace LuaUtil
         // If several scripts register handlers for `eventName`, they are called in reverse order.
         // If some handler returns `false`, all remaining handlers are ignored. Any other return value
         // (including `nil`) has no effect.
-        void receiveEvent(std::string_view eventName, std::string_view eventData);
+        void receiveEvent(std::string_view eventName, std::string_view eventData)
+            { receiveEvent(eventName, EventData(BinaryData(eventData))); }
+        // `eventData` should be either binary data or a value of the Lua state of this container.
+        void receiveEvent(std::string_view eventName, const EventData& eventData);
 
         // Serializer defines how to serialize/deserialize userdata. If serializer is not provided,
         // only built-in types and types from util package can be serialized.
@@ -149,6 +172,14 @@ namespace LuaUtil
         // because they can not be stored in saves. I.e. loading a saved game will not fully restore the state.
         void setupUnsavableTimer(TimerType type, double time, int scriptId, sol::function callback);
 
+        // Enables measuring the time of engine handlers, event handlers and timer callbacks in all containers.
+        static void setProfilerEnabled(bool enabled) { sProfilerEnabled = enabled; }
+        static bool isProfilerEnabled() { return sProfilerEnabled; }
+
+        // Stats collected since the last call of `clearProfile`, by script id.
+        const std::map<int, ScriptProfile>& getProfile() const { return mProfile; }
+        void clearProfile() { mProfile.clear(); }
+
     protected:
         struct Handler
         {
@@ -169,8 +200,10 @@ namespace LuaUtil
         template <typename... Args>
         void callEngineHandlers(EngineHandlerList& handlers, const Args&... args)
         {
+            const LuaAllocator::OwnerScope memoryScope(mLua.getAllocator(), mMemoryOwner);
             for (Handler& handler : handlers.mList)
             {
+                const ProfilerScope profilerScope(*this, handler.mScriptId, &ScriptProfile::mEngineHandlers, handlers.mName);
                 try { LuaUtil::call(handler.mFn, args...); }
                 catch (std::exception& e)
                 {
@@ -186,6 +219,7 @@ namespace LuaUtil
 
         const std::string mNamePrefix;
         LuaUtil::LuaState& mLua;
+        const LuaAllocator::OwnerId mMemoryOwner;  // Lua memory allocated by the scripts is accounted to it
 
     private:
         struct Script
@@ -212,6 +246,23 @@ namespace LuaUtil
         };
         using EventHandlerList = std::vector<Handler>;
 
+        // Adds the time of one handler call to mProfile if the profiler is enabled.
+        class ProfilerScope
+        {
+        public:
+            ProfilerScope(ScriptsContainer& container, int scriptId, HandlerStatsMap ScriptProfile::*handlers,
+                          std::string_view name);
+            ~ProfilerScope();
+
+            ProfilerScope(const ProfilerScope&) = delete;
+            ProfilerScope& operator=(const ProfilerScope&) = delete;
+
+        private:
+            ScriptProfile* mProfile = nullptr;
+            HandlerStats* mStats = nullptr;
+            std::chrono::steady_clock::time_point mStart;
+        };
+
         // Add to container without calling onInit/onLoad.
         bool addScript(int scriptId, std::optional<sol::function>& onInit, std::optional<sol::function>& onLoad);
 
@@ -244,6 +295,9 @@ namespace LuaUtil
         std::vector<Timer> mSimulationTimersQueue;
         std::vector<Timer> mGameTimersQueue;
         int64_t mTemporaryCallbackCounter = 0;
+
+        std::map<int, ScriptProfile> mProfile;
+        static bool sProfilerEnabled;
     };
 
     // Wrapper for a Lua function.
@@ -1,5 +1,7 @@
 #include "serialization.hpp"
 
+#include <unordered_map>
+
 #include <osg/Matrixf>
 #include <osg/Quat>
 #include <osg/Vec2f>
@@ -15,7 +17,8 @@
 namespace LuaUtil
 {
 
-    constexpr unsigned char FORMAT_VERSION = 0;
+    // Version 1 adds string references.
+    constexpr unsigned char FORMAT_VERSION = 1;
 
     enum class SerializedType : char
     {
@@ -24,6 +27,8 @@ namespace LuaUtil
         BOOLEAN =      0x2,
         TABLE_START =  0x3,
         TABLE_END =    0x4,
+        SHORT_STRING_REF = 0x5,  // + 8bit index in the string dictionary
+        STRING_REF =   0x6,  // + 32bit index in the string dictionary
 
         VEC2 =         0x10,
         VEC3 =         0x11,
@@ -38,6 +43,12 @@ namespace LuaUtil
     constexpr unsigned char CUSTOM_FULL_FLAG = 0x40;     // 0b01TTTTTT + 32bit dataSize
     constexpr unsigned char CUSTOM_COMPACT_FLAG = 0x80;  // 0b1SSSSTTT. SSSS = dataSize, TTT = (typeName size - 1)
 
+    // Every string of at least this size is added to the string dictionary when it is serialized the first time.
+    // Further occurrences of the same string (e.g. the same keys in an array of tables) are serialized as
+    // a reference to the dictionary. The dictionary itself is not stored: the deserializer builds the same one.
+    constexpr size_t MIN_DICTIONARY_STRING_SIZE = 4;
+    using StringDictionary = std::unordered_map<std::string_view, uint32_t>;
+
     static void appendType(BinaryData& out, SerializedType type)
     {
         out.push_back(static_cast<char>(type));
@@ -61,8 +72,25 @@ namespace LuaUtil
         return Misc::fromLittleEndian(v);
     }
 
-    static void appendString(BinaryData& out, std::string_view str)
+    static void appendString(BinaryData& out, std::string_view str, StringDictionary& dictionary)
     {
+        if (str.size() >= MIN_DICTIONARY_STRING_SIZE)
+        {
+            // `str` points to a Lua string that is referenced by the serialized object, so stays valid.
+            auto [it, inserted] = dictionary.emplace(str, static_cast<uint32_t>(dictionary.size()));
+            if (!inserted && it->second <= 0xff)
+            {
+                appendType(out, SerializedType::SHORT_STRING_REF);
+                out.push_back(static_cast<char>(it->second));
+                return;
+            }
+            else if (!inserted)
+            {
+                appendType(out, SerializedType::STRING_REF);
+                appendValue<uint32_t>(out, it->second);
+                return;
+            }
+        }
         if (str.size() < 32)
             out.push_back(SHORT_STRING_FLAG | char(str.size()));
         else
@@ -194,7 +222,8 @@ namespace LuaUtil
             throw std::runtime_error("Value is not serializable.");
     }
 
-    static void serialize(BinaryData& out, const sol::object& obj, const UserdataSerializer* customSerializer, int recursionCounter)
+    static void serialize(BinaryData& out, const sol::object& obj, const UserdataSerializer* customSerializer,
+                          StringDictionary& dictionary, int recursionCounter)
     {
         if (obj.get_type() == sol::type::lightuserdata)
             throw std::runtime_error("Light userdata is not allowed to be serialized.");
@@ -210,8 +239,8 @@ namespace LuaUtil
             appendType(out, SerializedType::TABLE_START);
             for (auto& [key, value] : table)
             {
-                serialize(out, key, customSerializer, recursionCounter + 1);
-                serialize(out, value, customSerializer, recursionCounter + 1);
+                serialize(out, key, customSerializer, dictionary, recursionCounter + 1);
+                serialize(out, value, customSerializer, dictionary, recursionCounter + 1);
             }
             appendType(out, SerializedType::TABLE_END);
         }
@@ -221,7 +250,7 @@ namespace LuaUtil
             appendValue<double>(out, obj.as<double>());
         }
         else if (obj.is<std::string_view>())
-            appendString(out, obj.as<std::string_view>());
+            appendString(out, obj.as<std::string_view>(), dictionary);
         else if (obj.is<bool>())
         {
             char v = obj.as<bool>() ? 1 : 0;
@@ -231,8 +260,22 @@ namespace LuaUtil
             throw std::runtime_error("Unknown Lua type.");
     }
 
-    static void deserializeImpl(lua_State* lua, std::string_view& binaryData,
-                                const UserdataSerializer* customSerializer, bool readOnly)
+    static void pushString(lua_State* lua, std::string_view str, std::vector<std::string_view>& dictionary)
+    {
+        if (str.size() >= MIN_DICTIONARY_STRING_SIZE)
+            dictionary.push_back(str);
+        sol::stack::push<std::string_view>(lua, str);
+    }
+
+    static void pushStringRef(lua_State* lua, uint32_t index, const std::vector<std::string_view>& dictionary)
+    {
+        if (index >= dictionary.size())
+            throw std::runtime_error("Incorrect string reference in serialized data: " + std::to_string(index));
+        sol::stack::push<std::string_view>(lua, dictionary[index]);
+    }
+
+    static void deserializeImpl(lua_State* lua, std::string_view& binaryData, const UserdataSerializer* customSerializer,
+                                bool readOnly, std::vector<std::string_view>& dictionary)
     {
         if (binaryData.empty())
             throw std::runtime_error("Unexpected end of serialized data.");
@@ -261,7 +304,7 @@ namespace LuaUtil
         if (type & SHORT_STRING_FLAG)
         {
             size_t size = type & 0x1f;
-            sol::stack::push<std::string_view>(lua, binaryData.substr(0, size));
+            pushString(lua, binaryData.substr(0, size), dictionary);
             binaryData = binaryData.substr(size);
             return;
         }
@@ -276,17 +319,23 @@ namespace LuaUtil
             case SerializedType::LONG_STRING:
             {
                 uint32_t size = getValue<uint32_t>(binaryData);
-                sol::stack::push<std::string_view>(lua, binaryData.substr(0, size));
+                pushString(lua, binaryData.substr(0, size), dictionary);
                 binaryData = binaryData.substr(size);
                 return;
             }
+            case SerializedType::SHORT_STRING_REF:
+                pushStringRef(lua, getValue<uint8_t>(binaryData), dictionary);
+                return;
+            case SerializedType::STRING_REF:
+                pushStringRef(lua, getValue<uint32_t>(binaryData), dictionary);
+                return;
             case SerializedType::TABLE_START:
             {
                 lua_createtable(lua, 0, 0);
                 while (!binaryData.empty() && binaryData[0] != char(SerializedType::TABLE_END))
                 {
-                    deserializeImpl(lua, binaryData, customSerializer, readOnly);
-                    deserializeImpl(lua, binaryData, customSerializer, readOnly);
+                    deserializeImpl(lua, binaryData, customSerializer, readOnly, dictionary);
+                    deserializeImpl(lua, binaryData, customSerializer, readOnly, dictionary);
                     lua_settable(lua, -3);
                 }
                 if (binaryData.empty())
@@ -358,7 +407,8 @@ namespace LuaUtil
             return "";
         BinaryData res;
         res.push_back(FORMAT_VERSION);
-        serialize(res, obj, customSerializer, 0);
+        StringDictionary dictionary;
+        serialize(res, obj, customSerializer, dictionary, 0);
         return res;
     }
 
@@ -367,14 +417,101 @@ namespace LuaUtil
     {
         if (binaryData.empty())
             return sol::nil;
-        if (binaryData[0] != FORMAT_VERSION)
+        if (static_cast<unsigned char>(binaryData[0]) > FORMAT_VERSION)
             throw std::runtime_error("Incorrect version of Lua serialization format: " +
-                                     std::to_string(static_cast<unsigned>(binaryData[0])));
+                                     std::to_string(static_cast<unsigned char>(binaryData[0])));
         binaryData = binaryData.substr(1);
-        deserializeImpl(lua, binaryData, customSerializer, readOnly);
+        std::vector<std::string_view> dictionary;
+        deserializeImpl(lua, binaryData, customSerializer, readOnly, dictionary);
         if (!binaryData.empty())
             throw std::runtime_error("Unexpected data after serialized object");
         return sol::stack::pop<sol::object>(lua);
     }
 
+    static bool isBuiltInUserdata(const sol::userdata& data)
+    {
+        return data.is<osg::Vec2f>() || data.is<osg::Vec3f>() || data.is<TransformM>() || data.is<TransformQ>()
+            || data.is<osg::Vec4f>() || data.is<Misc::Color>();
+    }
+
+    // Makes the same copy of `obj` as `deserialize(serialize(obj, serializer), deserializer)`, but without binary data.
+    // Only tables are copied; other values are immutable, so are shared. If `deserializer` is nullptr, custom userdata
+    // is only checked to be serializable.
+    static sol::object copy(lua_State* lua, const sol::object& obj, const UserdataSerializer* serializer,
+                            const UserdataSerializer* deserializer, bool& hasCustomUserdata, int recursionCounter)
+    {
+        if (obj.get_type() == sol::type::lightuserdata)
+            throw std::runtime_error("Light userdata is not allowed to be serialized.");
+        if (obj.is<sol::function>())
+            throw std::runtime_error("Functions are not allowed to be serialized.");
+        else if (obj.is<sol::userdata>())
+        {
+            if (isBuiltInUserdata(obj))
+                return obj;
+            BinaryData data;
+            if (!serializer || !serializer->serialize(data, obj))
+                throw std::runtime_error("Value is not serializable.");
+            hasCustomUserdata = true;
+            if (!deserializer)
+                return obj;
+            std::string_view binaryData = data;
+            std::vector<std::string_view> dictionary;
+            deserializeImpl(lua, binaryData, deserializer, false, dictionary);
+            return sol::stack::pop<sol::object>(lua);
+        }
+        else if (obj.is<sol::lua_table>())
+        {
+            if (recursionCounter >= 32)
+                throw std::runtime_error("Can not serialize more than 32 nested tables. Likely the table contains itself.");
+            sol::table table = obj;
+            sol::table res(lua, sol::create);
+            for (auto& [key, value] : table)
+            {
+                res.raw_set(copy(lua, key, serializer, deserializer, hasCustomUserdata, recursionCounter + 1),
+                            copy(lua, value, serializer, deserializer, hasCustomUserdata, recursionCounter + 1));
+            }
+            return res;
+        }
+        else if (obj.is<double>() || obj.is<std::string_view>() || obj.is<bool>())
+            return obj;
+        else
+            throw std::runtime_error("Unknown Lua type.");
+    }
+
+    EventData::EventData(lua_State* lua, const sol::object& value, const UserdataSerializer* serializer)
+        : mLua(lua), mSerializer(serializer)
+    {
+        if (value != sol::nil)
+            mValue = copy(lua, value, serializer, nullptr, mHasCustomUserdata, 0);
+    }
+
+    sol::object EventData::get(lua_State* lua, const UserdataSerializer* deserializer) const
+    {
+        if (!mValue.valid())
+            return deserialize(lua, mData, deserializer);
+        if (mLua != lua)
+            throw std::logic_error("EventData is used in another Lua state without detaching");
+        if (!mHasCustomUserdata)
+            return mValue;
+        if (!deserializer)
+            return deserialize(lua, getBinaryData(), nullptr);  // throws the same error as for binary data
+        bool hasCustomUserdata = false;
+        return copy(lua, mValue, mSerializer, deserializer, hasCustomUserdata, 0);
+    }
+
+    BinaryData EventData::getBinaryData() const
+    {
+        if (mValue.valid())
+            return serialize(mValue, mSerializer);
+        return mData;
+    }
+
+    void EventData::detach()
+    {
+        if (!mValue.valid())
+            return;
+        mData = serialize(mValue, mSerializer);
+        mValue = sol::object();
+    }
+
 }
@@ -52,6 +52,40 @@ namespace LuaUtil
     sol::object deserialize(lua_State* lua, std::string_view binaryData,
                             const UserdataSerializer* customSerializer = nullptr, bool readOnly = false);
 
+    // Serializable data passed from one script to another (e.g. data of an event). If it is created from a Lua value,
+    // it keeps a copy of the value in the same Lua state, so a script of this state receives it without serialization
+    // and parsing. The result is the same as if the value was serialized by `serializer` and deserialized by
+    // the serializer of the receiver.
+    class EventData
+    {
+    public:
+        EventData() = default;
+        explicit EventData(BinaryData data) : mData(std::move(data)) {}
+
+        // `lua` should be the main thread of the Lua state. Throws the same errors as `serialize`.
+        EventData(lua_State* lua, const sol::object& value, const UserdataSerializer* serializer);
+
+        // `lua` should be the main thread of the receiver's Lua state. The value kept in the Lua state is returned
+        // as is, so every EventData should be received only once.
+        sol::object get(lua_State* lua, const UserdataSerializer* deserializer) const;
+
+        bool isInLuaState(lua_State* lua) const { return mValue.valid() && mLua == lua; }
+
+        // Returns a serialized copy of the data.
+        BinaryData getBinaryData() const;
+
+        // Serializes the value and releases its copy kept in the Lua state. After that the data can be passed to
+        // another Lua state. Should be called only when no other thread uses the Lua state of the value.
+        void detach();
+
+    private:
+        BinaryData mData;
+        sol::object mValue;
+        lua_State* mLua = nullptr;
+        const UserdataSerializer* mSerializer = nullptr;
+        bool mHasCustomUserdata = false;  // Custom userdata is converted by the serializers on every `get`.
+    };
+
 }
 
 #endif // COMPONENTS_LUA_SERIALIZATION_H
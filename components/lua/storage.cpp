@@ -23,10 +23,17 @@ namespace LuaUtil
     sol::object LuaStorage::Value::getReadOnly(lua_State* L) const
     {
         if (mReadOnlyValue == sol::nil && !mSerializedValue.empty())
-            mReadOnlyValue = deserialize(L, mSerializedValue, nullptr, true);
+            mReadOnlyValue = getReadOnlyUncached(L);
         return mReadOnlyValue;
     }
 
+    sol::object LuaStorage::Value::getReadOnlyUncached(lua_State* L) const
+    {
+        if (mSerializedValue.empty())
+            return sol::make_object(L, sol::nil);
+        return deserialize(L, mSerializedValue, nullptr, true);
+    }
+
     const LuaStorage::Value& LuaStorage::Section::get(std::string_view key) const
     {
         auto it = mValues.find(key);
@@ -87,11 +94,11 @@ namespace LuaUtil
         runCallbacks(sol::nullopt);
     }
 
-    sol::table LuaStorage::Section::asTable()
+    sol::table LuaStorage::Section::asTable(lua_State* L)
     {
-        sol::table res(mStorage->mLua, sol::create);
+        sol::table res(L, sol::create);
         for (const auto& [k, v] : mValues)
-            res[k] = v.getCopy(mStorage->mLua);
+            res[k] = v.getCopy(L);
         return res;
     }
 
@@ -101,15 +108,19 @@ namespace LuaUtil
         sol::usertype<SectionView> sview = lua.new_usertype<SectionView>("Section");
         sview["get"] = [](sol::this_state s, const SectionView& section, std::string_view key)
         {
-            return section.mSection->get(key).getReadOnly(s);
+            const Value& value = section.mSection->get(key);
+            if (section.mOwnState)
+                return value.getReadOnly(s);
+            return value.getReadOnlyUncached(s);
         };
         sview["getCopy"] = [](sol::this_state s, const SectionView& section, std::string_view key)
         {
             return section.mSection->get(key).getCopy(s);
         };
-        sview["asTable"] = [](const SectionView& section) { return section.mSection->asTable(); };
+        sview["asTable"] = [](sol::this_state s, const SectionView& section) { return section.mSection->asTable(s); };
         sview["subscribe"] = [](const SectionView& section, const Callback& callback)
         {
+            std::lock_guard<std::mutex> lock(section.mSection->mStorage->mMutex);
             std::vector<Callback>& callbacks = section.mSection->mCallbacks;
             if (!callbacks.empty() && callbacks.size() == callbacks.capacity())
             {
@@ -183,7 +194,7 @@ namespace LuaUtil
         for (const auto& [sectionName, section] : mData)
         {
             if (section->mPermanent && !section->mValues.empty())
-                data[sectionName] = section->asTable();
+                data[sectionName] = section->asTable(mLua);
         }
         std::string serializedData = serialize(data);
         Log(Debug::Info) << "Saving Lua storage \"" << path << "\" (" << serializedData.size() << " bytes)";
@@ -194,6 +205,7 @@ namespace LuaUtil
 
     const std::shared_ptr<LuaStorage::Section>& LuaStorage::getSection(std::string_view sectionName)
     {
+        std::lock_guard<std::mutex> lock(mMutex);
         auto it = mData.find(sectionName);
         if (it != mData.end())
             return it->second;
@@ -203,10 +215,12 @@ namespace LuaUtil
         return newIt->second;
     }
 
-    sol::object LuaStorage::getSection(std::string_view sectionName, bool readOnly)
+    sol::object LuaStorage::getSection(std::string_view sectionName, bool readOnly, lua_State* lua)
     {
+        if (lua == nullptr)
+            lua = mLua;
         const std::shared_ptr<Section>& section = getSection(sectionName);
-        return sol::make_object<SectionView>(mLua, SectionView{section, readOnly});
+        return sol::make_object<SectionView>(lua, SectionView{section, readOnly, lua == mLua});
     }
 
     sol::table LuaStorage::getAllSections(bool readOnly)
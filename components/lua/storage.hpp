@@ -2,6 +2,7 @@
 #define COMPONENTS_LUA_STORAGE_H
 
 #include <map>
+#include <mutex>
 #include <sol/sol.hpp>
 
 #include "scriptscontainer.hpp"
@@ -21,9 +22,13 @@ namespace LuaUtil
         void load(const std::string& path);
         void save(const std::string& path) const;
 
-        sol::object getSection(std::string_view sectionName, bool readOnly);
+        // `lua` is the Lua state that will use the section; the state of the storage by default.
+        // Sections can be used from other states only for reading and subscribing; these functions and
+        // reading from the section are thread safe as long as nothing modifies the storage at the same time.
+        sol::object getSection(std::string_view sectionName, bool readOnly, lua_State* lua = nullptr);
         sol::object getMutableSection(std::string_view sectionName) { return getSection(sectionName, false); }
-        sol::object getReadOnlySection(std::string_view sectionName) { return getSection(sectionName, true); }
+        sol::object getReadOnlySection(std::string_view sectionName, lua_State* lua = nullptr)
+            { return getSection(sectionName, true, lua); }
         sol::table getAllSections(bool readOnly = false);
 
         void setSingleValue(std::string_view section, std::string_view key, const sol::object& value)
@@ -47,7 +52,9 @@ namespace LuaUtil
             Value() {}
             Value(const sol::object& value) : mSerializedValue(serialize(value)) {}
             sol::object getCopy(lua_State* L) const;
+            // Caches the result, so `L` should always be the state of the storage.
             sol::object getReadOnly(lua_State* L) const;
+            sol::object getReadOnlyUncached(lua_State* L) const;
 
         private:
             std::string mSerializedValue;
@@ -60,7 +67,7 @@ namespace LuaUtil
             const Value& get(std::string_view key) const;
             void set(std::string_view key, const sol::object& value);
             void setAll(const sol::optional<sol::table>& values);
-            sol::table asTable();
+            sol::table asTable(lua_State* L);
             void runCallbacks(sol::optional<std::string_view> changedKey);
             void throwIfCallbackRecursionIsTooDeep();
 
@@ -75,6 +82,7 @@ namespace LuaUtil
         {
             std::shared_ptr<Section> mSection;
             bool mReadOnly;
+            bool mOwnState;  // false if used by a Lua state other than the state of the storage
         };
 
         const std::shared_ptr<Section>& getSection(std::string_view sectionName);
@@ -83,6 +91,7 @@ namespace LuaUtil
         std::map<std::string_view, std::shared_ptr<Section>> mData;
         const Listener* mListener = nullptr;
         std::set<const Section*> mRunningCallbacks;
+        std::mutex mMutex;  // Protects creation of sections and adding callbacks
     };
 
 }
@@ -2,6 +2,7 @@
 #include "effect.hpp"
 
 #include <components/files/hash.hpp>
+#include <components/files/memorystream.hpp>
 
 #include <array>
 #include <map>
@@ -172,11 +173,12 @@ std::string NIFFile::printVersion(unsigned int version)
 
 void NIFFile::parse(Files::IStreamPtr&& stream)
 {
-    const std::array<std::uint64_t, 2> fileHash = Files::getHash(filename, *stream);
-    hash.append(reinterpret_cast<const char*>(fileHash.data()), fileHash.size() * sizeof(std::uint64_t));
-
     NIFStream nif (this, std::move(stream));
 
+    Files::IMemStream data(nif.data(), nif.size());
+    const std::array<std::uint64_t, 2> fileHash = Files::getHash(filename, data);
+    hash.append(reinterpret_cast<const char*>(fileHash.data()), fileHash.size() * sizeof(std::uint64_t));
+
     // Check the header string
     std::string head = nif.getVersionString();
     static const std::array<std::string, 2> verStrings =
@@ -5,8 +5,11 @@
 
 #include "nifstream.hpp"
 
+#include <algorithm>
 #include <sstream>
-#include <map>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "niffile.hpp"
 
@@ -29,12 +32,9 @@ struct KeyT {
     T mInTan; // Only for Quadratic interpolation, and never for QuaternionKeyList
     T mOutTan; // Only for Quadratic interpolation, and never for QuaternionKeyList
 
-    // FIXME: Implement TBC interpolation
-    /*
-    float mTension;    // Only for TBC interpolation
-    float mBias;       // Only for TBC interpolation
+    float mTension; // Only for TBC interpolation
+    float mBias; // Only for TBC interpolation
     float mContinuity; // Only for TBC interpolation
-    */
 };
 using FloatKey = KeyT<float>;
 using Vector3Key = KeyT<osg::Vec3f>;
@@ -43,13 +43,24 @@ using QuaternionKey = KeyT<osg::Quat>;
 
 template<typename T, T (NIFStream::*getValue)()>
 struct KeyMapT {
-    using MapType = std::map<float, KeyT<T>>;
-
     using ValueType = T;
     using KeyType = KeyT<T>;
 
     unsigned int mInterpolationType = InterpolationType_Unknown;
-    MapType mKeys;
+
+    // Keys sorted by time and flattened into separate arrays, so that a key lookup only touches mTimes.
+    // Tangents are only stored for Quadratic and TBC keys (TBC parameters are converted into tangents on load)
+    // and are empty otherwise.
+    std::vector<float> mTimes;
+    std::vector<T> mValues;
+    std::vector<T> mInTans;
+    std::vector<T> mOutTans;
+
+    bool empty() const { return mTimes.empty(); }
+
+    std::size_t size() const { return mTimes.size(); }
+
+    bool hasTangents() const { return !mInTans.empty(); }
 
     //Read in a KeyGroup (see http://niftools.sourceforge.net/doc/nif/NiKeyframeData.html)
     void read(NIFStream *nif, bool morph = false)
@@ -64,33 +75,33 @@ struct KeyMapT {
         if (count != 0 || morph)
             mInterpolationType = nif->getUInt();
 
-        KeyType key = {};
+        std::vector<std::pair<float, KeyType>> keys;
 
         if (mInterpolationType == InterpolationType_Linear || mInterpolationType == InterpolationType_Constant)
         {
-            for (size_t i = 0;i < count;i++)
+            keys.resize(count);
+            for (auto& [time, key] : keys)
             {
-                float time = nif->getFloat();
+                time = nif->getFloat();
                 readValue(*nif, key);
-                mKeys[time] = key;
             }
         }
         else if (mInterpolationType == InterpolationType_Quadratic)
         {
-            for (size_t i = 0;i < count;i++)
+            keys.resize(count);
+            for (auto& [time, key] : keys)
             {
-                float time = nif->getFloat();
+                time = nif->getFloat();
                 readQuadratic(*nif, key);
-                mKeys[time] = key;
             }
         }
         else if (mInterpolationType == InterpolationType_TBC)
         {
-            for (size_t i = 0;i < count;i++)
+            keys.resize(count);
+            for (auto& [time, key] : keys)
             {
-                float time = nif->getFloat();
+                time = nif->getFloat();
                 readTBC(*nif, key);
-                mKeys[time] = key;
             }
         }
         else if (mInterpolationType == InterpolationType_XYZ)
@@ -114,9 +125,92 @@ struct KeyMapT {
                 nif->getVersion() <= NIFStream::generateVersion(20,1,0,2) && nif->getBethVersion() < 10)
                 nif->getFloat(); // Legacy weight
         }
+
+        setKeys(std::move(keys));
     }
 
 private:
+    void setKeys(std::vector<std::pair<float, KeyType>>&& keys)
+    {
+        // Keys are expected to be sorted already, but duplicate or unordered times are possible.
+        // Keep the last key read for each time like the map-based storage used to.
+        const auto timeLess = [] (const auto& a, const auto& b) { return a.first < b.first; };
+        if (!std::is_sorted(keys.begin(), keys.end(), timeLess))
+            std::stable_sort(keys.begin(), keys.end(), timeLess);
+        const auto sameTime = [] (const auto& a, const auto& b) { return a.first == b.first; };
+        if (std::adjacent_find(keys.begin(), keys.end(), sameTime) != keys.end())
+        {
+            std::reverse(keys.begin(), keys.end());
+            keys.erase(std::unique(keys.begin(), keys.end(), sameTime), keys.end());
+            std::reverse(keys.begin(), keys.end());
+        }
+
+        mTimes.clear();
+        mValues.clear();
+        mInTans.clear();
+        mOutTans.clear();
+        mTimes.reserve(keys.size());
+        mValues.reserve(keys.size());
+        for (const auto& [time, key] : keys)
+        {
+            mTimes.push_back(time);
+            mValues.push_back(key.mValue);
+        }
+
+        if constexpr (!std::is_same_v<T, osg::Quat>)
+        {
+            if (mInterpolationType == InterpolationType_Quadratic)
+            {
+                mInTans.reserve(keys.size());
+                mOutTans.reserve(keys.size());
+                for (const auto& [time, key] : keys)
+                {
+                    mInTans.push_back(key.mInTan);
+                    mOutTans.push_back(key.mOutTan);
+                }
+            }
+            else if (mInterpolationType == InterpolationType_TBC)
+                generateTBCTangents(keys);
+        }
+    }
+
+    // Convert Kochanek-Bartels (TBC) parameters into Hermite tangents, so that TBC keys can be evaluated
+    // with the same kernel as Quadratic keys
+    void generateTBCTangents(const std::vector<std::pair<float, KeyType>>& keys)
+    {
+        const std::size_t count = keys.size();
+        mInTans.resize(count, T());
+        mOutTans.resize(count, T());
+        if (count < 2)
+            return;
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const KeyType& key = keys[i].second;
+            const std::size_t prev = i > 0 ? i - 1 : i;
+            const std::size_t next = i + 1 < count ? i + 1 : i;
+            // The first and the last key have only one neighbour, use the same delta on both sides
+            const T prevDelta = i > 0 ? T(key.mValue - keys[prev].second.mValue) : T(keys[next].second.mValue - key.mValue);
+            const T nextDelta = i + 1 < count ? T(keys[next].second.mValue - key.mValue) : prevDelta;
+            const float prevTime = i > 0 ? keys[i].first - keys[prev].first : keys[next].first - keys[i].first;
+            const float nextTime = i + 1 < count ? keys[next].first - keys[i].first : prevTime;
+
+            const float t = 1.f - key.mTension;
+            const float inPrev = 0.5f * t * (1.f - key.mContinuity) * (1.f + key.mBias);
+            const float inNext = 0.5f * t * (1.f + key.mContinuity) * (1.f - key.mBias);
+            const float outPrev = 0.5f * t * (1.f + key.mContinuity) * (1.f + key.mBias);
+            const float outNext = 0.5f * t * (1.f - key.mContinuity) * (1.f - key.mBias);
+
+            // Tangents are applied to a whole segment, so adjust them for unevenly spaced keys
+            const float timeSum = prevTime + nextTime;
+            const float inScale = timeSum > 0.f ? 2.f * prevTime / timeSum : 1.f;
+            const float outScale = timeSum > 0.f ? 2.f * nextTime / timeSum : 1.f;
+
+            mInTans[i] = T((prevDelta * inPrev + nextDelta * inNext) * inScale);
+            mOutTans[i] = T((prevDelta * outPrev + nextDelta * outNext) * outScale);
+        }
+    }
+
     static void readValue(NIFStream &nif, KeyT<T> &key)
     {
         key.mValue = (nif.*getValue)();
@@ -138,9 +232,9 @@ private:
     static void readTBC(NIFStream &nif, KeyT<T> &key)
     {
         readValue(nif, key);
-        /*key.mTension = */nif.getFloat();
-        /*key.mBias = */nif.getFloat();
-        /*key.mContinuity = */nif.getFloat();
+        key.mTension = nif.getFloat();
+        key.mBias = nif.getFloat();
+        key.mContinuity = nif.getFloat();
     }
 };
 using FloatKeyMap = KeyMapT<float,&NIFStream::getFloat>;
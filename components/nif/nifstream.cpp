@@ -4,10 +4,30 @@
 
 namespace Nif
 {
+    NIFStream::NIFStream(NIFFile* file, Files::IStreamPtr&& inp)
+        : file(file)
+    {
+        // Parsing from memory avoids the per-read overhead of the istream, most reads are only a few bytes large
+        inp->seekg(0, std::ios_base::end);
+        const std::streamoff size = inp->tellg();
+        inp->seekg(0, std::ios_base::beg);
+        if (size < 0 || inp->fail())
+            throw std::runtime_error("Failed to get the size of the NIF stream");
+
+        mBuffer.resize(static_cast<std::size_t>(size));
+        inp->read(mBuffer.data(), size);
+        if (inp->gcount() != size)
+            throw std::runtime_error("Failed to read " + std::to_string(size) + " bytes of the NIF stream");
+
+        mBegin = mBuffer.data();
+        mPos = mBegin;
+        mEnd = mBegin + mBuffer.size();
+    }
+
     osg::Quat NIFStream::getQuaternion()
     {
         float f[4];
-        readLittleEndianBufferOfType<4, float>(inp, f);
+        readLittleEndianBuffer(f, 4);
         osg::Quat quat;
         quat.w() = f[0];
         quat.x() = f[1];
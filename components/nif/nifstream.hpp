@@ -3,11 +3,13 @@
 #ifndef OPENMW_COMPONENTS_NIF_NIFSTREAM_HPP
 #define OPENMW_COMPONENTS_NIF_NIFSTREAM_HPP
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <stdint.h>
 #include <stdexcept>
+#include <string>
 #include <vector>
-#include <typeinfo>
 #include <type_traits>
 
 #include <components/files/constrainedfilestream.hpp>
@@ -24,103 +26,117 @@ namespace Nif
 
 class NIFFile;
 
-template <std::size_t numInstances, typename T> inline void readLittleEndianBufferOfType(Files::IStreamPtr &pIStream, T* dest)
+class NIFStream
 {
-    static_assert(std::is_arithmetic_v<T>, "Buffer element type is not arithmetic");
-    pIStream->read((char*)dest, numInstances * sizeof(T));
-    if (pIStream->bad())
-        throw std::runtime_error("Failed to read little endian typed (" + std::string(typeid(T).name()) + ") buffer of "
-                                 + std::to_string(numInstances) + " instances");
-    if constexpr (Misc::IS_BIG_ENDIAN)
-        for (std::size_t i = 0; i < numInstances; i++)
-            Misc::swapEndiannessInplace(dest[i]);
-}
+    /// File contents
+    std::vector<char> mBuffer;
+    const char* mBegin;
+    const char* mPos;
+    const char* mEnd;
+
+    /// Return a pointer to the next \a size bytes and advance past them
+    const char* advance(std::size_t size)
+    {
+        if (static_cast<std::size_t>(mEnd - mPos) < size)
+            throw std::runtime_error("Failed to read " + std::to_string(size) + " bytes at offset "
+                                     + std::to_string(mPos - mBegin) + ": unexpected end of file");
+        const char* data = mPos;
+        mPos += size;
+        return data;
+    }
 
-template <typename T> inline void readLittleEndianDynamicBufferOfType(Files::IStreamPtr &pIStream, T* dest, std::size_t numInstances)
-{
-    static_assert(std::is_arithmetic_v<T>, "Buffer element type is not arithmetic");
-    pIStream->read((char*)dest, numInstances * sizeof(T));
-    if (pIStream->bad())
-        throw std::runtime_error("Failed to read little endian dynamic buffer of " + std::to_string(numInstances) + " instances");
-    if constexpr (Misc::IS_BIG_ENDIAN)
-        for (std::size_t i = 0; i < numInstances; i++)
-            Misc::swapEndiannessInplace(dest[i]);
-}
-template<typename type> type inline readLittleEndianType(Files::IStreamPtr &pIStream)
-{
-    type val;
-    readLittleEndianBufferOfType<1, type>(pIStream, &val);
-    return val;
-}
+    /// Throw if fewer than \a count elements of \a elementSize bytes are left, so that a corrupt count
+    /// does not allocate memory before reading fails
+    void checkRemaining(std::size_t count, std::size_t elementSize) const
+    {
+        if (count > static_cast<std::size_t>(mEnd - mPos) / elementSize)
+            throw std::runtime_error("Failed to read " + std::to_string(count) + " elements of " + std::to_string(elementSize)
+                                     + " bytes at offset " + std::to_string(mPos - mBegin) + ": unexpected end of file");
+    }
 
-class NIFStream
-{
-    /// Input stream
-    Files::IStreamPtr inp;
+    template <typename T> void readLittleEndianBuffer(T* dest, std::size_t numInstances)
+    {
+        static_assert(std::is_arithmetic_v<T>, "Buffer element type is not arithmetic");
+        std::memcpy(dest, advance(numInstances * sizeof(T)), numInstances * sizeof(T));
+        if constexpr (Misc::IS_BIG_ENDIAN)
+            for (std::size_t i = 0; i < numInstances; i++)
+                Misc::swapEndiannessInplace(dest[i]);
+    }
+
+    template <typename T> T readLittleEndianType()
+    {
+        T val;
+        readLittleEndianBuffer(&val, 1);
+        return val;
+    }
 
 public:
 
     NIFFile * const file;
 
-    NIFStream (NIFFile * file, Files::IStreamPtr&& inp): inp (std::move(inp)), file (file) {}
+    /// Read the whole stream into memory and parse from there
+    NIFStream (NIFFile * file, Files::IStreamPtr&& inp);
+
+    const char* data() const { return mBegin; }
+    std::size_t size() const { return mEnd - mBegin; }
 
-    void skip(size_t size) { inp->ignore(size); }
+    void skip(size_t size) { advance(size); }
 
     char getChar()
     {
-        return readLittleEndianType<char>(inp);
+        return readLittleEndianType<char>();
     }
 
     short getShort()
     {
-        return readLittleEndianType<short>(inp);
+        return readLittleEndianType<short>();
     }
 
     unsigned short getUShort()
     {
-        return readLittleEndianType<unsigned short>(inp);
+        return readLittleEndianType<unsigned short>();
     }
 
     int getInt()
     {
-        return readLittleEndianType<int>(inp);
+        return readLittleEndianType<int>();
     }
 
     unsigned int getUInt()
     {
-        return readLittleEndianType<unsigned int>(inp);
+        return readLittleEndianType<unsigned int>();
     }
 
     float getFloat()
     {
-        return readLittleEndianType<float>(inp);
+        return readLittleEndianType<float>();
     }
 
     osg::Vec2f getVector2()
     {
         osg::Vec2f vec;
-        readLittleEndianBufferOfType<2,float>(inp, vec._v);
+        readLittleEndianBuffer(vec._v, 2);
         return vec;
     }
 
     osg::Vec3f getVector3()
     {
         osg::Vec3f vec;
-        readLittleEndianBufferOfType<3, float>(inp, vec._v);
+        readLittleEndianBuffer(vec._v, 3);
         return vec;
     }
 
     osg::Vec4f getVector4()
     {
         osg::Vec4f vec;
-        readLittleEndianBufferOfType<4, float>(inp, vec._v);
+        readLittleEndianBuffer(vec._v, 4);
         return vec;
     }
 
     Matrix3 getMatrix3()
     {
         Matrix3 mat;
-        readLittleEndianBufferOfType<9, float>(inp, (float*)&mat.mValues);
+        readLittleEndianBuffer((float*)&mat.mValues, 9);
         return mat;
     }
 
@@ -145,98 +161,101 @@ public:
     ///Read in a string of the given length
     std::string getSizedString(size_t length)
     {
-        std::string str(length, '\0');
-        inp->read(str.data(), length);
-        if (inp->bad())
-            throw std::runtime_error("Failed to read sized string of " + std::to_string(length) + " chars");
-        size_t end = str.find('\0');
-        if (end != std::string::npos)
-            str.erase(end);
-        return str;
+        const char* str = advance(length);
+        return std::string(str, std::find(str, str + length, '\0'));
     }
     ///Read in a string of the length specified in the file
     std::string getSizedString()
     {
-        size_t size = readLittleEndianType<uint32_t>(inp);
+        size_t size = readLittleEndianType<uint32_t>();
         return getSizedString(size);
     }
 
     ///Specific to Bethesda headers, uses a byte for length
     std::string getExportString()
     {
-        size_t size = static_cast<size_t>(readLittleEndianType<uint8_t>(inp));
+        size_t size = static_cast<size_t>(readLittleEndianType<uint8_t>());
         return getSizedString(size);
     }
 
     ///This is special since the version string doesn't start with a number, and ends with "\n"
     std::string getVersionString()
     {
-        std::string result;
-        std::getline(*inp, result);
-        if (inp->bad())
-            throw std::runtime_error("Failed to read version string");
+        const char* end = std::find(mPos, mEnd, '\n');
+        std::string result(mPos, end);
+        mPos = end == mEnd ? end : end + 1;
         return result;
     }
 
     void getChars(std::vector<char> &vec, size_t size)
     {
+        checkRemaining(size, sizeof(char));
         vec.resize(size);
-        readLittleEndianDynamicBufferOfType<char>(inp, vec.data(), size);
+        readLittleEndianBuffer(vec.data(), size);
     }
 
     void getUChars(std::vector<unsigned char> &vec, size_t size)
     {
+        checkRemaining(size, sizeof(unsigned char));
         vec.resize(size);
-        readLittleEndianDynamicBufferOfType<unsigned char>(inp, vec.data(), size);
+        readLittleEndianBuffer(vec.data(), size);
     }
 
     void getUShorts(std::vector<unsigned short> &vec, size_t size)
     {
+        checkRemaining(size, sizeof(unsigned short));
         vec.resize(size);
-        readLittleEndianDynamicBufferOfType<unsigned short>(inp, vec.data(), size);
+        readLittleEndianBuffer(vec.data(), size);
     }
 
     void getFloats(std::vector<float> &vec, size_t size)
     {
+        checkRemaining(size, sizeof(float));
         vec.resize(size);
-        readLittleEndianDynamicBufferOfType<float>(inp, vec.data(), size);
+        readLittleEndianBuffer(vec.data(), size);
     }
 
     void getInts(std::vector<int> &vec, size_t size)
     {
+        checkRemaining(size, sizeof(int));
         vec.resize(size);
-        readLittleEndianDynamicBufferOfType<int>(inp, vec.data(), size);
+        readLittleEndianBuffer(vec.data(), size);
     }
 
     void getUInts(std::vector<unsigned int> &vec, size_t size)
     {
+        checkRemaining(size, sizeof(unsigned int));
         vec.resize(size);
-        readLittleEndianDynamicBufferOfType<unsigned int>(inp, vec.data(), size);
+        readLittleEndianBuffer(vec.data(), size);
     }
 
     void getVector2s(std::vector<osg::Vec2f> &vec, size_t size)
     {
+        checkRemaining(size, 2 * sizeof(float));
         vec.resize(size);
         /* The packed storage of each Vec2f is 2 floats exactly */
-        readLittleEndianDynamicBufferOfType<float>(inp,(float*)vec.data(), size*2);
+        readLittleEndianBuffer((float*)vec.data(), size*2);
     }
 
     void getVector3s(std::vector<osg::Vec3f> &vec, size_t size)
     {
+        checkRemaining(size, 3 * sizeof(float));
         vec.resize(size);
         /* The packed storage of each Vec3f is 3 floats exactly */
-        readLittleEndianDynamicBufferOfType<float>(inp, (float*)vec.data(), size*3);
+        readLittleEndianBuffer((float*)vec.data(), size*3);
     }
 
     void getVector4s(std::vector<osg::Vec4f> &vec, size_t size)
     {
+        checkRemaining(size, 4 * sizeof(float));
         vec.resize(size);
         /* The packed storage of each Vec4f is 4 floats exactly */
-        readLittleEndianDynamicBufferOfType<float>(inp, (float*)vec.data(), size*4);
+        readLittleEndianBuffer((float*)vec.data(), size*4);
     }
 
     void getQuaternions(std::vector<osg::Quat> &quat, size_t size)
     {
+        checkRemaining(size, 4 * sizeof(float));
         quat.resize(size);
         for (size_t i = 0;i < quat.size();i++)
             quat[i] = getQuaternion();
@@ -244,6 +263,7 @@ public:
 
     void getStrings(std::vector<std::string> &vec, size_t size)
     {
+        checkRemaining(size, sizeof(uint32_t));
         vec.resize(size);
         for (size_t i = 0; i < vec.size(); i++)
             vec[i] = getString();
@@ -251,6 +271,7 @@ public:
     /// We need to use this when the string table isn't actually initialized.
     void getSizedStrings(std::vector<std::string> &vec, size_t size)
     {
+        checkRemaining(size, sizeof(uint32_t));
         vec.resize(size);
         for (size_t i = 0; i < vec.size(); i++)
             vec[i] = getSizedString();
@@ -10,8 +10,10 @@
 #include <components/sceneutil/nodecallback.hpp>
 #include <components/sceneutil/statesetupdater.hpp>
 
+#include <algorithm>
 #include <set>
 #include <type_traits>
+#include <vector>
 
 #include <osg/Texture2D>
 
@@ -40,23 +42,22 @@ namespace NifOsg
     template <typename MapT>
     class ValueInterpolator
     {
-        typename MapT::MapType::const_iterator retrieveKey(float time) const
+        // Returns the index of the first key at or after the given time, which must be strictly inside the track.
+        std::size_t retrieveKey(float time) const
         {
-            // retrieve the current position in the map, optimized for the most common case
+            // check the cached position first, optimized for the most common case
             // where time moves linearly along the keyframe track
-            if (mLastHighKey != mKeys->mKeys.end())
+            const std::vector<float>& times = mKeys->mTimes;
+            std::size_t high = mLastHighKey;
+            if (high < times.size() && time <= times[high])
             {
-                if (time > mLastHighKey->first)
-                {
-                    // try if we're there by incrementing one
-                    ++mLastLowKey;
-                    ++mLastHighKey;
-                }
-                if (mLastHighKey != mKeys->mKeys.end() && time >= mLastLowKey->first && time <= mLastHighKey->first)
-                    return mLastHighKey;
+                if (time >= times[high - 1])
+                    return high;
             }
+            else if (++high < times.size() && time <= times[high] && time >= times[high - 1])
+                return high;
 
-            return mKeys->mKeys.lower_bound(time);
+            return std::lower_bound(times.begin(), times.end(), time) - times.begin();
         }
 
     public:
@@ -84,22 +85,12 @@ namespace NifOsg
             if (interpolator->data.empty())
                 return;
             mKeys = interpolator->data->mKeyList;
-            if (mKeys)
-            {
-                mLastLowKey = mKeys->mKeys.end();
-                mLastHighKey = mKeys->mKeys.end();
-            }
         }
 
         ValueInterpolator(std::shared_ptr<const MapT> keys, ValueT defaultVal = ValueT())
             : mKeys(keys)
             , mDefaultVal(defaultVal)
         {
-            if (keys)
-            {
-                mLastLowKey = mKeys->mKeys.end();
-                mLastHighKey = mKeys->mKeys.end();
-            }
         }
 
         ValueT interpKey(float time) const
@@ -107,81 +98,84 @@ namespace NifOsg
             if (empty())
                 return mDefaultVal;
 
-            const typename MapT::MapType & keys = mKeys->mKeys;
+            const std::vector<float>& times = mKeys->mTimes;
+            const std::vector<ValueT>& values = mKeys->mValues;
 
-            if(time <= keys.begin()->first)
-                return keys.begin()->second.mValue;
+            if (time <= times.front())
+                return values.front();
 
-            typename MapT::MapType::const_iterator it = retrieveKey(time);
+            if (time >= times.back())
+                return values.back();
 
-            // now do the actual interpolation
-            if (it != keys.end())
-            {
-                // cache for next time
-                mLastHighKey = it;
-                mLastLowKey = --it;
+            const std::size_t high = retrieveKey(time);
+            const std::size_t low = high - 1;
 
-                float a = (time - mLastLowKey->first) / (mLastHighKey->first - mLastLowKey->first);
+            // cache for next time
+            mLastHighKey = high;
 
-                return interpolate(mLastLowKey->second, mLastHighKey->second, a, mKeys->mInterpolationType);
-            }
+            const float fraction = (time - times[low]) / (times[high] - times[low]);
 
-            return keys.rbegin()->second.mValue;
+            switch (mKeys->mInterpolationType)
+            {
+                case Nif::InterpolationType_Constant:
+                    return interpolateConstant(values[low], values[high], fraction);
+                case Nif::InterpolationType_Quadratic:
+                case Nif::InterpolationType_TBC:
+                    if constexpr (!std::is_same_v<ValueT, osg::Quat>)
+                    {
+                        if (mKeys->hasTangents())
+                            return interpolateHermite(values[low], values[high], mKeys->mOutTans[low], mKeys->mInTans[high], fraction);
+                    }
+                    [[fallthrough]];
+                default:
+                    return interpolateLinear(values[low], values[high], fraction);
+            }
         }
 
         bool empty() const
         {
-            return !mKeys || mKeys->mKeys.empty();
+            return !mKeys || mKeys->empty();
         }
 
     private:
-        template <typename ValueType>
-        ValueType interpolate(const Nif::KeyT<ValueType>& a, const Nif::KeyT<ValueType>& b, float fraction, unsigned int type) const
+        static ValueT interpolateConstant(const ValueT& a, const ValueT& b, float fraction)
         {
-            switch (type)
-            {
-                case Nif::InterpolationType_Constant:
-                    return fraction > 0.5f ? b.mValue : a.mValue;
-                case Nif::InterpolationType_Quadratic:
-                {
-                    // Using a cubic Hermite spline.
-                    // b1(t) = 2t^3  - 3t^2 + 1
-                    // b2(t) = -2t^3 + 3t^2
-                    // b3(t) = t^3 - 2t^2 + t
-                    // b4(t) = t^3 - t^2
-                    // f(t) = a.mValue * b1(t) + b.mValue * b2(t) + a.mOutTan * b3(t) + b.mInTan * b4(t)
-                    const float t = fraction;
-                    const float t2 = t * t;
-                    const float t3 = t2 * t;
-                    const float b1 = 2.f * t3 - 3.f * t2 + 1;
-                    const float b2 = -2.f * t3 + 3.f * t2;
-                    const float b3 = t3 - 2.f * t2 + t;
-                    const float b4 = t3 - t2;
-                    return a.mValue * b1 + b.mValue * b2 + a.mOutTan * b3 + b.mInTan * b4;
-                }
-                // TODO: Implement TBC interpolation
-                default:
-                    return a.mValue + ((b.mValue - a.mValue) * fraction);
-            }
+            return fraction > 0.5f ? b : a;
         }
-        osg::Quat interpolate(const Nif::KeyT<osg::Quat>& a, const Nif::KeyT<osg::Quat>& b, float fraction, unsigned int type) const
+
+        static ValueT interpolateLinear(const ValueT& a, const ValueT& b, float fraction)
         {
-            switch (type)
+            if constexpr (std::is_same_v<ValueT, osg::Quat>)
             {
-                case Nif::InterpolationType_Constant:
-                    return fraction > 0.5f ? b.mValue : a.mValue;
-                // TODO: Implement Quadratic and TBC interpolation
-                default:
-                {
-                    osg::Quat result;
-                    result.slerp(fraction, a.mValue, b.mValue);
-                    return result;
-                }
+                // TODO: Implement Quadratic and TBC interpolation for rotations
+                osg::Quat result;
+                result.slerp(fraction, a, b);
+                return result;
             }
+            else
+                return a + ((b - a) * fraction);
+        }
+
+        static ValueT interpolateHermite(const ValueT& a, const ValueT& b, const ValueT& outTan, const ValueT& inTan, float fraction)
+        {
+            // Using a cubic Hermite spline.
+            // b1(t) = 2t^3  - 3t^2 + 1
+            // b2(t) = -2t^3 + 3t^2
+            // b3(t) = t^3 - 2t^2 + t
+            // b4(t) = t^3 - t^2
+            // f(t) = a.mValue * b1(t) + b.mValue * b2(t) + a.mOutTan * b3(t) + b.mInTan * b4(t)
+            const float t = fraction;
+            const float t2 = t * t;
+            const float t3 = t2 * t;
+            const float b1 = 2.f * t3 - 3.f * t2 + 1;
+            const float b2 = -2.f * t3 + 3.f * t2;
+            const float b3 = t3 - 2.f * t2 + t;
+            const float b4 = t3 - t2;
+            return a * b1 + b * b2 + outTan * b3 + inTan * b4;
         }
 
-        mutable typename MapT::MapType::const_iterator mLastLowKey;
-        mutable typename MapT::MapType::const_iterator mLastHighKey;
+        // Index of the key that was used as the upper bound of the last evaluated segment
+        mutable std::size_t mLastHighKey = 1;
 
         std::shared_ptr<const MapT> mKeys;
 
@@ -315,6 +315,8 @@ namespace NifOsg
             if (roots.empty())
                 nif->fail("Found no root nodes");
 
+            preloadTextures(nif, imageManager);
+
             osg::ref_ptr<SceneUtil::TextKeyMapHolder> textkeys (new SceneUtil::TextKeyMapHolder);
 
             osg::ref_ptr<osg::Group> created(new osg::Group);
@@ -459,6 +461,20 @@ namespace NifOsg
             sequenceNode->setMode(osg::Sequence::START);
         }
 
+        /// Start decoding the external textures of the file in the background, while the scene graph is being built.
+        void preloadTextures(Nif::NIFFilePtr nif, Resource::ImageManager* imageManager)
+        {
+            for (size_t i = 0; i < nif->numRecords(); ++i)
+            {
+                const Nif::Record* record = nif->getRecord(i);
+                if (!record || record->recType != Nif::RC_NiSourceTexture)
+                    continue;
+                const Nif::NiSourceTexture* st = static_cast<const Nif::NiSourceTexture*>(record);
+                if (st->external || st->data.empty())
+                    imageManager->preloadImage(Misc::ResourceHelpers::correctTexturePath(st->filename, imageManager->getVFS()));
+            }
+        }
+
         osg::ref_ptr<osg::Image> handleSourceTexture(const Nif::NiSourceTexture* st, Resource::ImageManager* imageManager)
         {
             if (!st)
@@ -472,7 +488,7 @@ namespace NifOsg
             else
             {
                 std::string filename = Misc::ResourceHelpers::correctTexturePath(st->filename, imageManager->getVFS());
-                image = imageManager->getImage(filename);
+                image = imageManager->getImage(filename, false, true);
             }
             return image;
         }
@@ -1787,7 +1803,7 @@ namespace NifOsg
                     }
                 }
                 std::string filename = Misc::ResourceHelpers::correctTexturePath(textureSet->textures[i], imageManager->getVFS());
-                osg::ref_ptr<osg::Image> image = imageManager->getImage(filename);
+                osg::ref_ptr<osg::Image> image = imageManager->getImage(filename, false, true);
                 osg::ref_ptr<osg::Texture2D> texture2d = new osg::Texture2D(image);
                 if (image)
                     texture2d->setTextureSize(image->s(), image->t());
@@ -1980,7 +1996,7 @@ namespace NifOsg
                         boundTextures.clear();
                     }
                     std::string filename = Misc::ResourceHelpers::correctTexturePath(texprop->filename, imageManager->getVFS());
-                    osg::ref_ptr<osg::Image> image = imageManager->getImage(filename);
+                    osg::ref_ptr<osg::Image> image = imageManager->getImage(filename, false, true);
                     osg::ref_ptr<osg::Texture2D> texture2d = new osg::Texture2D(image);
                     texture2d->setName("diffuseMap");
                     if (image)
@@ -1,10 +1,16 @@
 #include "imagemanager.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <condition_variable>
+#include <cstring>
+
 #include <osgDB/Registry>
 
 #include <components/debug/debuglog.hpp>
 #include <components/misc/pathhelpers.hpp>
+#include <components/sceneutil/workqueue.hpp>
 #include <components/vfs/manager.hpp>
 
 #include "objectcache.hpp"
@@ -45,17 +51,41 @@ namespace
 namespace Resource
 {
 
+    osg::ref_ptr<osg::Image> dropMipmapLevels(const osg::Image& image, unsigned int levels)
+    {
+        const osg::Image::MipmapDataType& offsets = image.getMipmapLevels();
+        const unsigned int start = offsets[levels - 1];
+        const unsigned int size = image.getTotalSizeInBytesIncludingMipmaps() - start;
+
+        unsigned char* data = new unsigned char[size];
+        std::memcpy(data, image.data() + start, size);
+
+        osg::Image::MipmapDataType newOffsets;
+        for (std::size_t i = levels; i < offsets.size(); ++i)
+            newOffsets.push_back(offsets[i] - start);
+
+        osg::ref_ptr<osg::Image> newImage = new osg::Image;
+        newImage->setFileName(image.getFileName());
+        newImage->setImage(std::max(1, image.s() >> levels), std::max(1, image.t() >> levels), image.r(),
+            image.getInternalTextureFormat(), image.getPixelFormat(), image.getDataType(),
+            data, osg::Image::USE_NEW_DELETE, image.getPacking());
+        newImage->setMipmapLevels(newOffsets);
+        newImage->setOrigin(image.getOrigin());
+        return newImage;
+    }
+
     ImageManager::ImageManager(const VFS::Manager *vfs)
         : ResourceManager(vfs)
         , mWarningImage(createWarningImage())
         , mOptions(new osgDB::Options("dds_flip dds_dxt1_detect_rgba ignoreTga2Fields"))
         , mOptionsNoFlip(new osgDB::Options("dds_dxt1_detect_rgba ignoreTga2Fields"))
+        , mSkipMipmapLevels(0)
     {
     }
 
     ImageManager::~ImageManager()
     {
-
+        setWorkQueue(nullptr);
     }
 
     bool checkSupported(osg::Image* image, const std::string& filename)
@@ -83,109 +113,256 @@ namespace Resource
         return true;
     }
 
-    osg::ref_ptr<osg::Image> ImageManager::getImage(const std::string &filename, bool disableFlip)
+    osg::ref_ptr<osg::Image> ImageManager::loadImage(const std::string& normalized, bool disableFlip, bool sceneTexture)
     {
-        const std::string normalized = mVFS->normalizeFilename(filename);
+        Files::IStreamPtr stream;
+        try
+        {
+            stream = mVFS->get(normalized);
+        }
+        catch (std::exception& e)
+        {
+            Log(Debug::Error) << "Failed to open image: " << e.what();
+            return mWarningImage;
+        }
 
-        osg::ref_ptr<osg::Object> obj = mCache->getRefFromObjectCache(normalized);
-        if (obj)
-            return osg::ref_ptr<osg::Image>(static_cast<osg::Image*>(obj.get()));
-        else
+        const std::string ext(Misc::getFileExtension(normalized));
+        osgDB::ReaderWriter* reader = osgDB::Registry::instance()->getReaderWriterForExtension(ext);
+        if (!reader)
         {
-            Files::IStreamPtr stream;
-            try
-            {
-                stream = mVFS->get(normalized);
-            }
-            catch (std::exception& e)
+            Log(Debug::Error) << "Error loading " << normalized << ": no readerwriter for '" << ext << "' found";
+            return mWarningImage;
+        }
+
+        bool killAlpha = false;
+        if (reader->supportedExtensions().count("tga"))
+        {
+            // Morrowind ignores the alpha channel of 16bpp TGA files even when the header says not to
+            unsigned char header[18];
+            stream->read((char*)header, 18);
+            if (stream->gcount() != 18)
             {
-                Log(Debug::Error) << "Failed to open image: " << e.what();
-                mCache->addEntryToObjectCache(normalized, mWarningImage);
+                Log(Debug::Error) << "Error loading " << normalized << ": couldn't read TGA header";
                 return mWarningImage;
             }
+            int type = header[2];
+            int depth;
+            if (type == 1 || type == 9)
+                depth = header[7];
+            else
+                depth = header[16];
+            int alphaBPP = header[17] & 0x0F;
+            killAlpha = depth == 16 && alphaBPP == 1;
+            stream->seekg(0);
+        }
+
+        osgDB::ReaderWriter::ReadResult result = reader->readImage(*stream, disableFlip ? mOptionsNoFlip : mOptions);
+        if (!result.success())
+        {
+            Log(Debug::Error) << "Error loading " << normalized << ": " << result.message() << " code " << result.status();
+            return mWarningImage;
+        }
 
-            const std::string ext(Misc::getFileExtension(normalized));
-            osgDB::ReaderWriter* reader = osgDB::Registry::instance()->getReaderWriterForExtension(ext);
-            if (!reader)
+        osg::ref_ptr<osg::Image> image = result.getImage();
+
+        image->setFileName(normalized);
+        if (!checkSupported(image, normalized))
+        {
+            static bool uncompress = (getenv("OPENMW_DECOMPRESS_TEXTURES") != nullptr);
+            if (!uncompress)
             {
-                Log(Debug::Error) << "Error loading " << filename << ": no readerwriter for '" << ext << "' found";
-                mCache->addEntryToObjectCache(normalized, mWarningImage);
+                Log(Debug::Error) << "Error loading " << normalized << ": no S3TC texture compression support installed";
                 return mWarningImage;
             }
+            else
+            {
+                // decompress texture in software if not supported by GPU
+                // requires update to getColor() to be released with OSG 3.6
+                osg::ref_ptr<osg::Image> newImage = new osg::Image;
+                newImage->setFileName(image->getFileName());
+                newImage->allocateImage(image->s(), image->t(), image->r(), image->isImageTranslucent() ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE);
+                for (int s=0; s<image->s(); ++s)
+                    for (int t=0; t<image->t(); ++t)
+                        for (int r=0; r<image->r(); ++r)
+                            newImage->setColor(image->getColor(s,t,r), s,t,r);
+                image = newImage;
+            }
+        }
+        else if (killAlpha)
+        {
+            osg::ref_ptr<osg::Image> newImage = new osg::Image;
+            newImage->setFileName(image->getFileName());
+            newImage->allocateImage(image->s(), image->t(), image->r(), GL_RGB, GL_UNSIGNED_BYTE);
+            // OSG just won't write the alpha as there's nowhere to put it.
+            for (int s = 0; s < image->s(); ++s)
+                for (int t = 0; t < image->t(); ++t)
+                    for (int r = 0; r < image->r(); ++r)
+                        newImage->setColor(image->getColor(s, t, r), s, t, r);
+            image = newImage;
+        }
 
-            bool killAlpha = false;
-            if (reader->supportedExtensions().count("tga"))
+        if (sceneTexture && mSkipMipmapLevels > 0 && image->r() == 1)
+        {
+            // Keep at least one level and never go below 256 pixels, which would make small textures unrecognizable
+            unsigned int levels = std::min<unsigned int>(mSkipMipmapLevels, image->getNumMipmapLevels() - 1);
+            while (levels > 0 && std::max(image->s(), image->t()) >> levels < 256)
+                --levels;
+            if (levels > 0)
+                image = dropMipmapLevels(*image, levels);
+        }
+
+        return image;
+    }
+
+    class ImageManager::PreloadImageWorkItem : public SceneUtil::WorkItem
+    {
+    public:
+        PreloadImageWorkItem(ImageManager* imageManager, const std::string& normalized, const std::string& key)
+            : mImageManager(imageManager)
+            , mNormalized(normalized)
+            , mKey(key)
+            , mStarted(false)
+            , mAborted(false)
+        {
+        }
+
+        void doWork() override
+        {
+            load();
+        }
+
+        /// Cancel the preload if it has not started yet, otherwise wait for it to finish.
+        void abort() override
+        {
+            if (mStarted.exchange(true))
             {
-                // Morrowind ignores the alpha channel of 16bpp TGA files even when the header says not to
-                unsigned char header[18];
-                stream->read((char*)header, 18);
-                if (stream->gcount() != 18)
-                {
-                    Log(Debug::Error) << "Error loading " << filename << ": couldn't read TGA header";
-                    mCache->addEntryToObjectCache(normalized, mWarningImage);
-                    return mWarningImage;
-                }
-                int type = header[2];
-                int depth;
-                if (type == 1 || type == 9)
-                    depth = header[7];
-                else
-                    depth = header[16];
-                int alphaBPP = header[17] & 0x0F;
-                killAlpha = depth == 16 && alphaBPP == 1;
-                stream->seekg(0);
+                getImage();
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mAborted = true;
             }
+            mCondition.notify_all();
+        }
+
+        /// Get the image, loading it on the calling thread if no worker has started yet.
+        /// @return nullptr if the preload was aborted.
+        osg::ref_ptr<osg::Image> getImage()
+        {
+            load();
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [&] { return mImage != nullptr || mAborted; });
+            return mImage;
+        }
 
-            osgDB::ReaderWriter::ReadResult result = reader->readImage(*stream, disableFlip ? mOptionsNoFlip : mOptions);
-            if (!result.success())
+    private:
+        void load()
+        {
+            if (mStarted.exchange(true))
+                return;
+            osg::ref_ptr<osg::Image> image = mImageManager->loadImage(mNormalized, false, true);
+            mImageManager->finishPreload(mKey, image);
             {
-                Log(Debug::Error) << "Error loading " << filename << ": " << result.message() << " code " << result.status();
-                mCache->addEntryToObjectCache(normalized, mWarningImage);
-                return mWarningImage;
+                std::lock_guard<std::mutex> lock(mMutex);
+                mImage = image;
             }
+            mCondition.notify_all();
+        }
 
-            osg::ref_ptr<osg::Image> image = result.getImage();
+        ImageManager* mImageManager;
+        std::string mNormalized;
+        std::string mKey;
+        std::atomic_bool mStarted;
+        bool mAborted;
+        osg::ref_ptr<osg::Image> mImage;
+        std::mutex mMutex;
+        std::condition_variable mCondition;
+    };
 
-            image->setFileName(normalized);
-            if (!checkSupported(image, filename))
+    std::string ImageManager::getCacheKey(const std::string& normalized, bool sceneTexture) const
+    {
+        if (sceneTexture && mSkipMipmapLevels > 0)
+            return normalized + "|skip" + std::to_string(mSkipMipmapLevels);
+        return normalized;
+    }
+
+    osg::ref_ptr<osg::Image> ImageManager::getImage(const std::string &filename, bool disableFlip, bool sceneTexture)
+    {
+        const std::string normalized = mVFS->normalizeFilename(filename);
+        const std::string key = getCacheKey(normalized, sceneTexture);
+
+        osg::ref_ptr<osg::Object> obj = mCache->getRefFromObjectCache(key);
+        if (obj)
+            return osg::ref_ptr<osg::Image>(static_cast<osg::Image*>(obj.get()));
+
+        // Preloaded images are always flipped scene textures
+        if (!disableFlip && sceneTexture)
+        {
+            osg::ref_ptr<PreloadImageWorkItem> preloading;
             {
-                static bool uncompress = (getenv("OPENMW_DECOMPRESS_TEXTURES") != nullptr);
-                if (!uncompress)
-                {
-                    Log(Debug::Error) << "Error loading " << filename << ": no S3TC texture compression support installed";
-                    mCache->addEntryToObjectCache(normalized, mWarningImage);
-                    return mWarningImage;
-                }
-                else
-                {
-                    // decompress texture in software if not supported by GPU
-                    // requires update to getColor() to be released with OSG 3.6
-                    osg::ref_ptr<osg::Image> newImage = new osg::Image;
-                    newImage->setFileName(image->getFileName());
-                    newImage->allocateImage(image->s(), image->t(), image->r(), image->isImageTranslucent() ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE);
-                    for (int s=0; s<image->s(); ++s)
-                        for (int t=0; t<image->t(); ++t)
-                            for (int r=0; r<image->r(); ++r)
-                                newImage->setColor(image->getColor(s,t,r), s,t,r);
-                    image = newImage;
-                }
+                std::lock_guard<std::mutex> lock(mPreloadingMutex);
+                auto found = mPreloading.find(key);
+                if (found != mPreloading.end())
+                    preloading = found->second;
             }
-            else if (killAlpha)
+            if (preloading)
             {
-                osg::ref_ptr<osg::Image> newImage = new osg::Image;
-                newImage->setFileName(image->getFileName());
-                newImage->allocateImage(image->s(), image->t(), image->r(), GL_RGB, GL_UNSIGNED_BYTE);
-                // OSG just won't write the alpha as there's nowhere to put it.
-                for (int s = 0; s < image->s(); ++s)
-                    for (int t = 0; t < image->t(); ++t)
-                        for (int r = 0; r < image->r(); ++r)
-                            newImage->setColor(image->getColor(s, t, r), s, t, r);
-                image = newImage;
+                if (osg::ref_ptr<osg::Image> image = preloading->getImage())
+                    return image;
             }
+        }
 
-            mCache->addEntryToObjectCache(normalized, image);
-            return image;
+        osg::ref_ptr<osg::Image> image = loadImage(normalized, disableFlip, sceneTexture);
+        mCache->addEntryToObjectCache(key, image);
+        return image;
+    }
+
+    void ImageManager::preloadImage(const std::string& filename)
+    {
+        const std::string normalized = mVFS->normalizeFilename(filename);
+        const std::string key = getCacheKey(normalized, true);
+        if (mCache->getRefFromObjectCache(key))
+            return;
+
+        std::lock_guard<std::mutex> lock(mPreloadingMutex);
+        if (!mWorkQueue || mPreloading.count(key))
+            return;
+        osg::ref_ptr<PreloadImageWorkItem> item = new PreloadImageWorkItem(this, normalized, key);
+        mPreloading.emplace(key, item);
+        mWorkQueue->addWorkItem(item);
+    }
+
+    void ImageManager::finishPreload(const std::string& key, osg::Image* image)
+    {
+        // Add to the cache first, so getImage always finds the image in one of the two places
+        mCache->addEntryToObjectCache(key, image);
+        std::lock_guard<std::mutex> lock(mPreloadingMutex);
+        mPreloading.erase(key);
+    }
+
+    void ImageManager::setWorkQueue(SceneUtil::WorkQueue* workQueue)
+    {
+        std::map<std::string, osg::ref_ptr<PreloadImageWorkItem>> preloading;
+        {
+            std::lock_guard<std::mutex> lock(mPreloadingMutex);
+            mWorkQueue = workQueue;
+            preloading = mPreloading;
         }
+        if (workQueue)
+            return;
+
+        // Items that have not started yet become no-ops, running ones are waited for
+        for (const auto& [name, item] : preloading)
+            item->abort();
+
+        std::lock_guard<std::mutex> lock(mPreloadingMutex);
+        mPreloading.clear();
+    }
+
+    void ImageManager::setSkipMipmapLevels(unsigned int levels)
+    {
+        mSkipMipmapLevels = levels;
     }
 
     osg::Image *ImageManager::getWarningImage()
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <map>
+#include <mutex>
 
 #include <osg/ref_ptr>
 #include <osg/Image>
@@ -15,9 +16,18 @@ namespace osgDB
     class Options;
 }
 
+namespace SceneUtil
+{
+    class WorkQueue;
+}
+
 namespace Resource
 {
 
+    /// Copy all but the \a levels largest mipmap levels of the image into a new image.
+    /// @note The image must have more than \a levels mipmap levels.
+    osg::ref_ptr<osg::Image> dropMipmapLevels(const osg::Image& image, unsigned int levels);
+
     /// @brief Handles loading/caching of Images.
     /// @note May be used from any thread.
     class ImageManager : public ResourceManager
@@ -28,16 +38,44 @@ namespace Resource
 
         /// Create or retrieve an Image
         /// Returns the dummy image if the given image is not found.
-        osg::ref_ptr<osg::Image> getImage(const std::string& filename, bool disableFlip = false);
+        /// @param sceneTexture Drop the mipmap levels set by setSkipMipmapLevels. Should only be used for textures of the 3D scene,
+        /// GUI textures are displayed at their full size.
+        osg::ref_ptr<osg::Image> getImage(const std::string& filename, bool disableFlip = false, bool sceneTexture = false);
+
+        /// Start decoding the given scene texture on the work queue, so that a later getImage call finds it ready or in progress.
+        /// @note Does nothing if no work queue is set or the image is already cached.
+        void preloadImage(const std::string& filename);
+
+        /// Set the work queue used by preloadImage. Pass nullptr to cancel pending preloads and decode images on demand only.
+        void setWorkQueue(SceneUtil::WorkQueue* workQueue);
+
+        /// Drop up to this many of the largest mipmap levels of loaded scene textures, without reducing images below 256 pixels.
+        /// Images without mipmaps are not affected.
+        /// @note Only affects images loaded after the call.
+        void setSkipMipmapLevels(unsigned int levels);
 
         osg::Image* getWarningImage();
 
         void reportStats(unsigned int frameNumber, osg::Stats* stats) const override;
 
     private:
+        class PreloadImageWorkItem;
+
+        osg::ref_ptr<osg::Image> loadImage(const std::string& normalized, bool disableFlip, bool sceneTexture);
+
+        /// Scene textures with dropped mipmap levels are cached separately from the full images.
+        std::string getCacheKey(const std::string& normalized, bool sceneTexture) const;
+
+        void finishPreload(const std::string& key, osg::Image* image);
+
         osg::ref_ptr<osg::Image> mWarningImage;
         osg::ref_ptr<osgDB::Options> mOptions;
         osg::ref_ptr<osgDB::Options> mOptionsNoFlip;
+        unsigned int mSkipMipmapLevels;
+
+        osg::ref_ptr<SceneUtil::WorkQueue> mWorkQueue;
+        std::map<std::string, osg::ref_ptr<PreloadImageWorkItem>> mPreloading;
+        std::mutex mPreloadingMutex;
 
         ImageManager(const ImageManager&);
         void operator = (const ImageManager&);
@@ -1,12 +1,20 @@
 #include "scenemanager.hpp"
 
+#include <atomic>
 #include <cstdlib>
 #include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string_view>
+#include <thread>
 
 #include <osg/AlphaFunc>
 #include <osg/Group>
 #include <osg/Node>
+#include <osg/Texture>
 #include <osg/UserDataContainer>
+#include <osg/ValueObject>
 
 #include <osgAnimation/RigGeometry>
 
@@ -21,6 +29,7 @@
 #include <components/debug/debuglog.hpp>
 
 #include <components/nifosg/nifloader.hpp>
+#include <components/nifosg/matrixtransform.hpp>
 #include <components/nif/niffile.hpp>
 
 #include <components/misc/pathhelpers.hpp>
@@ -39,7 +48,11 @@
 #include <components/sceneutil/lightmanager.hpp>
 #include <components/sceneutil/depth.hpp>
 #include <components/sceneutil/riggeometryosgaextension.hpp>
+#include <components/sceneutil/riggeometry.hpp>
+#include <components/sceneutil/morphgeometry.hpp>
+#include <components/sceneutil/workqueue.hpp>
 #include <components/sceneutil/extradata.hpp>
+#include <components/sceneutil/serialize.hpp>
 
 #include <components/shader/shadervisitor.hpp>
 #include <components/shader/shadermanager.hpp>
@@ -49,7 +62,9 @@
 
 #include "imagemanager.hpp"
 #include "niffilemanager.hpp"
+#include "stateregistry.hpp"
 #include "objectcache.hpp"
+#include "texturebudget.hpp"
 
 namespace
 {
@@ -121,6 +136,27 @@ namespace
     private:
         unsigned int mMask;
     };
+
+    class SetDeformationWorkQueueVisitor : public osg::NodeVisitor
+    {
+    public:
+        SetDeformationWorkQueueVisitor(SceneUtil::WorkQueue* workQueue)
+            : osg::NodeVisitor(TRAVERSE_ALL_CHILDREN)
+            , mWorkQueue(workQueue)
+        {
+        }
+
+        void apply(osg::Drawable& drw) override
+        {
+            if (SceneUtil::RigGeometry* rig = dynamic_cast<SceneUtil::RigGeometry*>(&drw))
+                rig->setWorkQueue(mWorkQueue);
+            else if (SceneUtil::MorphGeometry* morph = dynamic_cast<SceneUtil::MorphGeometry*>(&drw))
+                morph->setWorkQueue(mWorkQueue);
+        }
+
+    private:
+        SceneUtil::WorkQueue* mWorkQueue;
+    };
 }
 
 namespace Resource
@@ -133,6 +169,25 @@ namespace Resource
     class SharedStateManager : public osgDB::SharedStateManager
     {
     public:
+        SharedStateManager()
+            : mNumStateSetHits(0)
+        {
+        }
+
+        void apply(osg::Node& node) override
+        {
+            const osg::StateSet* stateset = node.getStateSet();
+            osgDB::SharedStateManager::apply(node);
+            if (stateset && stateset != node.getStateSet())
+                mNumStateSetHits.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /// @return The number of StateSets replaced by an equal shared one so far.
+        std::size_t getNumStateSetHits() const
+        {
+            return mNumStateSetHits.load(std::memory_order_relaxed);
+        }
+
         unsigned int getNumSharedTextures() const
         {
             return _sharedTextureList.size();
@@ -149,6 +204,10 @@ namespace Resource
             _sharedTextureList.clear();
             _sharedStateSetList.clear();
         }
+
+    private:
+        // Shared from the loading threads, while the stats are read by the main thread
+        std::atomic<std::size_t> mNumStateSetHits;
     };
 
     /// Set texture filtering settings on textures contained in a FlipController.
@@ -347,8 +406,10 @@ namespace Resource
         , mConvertAlphaTestToAlphaToCoverage(false)
         , mSupportsNormalsRT(false)
         , mSharedStateManager(new SharedStateManager)
+        , mStateRegistry(std::make_unique<StateRegistry>())
         , mImageManager(imageManager)
         , mNifFileManager(nifFileManager)
+        , mTextureBudget(new TextureBudget(imageManager))
         , mMinFilter(osg::Texture::LINEAR_MIPMAP_LINEAR)
         , mMagFilter(osg::Texture::LINEAR)
         , mMaxAnisotropy(1)
@@ -480,6 +541,33 @@ namespace Resource
         mShaderManager->setShaderPath(path);
     }
 
+    void SceneManager::setSceneCachePath(const std::string& path)
+    {
+        mSceneCachePath = path;
+        if (path.empty())
+            return;
+
+        std::error_code ec;
+        std::filesystem::create_directories(path, ec);
+        if (ec)
+        {
+            Log(Debug::Warning) << "Failed to create scene cache directory " << path << ": " << ec.message() << ", scene cache is disabled";
+            mSceneCachePath.clear();
+            return;
+        }
+
+        std::string textureNames;
+        for (const std::string& name : mVFS->getRecursiveDirectoryIterator("textures/"))
+        {
+            textureNames += name;
+            textureNames += '\n';
+        }
+        std::istringstream textureNamesStream(textureNames);
+        mSceneCacheTexturesHash = Files::getHash("textures/", textureNamesStream)[0];
+
+        SceneUtil::registerLosslessSerializers();
+    }
+
     bool SceneManager::checkLoaded(const std::string &name, double timeStamp)
     {
         return mCache->checkInObjectCache(mVFS->normalizeFilename(name), timeStamp);
@@ -503,7 +591,7 @@ namespace Resource
                 filePath = std::filesystem::relative(filename, osgDB::getCurrentWorkingDirectory());
             try
             {
-                return osgDB::ReaderWriter::ReadResult(mImageManager->getImage(filePath.string()),
+                return osgDB::ReaderWriter::ReadResult(mImageManager->getImage(filePath.string(), false, true),
                                                        osgDB::ReaderWriter::ReadResult::FILE_LOADED);
             }
             catch (std::exception& e)
@@ -627,6 +715,226 @@ namespace Resource
             return loadNonNif(normalizedFilename, *vfs->get(normalizedFilename), imageManager);
     }
 
+    namespace
+    {
+        /// Bump when the NIF to OSG conversion changes in a way that invalidates previously cached scenes.
+        constexpr unsigned int sSceneCacheVersion = 1;
+
+        /// @brief Checks if a converted scene can be written to the scene cache and read back without losing anything.
+        /// @par Only stock OSG classes (and NifOsg::MatrixTransform) without callbacks qualify. Controllers, particle systems,
+        /// skinned or morphed geometry and embedded textures have no lossless serializers, so such scenes are always converted from the NIF.
+        class CacheableSceneVisitor : public osg::NodeVisitor
+        {
+        public:
+            CacheableSceneVisitor()
+                : osg::NodeVisitor(TRAVERSE_ALL_CHILDREN)
+                , mCacheable(true)
+            {
+            }
+
+            void apply(osg::Node& node) override
+            {
+                if (!isStockObject(node) && !dynamic_cast<NifOsg::MatrixTransform*>(&node))
+                    mCacheable = false;
+                else if (node.getUpdateCallback() || node.getEventCallback() || node.getCullCallback() || node.getComputeBoundingSphereCallback())
+                    mCacheable = false;
+                else if (!isCacheable(node.getUserDataContainer()) || !isCacheable(node.getStateSet()))
+                    mCacheable = false;
+
+                if (mCacheable)
+                    traverse(node);
+            }
+
+            void apply(osg::Drawable& drawable) override
+            {
+                if (drawable.getDrawCallback() || drawable.getComputeBoundingBoxCallback())
+                    mCacheable = false;
+                else
+                    apply(static_cast<osg::Node&>(drawable));
+            }
+
+            bool mCacheable;
+
+        private:
+            static bool isStockObject(const osg::Object& object)
+            {
+                return std::string_view(object.libraryName()) == "osg";
+            }
+
+            static bool isCacheable(const osg::UserDataContainer* container)
+            {
+                if (!container)
+                    return true;
+                if (container->getUserData())
+                    return false;
+                for (unsigned int i=0; i<container->getNumUserObjects(); ++i)
+                {
+                    if (!dynamic_cast<const osg::ValueObject*>(container->getUserObject(i)))
+                        return false;
+                }
+                return true;
+            }
+
+            static bool isCacheable(const osg::StateAttribute* attr)
+            {
+                if (!isStockObject(*attr) || attr->getUpdateCallback() || attr->getEventCallback())
+                    return false;
+                if (const osg::Texture* texture = attr->asTexture())
+                {
+                    // Images are written as references and read back through the ImageManager, so they need a VFS file name
+                    for (unsigned int i=0; i<texture->getNumImages(); ++i)
+                    {
+                        const osg::Image* image = texture->getImage(i);
+                        if (!image || image->getFileName().empty())
+                            return false;
+                    }
+                }
+                return true;
+            }
+
+            static bool isCacheable(const osg::StateSet* stateset)
+            {
+                if (!stateset)
+                    return true;
+                if (stateset->getUpdateCallback() || stateset->getEventCallback() || !isCacheable(stateset->getUserDataContainer()))
+                    return false;
+                for (const auto& [type, attr] : stateset->getAttributeList())
+                {
+                    if (!isCacheable(attr.first.get()))
+                        return false;
+                }
+                for (const auto& attributes : stateset->getTextureAttributeList())
+                {
+                    for (const auto& [type, attr] : attributes)
+                    {
+                        if (!isCacheable(attr.first.get()))
+                            return false;
+                    }
+                }
+                for (const auto& [name, uniform] : stateset->getUniformList())
+                {
+                    if (uniform.first->getUpdateCallback() || uniform.first->getEventCallback())
+                        return false;
+                }
+                return true;
+            }
+        };
+
+        std::string getSceneCacheFileName(const std::array<std::uint64_t, 2>& fileHash, std::uint64_t texturesHash)
+        {
+            // Loader settings that change the converted scene are part of the key, so changing them does not pick up stale files
+            std::ostringstream key;
+            key << std::hex << std::setfill('0') << std::setw(16) << fileHash[0] << std::setw(16) << fileHash[1]
+                << '-' << sSceneCacheVersion
+                << '-' << std::setw(16) << texturesHash
+                << '-' << std::setw(8) << NifOsg::Loader::getHiddenNodeMask()
+                << '-' << std::setw(8) << NifOsg::Loader::getIntersectionDisabledNodeMask()
+                << '-' << NifOsg::Loader::getShowMarkers()
+                << ".osgb";
+            return key.str();
+        }
+
+        enum class CachedSceneState
+        {
+            Missing,
+            Loaded,
+            Uncacheable
+        };
+
+        CachedSceneState readCachedScene(const std::filesystem::path& path, Resource::ImageManager* imageManager, osg::ref_ptr<osg::Node>& node)
+        {
+            std::ifstream stream(path, std::ios::binary);
+            if (!stream.is_open())
+                return CachedSceneState::Missing;
+
+            // An empty file records that the scene was converted before and turned out to be uncacheable
+            if (stream.peek() == std::ifstream::traits_type::eof())
+                return CachedSceneState::Uncacheable;
+
+            osgDB::ReaderWriter* reader = osgDB::Registry::instance()->getReaderWriterForExtension("osgb");
+            if (!reader)
+                return CachedSceneState::Missing;
+
+            osg::ref_ptr<osgDB::Options> options (new osgDB::Options);
+            options->setReadFileCallback(new ImageReadCallback(imageManager));
+
+            osgDB::ReaderWriter::ReadResult result = reader->readNode(stream, options);
+            if (!result.success() || !result.getNode())
+            {
+                Log(Debug::Warning) << "Failed to read cached scene " << path << ": " << result.message();
+                return CachedSceneState::Missing;
+            }
+
+            node = result.getNode();
+            return CachedSceneState::Loaded;
+        }
+
+        void writeCachedScene(const std::filesystem::path& path, const osg::Node* node)
+        {
+            // Write to a temporary file first, so concurrent loads of the same scene never see a partially written file
+            std::ostringstream tmpName;
+            tmpName << path.filename().string() << '.' << std::this_thread::get_id() << ".tmp";
+            const std::filesystem::path tmpPath = path.parent_path() / tmpName.str();
+
+            try
+            {
+                {
+                    std::ofstream stream(tmpPath, std::ios::binary | std::ios::trunc);
+                    if (!stream.is_open())
+                        throw std::runtime_error("can not open file");
+
+                    if (node)
+                    {
+                        osgDB::ReaderWriter* writer = osgDB::Registry::instance()->getReaderWriterForExtension("osgb");
+                        if (!writer)
+                            throw std::runtime_error("no readerwriter for 'osgb' found");
+
+                        osg::ref_ptr<osgDB::Options> options (new osgDB::Options);
+                        options->setPluginStringData("fileType", "Binary");
+                        options->setPluginStringData("WriteImageHint", "UseExternal");
+
+                        osgDB::ReaderWriter::WriteResult result = writer->writeNode(*node, stream, options);
+                        if (!result.success())
+                            throw std::runtime_error(result.message());
+                    }
+                }
+                std::filesystem::rename(tmpPath, path);
+            }
+            catch (const std::exception& e)
+            {
+                Log(Debug::Warning) << "Failed to write cached scene " << path << ": " << e.what();
+                std::error_code ec;
+                std::filesystem::remove(tmpPath, ec);
+            }
+        }
+    }
+
+    osg::ref_ptr<osg::Node> SceneManager::loadNifWithSceneCache(const std::string& normalizedFilename)
+    {
+        // Debug serializers replace the osg::Geometry wrapper, so cached scenes would be read without geometry
+        if (SceneUtil::hasDebugSerializers())
+            return NifOsg::Loader::load(mNifFileManager->get(normalizedFilename), mImageManager);
+
+        const std::array<std::uint64_t, 2> fileHash = Files::getHash(normalizedFilename, *mVFS->get(normalizedFilename));
+        const std::filesystem::path cachePath = std::filesystem::path(mSceneCachePath) / getSceneCacheFileName(fileHash, mSceneCacheTexturesHash);
+
+        osg::ref_ptr<osg::Node> node;
+        const CachedSceneState state = readCachedScene(cachePath, mImageManager, node);
+        if (state == CachedSceneState::Loaded)
+            return node;
+
+        node = NifOsg::Loader::load(mNifFileManager->get(normalizedFilename), mImageManager);
+
+        if (state == CachedSceneState::Missing)
+        {
+            CacheableSceneVisitor cacheableVisitor;
+            node->accept(cacheableVisitor);
+            writeCachedScene(cachePath, cacheableVisitor.mCacheable ? node.get() : nullptr);
+        }
+
+        return node;
+    }
+
     class CanOptimizeCallback : public SceneUtil::Optimizer::IsOperationPermissibleForObjectCallback
     {
     public:
@@ -740,7 +1048,10 @@ namespace Resource
             osg::ref_ptr<osg::Node> loaded;
             try
             {
-                loaded = load(normalized, mVFS, mImageManager, mNifFileManager);
+                if (!mSceneCachePath.empty() && Misc::getFileExtension(normalized) == "nif")
+                    loaded = loadNifWithSceneCache(normalized);
+                else
+                    loaded = load(normalized, mVFS, mImageManager, mNifFileManager);
 
                 SceneUtil::ProcessExtraDataVisitor extraDataVisitor(this);
                 loaded->accept(extraDataVisitor);
@@ -776,6 +1087,9 @@ namespace Resource
             osg::ref_ptr<Shader::ShaderVisitor> shaderVisitor (createShaderVisitor());
             loaded->accept(*shaderVisitor);
 
+            // Make equal uniforms the same objects, so StateSets from different nodes and files compare equal
+            mStateRegistry->canonicalize(*loaded);
+
             if (canOptimize(normalized))
             {
                 SceneUtil::Optimizer optimizer;
@@ -789,6 +1103,15 @@ namespace Resource
             else
                 shareState(loaded);
 
+            mTextureBudget->track(loaded);
+
+            // Instances share the work queue of their template
+            if (mDeformationWorkQueue)
+            {
+                SetDeformationWorkQueueVisitor setDeformationWorkQueueVisitor(mDeformationWorkQueue);
+                loaded->accept(setDeformationWorkQueueVisitor);
+            }
+
             if (compile && mIncrementalCompileOperation)
                 mIncrementalCompileOperation->add(loaded);
             else
@@ -873,11 +1196,21 @@ namespace Resource
         return mImageManager;
     }
 
+    Resource::TextureBudget& SceneManager::getTextureBudget()
+    {
+        return *mTextureBudget;
+    }
+
     void SceneManager::setParticleSystemMask(unsigned int mask)
     {
         mParticleSystemMask = mask;
     }
 
+    void SceneManager::setDeformationWorkQueue(SceneUtil::WorkQueue* workQueue)
+    {
+        mDeformationWorkQueue = workQueue;
+    }
+
     void SceneManager::setFilterSettings(const std::string &magfilter, const std::string &minfilter,
                                            const std::string &mipmap, int maxAnisotropy)
     {
@@ -942,6 +1275,8 @@ namespace Resource
         mSharedStateManager->prune();
         mSharedStateMutex.unlock();
 
+        mStateRegistry->prune();
+
         if (mIncrementalCompileOperation)
         {
             std::lock_guard<OpenThreads::Mutex> lock(*mIncrementalCompileOperation->getToCompiledMutex());
@@ -965,8 +1300,12 @@ namespace Resource
     {
         ResourceManager::clearCache();
 
-        std::lock_guard<std::mutex> lock(mSharedStateMutex);
-        mSharedStateManager->clearCache();
+        {
+            std::lock_guard<std::mutex> lock(mSharedStateMutex);
+            mSharedStateManager->clearCache();
+        }
+
+        mStateRegistry->clear();
     }
 
     void SceneManager::reportStats(unsigned int frameNumber, osg::Stats *stats) const
@@ -981,9 +1320,15 @@ namespace Resource
             std::lock_guard<std::mutex> lock(mSharedStateMutex);
             stats->setAttribute(frameNumber, "Texture", mSharedStateManager->getNumSharedTextures());
             stats->setAttribute(frameNumber, "StateSet", mSharedStateManager->getNumSharedStateSets());
+            stats->setAttribute(frameNumber, "StateSet Shared", mSharedStateManager->getNumStateSetHits());
         }
 
+        stats->setAttribute(frameNumber, "Uniform", mStateRegistry->getNumUniforms());
+        stats->setAttribute(frameNumber, "Uniform Shared", mStateRegistry->getNumUniformHits());
+
         stats->setAttribute(frameNumber, "Node", mCache->getCacheSize());
+
+        mTextureBudget->reportStats(frameNumber, stats);
     }
 
     Shader::ShaderVisitor *SceneManager::createShaderVisitor(const std::string& shaderPrefix)
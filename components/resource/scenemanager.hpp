@@ -1,6 +1,7 @@
 #ifndef OPENMW_COMPONENTS_RESOURCE_SCENEMANAGER_H
 #define OPENMW_COMPONENTS_RESOURCE_SCENEMANAGER_H
 
+#include <cstdint>
 #include <string>
 #include <map>
 #include <memory>
@@ -20,6 +21,8 @@ namespace Resource
     class ImageManager;
     class NifFileManager;
     class SharedStateManager;
+    class StateRegistry;
+    class TextureBudget;
 }
 
 namespace osgUtil
@@ -27,6 +30,11 @@ namespace osgUtil
     class IncrementalCompileOperation;
 }
 
+namespace SceneUtil
+{
+    class WorkQueue;
+}
+
 namespace osgDB
 {
     class SharedStateManager;
@@ -126,6 +134,11 @@ namespace Resource
 
         void setShaderPath(const std::string& path);
 
+        /// Keep NIF files converted to OSG scenes as OSG binary files in the given directory, so that later loads can skip the conversion.
+        /// Cached files are keyed by the contents of the NIF file. Scenes using classes without lossless serializers are never cached.
+        /// @note An empty path disables the scene cache.
+        void setSceneCachePath(const std::string& path);
+
         /// Check if a given scene is loaded and if so, update its usage timestamp to prevent it from being unloaded
         bool checkLoaded(const std::string& name, double referenceTime);
 
@@ -173,9 +186,17 @@ namespace Resource
 
         Resource::ImageManager* getImageManager();
 
+        /// Textures of scenes loaded while the budget is enabled are tracked by it.
+        Resource::TextureBudget& getTextureBudget();
+
         /// @param mask The node mask to apply to loaded particle system nodes.
         void setParticleSystemMask(unsigned int mask);
 
+        /// Set the work queue on which skinned and morphed meshes update their vertices. Pass nullptr to update
+        /// vertices on the cull thread.
+        /// @note Only affects scenes loaded after the call.
+        void setDeformationWorkQueue(SceneUtil::WorkQueue* workQueue);
+
         /// @warning It is unsafe to call this method while the draw thread is using textures! call Viewer::stopThreading first.
         void setFilterSettings(const std::string &magfilter, const std::string &minfilter,
                                const std::string &mipmap, int maxAnisotropy);
@@ -200,6 +221,8 @@ namespace Resource
 
     private:
 
+        osg::ref_ptr<osg::Node> loadNifWithSceneCache(const std::string& normalizedFilename);
+
         Shader::ShaderVisitor* createShaderVisitor(const std::string& shaderPrefix = "objects");
 
         std::unique_ptr<Shader::ShaderManager> mShaderManager;
@@ -219,9 +242,11 @@ namespace Resource
 
         osg::ref_ptr<Resource::SharedStateManager> mSharedStateManager;
         mutable std::mutex mSharedStateMutex;
+        std::unique_ptr<StateRegistry> mStateRegistry;
 
         Resource::ImageManager* mImageManager;
         Resource::NifFileManager* mNifFileManager;
+        std::unique_ptr<Resource::TextureBudget> mTextureBudget;
 
         osg::Texture::FilterMode mMinFilter;
         osg::Texture::FilterMode mMagFilter;
@@ -231,6 +256,12 @@ namespace Resource
         osg::ref_ptr<osgUtil::IncrementalCompileOperation> mIncrementalCompileOperation;
 
         unsigned int mParticleSystemMask;
+        osg::ref_ptr<SceneUtil::WorkQueue> mDeformationWorkQueue;
+
+        std::string mSceneCachePath;
+        // Hash of the texture file names in the VFS. The NIF loader resolves texture paths through the VFS,
+        // so cached scenes are only valid for the same set of textures.
+        std::uint64_t mSceneCacheTexturesHash = 0;
 
         SceneManager(const SceneManager&);
         void operator = (const SceneManager&);
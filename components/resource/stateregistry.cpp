@@ -0,0 +1,135 @@
+#include "stateregistry.hpp"
+
+#include <set>
+#include <vector>
+
+#include <osg/Array>
+#include <osg/Node>
+#include <osg/NodeVisitor>
+#include <osg/StateSet>
+
+namespace Resource
+{
+    namespace
+    {
+        const osg::Array* getUniformData(const osg::Uniform& uniform)
+        {
+            if (const osg::Array* array = uniform.getFloatArray())
+                return array;
+            if (const osg::Array* array = uniform.getDoubleArray())
+                return array;
+            if (const osg::Array* array = uniform.getIntArray())
+                return array;
+            if (const osg::Array* array = uniform.getUIntArray())
+                return array;
+            if (const osg::Array* array = uniform.getInt64Array())
+                return array;
+            return uniform.getUInt64Array();
+        }
+
+        bool canShare(const osg::Uniform& uniform)
+        {
+            return !uniform.getUpdateCallback() && !uniform.getEventCallback()
+                && uniform.getDataVariance() != osg::Object::DYNAMIC;
+        }
+
+        class CanonicalizeStateVisitor : public osg::NodeVisitor
+        {
+        public:
+            CanonicalizeStateVisitor(StateRegistry& registry)
+                : osg::NodeVisitor(TRAVERSE_ALL_CHILDREN)
+                , mRegistry(registry)
+            {
+            }
+
+            void apply(osg::Node& node) override
+            {
+                if (osg::StateSet* stateset = node.getStateSet())
+                    apply(*stateset);
+                traverse(node);
+            }
+
+        private:
+            void apply(osg::StateSet& stateset)
+            {
+                // Dynamic StateSets are changed by controllers, possibly through the state they contain
+                if (stateset.getDataVariance() == osg::Object::DYNAMIC || !mVisited.insert(&stateset).second)
+                    return;
+
+                std::vector<std::pair<osg::ref_ptr<osg::Uniform>, osg::StateAttribute::OverrideValue>> replaced;
+                for (const auto& [name, uniform] : stateset.getUniformList())
+                {
+                    if (!canShare(*uniform.first))
+                        continue;
+                    osg::ref_ptr<osg::Uniform> shared = mRegistry.getUniform(uniform.first);
+                    if (shared != uniform.first)
+                        replaced.emplace_back(std::move(shared), uniform.second);
+                }
+                // Adding a uniform with the same name replaces the old one and keeps track of its parents
+                for (const auto& [uniform, value] : replaced)
+                    stateset.addUniform(uniform, value);
+            }
+
+            StateRegistry& mRegistry;
+            std::set<const osg::StateSet*> mVisited;
+        };
+    }
+
+    StateRegistry::StateRegistry()
+        : mUniformHits(0)
+    {
+    }
+
+    void StateRegistry::canonicalize(osg::Node& node)
+    {
+        CanonicalizeStateVisitor visitor(*this);
+        node.accept(visitor);
+    }
+
+    osg::ref_ptr<osg::Uniform> StateRegistry::getUniform(osg::Uniform* uniform)
+    {
+        const osg::Array* data = getUniformData(*uniform);
+        if (!data)
+            return uniform;
+
+        UniformKey key(uniform->getName(), uniform->getType(), uniform->getNumElements(),
+            std::string(static_cast<const char*>(data->getDataPointer()), data->getTotalDataSize()));
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        const auto [it, inserted] = mUniforms.emplace(std::move(key), uniform);
+        if (!inserted)
+            ++mUniformHits;
+        return it->second;
+    }
+
+    void StateRegistry::prune()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (auto it = mUniforms.begin(); it != mUniforms.end();)
+        {
+            if (it->second->referenceCount() <= 1)
+                it = mUniforms.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    void StateRegistry::clear()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mUniforms.clear();
+    }
+
+    std::size_t StateRegistry::getNumUniforms() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mUniforms.size();
+    }
+
+    unsigned int StateRegistry::getNumUniformHits() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mUniformHits;
+    }
+
+}
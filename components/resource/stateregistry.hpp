@@ -0,0 +1,57 @@
+#ifndef OPENMW_COMPONENTS_RESOURCE_STATEREGISTRY_H
+#define OPENMW_COMPONENTS_RESOURCE_STATEREGISTRY_H
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+#include <osg/Uniform>
+#include <osg/ref_ptr>
+
+namespace osg
+{
+    class Node;
+    class Stats;
+}
+
+namespace Resource
+{
+
+    /// @brief Content-addressed registry of uniforms, shared by all loaded scenes.
+    /// @par StateSets compare their uniforms by address, so the StateSets the ShaderVisitor creates for each node never compare equal.
+    /// Replacing uniforms with registered equivalents first lets the SharedStateManager merge these StateSets, which then batch in the render bins.
+    /// Programs need no registry, the ShaderManager already returns the same program for the same shaders.
+    /// @note Thread safe.
+    class StateRegistry
+    {
+    public:
+        StateRegistry();
+
+        /// Replace the uniforms of the StateSets in \a node with registered equivalents, registering the ones not seen before.
+        /// @note Uniforms with callbacks or a dynamic data variance are left alone, as they are expected to change.
+        void canonicalize(osg::Node& node);
+
+        osg::ref_ptr<osg::Uniform> getUniform(osg::Uniform* uniform);
+
+        /// Forget the uniforms that are not used outside of the registry anymore.
+        void prune();
+
+        void clear();
+
+        std::size_t getNumUniforms() const;
+
+        /// @return The number of uniforms replaced by a registered equivalent so far.
+        unsigned int getNumUniformHits() const;
+
+    private:
+        using UniformKey = std::tuple<std::string, int, unsigned int, std::string>;
+
+        mutable std::mutex mMutex;
+        std::map<UniformKey, osg::ref_ptr<osg::Uniform>> mUniforms;
+        unsigned int mUniformHits;
+    };
+
+}
+
+#endif
@@ -375,20 +375,30 @@ void StatsHandler::setUpScene(osgViewer::ViewerBase *viewer)
             "",
             "Texture",
             "StateSet",
+            "StateSet Shared",
+            "Uniform",
+            "Uniform Shared",
             "Node",
             "Shape",
             "Shape Instance",
             "Image",
+            "Texture Memory",
+            "Texture Reduced",
             "Nif",
             "Keyframe",
             "",
             "Groundcover Chunk",
+            "Groundcover Prototype",
             "Object Chunk",
             "Terrain Chunk",
             "Terrain Texture",
             "Land",
             "Composite",
             "",
+            "Occlusion Tested",
+            "Occlusion Culled",
+            "Occluders",
+            "",
             "NavMesh Jobs",
             "NavMesh Waiting",
             "NavMesh Pushed",
@@ -407,6 +417,9 @@ void StatsHandler::setUpScene(osgViewer::ViewerBase *viewer)
             "Physics Objects",
             "Physics Projectiles",
             "Physics HeightFields",
+            "",
+            "Lua Memory",
+            "Lua Pooled",
         });
 
         static const auto longest = std::max_element(statNames.begin(), statNames.end(),
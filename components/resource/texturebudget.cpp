@@ -0,0 +1,463 @@
+#include "texturebudget.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <queue>
+
+#include <osg/GraphicsContext>
+#include <osg/GraphicsThread>
+#include <osg/Group>
+#include <osg/Stats>
+#include <osg/Texture2D>
+#include <osg/observer_ptr>
+
+#include <osgUtil/CullVisitor>
+
+#include <components/sceneutil/nodecallback.hpp>
+#include <components/sceneutil/workqueue.hpp>
+
+#include "imagemanager.hpp"
+
+namespace Resource
+{
+
+    struct TextureBudget::Entry
+    {
+        std::string mFileName;
+
+        /// Textures using the image, they all get the same resolution
+        std::vector<osg::observer_ptr<osg::Texture2D>> mTextures;
+
+        /// Larger dimension and size including mipmaps at full resolution
+        unsigned int mFullSize = 0;
+        std::size_t mFullBytes = 0;
+
+        unsigned int mMaxSkippedLevels = 0;
+        unsigned int mSkippedLevels = 0;
+
+        /// The reduced image, if any
+        osg::ref_ptr<osg::Image> mImage;
+
+        /// A different resolution is being prepared
+        bool mPending = false;
+
+        /// Largest size on screen in pixels since the last evaluation, written by the cull traversal
+        std::atomic<unsigned int> mPixelSize {0};
+
+        void recordUse(unsigned int pixelSize)
+        {
+            unsigned int current = mPixelSize.load(std::memory_order_relaxed);
+            while (current < pixelSize && !mPixelSize.compare_exchange_weak(current, pixelSize, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        std::size_t getBytes(unsigned int skippedLevels) const
+        {
+            // Each level has a quarter of the texels of the one above it
+            return mFullBytes >> (2 * skippedLevels);
+        }
+    };
+
+    namespace
+    {
+        /// Frames between evaluations of the texture resolutions
+        constexpr unsigned int sEvaluationInterval = 30;
+
+        /// Resolution changes started per evaluation, to spread the work over several frames
+        constexpr unsigned int sMaxChangesPerEvaluation = 8;
+
+        /// Textures are not reduced below this size
+        constexpr unsigned int sMinTextureSize = 256;
+
+        class TextureUsageCallback : public SceneUtil::NodeCallback<TextureUsageCallback, osg::Node*, osgUtil::CullVisitor*>
+        {
+        public:
+            TextureUsageCallback() = default;
+
+            TextureUsageCallback(std::vector<std::shared_ptr<TextureBudget::Entry>>&& entries)
+                : mEntries(std::move(entries))
+            {
+            }
+
+            TextureUsageCallback(const TextureUsageCallback& copy, const osg::CopyOp& copyop)
+                : SceneUtil::NodeCallback<TextureUsageCallback, osg::Node*, osgUtil::CullVisitor*>(copy, copyop)
+                , mEntries(copy.mEntries)
+            {
+            }
+
+            META_Object(Resource, TextureUsageCallback)
+
+            void operator()(osg::Node* node, osgUtil::CullVisitor* cv)
+            {
+                const float pixelSize = cv->clampedPixelSize(node->getBound());
+                if (pixelSize > 0)
+                {
+                    for (const auto& entry : mEntries)
+                        entry->recordUse(static_cast<unsigned int>(pixelSize));
+                }
+                traverse(node, cv);
+            }
+
+        private:
+            std::vector<std::shared_ptr<TextureBudget::Entry>> mEntries;
+        };
+
+        class TrackTexturesVisitor : public osg::NodeVisitor
+        {
+        public:
+            using GetEntry = std::function<std::shared_ptr<TextureBudget::Entry>(osg::Texture2D&)>;
+
+            TrackTexturesVisitor(GetEntry&& getEntry)
+                : osg::NodeVisitor(TRAVERSE_ALL_CHILDREN)
+                , mGetEntry(std::move(getEntry))
+            {
+            }
+
+            void apply(osg::Node& node) override
+            {
+                const std::size_t inherited = mStack.size();
+                collect(node.getStateSet(), mStack);
+
+                if (osg::Group* group = node.asGroup())
+                {
+                    std::vector<std::shared_ptr<TextureBudget::Entry>> entries = mStack;
+                    for (unsigned int i = 0; i < group->getNumChildren(); ++i)
+                    {
+                        if (osg::Drawable* drawable = group->getChild(i)->asDrawable())
+                            collect(drawable->getStateSet(), entries);
+                    }
+                    if (!entries.empty() && hasDrawables(*group))
+                    {
+                        std::sort(entries.begin(), entries.end());
+                        entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+                        group->addCullCallback(new TextureUsageCallback(std::move(entries)));
+                    }
+                }
+
+                traverse(node);
+                mStack.resize(inherited);
+            }
+
+        private:
+            static bool hasDrawables(const osg::Group& group)
+            {
+                for (unsigned int i = 0; i < group.getNumChildren(); ++i)
+                {
+                    if (group.getChild(i)->asDrawable())
+                        return true;
+                }
+                return false;
+            }
+
+            void collect(osg::StateSet* stateset, std::vector<std::shared_ptr<TextureBudget::Entry>>& entries)
+            {
+                if (!stateset)
+                    return;
+                for (unsigned int unit = 0; unit < stateset->getTextureAttributeList().size(); ++unit)
+                {
+                    osg::StateAttribute* attr = stateset->getTextureAttribute(unit, osg::StateAttribute::TEXTURE);
+                    osg::Texture2D* texture = dynamic_cast<osg::Texture2D*>(attr);
+                    if (!texture)
+                        continue;
+                    if (std::shared_ptr<TextureBudget::Entry> entry = mGetEntry(*texture))
+                        entries.push_back(std::move(entry));
+                }
+            }
+
+            GetEntry mGetEntry;
+            std::vector<std::shared_ptr<TextureBudget::Entry>> mStack;
+        };
+    }
+
+    class TextureBudget::PrepareImageWorkItem : public SceneUtil::WorkItem
+    {
+    public:
+        PrepareImageWorkItem(TextureBudget* budget, std::shared_ptr<Entry> entry, osg::ref_ptr<osg::Image> source, unsigned int sourceLevels, unsigned int targetLevels)
+            : mBudget(budget)
+            , mEntry(std::move(entry))
+            , mSource(std::move(source))
+            , mSourceLevels(sourceLevels)
+            , mTargetLevels(targetLevels)
+        {
+        }
+
+        void doWork() override
+        {
+            osg::ref_ptr<osg::Image> source = mSource;
+            unsigned int sourceLevels = mSourceLevels;
+            if (!source)
+            {
+                source = mBudget->mImageManager->getImage(mEntry->mFileName, false, true);
+                sourceLevels = 0;
+            }
+
+            Result result {mEntry, nullptr, mTargetLevels};
+            // The file may have changed or failed to load since it was first tracked
+            const unsigned int levels = mTargetLevels - sourceLevels;
+            if (source && static_cast<unsigned int>(std::max(source->s(), source->t())) == mEntry->mFullSize >> sourceLevels
+                && source->getNumMipmapLevels() > levels)
+            {
+                result.mImage = levels > 0 ? dropMipmapLevels(*source, levels) : source;
+            }
+            mBudget->addResult(std::move(result));
+        }
+
+    private:
+        TextureBudget* mBudget;
+        std::shared_ptr<Entry> mEntry;
+        osg::ref_ptr<osg::Image> mSource;
+        unsigned int mSourceLevels;
+        unsigned int mTargetLevels;
+    };
+
+    namespace
+    {
+        /// Replaces the images on the draw thread, between frames
+        class SwapImagesOperation : public osg::GraphicsOperation
+        {
+        public:
+            SwapImagesOperation(std::function<void()>&& swap)
+                : osg::GraphicsOperation("SwapImagesOperation", false)
+                , mSwap(std::move(swap))
+            {
+            }
+
+            void operator()(osg::GraphicsContext* graphicsContext) override
+            {
+                mSwap();
+            }
+
+        private:
+            std::function<void()> mSwap;
+        };
+    }
+
+    TextureBudget::TextureBudget(ImageManager* imageManager)
+        : mImageManager(imageManager)
+        , mBudget(0)
+        , mResidentBytes(0)
+        , mNumReduced(0)
+    {
+    }
+
+    TextureBudget::~TextureBudget()
+    {
+    }
+
+    void TextureBudget::setBudget(std::size_t budget)
+    {
+        mBudget = budget;
+    }
+
+    void TextureBudget::setWorkQueue(SceneUtil::WorkQueue* workQueue)
+    {
+        mWorkQueue = workQueue;
+    }
+
+    void TextureBudget::track(osg::Node* node)
+    {
+        if (!isEnabled())
+            return;
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        TrackTexturesVisitor visitor([this] (osg::Texture2D& texture) -> std::shared_ptr<Entry>
+        {
+            osg::Image* image = texture.getImage();
+            if (!image || image->getFileName().empty() || image->r() != 1 || image->getNumMipmapLevels() < 2)
+                return nullptr;
+
+            std::shared_ptr<Entry>& entry = mEntries[image->getFileName()];
+            if (!entry)
+            {
+                entry = std::make_shared<Entry>();
+                entry->mFileName = image->getFileName();
+                entry->mFullSize = std::max(image->s(), image->t());
+                entry->mFullBytes = image->getTotalSizeInBytesIncludingMipmaps();
+                while (entry->mMaxSkippedLevels + 1 < image->getNumMipmapLevels()
+                       && (entry->mFullSize >> (entry->mMaxSkippedLevels + 1)) >= sMinTextureSize)
+                    ++entry->mMaxSkippedLevels;
+                mResidentBytes += entry->getBytes(0);
+            }
+            if (entry->mMaxSkippedLevels == 0)
+                return nullptr;
+
+            auto found = std::find_if(entry->mTextures.begin(), entry->mTextures.end(),
+                [&] (const osg::observer_ptr<osg::Texture2D>& tracked) { return tracked == &texture; });
+            if (found == entry->mTextures.end())
+            {
+                entry->mTextures.emplace_back(&texture);
+                // The scene is not being drawn yet, so its textures can be changed right away
+                if (entry->mImage)
+                {
+                    texture.setImage(entry->mImage);
+                    texture.setTextureSize(entry->mImage->s(), entry->mImage->t());
+                }
+            }
+            return entry;
+        });
+        node->accept(visitor);
+    }
+
+    void TextureBudget::addResult(Result&& result)
+    {
+        std::lock_guard<std::mutex> lock(mResultsMutex);
+        mResults.push_back(std::move(result));
+    }
+
+    void TextureBudget::update(unsigned int frameNumber, osg::GraphicsContext* gc)
+    {
+        if (!isEnabled() || !gc)
+            return;
+
+        std::vector<Result> results;
+        {
+            std::lock_guard<std::mutex> lock(mResultsMutex);
+            results.swap(mResults);
+        }
+
+        if (!results.empty())
+        {
+            gc->add(new SwapImagesOperation([this, results = std::move(results)]
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                for (const Result& result : results)
+                {
+                    Entry& entry = *result.mEntry;
+                    entry.mPending = false;
+                    if (!result.mImage)
+                        continue;
+
+                    mResidentBytes += entry.getBytes(result.mSkippedLevels);
+                    mResidentBytes -= entry.getBytes(entry.mSkippedLevels);
+                    if (entry.mSkippedLevels == 0 && result.mSkippedLevels > 0)
+                        ++mNumReduced;
+                    else if (entry.mSkippedLevels > 0 && result.mSkippedLevels == 0)
+                        --mNumReduced;
+                    entry.mSkippedLevels = result.mSkippedLevels;
+                    // Keep no extra reference to full resolution images, so they can expire from the ImageManager cache
+                    entry.mImage = result.mSkippedLevels > 0 ? result.mImage : nullptr;
+
+                    // The texture compares the modified count of the image to decide if it needs to be uploaded again
+                    result.mImage->dirty();
+                    for (const osg::observer_ptr<osg::Texture2D>& tracked : entry.mTextures)
+                    {
+                        osg::ref_ptr<osg::Texture2D> texture;
+                        if (!tracked.lock(texture))
+                            continue;
+                        texture->setImage(result.mImage);
+                        texture->setTextureSize(result.mImage->s(), result.mImage->t());
+                    }
+                }
+            }));
+        }
+
+        if (frameNumber % sEvaluationInterval == 0)
+            evaluate();
+    }
+
+    void TextureBudget::evaluate()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        struct Candidate
+        {
+            float mExcess;
+            Entry* mEntry;
+
+            bool operator<(const Candidate& other) const { return mExcess < other.mExcess; }
+        };
+
+        std::map<Entry*, unsigned int> targets;
+        std::map<Entry*, unsigned int> pixelSizes;
+        std::priority_queue<Candidate> candidates;
+        std::size_t total = 0;
+
+        // How many times larger than needed the texture would be at the given level. Unused textures are reduced first.
+        const auto getExcess = [&] (Entry* entry, unsigned int levels)
+        {
+            const unsigned int pixelSize = pixelSizes[entry];
+            return pixelSize > 0 ? static_cast<float>(entry->mFullSize >> levels) / pixelSize
+                                 : static_cast<float>(entry->mFullSize >> levels) * 2;
+        };
+
+        for (auto it = mEntries.begin(); it != mEntries.end();)
+        {
+            Entry* entry = it->second.get();
+            entry->mTextures.erase(std::remove_if(entry->mTextures.begin(), entry->mTextures.end(),
+                [] (const osg::observer_ptr<osg::Texture2D>& texture) { return !texture.valid(); }), entry->mTextures.end());
+            if (entry->mTextures.empty() && !entry->mPending)
+            {
+                mResidentBytes -= entry->getBytes(entry->mSkippedLevels);
+                if (entry->mSkippedLevels > 0)
+                    --mNumReduced;
+                it = mEntries.erase(it);
+                continue;
+            }
+
+            pixelSizes[entry] = entry->mPixelSize.exchange(0, std::memory_order_relaxed);
+            targets[entry] = 0;
+            total += entry->getBytes(0);
+            if (entry->mMaxSkippedLevels > 0)
+                candidates.push(Candidate {getExcess(entry, 0), entry});
+            ++it;
+        }
+
+        while (total > mBudget && !candidates.empty())
+        {
+            Entry* entry = candidates.top().mEntry;
+            candidates.pop();
+            unsigned int& levels = targets[entry];
+            total -= entry->getBytes(levels) - entry->getBytes(levels + 1);
+            ++levels;
+            if (levels < entry->mMaxSkippedLevels)
+                candidates.push(Candidate {getExcess(entry, levels), entry});
+        }
+
+        unsigned int changes = 0;
+        for (const auto& [name, entry] : mEntries)
+        {
+            if (changes >= sMaxChangesPerEvaluation)
+                break;
+            const unsigned int target = targets[entry.get()];
+            if (entry->mPending || target == entry->mSkippedLevels)
+                continue;
+
+            // Move one level at a time, dropping levels from the current image and restoring them from the full resolution image
+            osg::ref_ptr<PrepareImageWorkItem> item;
+            if (target > entry->mSkippedLevels)
+            {
+                osg::ref_ptr<osg::Image> source = entry->mImage;
+                if (!source)
+                {
+                    osg::ref_ptr<osg::Texture2D> texture;
+                    if (!entry->mTextures.front().lock(texture) || !texture->getImage())
+                        continue;
+                    source = texture->getImage();
+                }
+                item = new PrepareImageWorkItem(this, entry, source, entry->mSkippedLevels, entry->mSkippedLevels + 1);
+            }
+            else
+                item = new PrepareImageWorkItem(this, entry, nullptr, 0, entry->mSkippedLevels - 1);
+
+            entry->mPending = true;
+            ++changes;
+            if (mWorkQueue)
+                mWorkQueue->addWorkItem(item);
+            else
+                item->doWork();
+        }
+    }
+
+    void TextureBudget::reportStats(unsigned int frameNumber, osg::Stats* stats) const
+    {
+        if (!isEnabled())
+            return;
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        stats->setAttribute(frameNumber, "Texture Memory", mResidentBytes / (1024.0 * 1024.0));
+        stats->setAttribute(frameNumber, "Texture Reduced", mNumReduced);
+    }
+
+}
@@ -0,0 +1,94 @@
+#ifndef OPENMW_COMPONENTS_RESOURCE_TEXTUREBUDGET_H
+#define OPENMW_COMPONENTS_RESOURCE_TEXTUREBUDGET_H
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <osg/ref_ptr>
+
+namespace osg
+{
+    class GraphicsContext;
+    class Image;
+    class Node;
+    class Stats;
+}
+
+namespace SceneUtil
+{
+    class WorkQueue;
+}
+
+namespace Resource
+{
+    class ImageManager;
+
+    /// @brief Keeps the memory used by the textures of loaded scenes within a budget by dropping and restoring mipmap levels.
+    /// @par Textures are tracked per image. Cull callbacks record how large the objects using a texture appear on screen,
+    /// and while the budget is exceeded, the textures with the most resolution to spare lose their largest mipmap level first.
+    /// Levels are restored one at a time once there is room again, by reloading the image through the ImageManager.
+    class TextureBudget
+    {
+    public:
+        TextureBudget(ImageManager* imageManager);
+        ~TextureBudget();
+
+        /// @param budget Memory in bytes for the tracked textures, 0 disables the budget.
+        /// @note Only affects scenes tracked after the call.
+        void setBudget(std::size_t budget);
+        bool isEnabled() const { return mBudget != 0; }
+
+        /// Set the work queue used to prepare images at a different resolution.
+        /// @note Pass nullptr before the work queue is destroyed.
+        void setWorkQueue(SceneUtil::WorkQueue* workQueue);
+
+        /// Track the textures of a loaded scene and install cull callbacks recording their use.
+        /// @note Call after optimizing the scene, the Optimizer leaves nodes with callbacks alone. Copies of the scene that
+        /// are optimized again should drop the TextureUsageCallbacks and be tracked anew.
+        /// @note Thread safe.
+        void track(osg::Node* node);
+
+        /// Re-evaluate texture resolutions and swap images that finished loading.
+        /// @param gc The images are swapped by an operation on this context, so they are never replaced while being drawn.
+        /// @note Call once per frame from the update thread.
+        void update(unsigned int frameNumber, osg::GraphicsContext* gc);
+
+        void reportStats(unsigned int frameNumber, osg::Stats* stats) const;
+
+        struct Entry;
+
+    private:
+        struct Result
+        {
+            std::shared_ptr<Entry> mEntry;
+            osg::ref_ptr<osg::Image> mImage;
+            unsigned int mSkippedLevels;
+        };
+
+        class PrepareImageWorkItem;
+
+        void evaluate();
+
+        void addResult(Result&& result);
+
+        ImageManager* mImageManager;
+        std::size_t mBudget;
+        std::size_t mResidentBytes;
+        std::size_t mNumReduced;
+
+        osg::ref_ptr<SceneUtil::WorkQueue> mWorkQueue;
+
+        std::map<std::string, std::shared_ptr<Entry>> mEntries;
+        mutable std::mutex mMutex;
+
+        std::vector<Result> mResults;
+        std::mutex mResultsMutex;
+    };
+
+}
+
+#endif
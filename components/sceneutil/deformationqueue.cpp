@@ -0,0 +1,51 @@
+#include "deformationqueue.hpp"
+
+namespace SceneUtil
+{
+    namespace
+    {
+        class DeformationWorkItem : public WorkItem
+        {
+        public:
+            explicit DeformationWorkItem(std::function<void()>&& work)
+                : mWork(std::move(work))
+            {
+            }
+
+            void doWork() override
+            {
+                mWork();
+            }
+
+        private:
+            std::function<void()> mWork;
+        };
+    }
+
+    void PendingDeformation::run(WorkQueue* workQueue, std::function<void()>&& work)
+    {
+        wait();
+
+        if (!workQueue)
+        {
+            mWorkItem = nullptr;
+            work();
+            return;
+        }
+
+        mWorkItem = new DeformationWorkItem(std::move(work));
+        workQueue->addWorkItem(mWorkItem);
+    }
+
+    void PendingDeformation::wait() const
+    {
+        if (mWorkItem)
+            mWorkItem->waitTillDone();
+    }
+
+    void PendingDeformation::drawImplementation(osg::RenderInfo& renderInfo, const osg::Drawable* drawable) const
+    {
+        wait();
+        drawable->drawImplementation(renderInfo);
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef OPENMW_COMPONENTS_SCENEUTIL_DEFORMATIONQUEUE_H
+#define OPENMW_COMPONENTS_SCENEUTIL_DEFORMATIONQUEUE_H
+
+#include <osg/Drawable>
+
+#include <functional>
+
+#include "workqueue.hpp"
+
+namespace SceneUtil
+{
+    /// @brief Tracks the pending vertex update of one of the internal geometries of a RigGeometry or MorphGeometry.
+    /// @par Installed as draw callback of that geometry, so that drawing never starts before the vertices are written.
+    class PendingDeformation : public osg::Drawable::DrawCallback
+    {
+    public:
+        /// Run a vertex update on \a workQueue, or right away if \a workQueue is null.
+        /// @note Waits for the previous update to complete first.
+        void run(WorkQueue* workQueue, std::function<void()>&& work);
+
+        /// Wait until the last vertex update is complete.
+        void wait() const;
+
+        void drawImplementation(osg::RenderInfo& renderInfo, const osg::Drawable* drawable) const override;
+
+    private:
+        osg::ref_ptr<WorkItem> mWorkItem;
+    };
+}
+
+#endif
@@ -10,6 +10,7 @@ namespace SceneUtil
 
 MorphGeometry::MorphGeometry()
     : mLastFrameNumber(0)
+    , mCurrentGeometry(0)
     , mDirty(true)
     , mMorphedBoundingBox(false)
 {
@@ -19,17 +20,28 @@ MorphGeometry::MorphGeometry()
 MorphGeometry::MorphGeometry(const MorphGeometry &copy, const osg::CopyOp &copyop)
     : osg::Drawable(copy, copyop)
     , mMorphTargets(copy.mMorphTargets)
+    , mWorkQueue(copy.mWorkQueue)
     , mLastFrameNumber(0)
+    , mCurrentGeometry(0)
     , mDirty(true)
     , mMorphedBoundingBox(false)
 {
     setSourceGeometry(copy.getSourceGeometry());
 }
 
+void MorphGeometry::setWorkQueue(osg::ref_ptr<WorkQueue> workQueue)
+{
+    mWorkQueue = std::move(workQueue);
+}
+
 void MorphGeometry::setSourceGeometry(osg::ref_ptr<osg::Geometry> sourceGeom)
 {
     for (unsigned int i=0; i<2; ++i)
+    {
+        if (mDeformations[i])
+            mDeformations[i]->wait();
         mGeometry[i] = nullptr;
+    }
 
     mSourceGeometry = sourceGeom;
 
@@ -47,6 +59,8 @@ void MorphGeometry::setSourceGeometry(osg::ref_ptr<osg::Geometry> sourceGeom)
         to.setSupportsDisplayList(false);
         to.setUseVertexBufferObjects(true);
         to.setCullingActive(false); // make sure to disable culling since that's handled by this class
+        mDeformations[i] = new PendingDeformation;
+        to.setDrawCallback(mDeformations[i]);
 
         // vertices are modified every frame, so we need to deep copy them.
         // assign a dedicated VBO to make sure that modifications don't interfere with source geometry's VBO.
@@ -98,7 +112,8 @@ void MorphGeometry::accept(osg::NodeVisitor &nv)
 
 void MorphGeometry::accept(osg::PrimitiveFunctor& func) const
 {
-    getGeometry(mLastFrameNumber)->accept(func);
+    mDeformations[mCurrentGeometry]->wait();
+    mGeometry[mCurrentGeometry]->accept(func);
 }
 
 osg::BoundingBox MorphGeometry::computeBoundingBox() const
@@ -160,7 +175,7 @@ void MorphGeometry::cull(osg::NodeVisitor *nv)
 {
     if (mLastFrameNumber == nv->getTraversalNumber() || !mDirty || mMorphTargets.size() == 0)
     {
-        osg::Geometry& geom = *getGeometry(mLastFrameNumber);
+        osg::Geometry& geom = *mGeometry[mCurrentGeometry];
         nv->pushOntoNodePath(&geom);
         nv->apply(geom);
         nv->popFromNodePath();
@@ -169,24 +184,35 @@ void MorphGeometry::cull(osg::NodeVisitor *nv)
 
     mDirty = false;
     mLastFrameNumber = nv->getTraversalNumber();
-    osg::Geometry& geom = *getGeometry(mLastFrameNumber);
+    // Write to the geometry that was not used last, the previous frame may still be drawing it
+    mCurrentGeometry = 1 - mCurrentGeometry;
+    osg::Geometry& geom = *mGeometry[mCurrentGeometry];
 
-    const osg::Vec3Array* positionSrc = mMorphTargets[0].getOffsets();
-    osg::Vec3Array* positionDst = static_cast<osg::Vec3Array*>(geom.getVertexArray());
+    osg::ref_ptr<const osg::Vec3Array> positionSrc = mMorphTargets[0].getOffsets();
+    osg::ref_ptr<osg::Vec3Array> positionDst = static_cast<osg::Vec3Array*>(geom.getVertexArray());
     assert(positionSrc->size() == positionDst->size());
-    for (unsigned int vertex=0; vertex<positionSrc->size(); ++vertex)
-        (*positionDst)[vertex] = (*positionSrc)[vertex];
 
+    // Weights may be changed by the next frame's update while vertices are morphed on a worker thread
+    std::vector<std::pair<osg::ref_ptr<const osg::Vec3Array>, float>> targets;
     for (unsigned int i=1; i<mMorphTargets.size(); ++i)
     {
         float weight = mMorphTargets[i].getWeight();
-        if (weight == 0.f)
-            continue;
-        const osg::Vec3Array* offsets = mMorphTargets[i].getOffsets();
-        for (unsigned int vertex=0; vertex<positionSrc->size(); ++vertex)
-            (*positionDst)[vertex] += (*offsets)[vertex] * weight;
+        if (weight != 0.f)
+            targets.emplace_back(mMorphTargets[i].getOffsets(), weight);
     }
 
+    mDeformations[mCurrentGeometry]->run(mWorkQueue, [positionSrc, positionDst, targets = std::move(targets)]
+    {
+        for (unsigned int vertex=0; vertex<positionSrc->size(); ++vertex)
+            (*positionDst)[vertex] = (*positionSrc)[vertex];
+
+        for (const auto& [offsets, weight] : targets)
+        {
+            for (unsigned int vertex=0; vertex<positionSrc->size(); ++vertex)
+                (*positionDst)[vertex] += (*offsets)[vertex] * weight;
+        }
+    });
+
     positionDst->dirty();
 
 #if OSG_MIN_VERSION_REQUIRED(3, 5, 10)
@@ -198,10 +224,5 @@ void MorphGeometry::cull(osg::NodeVisitor *nv)
     nv->popFromNodePath();
 }
 
-osg::Geometry* MorphGeometry::getGeometry(unsigned int frame) const
-{
-    return mGeometry[frame%2];
-}
-
 
 }
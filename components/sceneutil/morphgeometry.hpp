@@ -3,12 +3,15 @@
 
 #include <osg/Geometry>
 
+#include "deformationqueue.hpp"
+
 namespace SceneUtil
 {
 
     /// @brief Vertex morphing implementation.
     /// @note The internal Geometry used for rendering is double buffered, this allows updates to be done in a thread safe way while
     /// not compromising rendering performance. This is crucial when using osg's default threading model of DrawThreadPerContext.
+    /// @note Vertices may be morphed on a worker thread, see setWorkQueue.
     class MorphGeometry : public osg::Drawable
     {
     public:
@@ -17,6 +20,10 @@ namespace SceneUtil
 
         META_Object(SceneUtil, MorphGeometry)
 
+        /// Set the work queue to update vertices on, in parallel with the rest of the cull traversal.
+        /// Without a work queue vertices are updated on the cull thread.
+        void setWorkQueue(osg::ref_ptr<WorkQueue> workQueue);
+
         /// Initialize this geometry from the source geometry.
         /// @note The source geometry will not be modified.
         void setSourceGeometry(osg::ref_ptr<osg::Geometry> sourceGeom);
@@ -73,9 +80,11 @@ namespace SceneUtil
         osg::ref_ptr<osg::Geometry> mSourceGeometry;
 
         osg::ref_ptr<osg::Geometry> mGeometry[2];
-        osg::Geometry* getGeometry(unsigned int frame) const;
+        osg::ref_ptr<PendingDeformation> mDeformations[2];
+        osg::ref_ptr<WorkQueue> mWorkQueue;
 
         unsigned int mLastFrameNumber;
+        unsigned int mCurrentGeometry;
         bool mDirty; // Have any morph targets changed?
 
         mutable bool mMorphedBoundingBox;
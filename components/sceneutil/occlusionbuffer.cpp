@@ -0,0 +1,210 @@
+#include "occlusionbuffer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+namespace SceneUtil
+{
+    namespace
+    {
+        // Anything closer to the eye than this is clipped off occluders, and makes bounds visible
+        constexpr float sNearW = 1.f;
+
+        float edge(const osg::Vec3f& a, const osg::Vec3f& b, float x, float y)
+        {
+            return (b.x() - a.x()) * (y - a.y()) - (b.y() - a.y()) * (x - a.x());
+        }
+
+        // Pixel range covered by [min, max], clamped to the buffer
+        std::pair<int, int> getPixelRange(float min, float max, int size)
+        {
+            const float limit = static_cast<float>(size);
+            const int first = static_cast<int>(std::floor(std::clamp(min, 0.f, limit)));
+            const int last = static_cast<int>(std::floor(std::clamp(max, -1.f, limit - 1.f)));
+            return { first, last };
+        }
+    }
+
+    OcclusionBuffer::OcclusionBuffer()
+        : mWidth(0)
+        , mHeight(0)
+        , mTilesX(0)
+        , mTilesY(0)
+    {
+    }
+
+    void OcclusionBuffer::reset(int width, int height, const osg::Matrixd& viewProjection)
+    {
+        mWidth = width;
+        mHeight = height;
+        mTilesX = (width + sTileSize - 1) / sTileSize;
+        mTilesY = (height + sTileSize - 1) / sTileSize;
+        mViewProjection = viewProjection;
+        mDepth.assign(static_cast<std::size_t>(width * height), 0.f);
+        mTileDepth.assign(static_cast<std::size_t>(mTilesX * mTilesY), 0.f);
+    }
+
+    osg::Vec3f OcclusionBuffer::toScreen(const osg::Vec4f& clip) const
+    {
+        const float invW = 1.f / clip.w();
+        return osg::Vec3f((clip.x() * invW * 0.5f + 0.5f) * mWidth, (clip.y() * invW * 0.5f + 0.5f) * mHeight, invW);
+    }
+
+    void OcclusionBuffer::addOccluder(const OccluderMesh& mesh, const osg::Matrixf& matrix)
+    {
+        const osg::Matrixf transform(osg::Matrixd(matrix) * mViewProjection);
+
+        for (std::size_t i = 0; i + 2 < mesh.mIndices.size(); i += 3)
+        {
+            const std::array<osg::Vec4f, 3> triangle {
+                osg::Vec4f(mesh.mVertices[mesh.mIndices[i]], 1.f) * transform,
+                osg::Vec4f(mesh.mVertices[mesh.mIndices[i + 1]], 1.f) * transform,
+                osg::Vec4f(mesh.mVertices[mesh.mIndices[i + 2]], 1.f) * transform,
+            };
+
+            const int numInside = (triangle[0].w() > sNearW) + (triangle[1].w() > sNearW) + (triangle[2].w() > sNearW);
+            if (numInside == 0)
+                continue;
+            if (numInside == 3)
+            {
+                rasterizeTriangle(triangle[0], triangle[1], triangle[2]);
+                continue;
+            }
+
+            // Clip against the near plane, which leaves a triangle or a quad
+            std::array<osg::Vec4f, 4> clipped;
+            std::size_t numClipped = 0;
+            for (std::size_t j = 0; j < 3; ++j)
+            {
+                const osg::Vec4f& from = triangle[j];
+                const osg::Vec4f& to = triangle[(j + 1) % 3];
+                const bool fromInside = from.w() > sNearW;
+                if (fromInside)
+                    clipped[numClipped++] = from;
+                if (fromInside != (to.w() > sNearW))
+                    clipped[numClipped++] = from + (to - from) * ((sNearW - from.w()) / (to.w() - from.w()));
+            }
+
+            rasterizeTriangle(clipped[0], clipped[1], clipped[2]);
+            if (numClipped == 4)
+                rasterizeTriangle(clipped[0], clipped[2], clipped[3]);
+        }
+    }
+
+    void OcclusionBuffer::rasterizeTriangle(const osg::Vec4f& a, const osg::Vec4f& b, const osg::Vec4f& c)
+    {
+        osg::Vec3f p0 = toScreen(a);
+        osg::Vec3f p1 = toScreen(b);
+        osg::Vec3f p2 = toScreen(c);
+
+        float area = edge(p0, p1, p2.x(), p2.y());
+        if (!(std::abs(area) > 1e-6f))
+            return;
+        if (area < 0)
+        {
+            std::swap(p1, p2);
+            area = -area;
+        }
+
+        const auto [x0, x1] = getPixelRange(std::min({p0.x(), p1.x(), p2.x()}), std::max({p0.x(), p1.x(), p2.x()}), mWidth);
+        const auto [y0, y1] = getPixelRange(std::min({p0.y(), p1.y(), p2.y()}), std::max({p0.y(), p1.y(), p2.y()}), mHeight);
+        if (x0 > x1 || y0 > y1)
+            return;
+
+        // Edge functions are evaluated at pixel centers and stepped incrementally along rows
+        const float stepX0 = p1.y() - p2.y();
+        const float stepX1 = p2.y() - p0.y();
+        const float stepX2 = p0.y() - p1.y();
+        const float invArea = 1.f / area;
+
+        for (int y = y0; y <= y1; ++y)
+        {
+            const float centerX = x0 + 0.5f;
+            const float centerY = y + 0.5f;
+            float e0 = edge(p1, p2, centerX, centerY);
+            float e1 = edge(p2, p0, centerX, centerY);
+            float e2 = edge(p0, p1, centerX, centerY);
+            float* depth = &mDepth[static_cast<std::size_t>(y * mWidth)];
+            for (int x = x0; x <= x1; ++x)
+            {
+                if (e0 >= 0 && e1 >= 0 && e2 >= 0)
+                {
+                    const float z = (e0 * p0.z() + e1 * p1.z() + e2 * p2.z()) * invArea;
+                    depth[x] = std::max(depth[x], z);
+                }
+                e0 += stepX0;
+                e1 += stepX1;
+                e2 += stepX2;
+            }
+        }
+    }
+
+    void OcclusionBuffer::finish()
+    {
+        for (int tileY = 0; tileY < mTilesY; ++tileY)
+        {
+            for (int tileX = 0; tileX < mTilesX; ++tileX)
+            {
+                float farthest = std::numeric_limits<float>::max();
+                const int endY = std::min(mHeight, (tileY + 1) * sTileSize);
+                const int endX = std::min(mWidth, (tileX + 1) * sTileSize);
+                for (int y = tileY * sTileSize; y < endY; ++y)
+                    for (int x = tileX * sTileSize; x < endX; ++x)
+                        farthest = std::min(farthest, mDepth[static_cast<std::size_t>(y * mWidth + x)]);
+                mTileDepth[static_cast<std::size_t>(tileY * mTilesX + tileX)] = farthest;
+            }
+        }
+    }
+
+    bool OcclusionBuffer::isOccluded(const osg::BoundingBox& box) const
+    {
+        if (!box.valid() || mDepth.empty())
+            return false;
+
+        float minX = std::numeric_limits<float>::max();
+        float minY = std::numeric_limits<float>::max();
+        float maxX = -std::numeric_limits<float>::max();
+        float maxY = -std::numeric_limits<float>::max();
+        float nearest = 0.f;
+        for (unsigned int i = 0; i < 8; ++i)
+        {
+            const osg::Vec4d clip = osg::Vec4d(box.corner(i), 1.0) * mViewProjection;
+            if (clip.w() <= sNearW)
+                return false;
+            const osg::Vec3f screen = toScreen(osg::Vec4f(clip));
+            minX = std::min(minX, screen.x());
+            minY = std::min(minY, screen.y());
+            maxX = std::max(maxX, screen.x());
+            maxY = std::max(maxY, screen.y());
+            nearest = std::max(nearest, screen.z());
+        }
+
+        const auto [x0, x1] = getPixelRange(minX, maxX, mWidth);
+        const auto [y0, y1] = getPixelRange(minY, maxY, mHeight);
+        if (x0 > x1 || y0 > y1)
+            return false;
+
+        for (int tileY = y0 / sTileSize; tileY <= y1 / sTileSize; ++tileY)
+        {
+            for (int tileX = x0 / sTileSize; tileX <= x1 / sTileSize; ++tileX)
+            {
+                // Every pixel of the tile has a nearer occluder
+                if (nearest < mTileDepth[static_cast<std::size_t>(tileY * mTilesX + tileX)])
+                    continue;
+
+                const int startY = std::max(y0, tileY * sTileSize);
+                const int endY = std::min(y1, (tileY + 1) * sTileSize - 1);
+                const int startX = std::max(x0, tileX * sTileSize);
+                const int endX = std::min(x1, (tileX + 1) * sTileSize - 1);
+                for (int y = startY; y <= endY; ++y)
+                    for (int x = startX; x <= endX; ++x)
+                        if (nearest >= mDepth[static_cast<std::size_t>(y * mWidth + x)])
+                            return false;
+            }
+        }
+        return true;
+    }
+
+}
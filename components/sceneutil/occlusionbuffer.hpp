@@ -0,0 +1,71 @@
+#ifndef OPENMW_COMPONENTS_SCENEUTIL_OCCLUSIONBUFFER_H
+#define OPENMW_COMPONENTS_SCENEUTIL_OCCLUSIONBUFFER_H
+
+#include <vector>
+
+#include <osg/BoundingBox>
+#include <osg/Matrixd>
+#include <osg/Matrixf>
+#include <osg/Vec3f>
+#include <osg/Vec4f>
+
+namespace SceneUtil
+{
+
+    /// @brief Triangles that hide what is behind them, in the local space of the object they belong to.
+    /// @note Occluders must never be larger than the object they belong to, or visible objects could be culled.
+    struct OccluderMesh
+    {
+        std::vector<osg::Vec3f> mVertices;
+        std::vector<unsigned int> mIndices;
+    };
+
+    /// @brief Low resolution depth buffer rasterized on the CPU from occluder meshes, to test whether bounds are entirely hidden behind them.
+    /// @par Depth is stored as 1/w, which interpolates linearly in screen space and does not depend on the depth range of the projection.
+    /// The buffer also keeps the farthest depth of each tile of pixels, so most tests only need to look at the tiles.
+    class OcclusionBuffer
+    {
+    public:
+        static constexpr int sTileSize = 8;
+
+        OcclusionBuffer();
+
+        /// Clear the buffer and set up the transform for the following calls.
+        /// @param viewProjection Transforms world space to clip space.
+        void reset(int width, int height, const osg::Matrixd& viewProjection);
+
+        /// Rasterize the triangles of \a mesh.
+        /// @param matrix Transforms the mesh to world space.
+        void addOccluder(const OccluderMesh& mesh, const osg::Matrixf& matrix);
+
+        /// Update the tiles. Call after adding the occluders and before testing.
+        void finish();
+
+        /// @return true if \a box, in world space, is entirely behind occluders.
+        /// @note Bounds intersecting the near plane or outside of the buffer are never occluded, they are left to frustum culling.
+        /// @note Thread safe, as long as the buffer is not modified.
+        bool isOccluded(const osg::BoundingBox& box) const;
+
+        int getWidth() const { return mWidth; }
+        int getHeight() const { return mHeight; }
+
+        /// @return 1/w of the nearest occluder at the pixel, 0 if there is none.
+        float getDepth(int x, int y) const { return mDepth[y * mWidth + x]; }
+
+    private:
+        void rasterizeTriangle(const osg::Vec4f& a, const osg::Vec4f& b, const osg::Vec4f& c);
+
+        osg::Vec3f toScreen(const osg::Vec4f& clip) const;
+
+        int mWidth;
+        int mHeight;
+        int mTilesX;
+        int mTilesY;
+        osg::Matrixd mViewProjection;
+        std::vector<float> mDepth;
+        std::vector<float> mTileDepth;
+    };
+
+}
+
+#endif
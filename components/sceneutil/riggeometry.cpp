@@ -6,6 +6,7 @@
 #include <components/resource/scenemanager.hpp>
 #include <osg/MatrixTransform>
 
+#include "deformationqueue.hpp"
 #include "skeleton.hpp"
 #include "util.hpp"
 
@@ -40,6 +41,7 @@ namespace SceneUtil
 RigGeometry::RigGeometry()
     : mSkeleton(nullptr)
     , mLastFrameNumber(0)
+    , mCurrentGeometry(0)
     , mBoundsFirstFrame(true)
 {
     setNumChildrenRequiringUpdateTraversal(1);
@@ -48,21 +50,32 @@ RigGeometry::RigGeometry()
 
 RigGeometry::RigGeometry(const RigGeometry &copy, const osg::CopyOp &copyop)
     : Drawable(copy, copyop)
+    , mWorkQueue(copy.mWorkQueue)
     , mSkeleton(nullptr)
     , mInfluenceMap(copy.mInfluenceMap)
     , mBone2VertexVector(copy.mBone2VertexVector)
     , mBoneSphereVector(copy.mBoneSphereVector)
     , mLastFrameNumber(0)
+    , mCurrentGeometry(0)
     , mBoundsFirstFrame(true)
 {
     setSourceGeometry(copy.mSourceGeometry);
     setNumChildrenRequiringUpdateTraversal(1);
 }
 
+void RigGeometry::setWorkQueue(osg::ref_ptr<WorkQueue> workQueue)
+{
+    mWorkQueue = std::move(workQueue);
+}
+
 void RigGeometry::setSourceGeometry(osg::ref_ptr<osg::Geometry> sourceGeometry)
 {
     for (unsigned int i=0; i<2; ++i)
+    {
+        if (mDeformations[i])
+            mDeformations[i]->wait();
         mGeometry[i] = nullptr;
+    }
 
     mSourceGeometry = sourceGeometry;
 
@@ -83,6 +96,8 @@ void RigGeometry::setSourceGeometry(osg::ref_ptr<osg::Geometry> sourceGeometry)
         to.setCullingActive(false); // make sure to disable culling since that's handled by this class
         to.setComputeBoundingBoxCallback(new CopyBoundingBoxCallback());
         to.setComputeBoundingSphereCallback(new CopyBoundingSphereCallback());
+        mDeformations[i] = new PendingDeformation;
+        to.setDrawCallback(mDeformations[i]);
 
         // vertices and normals are modified every frame, so we need to deep copy them.
         // assign a dedicated VBO to make sure that modifications don't interfere with source geometry's VBO.
@@ -196,28 +211,25 @@ void RigGeometry::cull(osg::NodeVisitor* nv)
     }
 
     unsigned int traversalNumber = nv->getTraversalNumber();
-    if (mLastFrameNumber == traversalNumber || (mLastFrameNumber != 0 && !mSkeleton->getActive()))
+    if (mLastFrameNumber == traversalNumber || (mLastFrameNumber != 0 && (!mSkeleton->getActive() || !mSkeleton->isUpdatedSince(mLastFrameNumber))))
     {
-        osg::Geometry& geom = *getGeometry(mLastFrameNumber);
+        osg::Geometry& geom = *mGeometry[mCurrentGeometry];
         nv->pushOntoNodePath(&geom);
         nv->apply(geom);
         nv->popFromNodePath();
         return;
     }
     mLastFrameNumber = traversalNumber;
-    osg::Geometry& geom = *getGeometry(mLastFrameNumber);
+    // Write to the geometry that was not used last, the previous frame may still be drawing it
+    mCurrentGeometry = 1 - mCurrentGeometry;
+    osg::Geometry& geom = *mGeometry[mCurrentGeometry];
 
     mSkeleton->updateBoneMatrices(traversalNumber);
 
-    // skinning
-    const osg::Vec3Array* positionSrc = static_cast<osg::Vec3Array*>(mSourceGeometry->getVertexArray());
-    const osg::Vec3Array* normalSrc = static_cast<osg::Vec3Array*>(mSourceGeometry->getNormalArray());
-    const osg::Vec4Array* tangentSrc = mSourceTangents;
-
-    osg::Vec3Array* positionDst = static_cast<osg::Vec3Array*>(geom.getVertexArray());
-    osg::Vec3Array* normalDst = static_cast<osg::Vec3Array*>(geom.getNormalArray());
-    osg::Vec4Array* tangentDst = static_cast<osg::Vec4Array*>(geom.getTexCoordArray(7));
-
+    // Compute the matrix of each group of vertices sharing the same bone weights here. Vertices may be transformed on
+    // a worker thread while the next frame is already moving the bones.
+    std::vector<osg::Matrixf> matrices;
+    matrices.reserve(mBone2VertexVector->mData.size());
     int index = mBoneSphereVector->mData.size();
     for (auto &pair : mBone2VertexVector->mData)
     {
@@ -239,20 +251,45 @@ void RigGeometry::cull(osg::NodeVisitor* nv)
         if (mGeomToSkelMatrix)
             resultMat *= (*mGeomToSkelMatrix);
 
-        for (auto &vertex : pair.second)
+        matrices.push_back(resultMat);
+    }
+
+    // skinning
+    osg::ref_ptr<const osg::Vec3Array> positionSrc = static_cast<osg::Vec3Array*>(mSourceGeometry->getVertexArray());
+    osg::ref_ptr<const osg::Vec3Array> normalSrc = static_cast<osg::Vec3Array*>(mSourceGeometry->getNormalArray());
+    osg::ref_ptr<const osg::Vec4Array> tangentSrc = mSourceTangents;
+
+    osg::ref_ptr<osg::Vec3Array> positionDst = static_cast<osg::Vec3Array*>(geom.getVertexArray());
+    osg::ref_ptr<osg::Vec3Array> normalDst = static_cast<osg::Vec3Array*>(geom.getNormalArray());
+    osg::ref_ptr<osg::Vec4Array> tangentDst = static_cast<osg::Vec4Array*>(geom.getTexCoordArray(7));
+
+    mDeformations[mCurrentGeometry]->run(mWorkQueue, [=, influences = osg::ref_ptr<const Bone2VertexVector>(mBone2VertexVector), matrices = std::move(matrices)]
+    {
+        for (std::size_t i = 0; i < matrices.size(); ++i)
         {
-            (*positionDst)[vertex] = resultMat.preMult((*positionSrc)[vertex]);
+            const osg::Matrixf& resultMat = matrices[i];
+            const VertexList& vertices = influences->mData[i].second;
+
+            for (unsigned short vertex : vertices)
+                (*positionDst)[vertex] = resultMat.preMult((*positionSrc)[vertex]);
+
             if (normalDst)
-                (*normalDst)[vertex] = osg::Matrixf::transform3x3((*normalSrc)[vertex], resultMat);
+            {
+                for (unsigned short vertex : vertices)
+                    (*normalDst)[vertex] = osg::Matrixf::transform3x3((*normalSrc)[vertex], resultMat);
+            }
 
             if (tangentDst)
             {
-                const osg::Vec4f& srcTangent = (*tangentSrc)[vertex];
-                osg::Vec3f transformedTangent = osg::Matrixf::transform3x3(osg::Vec3f(srcTangent.x(), srcTangent.y(), srcTangent.z()), resultMat);
-                (*tangentDst)[vertex] = osg::Vec4f(transformedTangent, srcTangent.w());
+                for (unsigned short vertex : vertices)
+                {
+                    const osg::Vec4f& srcTangent = (*tangentSrc)[vertex];
+                    osg::Vec3f transformedTangent = osg::Matrixf::transform3x3(osg::Vec3f(srcTangent.x(), srcTangent.y(), srcTangent.z()), resultMat);
+                    (*tangentDst)[vertex] = osg::Vec4f(transformedTangent, srcTangent.w());
+                }
             }
         }
-    }
+    });
 
     positionDst->dirty();
     if (normalDst)
@@ -402,12 +439,8 @@ void RigGeometry::accept(osg::NodeVisitor &nv)
 
 void RigGeometry::accept(osg::PrimitiveFunctor& func) const
 {
-    getGeometry(mLastFrameNumber)->accept(func);
-}
-
-osg::Geometry* RigGeometry::getGeometry(unsigned int frame) const
-{
-    return mGeometry[frame%2].get();
+    mDeformations[mCurrentGeometry]->wait();
+    mGeometry[mCurrentGeometry]->accept(func);
 }
 
 
@@ -4,6 +4,8 @@
 #include <osg/Geometry>
 #include <osg/Matrixf>
 
+#include "deformationqueue.hpp"
+
 namespace SceneUtil
 {
     class Skeleton;
@@ -21,6 +23,7 @@ namespace SceneUtil
     /// Note though that the RigGeometry ignores any transforms below the Skeleton, so the attachment point is not that important.
     /// @note The internal Geometry used for rendering is double buffered, this allows updates to be done in a thread safe way while
     /// not compromising rendering performance. This is crucial when using osg's default threading model of DrawThreadPerContext.
+    /// @note Vertices may be transformed on a worker thread, see setWorkQueue.
     class RigGeometry : public osg::Drawable
     {
     public:
@@ -47,6 +50,10 @@ namespace SceneUtil
 
         void setInfluenceMap(osg::ref_ptr<InfluenceMap> influenceMap);
 
+        /// Set the work queue to update vertices on, in parallel with the rest of the cull traversal.
+        /// Without a work queue vertices are updated on the cull thread.
+        void setWorkQueue(osg::ref_ptr<WorkQueue> workQueue);
+
         /// Initialize this geometry from the source geometry.
         /// @note The source geometry will not be modified.
         void setSourceGeometry(osg::ref_ptr<osg::Geometry> sourceGeom);
@@ -76,7 +83,8 @@ namespace SceneUtil
         void updateBounds(osg::NodeVisitor* nv);
 
         osg::ref_ptr<osg::Geometry> mGeometry[2];
-        osg::Geometry* getGeometry(unsigned int frame) const;
+        osg::ref_ptr<PendingDeformation> mDeformations[2];
+        osg::ref_ptr<WorkQueue> mWorkQueue;
 
         osg::ref_ptr<osg::Geometry> mSourceGeometry;
         osg::ref_ptr<const osg::Vec4Array> mSourceTangents;
@@ -108,6 +116,7 @@ namespace SceneUtil
         std::vector<Bone*> mBoneNodesVector;
 
         unsigned int mLastFrameNumber;
+        unsigned int mCurrentGeometry;
         bool mBoundsFirstFrame;
 
         bool initFromParentSkeleton(osg::NodeVisitor* nv);
@@ -1,7 +1,10 @@
 #include "serialize.hpp"
 
+#include <osgDB/InputStream>
 #include <osgDB/ObjectWrapper>
+#include <osgDB/OutputStream>
 #include <osgDB/Registry>
+#include <osgDB/Serializer>
 
 #include <components/nifosg/matrixtransform.hpp>
 
@@ -95,12 +98,38 @@ public:
     }
 };
 
+static bool checkRotationScale(const NifOsg::MatrixTransform&)
+{
+    return true;
+}
+
+static bool readRotationScale(osgDB::InputStream& is, NifOsg::MatrixTransform& node)
+{
+    is >> node.mScale;
+    for (int i=0; i<3; ++i)
+        for (int j=0; j<3; ++j)
+            is >> node.mRotationScale.mValues[i][j];
+    return true;
+}
+
+static bool writeRotationScale(osgDB::OutputStream& os, const NifOsg::MatrixTransform& node)
+{
+    os << node.mScale;
+    for (int i=0; i<3; ++i)
+        for (int j=0; j<3; ++j)
+            os << node.mRotationScale.mValues[i][j];
+    os << std::endl;
+    return true;
+}
+
 class MatrixTransformSerializer : public osgDB::ObjectWrapper
 {
 public:
     MatrixTransformSerializer()
         : osgDB::ObjectWrapper(createInstanceFunc<NifOsg::MatrixTransform>, "NifOsg::MatrixTransform", "osg::Object osg::Node osg::Group osg::Transform osg::MatrixTransform NifOsg::MatrixTransform")
     {
+        addSerializer( new osgDB::UserSerializer<NifOsg::MatrixTransform>(
+            "RotationScale", &checkRotationScale, &readRotationScale, &writeRotationScale), osgDB::BaseSerializer::RW_USER );
     }
 };
 
@@ -118,6 +147,25 @@ public:
     }
 };
 
+static bool sDebugSerializers = false;
+
+void registerLosslessSerializers()
+{
+    static bool done = false;
+    if (!done)
+    {
+        osgDB::ObjectWrapperManager* mgr = osgDB::Registry::instance()->getObjectWrapperManager();
+        mgr->addWrapper(new MatrixTransformSerializer);
+
+        done = true;
+    }
+}
+
+bool hasDebugSerializers()
+{
+    return sDebugSerializers;
+}
+
 void registerSerializers()
 {
     static bool done = false;
@@ -132,7 +180,7 @@ void registerSerializers()
         mgr->addWrapper(new MorphGeometrySerializer);
         mgr->addWrapper(new LightManagerSerializer);
         mgr->addWrapper(new CameraRelativeTransformSerializer);
-        mgr->addWrapper(new MatrixTransformSerializer);
+        registerLosslessSerializers();
 
         // Don't serialize Geometry data as we are more interested in the overall structure rather than tons of vertex data that would make the file large and hard to read.
         mgr->removeWrapper(mgr->findWrapper("osg::Geometry"));
@@ -181,6 +229,7 @@ void registerSerializers()
             mgr->addWrapper(makeDummySerializer(ignore[i]));
         }
 
+        sDebugSerializers = true;
 
         done = true;
     }
@@ -7,6 +7,12 @@ namespace SceneUtil
     /// Register osg node serializers for certain SceneUtil classes if not already done so
     void registerSerializers();
 
+    /// Register osg node serializers required to write and read back scenes without losing data, e.g. NifOsg::MatrixTransform
+    void registerLosslessSerializers();
+
+    /// @return true if registerSerializers() has been called. Its serializers skip geometry data, so scenes written afterwards can not be read back faithfully.
+    bool hasDebugSerializers();
+
 }
 
 #endif
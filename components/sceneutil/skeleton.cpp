@@ -1,6 +1,10 @@
 #include "skeleton.hpp"
 
 #include <osg/MatrixTransform>
+#include <osgUtil/CullVisitor>
+
+#include <algorithm>
+#include <atomic>
 
 #include <components/debug/debuglog.hpp>
 #include <components/misc/stringops.hpp>
@@ -31,12 +35,26 @@ private:
     std::unordered_map<std::string, TransformPath>& mCache;
 };
 
+namespace
+{
+    unsigned int nextUpdatePhase()
+    {
+        static std::atomic<unsigned int> counter{0};
+        return counter++;
+    }
+}
+
 Skeleton::Skeleton()
     : mBoneCacheInit(false)
     , mNeedToUpdateBoneMatrices(true)
     , mActive(Active)
     , mLastFrameNumber(0)
     , mLastCullFrameNumber(0)
+    , mLastUpdateFrameNumber(0)
+    , mFullRatePixelSize(0.f)
+    , mMaxUpdateInterval(1)
+    , mUpdatePhase(nextUpdatePhase())
+    , mPixelSize(0.f)
 {
 
 }
@@ -48,6 +66,11 @@ Skeleton::Skeleton(const Skeleton &copy, const osg::CopyOp &copyop)
     , mActive(copy.mActive)
     , mLastFrameNumber(0)
     , mLastCullFrameNumber(0)
+    , mLastUpdateFrameNumber(0)
+    , mFullRatePixelSize(copy.mFullRatePixelSize)
+    , mMaxUpdateInterval(copy.mMaxUpdateInterval)
+    , mUpdatePhase(nextUpdatePhase())
+    , mPixelSize(0.f)
 {
 
 }
@@ -128,9 +151,34 @@ bool Skeleton::getActive() const
     return mActive != Inactive;
 }
 
+void Skeleton::setUpdateLod(float fullRatePixelSize, unsigned int maxInterval)
+{
+    mFullRatePixelSize = fullRatePixelSize;
+    mMaxUpdateInterval = std::max(maxInterval, 1u);
+}
+
+bool Skeleton::isUpdatedSince(unsigned int traversalNumber) const
+{
+    return mLastUpdateFrameNumber == 0 || mLastUpdateFrameNumber > traversalNumber;
+}
+
+bool Skeleton::skipUpdate(unsigned int traversalNumber) const
+{
+    if (mMaxUpdateInterval <= 1 || mPixelSize >= mFullRatePixelSize || mLastUpdateFrameNumber == 0)
+        return false;
+
+    // The update interval grows as the skeleton shrinks on screen
+    unsigned int interval = mMaxUpdateInterval;
+    if (mPixelSize > 0.f)
+        interval = std::min(interval, static_cast<unsigned int>(mFullRatePixelSize / mPixelSize) + 1);
+
+    return (traversalNumber + mUpdatePhase) % interval != 0 && traversalNumber - mLastUpdateFrameNumber < interval;
+}
+
 void Skeleton::markDirty()
 {
     mLastFrameNumber = 0;
+    mLastUpdateFrameNumber = 0;
     mBoneCache.clear();
     mBoneCacheInit = false;
 }
@@ -143,9 +191,23 @@ void Skeleton::traverse(osg::NodeVisitor& nv)
             return;
         if (mActive == SemiActive && mLastFrameNumber != 0 && mLastCullFrameNumber+3 <= nv.getTraversalNumber())
             return;
+        if (skipUpdate(nv.getTraversalNumber()))
+            return;
+        mLastUpdateFrameNumber = nv.getTraversalNumber();
     }
     else if (nv.getVisitorType() == osg::NodeVisitor::CULL_VISITOR)
+    {
+        if (mMaxUpdateInterval > 1)
+        {
+            // Use the largest size among all views of this frame, e.g. both eyes or the main and the reflection camera
+            const float pixelSize = static_cast<osgUtil::CullVisitor&>(nv).clampedPixelSize(getBound());
+            if (mLastCullFrameNumber != nv.getTraversalNumber())
+                mPixelSize = pixelSize;
+            else
+                mPixelSize = std::max(mPixelSize, pixelSize);
+        }
         mLastCullFrameNumber = nv.getTraversalNumber();
+    }
 
     osg::Group::traverse(nv);
 }
@@ -61,6 +61,15 @@ namespace SceneUtil
 
         bool getActive() const;
 
+        /// Throttle bone updates of skeletons that cover a small part of the screen. Skeletons with a projected size of
+        /// at least @a fullRatePixelSize pixels are updated every frame, smaller ones are updated less often, but at least
+        /// once every @a maxInterval frames. Updates of different skeletons are spread over frames.
+        /// @note A @a maxInterval of 1 disables throttling.
+        void setUpdateLod(float fullRatePixelSize, unsigned int maxInterval);
+
+        /// Return true if bones may have moved since the cull traversal of the given frame, i.e. if skinning done in that frame is outdated.
+        bool isUpdatedSince(unsigned int traversalNumber) const;
+
         void traverse(osg::NodeVisitor& nv) override;
 
         void markDirty();
@@ -83,6 +92,14 @@ namespace SceneUtil
 
         unsigned int mLastFrameNumber;
         unsigned int mLastCullFrameNumber;
+        unsigned int mLastUpdateFrameNumber;
+
+        float mFullRatePixelSize;
+        unsigned int mMaxUpdateInterval;
+        unsigned int mUpdatePhase;
+        float mPixelSize;
+
+        bool skipUpdate(unsigned int traversalNumber) const;
     };
 
 }
@@ -0,0 +1,179 @@
+#include "compileprograms.hpp"
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+#include <vector>
+
+#include <osg/GLExtensions>
+#include <osg/State>
+#include <osg/Timer>
+
+#include <components/debug/debuglog.hpp>
+#include <components/files/hash.hpp>
+#include <components/files/memorystream.hpp>
+
+namespace Shader
+{
+    namespace
+    {
+        // Keep the loading screen responsive while compiling
+        constexpr double sTimeSlice = 50.0;
+
+        std::string getString(GLenum name)
+        {
+            const GLubyte* value = glGetString(name);
+            return value != nullptr ? reinterpret_cast<const char*>(value) : std::string();
+        }
+
+        std::string getBinaryFileName(const osg::Program& program, const std::string& driver)
+        {
+            std::string key = driver;
+            for (unsigned int i = 0; i < program.getNumShaders(); ++i)
+            {
+                const osg::Shader* shader = program.getShader(i);
+                key += '\0';
+                key += std::to_string(shader->getType());
+                key += '\0';
+                key += shader->getShaderSource();
+            }
+            for (const auto& [name, index] : program.getAttribBindingList())
+            {
+                key += '\0';
+                key += name;
+                key += '=';
+                key += std::to_string(index);
+            }
+            for (const auto& [name, index] : program.getUniformBlockBindingList())
+            {
+                key += '\0';
+                key += name;
+                key += '=';
+                key += std::to_string(index);
+            }
+
+            Files::IMemStream stream(key.data(), key.size());
+            const std::array<std::uint64_t, 2> hash = Files::getHash(program.getName(), stream);
+
+            std::ostringstream fileName;
+            fileName << std::hex << std::setfill('0') << std::setw(16) << hash[0] << std::setw(16) << hash[1] << ".bin";
+            return fileName.str();
+        }
+
+        osg::ref_ptr<osg::ProgramBinary> readProgramBinary(const std::filesystem::path& path)
+        {
+            std::ifstream stream(path, std::ios::binary);
+            if (!stream)
+                return nullptr;
+
+            std::uint32_t format = 0;
+            if (!stream.read(reinterpret_cast<char*>(&format), sizeof(format)))
+                return nullptr;
+            const std::vector<char> data((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+            if (data.empty())
+                return nullptr;
+
+            osg::ref_ptr<osg::ProgramBinary> binary = new osg::ProgramBinary;
+            binary->assign(static_cast<unsigned int>(data.size()), reinterpret_cast<const unsigned char*>(data.data()));
+            binary->setFormat(static_cast<GLenum>(format));
+            return binary;
+        }
+
+        void writeProgramBinary(const std::filesystem::path& path, const osg::ProgramBinary& binary)
+        {
+            // Write to a temporary file first so an interrupted write never leaves a truncated binary behind
+            std::filesystem::path tmpPath = path;
+            tmpPath += ".tmp";
+            {
+                std::ofstream stream(tmpPath, std::ios::binary);
+                const std::uint32_t format = binary.getFormat();
+                stream.write(reinterpret_cast<const char*>(&format), sizeof(format));
+                stream.write(reinterpret_cast<const char*>(binary.getData()), binary.getSize());
+                if (!stream)
+                {
+                    Log(Debug::Warning) << "Failed to write program binary " << tmpPath;
+                    return;
+                }
+            }
+
+            std::error_code ec;
+            std::filesystem::rename(tmpPath, path, ec);
+            if (ec)
+                Log(Debug::Warning) << "Failed to write program binary " << path << ": " << ec.message();
+        }
+    }
+
+    CompileProgramsOperation::CompileProgramsOperation(std::vector<osg::ref_ptr<osg::Program>>&& programs, const std::string& binaryPath)
+        : osg::GraphicsOperation("CompileProgramsOperation", true)
+        , mPrograms(std::move(programs))
+        , mBinaryPath(binaryPath)
+        , mNumCompiled(0)
+    {
+    }
+
+    void CompileProgramsOperation::operator()(osg::GraphicsContext* context)
+    {
+        std::size_t index = mNumCompiled;
+        if (index == mPrograms.size())
+        {
+            setKeep(false);
+            return;
+        }
+
+        osg::State& state = *context->getState();
+        const osg::GLExtensions* extensions = state.get<osg::GLExtensions>();
+        const bool useBinaries = !mBinaryPath.empty() && extensions->isGetProgramBinarySupported;
+        if (useBinaries && mDriver.empty())
+            mDriver = getString(GL_VENDOR) + '\0' + getString(GL_RENDERER) + '\0' + getString(GL_VERSION);
+
+        const osg::Timer* timer = osg::Timer::instance();
+        const osg::Timer_t start = timer->tick();
+        while (index < mPrograms.size() && timer->delta_m(start, timer->tick()) < sTimeSlice)
+        {
+            compile(*mPrograms[index], state, useBinaries);
+            mNumCompiled = ++index;
+        }
+    }
+
+    void CompileProgramsOperation::compile(osg::Program& program, osg::State& state, bool useBinaries)
+    {
+        std::filesystem::path binaryPath;
+        if (useBinaries)
+        {
+            binaryPath = std::filesystem::path(mBinaryPath) / getBinaryFileName(program, mDriver);
+            program.setProgramBinary(readProgramBinary(binaryPath));
+        }
+
+        program.compileGLObjects(state);
+        if (!useBinaries)
+            return;
+
+        if (program.getProgramBinary() != nullptr)
+        {
+            if (program.getPCP(state)->isLinked())
+            {
+                // Later relinks, e.g. after ShaderManager::setGlobalDefines, have to use the new sources
+                program.setProgramBinary(nullptr);
+                return;
+            }
+
+            Log(Debug::Verbose) << "Program binary " << binaryPath << " was rejected by the driver, compiling from source";
+            program.setProgramBinary(nullptr);
+            program.releaseGLObjects(&state);
+            program.compileGLObjects(state);
+        }
+
+        osg::Program::PerContextProgram* pcp = program.getPCP(state);
+        if (!pcp->isLinked())
+            return;
+
+        osg::ref_ptr<osg::ProgramBinary> binary = pcp->compileProgramBinary(state);
+        if (binary != nullptr && binary->getSize() > 0)
+            writeProgramBinary(binaryPath, *binary);
+    }
+
+}
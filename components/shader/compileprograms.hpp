@@ -0,0 +1,40 @@
+#ifndef OPENMW_COMPONENTS_SHADER_COMPILEPROGRAMS_H
+#define OPENMW_COMPONENTS_SHADER_COMPILEPROGRAMS_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <osg/GraphicsThread>
+#include <osg/Program>
+
+namespace Shader
+{
+
+    /// @brief Compiles and links programs on a graphics context, a few of them per frame.
+    /// @par Program binaries are loaded from and stored in a cache directory. They are keyed by the driver and
+    /// the sources and bindings of a program, and recompiled from source if the driver rejects them.
+    class CompileProgramsOperation : public osg::GraphicsOperation
+    {
+    public:
+        /// @param binaryPath Directory of the cached program binaries, empty to disable them.
+        CompileProgramsOperation(std::vector<osg::ref_ptr<osg::Program>>&& programs, const std::string& binaryPath);
+
+        void operator()(osg::GraphicsContext* context) override;
+
+        std::size_t getNumPrograms() const { return mPrograms.size(); }
+        std::size_t getNumCompiled() const { return mNumCompiled; }
+        bool isDone() const { return mNumCompiled == mPrograms.size(); }
+
+    private:
+        void compile(osg::Program& program, osg::State& state, bool useBinaries);
+
+        std::vector<osg::ref_ptr<osg::Program>> mPrograms;
+        std::string mBinaryPath;
+        std::string mDriver;
+        std::atomic<std::size_t> mNumCompiled;
+    };
+
+}
+
+#endif
@@ -4,6 +4,7 @@
 #include <algorithm>
 #include <sstream>
 #include <regex>
+#include <tuple>
 
 #include <osg/Program>
 
@@ -14,8 +15,90 @@
 #include <components/misc/stringops.hpp>
 #include <components/settings/settings.hpp>
 
+#include "compileprograms.hpp"
+
 namespace Shader
 {
+    namespace
+    {
+        const char* const sRecordedProgramsFile = "programs.txt";
+        const char* const sProgramBinariesDirectory = "binaries";
+        // Programs recorded in older sessions are dropped beyond this number, so the file doesn't grow without bound
+        constexpr std::size_t sMaxRecordedPrograms = 2048;
+
+        // One line per shader and define, the rest of a define's line is its value
+        bool writeRecordedShader(std::ostream& stream, const char* type, const std::string& templateName, const ShaderManager::DefineMap& defines)
+        {
+            stream << type << ' ' << templateName << '\n';
+            for (const auto& [name, value] : defines)
+            {
+                if (value.find('\n') != std::string::npos)
+                    return false;
+                stream << "define " << name << ' ' << value << '\n';
+            }
+            return true;
+        }
+
+        struct RecordedProgram
+        {
+            std::string mVertexTemplate;
+            ShaderManager::DefineMap mVertexDefines;
+            std::string mFragmentTemplate;
+            ShaderManager::DefineMap mFragmentDefines;
+        };
+
+        bool parseRecordedProgram(const std::string& text, RecordedProgram& program)
+        {
+            std::istringstream stream(text);
+            std::string line;
+            ShaderManager::DefineMap* defines = nullptr;
+            while (std::getline(stream, line))
+            {
+                const std::size_t separator = line.find(' ');
+                const std::string type = line.substr(0, separator);
+                const std::string rest = separator == std::string::npos ? std::string() : line.substr(separator + 1);
+                if (type == "program")
+                    continue;
+                else if (type == "vertex")
+                {
+                    program.mVertexTemplate = rest;
+                    defines = &program.mVertexDefines;
+                }
+                else if (type == "fragment")
+                {
+                    program.mFragmentTemplate = rest;
+                    defines = &program.mFragmentDefines;
+                }
+                else if (type == "define" && defines != nullptr)
+                {
+                    const std::size_t nameEnd = rest.find(' ');
+                    if (nameEnd == std::string::npos)
+                        return false;
+                    (*defines)[rest.substr(0, nameEnd)] = rest.substr(nameEnd + 1);
+                }
+                else
+                    return false;
+            }
+            return !program.mVertexTemplate.empty() && !program.mFragmentTemplate.empty();
+        }
+    }
+
+    ShaderManager::ShaderKey::ShaderKey(const std::string& templateName, const DefineMap& defines)
+    {
+        std::size_t size = templateName.size();
+        for (const auto& [name, value] : defines)
+            size += name.size() + value.size() + 2;
+        mKey.reserve(size);
+        mKey += templateName;
+        for (const auto& [name, value] : defines)
+        {
+            mKey += '\0';
+            mKey += name;
+            mKey += '\0';
+            mKey += value;
+        }
+        mHash = std::hash<std::string>()(mKey);
+    }
 
     ShaderManager::ShaderManager()
     {
@@ -386,7 +469,8 @@ namespace Shader
             templateIt = mShaderTemplates.insert(std::make_pair(templateName, source)).first;
         }
 
-        ShaderMap::iterator shaderIt = mShaders.find(std::make_pair(templateName, defines));
+        ShaderKey key(templateName, defines);
+        ShaderMap::iterator shaderIt = mShaders.find(key);
         if (shaderIt == mShaders.end())
         {
             std::string shaderSource = templateIt->second;
@@ -394,7 +478,7 @@ namespace Shader
             if (!createSourceFromTemplate(shaderSource, linkedShaderNames, templateName, defines))
             {
                 // Add to the cache anyway to avoid logging the same error over and over.
-                mShaders.insert(std::make_pair(std::make_pair(templateName, defines), nullptr));
+                mShaders.emplace(std::move(key), ShaderEntry {templateName, defines, nullptr});
                 return nullptr;
             }
 
@@ -409,9 +493,12 @@ namespace Shader
             getLinkedShaders(shader, linkedShaderNames, defines);
             lock.lock();
 
-            shaderIt = mShaders.insert(std::make_pair(std::make_pair(templateName, defines), shader)).first;
+            bool inserted;
+            std::tie(shaderIt, inserted) = mShaders.emplace(std::move(key), ShaderEntry {templateName, defines, shader});
+            if (inserted)
+                mShaderEntries.emplace(shader.get(), &shaderIt->second);
         }
-        return shaderIt->second;
+        return shaderIt->second.mShader;
     }
 
     osg::ref_ptr<osg::Program> ShaderManager::getProgram(osg::ref_ptr<osg::Shader> vertexShader, osg::ref_ptr<osg::Shader> fragmentShader, const osg::Program* programTemplate)
@@ -428,6 +515,10 @@ namespace Shader
             addLinkedShaders(fragmentShader, program);
 
             found = mPrograms.insert(std::make_pair(std::make_pair(vertexShader, fragmentShader), program)).first;
+
+            // Programs with a custom template can't be recreated from their shaders alone
+            if (!mCachePath.empty() && programTemplate == mProgramTemplate)
+                recordProgram(vertexShader, fragmentShader);
         }
         return found->second;
     }
@@ -448,10 +539,11 @@ namespace Shader
     void ShaderManager::setGlobalDefines(DefineMap & globalDefines)
     {
         mGlobalDefines = globalDefines;
-        for (const auto& [key, shader]: mShaders)
+        for (const auto& [key, entry]: mShaders)
         {
-            std::string templateId = key.first;
-            ShaderManager::DefineMap defines = key.second;
+            const std::string& templateId = entry.mTemplateName;
+            const ShaderManager::DefineMap& defines = entry.mDefines;
+            const osg::ref_ptr<osg::Shader>& shader = entry.mShader;
             if (shader == nullptr)
                 // I'm not sure how to handle a shader that was already broken as there's no way to get a potential replacement to the nodes that need it.
                 continue;
@@ -470,10 +562,10 @@ namespace Shader
     void ShaderManager::releaseGLObjects(osg::State *state)
     {
         std::lock_guard<std::mutex> lock(mMutex);
-        for (const auto& [_, shader] : mShaders)
+        for (const auto& [_, entry] : mShaders)
         {
-            if (shader != nullptr)
-                shader->releaseGLObjects(state);
+            if (entry.mShader != nullptr)
+                entry.mShader->releaseGLObjects(state);
         }
         for (const auto& [_, program] : mPrograms)
             program->releaseGLObjects(state);
@@ -537,4 +629,129 @@ namespace Shader
         return unit;
     }
 
+    void ShaderManager::setCachePath(const std::string& path)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        std::error_code ec;
+        std::filesystem::create_directories(std::filesystem::path(path) / sProgramBinariesDirectory, ec);
+        if (ec)
+        {
+            Log(Debug::Warning) << "Failed to create shader cache directory " << path << ": " << ec.message() << ", shader cache is disabled";
+            mCachePath.clear();
+            return;
+        }
+        mCachePath = path;
+
+        // New programs are appended to the file, so the first ones are the oldest
+        std::vector<std::string> programs;
+        {
+            std::ifstream stream(std::filesystem::path(path) / sRecordedProgramsFile);
+            std::string line;
+            std::string program;
+            while (std::getline(stream, line))
+            {
+                if (line == "program" && !program.empty())
+                {
+                    programs.push_back(std::move(program));
+                    program.clear();
+                }
+                program += line;
+                program += '\n';
+            }
+            if (!program.empty())
+                programs.push_back(std::move(program));
+        }
+
+        if (programs.size() > sMaxRecordedPrograms)
+        {
+            programs.erase(programs.begin(), programs.end() - sMaxRecordedPrograms);
+            std::ofstream stream(std::filesystem::path(path) / sRecordedProgramsFile, std::ios::trunc);
+            for (const std::string& program : programs)
+                stream << program;
+        }
+
+        mRecordedPrograms.clear();
+        mRecordedProgramSet.clear();
+        for (std::string& program : programs)
+        {
+            if (mRecordedProgramSet.insert(program).second)
+                mRecordedPrograms.push_back(std::move(program));
+        }
+    }
+
+    void ShaderManager::recordProgram(const osg::Shader* vertexShader, const osg::Shader* fragmentShader)
+    {
+        const auto vertexEntry = mShaderEntries.find(vertexShader);
+        const auto fragmentEntry = mShaderEntries.find(fragmentShader);
+        if (vertexEntry == mShaderEntries.end() || fragmentEntry == mShaderEntries.end())
+            return;
+
+        std::ostringstream program;
+        program << "program\n";
+        if (!writeRecordedShader(program, "vertex", vertexEntry->second->mTemplateName, vertexEntry->second->mDefines)
+            || !writeRecordedShader(program, "fragment", fragmentEntry->second->mTemplateName, fragmentEntry->second->mDefines))
+            return;
+
+        if (!mRecordedProgramSet.insert(program.str()).second)
+            return;
+        mRecordedPrograms.push_back(program.str());
+
+        std::ofstream stream(std::filesystem::path(mCachePath) / sRecordedProgramsFile, std::ios::app);
+        stream << program.str();
+        if (!stream)
+            Log(Debug::Warning) << "Failed to record shader program in " << mCachePath;
+    }
+
+    osg::ref_ptr<CompileProgramsOperation> ShaderManager::createRecordedPrograms()
+    {
+        std::vector<std::string> recordedPrograms;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            recordedPrograms = mRecordedPrograms;
+        }
+
+        if (recordedPrograms.empty())
+            return nullptr;
+
+        std::vector<osg::ref_ptr<osg::Program>> programs;
+        std::unordered_set<std::string> invalidPrograms;
+        for (const std::string& text : recordedPrograms)
+        {
+            RecordedProgram recorded;
+            osg::ref_ptr<osg::Shader> vertexShader;
+            osg::ref_ptr<osg::Shader> fragmentShader;
+            if (parseRecordedProgram(text, recorded))
+            {
+                vertexShader = getShader(recorded.mVertexTemplate, recorded.mVertexDefines, osg::Shader::VERTEX);
+                fragmentShader = getShader(recorded.mFragmentTemplate, recorded.mFragmentDefines, osg::Shader::FRAGMENT);
+            }
+            if (vertexShader == nullptr || fragmentShader == nullptr)
+                invalidPrograms.insert(text);
+            else
+                programs.push_back(getProgram(vertexShader, fragmentShader));
+        }
+
+        Log(Debug::Info) << "Precompiling " << programs.size() << " of " << recordedPrograms.size() << " recorded shader programs";
+
+        if (!invalidPrograms.empty())
+        {
+            // Forget the programs that can't be created anymore, e.g. after the shader files changed
+            std::lock_guard<std::mutex> lock(mMutex);
+            for (const std::string& text : invalidPrograms)
+                mRecordedProgramSet.erase(text);
+            mRecordedPrograms.erase(std::remove_if(mRecordedPrograms.begin(), mRecordedPrograms.end(),
+                [&] (const std::string& text) { return invalidPrograms.count(text) != 0; }), mRecordedPrograms.end());
+            // Keep the recording order, so the oldest programs are still the first to go
+            std::ofstream stream(std::filesystem::path(mCachePath) / sRecordedProgramsFile, std::ios::trunc);
+            for (const std::string& text : mRecordedPrograms)
+                stream << text;
+        }
+
+        if (programs.empty())
+            return nullptr;
+
+        return new CompileProgramsOperation(std::move(programs), (std::filesystem::path(mCachePath) / sProgramBinariesDirectory).string());
+    }
+
 }
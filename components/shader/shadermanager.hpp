@@ -4,6 +4,9 @@
 #include <string>
 #include <map>
 #include <mutex>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <array>
 
@@ -14,6 +17,7 @@
 
 namespace Shader
 {
+    class CompileProgramsOperation;
 
     /// @brief Reads shader template files and turns them into a concrete shader, based on a list of define's.
     /// @par Shader templates can get the value of a define with the syntax @define.
@@ -67,6 +71,15 @@ namespace Shader
 
         int reserveGlobalTextureUnits(Slot slot);
 
+        /// Record the shader permutations of the programs created from now on in the given directory, and cache program binaries there.
+        /// @note Loads the permutations recorded in previous sessions, see createRecordedPrograms().
+        void setCachePath(const std::string& path);
+
+        /// Create the programs recorded in previous sessions, so their permutations don't need to be created during gameplay.
+        /// @return Operation compiling the programs on a graphics context, or nullptr if no programs were recorded.
+        /// @note Call once the global defines and the program template are set up.
+        osg::ref_ptr<CompileProgramsOperation> createRecordedPrograms();
+
     private:
         void getLinkedShaders(osg::ref_ptr<osg::Shader> shader, const std::vector<std::string>& linkedShaderNames, const DefineMap& defines);
         void addLinkedShaders(osg::ref_ptr<osg::Shader> shader, osg::ref_ptr<osg::Program> program);
@@ -79,10 +92,34 @@ namespace Shader
         typedef std::map<std::string, std::string> TemplateMap;
         TemplateMap mShaderTemplates;
 
-        typedef std::pair<std::string, DefineMap> MapKey;
-        typedef std::map<MapKey, osg::ref_ptr<osg::Shader> > ShaderMap;
+        /// Template name and defines flattened into a single string, hashed once so a lookup rarely compares the whole key.
+        struct ShaderKey
+        {
+            ShaderKey(const std::string& templateName, const DefineMap& defines);
+
+            bool operator==(const ShaderKey& other) const { return mHash == other.mHash && mKey == other.mKey; }
+
+            std::string mKey;
+            std::size_t mHash;
+        };
+
+        struct ShaderKeyHash
+        {
+            std::size_t operator()(const ShaderKey& key) const { return key.mHash; }
+        };
+
+        struct ShaderEntry
+        {
+            std::string mTemplateName;
+            DefineMap mDefines;
+            osg::ref_ptr<osg::Shader> mShader;
+        };
+
+        typedef std::unordered_map<ShaderKey, ShaderEntry, ShaderKeyHash> ShaderMap;
         ShaderMap mShaders;
 
+        std::map<const osg::Shader*, const ShaderEntry*> mShaderEntries;
+
         typedef std::map<std::pair<osg::ref_ptr<osg::Shader>, osg::ref_ptr<osg::Shader> >, osg::ref_ptr<osg::Program> > ProgramMap;
         ProgramMap mPrograms;
 
@@ -92,6 +129,13 @@ namespace Shader
 
         std::mutex mMutex;
 
+        void recordProgram(const osg::Shader* vertexShader, const osg::Shader* fragmentShader);
+
+        std::string mCachePath;
+        /// In the order they were recorded, so the oldest can be dropped first
+        std::vector<std::string> mRecordedPrograms;
+        std::unordered_set<std::string> mRecordedProgramSet;
+
         osg::ref_ptr<const osg::Program> mProgramTemplate;
 
         int mMaxTextureUnits = 0;
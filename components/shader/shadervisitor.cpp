@@ -358,7 +358,7 @@ namespace Shader
                 Misc::StringUtils::replaceLast(normalHeightMap, ".", mNormalHeightMapPattern + ".");
                 if (mImageManager.getVFS()->exists(normalHeightMap))
                 {
-                    image = mImageManager.getImage(normalHeightMap);
+                    image = mImageManager.getImage(normalHeightMap, false, true);
                     normalHeight = true;
                 }
                 else
@@ -366,7 +366,7 @@ namespace Shader
                     Misc::StringUtils::replaceLast(normalMapFileName, ".", mNormalMapPattern + ".");
                     if (mImageManager.getVFS()->exists(normalMapFileName))
                     {
-                        image = mImageManager.getImage(normalMapFileName);
+                        image = mImageManager.getImage(normalMapFileName, false, true);
                     }
                 }
                 // Avoid using the auto-detected normal map if it's already being used as a bump map.
@@ -400,7 +400,7 @@ namespace Shader
                 Misc::StringUtils::replaceLast(specularMapFileName, ".", mSpecularMapPattern + ".");
                 if (mImageManager.getVFS()->exists(specularMapFileName))
                 {
-                    osg::ref_ptr<osg::Image> image (mImageManager.getImage(specularMapFileName));
+                    osg::ref_ptr<osg::Image> image (mImageManager.getImage(specularMapFileName, false, true));
                     osg::ref_ptr<osg::Texture2D> specularMapTex (new osg::Texture2D(image));
                     specularMapTex->setTextureSize(image->s(), image->t());
                     specularMapTex->setWrap(osg::Texture::WRAP_S, diffuseMap->getWrap(osg::Texture::WRAP_S));
@@ -205,6 +205,34 @@ namespace Terrain
         return uvs;
     }
 
+    osg::ref_ptr<osg::Vec2Array> BufferCache::getVertexGridBuffer(unsigned int numVerts, float size)
+    {
+        const std::pair<unsigned int, float> id(numVerts, size);
+        std::lock_guard<std::mutex> lock(mVertexGridBufferMutex);
+        auto found = mVertexGridBufferMap.find(id);
+        if (found != mVertexGridBufferMap.end())
+            return found->second;
+
+        osg::ref_ptr<osg::Vec2Array> vertices (new osg::Vec2Array(osg::Array::BIND_PER_VERTEX));
+        vertices->reserve(numVerts * numVerts);
+
+        // Same layout and positions as Storage::fillVertexBuffers
+        for (unsigned int vertX = 0; vertX < numVerts; ++vertX)
+        {
+            for (unsigned int vertY = 0; vertY < numVerts; ++vertY)
+            {
+                vertices->push_back(osg::Vec2f((vertX / float(numVerts - 1) - 0.5f) * size,
+                                               (vertY / float(numVerts - 1) - 0.5f) * size));
+            }
+        }
+
+        // Assign a VBO here to enable state sharing between different Geometries.
+        vertices->setVertexBufferObject(new osg::VertexBufferObject);
+
+        mVertexGridBufferMap.emplace(id, vertices);
+        return vertices;
+    }
+
     osg::ref_ptr<osg::DrawElements> BufferCache::getIndexBuffer(unsigned int numVerts, unsigned int flags)
     {
         std::pair<int, int> id = std::make_pair(numVerts, flags);
@@ -239,6 +267,10 @@ namespace Terrain
             std::lock_guard<std::mutex> lock(mUvBufferMutex);
             mUvBufferMap.clear();
         }
+        {
+            std::lock_guard<std::mutex> lock(mVertexGridBufferMutex);
+            mVertexGridBufferMap.clear();
+        }
     }
 
     void BufferCache::releaseGLObjects(osg::State *state)
@@ -253,6 +285,11 @@ namespace Terrain
             for (const auto& [_, uvbuffer] : mUvBufferMap)
                 uvbuffer->releaseGLObjects(state);
         }
+        {
+            std::lock_guard<std::mutex> lock(mVertexGridBufferMutex);
+            for (const auto& [_, vertexGridBuffer] : mVertexGridBufferMap)
+                vertexGridBuffer->releaseGLObjects(state);
+        }
     }
 
 }
@@ -23,6 +23,11 @@ namespace Terrain
         /// @note Thread safe.
         osg::ref_ptr<osg::Vec2Array> getUVBuffer(unsigned int numVerts);
 
+        /// Get the horizontal positions of the vertices of a chunk with compact vertices, centered on the chunk origin.
+        /// @param size Width of the chunk in world units.
+        /// @note Thread safe.
+        osg::ref_ptr<osg::Vec2Array> getVertexGridBuffer(unsigned int numVerts, float size);
+
         void clearCache();
 
         void releaseGLObjects(osg::State* state);
@@ -35,6 +40,9 @@ namespace Terrain
 
         std::map<int, osg::ref_ptr<osg::Vec2Array> > mUvBufferMap;
         std::mutex mUvBufferMutex;
+
+        std::map<std::pair<unsigned int, float>, osg::ref_ptr<osg::Vec2Array> > mVertexGridBufferMap;
+        std::mutex mVertexGridBufferMutex;
     };
 
 }
@@ -1,9 +1,15 @@
 #include "chunkmanager.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <sstream>
 
+#include <osg/ClusterCullingCallback>
+#include <osg/Image>
 #include <osg/Texture2D>
 #include <osg/Material>
+#include <osg/Uniform>
 
 #include <osgUtil/IncrementalCompileOperation>
 
@@ -17,10 +23,52 @@
 #include "storage.hpp"
 #include "texturemanager.hpp"
 #include "compositemaprenderer.hpp"
+#include "defs.hpp"
 
 namespace Terrain
 {
 
+namespace
+{
+    /// Chunks with compact vertices only have the horizontal positions in their vertex array
+    class FixedBoundingBoxCallback : public osg::Drawable::ComputeBoundingBoxCallback
+    {
+    public:
+        FixedBoundingBoxCallback(const osg::BoundingBox& boundingBox)
+            : mBoundingBox(boundingBox)
+        {
+        }
+
+        osg::BoundingBox computeBound(const osg::Drawable&) const override { return mBoundingBox; }
+
+    private:
+        osg::BoundingBox mBoundingBox;
+    };
+
+    // World units per step of the quantized heights of compact vertices. All chunks round heights to the same steps,
+    // so the vertices on the border of two chunks decode to the same height on both sides.
+    constexpr float sCompactHeightStep = 0.5f;
+
+    unsigned char quantize8(float value)
+    {
+        return static_cast<unsigned char>(std::clamp(std::lround((value * 0.5f + 0.5f) * 255.f), 0L, 255L));
+    }
+
+    // Octahedral encoding, decoded by decodeNormal in terrain_vertex.glsl
+    void encodeNormal(const osg::Vec3f& normal, unsigned char& x, unsigned char& y)
+    {
+        const float sum = std::abs(normal.x()) + std::abs(normal.y()) + std::abs(normal.z());
+        osg::Vec2f encoded = sum > 0.f ? osg::Vec2f(normal.x() / sum, normal.y() / sum) : osg::Vec2f();
+        if (normal.z() < 0.f)
+        {
+            encoded = osg::Vec2f((1.f - std::abs(encoded.y())) * (encoded.x() >= 0.f ? 1.f : -1.f),
+                                 (1.f - std::abs(encoded.x())) * (encoded.y() >= 0.f ? 1.f : -1.f));
+        }
+        x = quantize8(encoded.x());
+        y = quantize8(encoded.y());
+    }
+}
+
 ChunkManager::ChunkManager(Storage *storage, Resource::SceneManager *sceneMgr, TextureManager* textureManager, CompositeMapRenderer* renderer)
     : GenericResourceManager<ChunkId>(nullptr)
     , mStorage(storage)
@@ -31,6 +79,7 @@ ChunkManager::ChunkManager(Storage *storage, Resource::SceneManager *sceneMgr, T
     , mCompositeMapSize(512)
     , mCompositeMapLevel(1.f)
     , mMaxCompGeometrySize(1.f)
+    , mCompactVertices(false)
 {
     mMultiPassRoot = new osg::StateSet;
     mMultiPassRoot->setRenderingHint(osg::StateSet::OPAQUE_BIN);
@@ -50,7 +99,7 @@ struct FindChunkTemplate
     osg::ref_ptr<osg::Object> mFoundTemplate;
 };
 
-osg::ref_ptr<osg::Node> ChunkManager::getChunk(float size, const osg::Vec2f& center, unsigned char lod, unsigned int lodFlags, bool activeGrid, const osg::Vec3f& viewPoint, bool compile)
+osg::ref_ptr<osg::Node> ChunkManager::getChunk(float size, const osg::Vec2f& center, unsigned char lod, unsigned int lodFlags, bool activeGrid, const osg::Vec3f& viewPoint, bool compile, const std::atomic<bool>* abort)
 {
     // Override lod with the vertexLodMod adjusted value.
     // TODO: maybe we can refactor this code by moving all vertexLodMod code into this class.
@@ -89,6 +138,64 @@ void ChunkManager::releaseGLObjects(osg::State *state)
     mBufferCache.releaseGLObjects(state);
 }
 
+bool ChunkManager::useCompactVertices() const
+{
+    // Only the terrain shader can decode compact vertices, see ChunkManager::createPasses
+    return mCompactVertices && (mSceneManager->getForceShaders() || !mSceneManager->getClampLighting());
+}
+
+osg::ref_ptr<osg::Array> ChunkManager::createCompactVertexArrays(TerrainDrawable& geometry, unsigned int numVerts, float chunkSize, osg::Vec3Array& positions, const osg::Vec3Array& normals)
+{
+    // Round the heights to the ones the shader decodes, also for chunks that end up with regular vertices so that
+    // they match their neighbours with compact vertices
+    long minStep = std::numeric_limits<long>::max();
+    long maxStep = std::numeric_limits<long>::min();
+    for (osg::Vec3f& position : positions)
+    {
+        const long step = std::lround(position.z() / sCompactHeightStep);
+        minStep = std::min(minStep, step);
+        maxStep = std::max(maxStep, step);
+        position.z() = step * sCompactHeightStep;
+    }
+
+    if (positions.empty() || maxStep - minStep > 65535)
+        return nullptr;
+
+    // Height in steps above the lowest step of the chunk in 16 bits, followed by the normal in 2x8 bits
+    osg::ref_ptr<osg::Vec4ubArray> compactVertices (new osg::Vec4ubArray(positions.size()));
+    compactVertices->setNormalize(true);
+    osg::BoundingBox boundingBox;
+    for (std::size_t i = 0; i < positions.size(); ++i)
+    {
+        osg::Vec4ub& vertex = (*compactVertices)[i];
+        encodeNormal(normals[i], vertex.r(), vertex.g());
+
+        const unsigned int quantized = static_cast<unsigned int>(std::lround(positions[i].z() / sCompactHeightStep) - minStep);
+        vertex.b() = static_cast<unsigned char>(quantized & 0xff);
+        vertex.a() = static_cast<unsigned char>(quantized >> 8);
+
+        boundingBox.expandBy(positions[i]);
+    }
+
+    geometry.setVertexArray(mBufferCache.getVertexGridBuffer(numVerts, chunkSize * mStorage->getCellWorldSize()));
+    geometry.setVertexAttribArray(CompactVertexAttribute, compactVertices, osg::Array::BIND_PER_VERTEX);
+    geometry.setComputeBoundingBoxCallback(new FixedBoundingBoxCallback(boundingBox));
+
+    osg::ref_ptr<osg::StateSet> stateset (new osg::StateSet(*mMultiPassRoot, osg::CopyOp::SHALLOW_COPY));
+    stateset->addUniform(new osg::Uniform("chunkHeightQuantization", osg::Vec2f(minStep * sCompactHeightStep, sCompactHeightStep)));
+    geometry.setStateSet(stateset);
+
+    return compactVertices;
+}
+
+std::string ChunkManager::getCompositeMapKey(float chunkSize, const osg::Vec2f& chunkCenter) const
+{
+    // Bump the version when the composite map contents change
+    std::ostringstream key;
+    key << "compositemap 1 " << chunkCenter.x() << ' ' << chunkCenter.y() << ' ' << chunkSize << ' ' << mCompositeMapSize;
+    return key.str();
+}
+
 osg::ref_ptr<osg::Texture2D> ChunkManager::createCompositeMapRTT()
 {
     osg::ref_ptr<osg::Texture2D> texture = new osg::Texture2D;
@@ -119,7 +226,7 @@ void ChunkManager::createCompositeMapGeometry(float chunkSize, const osg::Vec2f&
         float width = texCoords.z()*2.f;
         float height = texCoords.w()*2.f;
 
-        std::vector<osg::ref_ptr<osg::StateSet> > passes = createPasses(chunkSize, chunkCenter, true);
+        std::vector<osg::ref_ptr<osg::StateSet> > passes = createPasses(chunkSize, chunkCenter, true, false);
         for (std::vector<osg::ref_ptr<osg::StateSet> >::iterator it = passes.begin(); it != passes.end(); ++it)
         {
             osg::ref_ptr<osg::Geometry> geom = osg::createTexturedQuadGeometry(osg::Vec3(left,top,0), osg::Vec3(width,0,0), osg::Vec3(0,height,0));
@@ -134,7 +241,7 @@ void ChunkManager::createCompositeMapGeometry(float chunkSize, const osg::Vec2f&
     }
 }
 
-std::vector<osg::ref_ptr<osg::StateSet> > ChunkManager::createPasses(float chunkSize, const osg::Vec2f &chunkCenter, bool forCompositeMap)
+std::vector<osg::ref_ptr<osg::StateSet> > ChunkManager::createPasses(float chunkSize, const osg::Vec2f &chunkCenter, bool forCompositeMap, bool compactVertices)
 {
     std::vector<LayerInfo> layerList;
     std::vector<osg::ref_ptr<osg::Image> > blendmaps;
@@ -180,16 +287,25 @@ std::vector<osg::ref_ptr<osg::StateSet> > ChunkManager::createPasses(float chunk
 
     float blendmapScale = mStorage->getBlendmapScale(chunkSize);
 
-    return ::Terrain::createPasses(useShaders, mSceneManager, layers, blendmapTextures, blendmapScale, blendmapScale);
+    return ::Terrain::createPasses(useShaders, mSceneManager, layers, blendmapTextures, blendmapScale, blendmapScale, compactVertices);
 }
 
 osg::ref_ptr<osg::Node> ChunkManager::createChunk(float chunkSize, const osg::Vec2f &chunkCenter, unsigned char lod, unsigned int lodFlags, bool compile, TerrainDrawable* templateGeometry)
 {
     osg::ref_ptr<TerrainDrawable> geometry (new TerrainDrawable);
 
+    unsigned int numVerts = (mStorage->getCellVertices()-1) * chunkSize / (1 << lod) + 1;
+
+    osg::ref_ptr<osg::DrawElements> indices = mBufferCache.getIndexBuffer(numVerts, lodFlags);
+
+    // Decoded positions of a new chunk
+    osg::ref_ptr<osg::Vec3Array> positions;
+    // Chunks with a height range too large for compact vertices use regular ones
+    bool compactVertices = false;
+
     if (!templateGeometry)
     {
-        osg::ref_ptr<osg::Vec3Array> positions (new osg::Vec3Array);
+        positions = new osg::Vec3Array;
         osg::ref_ptr<osg::Vec3Array> normals (new osg::Vec3Array);
         osg::ref_ptr<osg::Vec4ubArray> colors (new osg::Vec4ubArray);
         colors->setNormalize(true);
@@ -197,49 +313,90 @@ osg::ref_ptr<osg::Node> ChunkManager::createChunk(float chunkSize, const osg::Ve
         mStorage->fillVertexBuffers(lod, chunkSize, chunkCenter, positions, normals, colors);
 
         osg::ref_ptr<osg::VertexBufferObject> vbo (new osg::VertexBufferObject);
-        positions->setVertexBufferObject(vbo);
-        normals->setVertexBufferObject(vbo);
         colors->setVertexBufferObject(vbo);
-    
-        geometry->setVertexArray(positions);
-        geometry->setNormalArray(normals, osg::Array::BIND_PER_VERTEX);
         geometry->setColorArray(colors, osg::Array::BIND_PER_VERTEX);
+
+        osg::ref_ptr<osg::Array> compactVertexArray;
+        if (useCompactVertices())
+            compactVertexArray = createCompactVertexArrays(*geometry, numVerts, chunkSize, *positions, *normals);
+
+        if (compactVertexArray)
+        {
+            compactVertices = true;
+            compactVertexArray->setVertexBufferObject(vbo);
+
+            // Cluster culling needs the decoded vertices
+            osg::ref_ptr<osg::Geometry> decoded (new osg::Geometry);
+            decoded->setVertexArray(positions);
+            decoded->setNormalArray(normals, osg::Array::BIND_PER_VERTEX);
+            decoded->addPrimitiveSet(indices);
+            geometry->setClusterCullingCallback(new osg::ClusterCullingCallback(decoded.get()));
+            geometry->setIntersectionVertices(positions);
+        }
+        else
+        {
+            positions->setVertexBufferObject(vbo);
+            normals->setVertexBufferObject(vbo);
+
+            geometry->setVertexArray(positions);
+            geometry->setNormalArray(normals, osg::Array::BIND_PER_VERTEX);
+        }
     }
     else
     {
         // Unfortunately we need to copy vertex data because of poor coupling with VertexBufferObject.
-        osg::ref_ptr<osg::Array> positions = static_cast<osg::Array*>(templateGeometry->getVertexArray()->clone(osg::CopyOp::DEEP_COPY_ALL));
-        osg::ref_ptr<osg::Array> normals = static_cast<osg::Array*>(templateGeometry->getNormalArray()->clone(osg::CopyOp::DEEP_COPY_ALL));
-        osg::ref_ptr<osg::Array> colors = static_cast<osg::Array*>(templateGeometry->getColorArray()->clone(osg::CopyOp::DEEP_COPY_ALL));
-
         osg::ref_ptr<osg::VertexBufferObject> vbo (new osg::VertexBufferObject);
-        positions->setVertexBufferObject(vbo);
-        normals->setVertexBufferObject(vbo);
+        osg::ref_ptr<osg::Array> colors = static_cast<osg::Array*>(templateGeometry->getColorArray()->clone(osg::CopyOp::DEEP_COPY_ALL));
         colors->setVertexBufferObject(vbo);
-    
-        geometry->setVertexArray(positions);
-        geometry->setNormalArray(normals, osg::Array::BIND_PER_VERTEX);
         geometry->setColorArray(colors, osg::Array::BIND_PER_VERTEX);
+
+        if (const osg::Array* templateCompactVertices = templateGeometry->getVertexAttribArray(CompactVertexAttribute))
+        {
+            compactVertices = true;
+            osg::ref_ptr<osg::Array> compactVertexArray = static_cast<osg::Array*>(templateCompactVertices->clone(osg::CopyOp::DEEP_COPY_ALL));
+            compactVertexArray->setVertexBufferObject(vbo);
+
+            // The vertex grid and the decoding state are shared
+            geometry->setVertexArray(templateGeometry->getVertexArray());
+            geometry->setVertexAttribArray(CompactVertexAttribute, compactVertexArray, osg::Array::BIND_PER_VERTEX);
+            geometry->setStateSet(templateGeometry->getStateSet());
+            geometry->setComputeBoundingBoxCallback(templateGeometry->getComputeBoundingBoxCallback());
+            geometry->setIntersectionVertices(templateGeometry->getIntersectionVertices());
+        }
+        else
+        {
+            osg::ref_ptr<osg::Array> vertices = static_cast<osg::Array*>(templateGeometry->getVertexArray()->clone(osg::CopyOp::DEEP_COPY_ALL));
+            osg::ref_ptr<osg::Array> normals = static_cast<osg::Array*>(templateGeometry->getNormalArray()->clone(osg::CopyOp::DEEP_COPY_ALL));
+            vertices->setVertexBufferObject(vbo);
+            normals->setVertexBufferObject(vbo);
+
+            geometry->setVertexArray(vertices);
+            geometry->setNormalArray(normals, osg::Array::BIND_PER_VERTEX);
+        }
+
+        // Same vertices as the template
+        geometry->setClusterCullingCallback(templateGeometry->getClusterCullingCallback());
     }
-    
+
     geometry->setUseDisplayList(false);
     geometry->setUseVertexBufferObjects(true);
 
     if (chunkSize <= 1.f)
         geometry->setLightListCallback(new SceneUtil::LightListCallback);
 
-    unsigned int numVerts = (mStorage->getCellVertices()-1) * chunkSize / (1 << lod) + 1;
-
-    geometry->addPrimitiveSet(mBufferCache.getIndexBuffer(numVerts, lodFlags));
+    geometry->addPrimitiveSet(indices);
 
     bool useCompositeMap = chunkSize >= mCompositeMapLevel;
     unsigned int numUvSets = useCompositeMap ? 1 : 2;
 
     geometry->setTexCoordArrayList(osg::Geometry::ArrayList(numUvSets, mBufferCache.getUVBuffer(numVerts)));
 
-    geometry->createClusterCullingCallback();
+    if (!geometry->getClusterCullingCallback())
+        geometry->createClusterCullingCallback();
 
-    geometry->setStateSet(mMultiPassRoot);
+    // Chunks with compact vertices have their own state set for decoding them
+    if (!geometry->getStateSet())
+        geometry->setStateSet(mMultiPassRoot);
 
     if (templateGeometry)
     {
@@ -254,29 +411,53 @@ osg::ref_ptr<osg::Node> ChunkManager::createChunk(float chunkSize, const osg::Ve
     {
         if (useCompositeMap)
         {
-            osg::ref_ptr<CompositeMap> compositeMap = new CompositeMap;
-            compositeMap->mTexture = createCompositeMapRTT();
-
-            createCompositeMapGeometry(chunkSize, chunkCenter, osg::Vec4f(0,0,1,1), *compositeMap);
-
-            mCompositeMapRenderer->addCompositeMap(compositeMap.get(), false);
-
-            geometry->setCompositeMap(compositeMap);
-            geometry->setCompositeMapRenderer(mCompositeMapRenderer);
+            osg::ref_ptr<osg::Texture2D> texture;
+            std::string cacheFileName;
+            if (mDiskCache)
+            {
+                cacheFileName = mDiskCache->getFileName(getCompositeMapKey(chunkSize, chunkCenter), ".png");
+                if (osg::ref_ptr<osg::Image> image = mDiskCache->readImage(cacheFileName))
+                {
+                    if (image->s() == static_cast<int>(mCompositeMapSize) && image->t() == static_cast<int>(mCompositeMapSize))
+                    {
+                        texture = createCompositeMapRTT();
+                        texture->setImage(image);
+                        texture->setUnRefImageDataAfterApply(true);
+                    }
+                }
+            }
+
+            if (!texture)
+            {
+                osg::ref_ptr<CompositeMap> compositeMap = new CompositeMap;
+                compositeMap->mTexture = createCompositeMapRTT();
+                compositeMap->mCacheFileName = std::move(cacheFileName);
+
+                createCompositeMapGeometry(chunkSize, chunkCenter, osg::Vec4f(0,0,1,1), *compositeMap);
+
+                mCompositeMapRenderer->addCompositeMap(compositeMap.get(), false);
+
+                geometry->setCompositeMap(compositeMap);
+                geometry->setCompositeMapRenderer(mCompositeMapRenderer);
+                texture = compositeMap->mTexture;
+            }
 
             TextureLayer layer;
-            layer.mDiffuseMap = compositeMap->mTexture;
+            layer.mDiffuseMap = texture;
             layer.mParallax = false;
             layer.mSpecular = false;
-            geometry->setPasses(::Terrain::createPasses(mSceneManager->getForceShaders() || !mSceneManager->getClampLighting(), mSceneManager, std::vector<TextureLayer>(1, layer), std::vector<osg::ref_ptr<osg::Texture2D> >(), 1.f, 1.f));
+            geometry->setPasses(::Terrain::createPasses(mSceneManager->getForceShaders() || !mSceneManager->getClampLighting(), mSceneManager, std::vector<TextureLayer>(1, layer), std::vector<osg::ref_ptr<osg::Texture2D> >(), 1.f, 1.f, compactVertices));
         }
         else
         {
-            geometry->setPasses(createPasses(chunkSize, chunkCenter, false));
+            geometry->setPasses(createPasses(chunkSize, chunkCenter, false, compactVertices));
         }
     }
 
-    geometry->setupWaterBoundingBox(-1, chunkSize * mStorage->getCellWorldSize() / numVerts);
+    if (templateGeometry)
+        geometry->setWaterBoundingBox(templateGeometry->getWaterBoundingBox());
+    else
+        geometry->setupWaterBoundingBox(*positions, -1, chunkSize * mStorage->getCellWorldSize() / numVerts);
 
     if (!templateGeometry && compile && mSceneManager->getIncrementalCompileOperation())
     {
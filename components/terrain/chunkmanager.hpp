@@ -1,11 +1,13 @@
 #ifndef OPENMW_COMPONENTS_TERRAIN_CHUNKMANAGER_H
 #define OPENMW_COMPONENTS_TERRAIN_CHUNKMANAGER_H
 
+#include <string>
 #include <tuple>
 
 #include <components/resource/resourcemanager.hpp>
 
 #include "buffercache.hpp"
+#include "diskcache.hpp"
 #include "quadtreeworld.hpp"
 
 namespace osg
@@ -36,12 +38,19 @@ namespace Terrain
     public:
         ChunkManager(Storage* storage, Resource::SceneManager* sceneMgr, TextureManager* textureManager, CompositeMapRenderer* renderer);
 
-        osg::ref_ptr<osg::Node> getChunk(float size, const osg::Vec2f& center, unsigned char lod, unsigned int lodFlags, bool activeGrid, const osg::Vec3f& viewPoint, bool compile) override;
+        osg::ref_ptr<osg::Node> getChunk(float size, const osg::Vec2f& center, unsigned char lod, unsigned int lodFlags, bool activeGrid, const osg::Vec3f& viewPoint, bool compile, const std::atomic<bool>* abort) override;
 
         void setCompositeMapSize(unsigned int size) { mCompositeMapSize = size; }
         void setCompositeMapLevel(float level) { mCompositeMapLevel = level; }
         void setMaxCompositeGeometrySize(float maxCompGeometrySize) { mMaxCompGeometrySize = maxCompGeometrySize; }
 
+        /// Load composite maps from this cache when possible, and store the ones that had to be rendered in it.
+        void setDiskCache(DiskCache* diskCache) { mDiskCache = diskCache; }
+
+        /// Store heights and normals of new chunks quantized to 16 and 8 bits and decode them in the terrain shader.
+        /// @note Ignored unless the terrain is always rendered with shaders.
+        void setCompactVertices(bool compact) { mCompactVertices = compact; }
+
         void setNodeMask(unsigned int mask) { mNodeMask = mask; }
         unsigned int getNodeMask() override { return mNodeMask; }
 
@@ -54,16 +63,27 @@ namespace Terrain
     private:
         osg::ref_ptr<osg::Node> createChunk(float size, const osg::Vec2f& center, unsigned char lod, unsigned int lodFlags, bool compile, TerrainDrawable* templateGeometry);
 
+        bool useCompactVertices() const;
+
+        /// Set up \a geometry to use compact vertices encoded from \a positions and \a normals. The heights of \a positions
+        /// are rounded to the decoded ones either way.
+        /// @return The array of encoded vertices, so the caller can share its buffer object with other arrays, or nullptr
+        /// if the height range of the chunk is too large for compact vertices.
+        osg::ref_ptr<osg::Array> createCompactVertexArrays(TerrainDrawable& geometry, unsigned int numVerts, float chunkSize, osg::Vec3Array& positions, const osg::Vec3Array& normals);
+
+        std::string getCompositeMapKey(float chunkSize, const osg::Vec2f& chunkCenter) const;
+
         osg::ref_ptr<osg::Texture2D> createCompositeMapRTT();
 
         void createCompositeMapGeometry(float chunkSize, const osg::Vec2f& chunkCenter, const osg::Vec4f& texCoords, CompositeMap& map);
 
-        std::vector<osg::ref_ptr<osg::StateSet> > createPasses(float chunkSize, const osg::Vec2f& chunkCenter, bool forCompositeMap);
+        std::vector<osg::ref_ptr<osg::StateSet> > createPasses(float chunkSize, const osg::Vec2f& chunkCenter, bool forCompositeMap, bool compactVertices);
 
         Terrain::Storage* mStorage;
         Resource::SceneManager* mSceneManager;
         TextureManager* mTextureManager;
         CompositeMapRenderer* mCompositeMapRenderer;
+        osg::ref_ptr<DiskCache> mDiskCache;
         BufferCache mBufferCache;
 
         osg::ref_ptr<osg::StateSet> mMultiPassRoot;
@@ -73,6 +93,7 @@ namespace Terrain
         unsigned int mCompositeMapSize;
         float mCompositeMapLevel;
         float mMaxCompGeometrySize;
+        bool mCompactVertices;
     };
 
 }
@@ -1,14 +1,26 @@
 #include "compositemaprenderer.hpp"
 
+#include <osg/BufferObject>
 #include <osg/FrameBufferObject>
+#include <osg/GLExtensions>
+#include <osg/Image>
 #include <osg/Texture2D>
 #include <osg/RenderInfo>
 
 #include <algorithm>
+#include <cstring>
+
+#include "diskcache.hpp"
 
 namespace Terrain
 {
 
+namespace
+{
+    // Frames between starting a read back and mapping its buffer, so the GPU has finished the copy by then
+    constexpr unsigned int sReadbackDelay = 3;
+}
+
 CompositeMapRenderer::CompositeMapRenderer()
     : mTargetFrameRate(120)
     , mMinimumTimeAvailable(0.0025)
@@ -35,6 +47,13 @@ void CompositeMapRenderer::drawImplementation(osg::RenderInfo &renderInfo) const
     double availableTime = std::max((targetFrameTime - dt)*conservativeTimeRatio,
                                     mMinimumTimeAvailable);
 
+    if (!mPendingReadbacks.empty())
+    {
+        osg::Timer readbackTimer;
+        finishReadbacks(*renderInfo.getState());
+        availableTime -= readbackTimer.time_s();
+    }
+
     std::lock_guard<std::mutex> lock(mMutex);
 
     if (mImmediateCompileSet.empty() && mCompileSet.empty())
@@ -138,14 +157,102 @@ void CompositeMapRenderer::compile(CompositeMap &compositeMap, osg::RenderInfo &
         }
     }
     if (compositeMap.mCompiled == compositeMap.mDrawables.size())
+    {
         compositeMap.mDrawables = std::vector<osg::ref_ptr<osg::Drawable>>();
 
+        if (mDiskCache && !compositeMap.mCacheFileName.empty())
+        {
+            startReadback(compositeMap, state);
+            if (timeLeft)
+                *timeLeft -= timer.time_s();
+        }
+    }
+
     state.haveAppliedAttribute(osg::StateAttribute::VIEWPORT);
 
     GLuint fboId = state.getGraphicsContext() ? state.getGraphicsContext()->getDefaultFboId() : 0;
     ext->glBindFramebuffer(GL_FRAMEBUFFER_EXT, fboId);
 }
 
+void CompositeMapRenderer::startReadback(CompositeMap& compositeMap, osg::State& state) const
+{
+    // Read back the finished texture while it is still attached, encoding and writing happen on the cache's thread
+    mFBO->apply(state, osg::FrameBufferObject::READ_FRAMEBUFFER);
+    const int width = compositeMap.mTexture->getTextureWidth();
+    const int height = compositeMap.mTexture->getTextureHeight();
+    osg::GLExtensions* ext = state.get<osg::GLExtensions>();
+
+    if (!ext->isPBOSupported)
+    {
+        osg::ref_ptr<osg::Image> image = new osg::Image;
+        image->readPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE);
+        mDiskCache->writeImage(compositeMap.mCacheFileName, image);
+        compositeMap.mCacheFileName.clear();
+        return;
+    }
+
+    PendingReadback readback;
+    readback.mContextID = state.getContextID();
+    readback.mWidth = width;
+    readback.mHeight = height;
+    readback.mFramesLeft = sReadbackDelay;
+    readback.mFileName = std::move(compositeMap.mCacheFileName);
+    compositeMap.mCacheFileName.clear();
+
+    ext->glGenBuffers(1, &readback.mBuffer);
+    ext->glBindBuffer(GL_PIXEL_PACK_BUFFER_ARB, readback.mBuffer);
+    ext->glBufferData(GL_PIXEL_PACK_BUFFER_ARB, width * height * 3, nullptr, GL_STREAM_READ_ARB);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+    ext->glBindBuffer(GL_PIXEL_PACK_BUFFER_ARB, 0);
+
+    mPendingReadbacks.push_back(std::move(readback));
+}
+
+void CompositeMapRenderer::finishReadbacks(osg::State& state) const
+{
+    osg::GLExtensions* ext = state.get<osg::GLExtensions>();
+    for (auto it = mPendingReadbacks.begin(); it != mPendingReadbacks.end();)
+    {
+        if (--it->mFramesLeft > 0)
+        {
+            ++it;
+            continue;
+        }
+
+        ext->glBindBuffer(GL_PIXEL_PACK_BUFFER_ARB, it->mBuffer);
+        if (const void* data = ext->glMapBuffer(GL_PIXEL_PACK_BUFFER_ARB, GL_READ_ONLY_ARB))
+        {
+            osg::ref_ptr<osg::Image> image = new osg::Image;
+            image->allocateImage(it->mWidth, it->mHeight, 1, GL_RGB, GL_UNSIGNED_BYTE);
+            std::memcpy(image->data(), data, it->mWidth * it->mHeight * 3);
+            ext->glUnmapBuffer(GL_PIXEL_PACK_BUFFER_ARB);
+            mDiskCache->writeImage(it->mFileName, image);
+        }
+        ext->glBindBuffer(GL_PIXEL_PACK_BUFFER_ARB, 0);
+        ext->glDeleteBuffers(1, &it->mBuffer);
+        it = mPendingReadbacks.erase(it);
+    }
+}
+
+void CompositeMapRenderer::releaseGLObjects(osg::State* state) const
+{
+    osg::Drawable::releaseGLObjects(state);
+
+    for (auto it = mPendingReadbacks.begin(); it != mPendingReadbacks.end();)
+    {
+        if (state && it->mContextID != state->getContextID())
+        {
+            ++it;
+            continue;
+        }
+        // Without a state the context is going away and takes the buffer with it
+        if (state)
+            state->get<osg::GLExtensions>()->glDeleteBuffers(1, &it->mBuffer);
+        it = mPendingReadbacks.erase(it);
+    }
+}
+
 void CompositeMapRenderer::setMinimumTimeAvailableForCompile(double time)
 {
     mMinimumTimeAvailable = time;
@@ -184,6 +291,11 @@ unsigned int CompositeMapRenderer::getCompileSetSize() const
     return mCompileSet.size();
 }
 
+void CompositeMapRenderer::setDiskCache(DiskCache* diskCache)
+{
+    mDiskCache = diskCache;
+}
+
 CompositeMap::CompositeMap()
     : mCompiled(0)
 {
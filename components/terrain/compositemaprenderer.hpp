@@ -5,17 +5,22 @@
 
 #include <set>
 #include <mutex>
+#include <string>
+#include <vector>
 
 namespace osg
 {
     class FrameBufferObject;
     class RenderInfo;
+    class State;
     class Texture2D;
 }
 
 namespace Terrain
 {
 
+    class DiskCache;
+
     class CompositeMap : public osg::Referenced
     {
     public:
@@ -24,6 +29,8 @@ namespace Terrain
         std::vector<osg::ref_ptr<osg::Drawable> > mDrawables;
         osg::ref_ptr<osg::Texture2D> mTexture;
         unsigned int mCompiled;
+        /// If not empty, the finished texture is written to the DiskCache under this name
+        std::string mCacheFileName;
     };
 
     /**
@@ -37,6 +44,9 @@ namespace Terrain
 
         void drawImplementation(osg::RenderInfo& renderInfo) const override;
 
+        /// Delete the pixel buffer objects of pending read backs. Their composite maps are not written to the DiskCache.
+        void releaseGLObjects(osg::State* state) const override;
+
         void compile(CompositeMap& compositeMap, osg::RenderInfo& renderInfo, double* timeLeft) const;
 
         /// Set the available time in seconds for compiling (non-immediate) composite maps each frame
@@ -53,7 +63,27 @@ namespace Terrain
 
         unsigned int getCompileSetSize() const;
 
+        /// Set the cache that finished composite maps with a cache file name are written to.
+        void setDiskCache(DiskCache* diskCache);
+
     private:
+        /// Copy a finished composite map into a pixel buffer object, so it can be written to the DiskCache
+        /// without waiting for the GPU. Falls back to a synchronous read if pixel buffer objects are not supported.
+        void startReadback(CompositeMap& compositeMap, osg::State& state) const;
+
+        /// Write the read backs started a few frames ago to the DiskCache.
+        void finishReadbacks(osg::State& state) const;
+
+        struct PendingReadback
+        {
+            unsigned int mContextID;
+            GLuint mBuffer;
+            int mWidth;
+            int mHeight;
+            unsigned int mFramesLeft;
+            std::string mFileName;
+        };
+
         float mTargetFrameRate;
         double mMinimumTimeAvailable;
         mutable osg::Timer mTimer;
@@ -66,6 +96,9 @@ namespace Terrain
         mutable std::mutex mMutex;
 
         osg::ref_ptr<osg::FrameBufferObject> mFBO;
+
+        osg::ref_ptr<DiskCache> mDiskCache;
+        mutable std::vector<PendingReadback> mPendingReadbacks;
     };
 
 }
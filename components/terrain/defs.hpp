@@ -24,6 +24,9 @@ namespace Terrain
         bool requiresShaders() const { return !mNormalMap.empty() || mSpecular; }
     };
 
+    /// Vertex attribute index of the packed height and normal of chunks that use compact vertices
+    constexpr unsigned int CompactVertexAttribute = 6;
+
 }
 
 #endif
@@ -0,0 +1,202 @@
+#include "diskcache.hpp"
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include <osg/Image>
+#include <osgDB/Registry>
+
+#include <components/debug/debuglog.hpp>
+#include <components/files/hash.hpp>
+#include <components/files/memorystream.hpp>
+#include <components/sceneutil/workqueue.hpp>
+
+namespace Terrain
+{
+    namespace
+    {
+        osgDB::ReaderWriter* getReaderWriter(const std::string& fileName)
+        {
+            const std::string extension = std::filesystem::path(fileName).extension().string();
+            if (extension.empty())
+                return nullptr;
+            return osgDB::Registry::instance()->getReaderWriterForExtension(extension.substr(1));
+        }
+
+        class WriteFileWorkItem : public SceneUtil::WorkItem
+        {
+        public:
+            WriteFileWorkItem(const std::filesystem::path& path, std::string&& data, osg::ref_ptr<osg::Image> image)
+                : mPath(path)
+                , mData(std::move(data))
+                , mImage(std::move(image))
+            {
+            }
+
+            void doWork() override
+            {
+                // Write to a temporary file first, so concurrent sessions never read a partially written file
+                std::ostringstream tmpName;
+                tmpName << mPath.filename().string() << '.' << std::this_thread::get_id() << ".tmp";
+                const std::filesystem::path tmpPath = mPath.parent_path() / tmpName.str();
+
+                try
+                {
+                    {
+                        std::ofstream stream(tmpPath, std::ios::binary | std::ios::trunc);
+                        if (!stream.is_open())
+                            throw std::runtime_error("can not open file");
+
+                        if (mImage)
+                        {
+                            osgDB::ReaderWriter* writer = getReaderWriter(mPath.string());
+                            if (!writer)
+                                throw std::runtime_error("no readerwriter for " + mPath.extension().string() + " found");
+
+                            osgDB::ReaderWriter::WriteResult result = writer->writeImage(*mImage, stream);
+                            if (!result.success())
+                                throw std::runtime_error(result.message());
+                        }
+                        else
+                            stream.write(mData.data(), mData.size());
+
+                        if (!stream)
+                            throw std::runtime_error("write failed");
+                    }
+                    std::filesystem::rename(tmpPath, mPath);
+                }
+                catch (const std::exception& e)
+                {
+                    Log(Debug::Warning) << "Failed to write cached chunk " << mPath << ": " << e.what();
+                    std::error_code ec;
+                    std::filesystem::remove(tmpPath, ec);
+                }
+            }
+
+        private:
+            std::filesystem::path mPath;
+            std::string mData;
+            osg::ref_ptr<osg::Image> mImage;
+        };
+
+        /// Removes the files cached for other content, which would otherwise never be used or deleted
+        class RemoveStaleFilesWorkItem : public SceneUtil::WorkItem
+        {
+        public:
+            explicit RemoveStaleFilesWorkItem(const std::filesystem::path& path)
+                : mPath(path)
+            {
+            }
+
+            void doWork() override
+            {
+                std::error_code ec;
+                std::uintmax_t numRemoved = 0;
+                for (std::filesystem::directory_iterator it(mPath.parent_path(), ec), end; !ec && it != end; it.increment(ec))
+                {
+                    if (it->path().filename() == mPath.filename())
+                        continue;
+                    std::error_code removeEc;
+                    const std::uintmax_t count = std::filesystem::remove_all(it->path(), removeEc);
+                    if (removeEc)
+                        Log(Debug::Warning) << "Failed to remove stale cached chunks " << it->path() << ": " << removeEc.message();
+                    else
+                        numRemoved += count;
+                }
+                if (ec)
+                    Log(Debug::Warning) << "Failed to list chunk cache directory " << mPath.parent_path() << ": " << ec.message();
+                if (numRemoved > 0)
+                    Log(Debug::Info) << "Removed " << numRemoved << " stale cached chunk files";
+            }
+
+        private:
+            std::filesystem::path mPath;
+        };
+    }
+
+    DiskCache::DiskCache(const std::string& path, std::string_view contentKey)
+        : mWorkQueue(new SceneUtil::WorkQueue(1))
+    {
+        // The content key can be large, so only its hash is mixed into the file names
+        Files::IMemStream contentKeyStream(contentKey.data(), contentKey.size());
+        const std::array<std::uint64_t, 2> contentHash = Files::getHash("content", contentKeyStream);
+        mContentKey.assign(reinterpret_cast<const char*>(contentHash.data()), sizeof(contentHash));
+
+        // Files of each content are kept in their own directory, so the ones of other content can be told apart
+        std::ostringstream directory;
+        directory << std::hex << std::setfill('0') << std::setw(16) << contentHash[0] << std::setw(16) << contentHash[1];
+        mPath = std::filesystem::path(path) / directory.str();
+
+        std::error_code ec;
+        std::filesystem::create_directories(mPath, ec);
+        if (ec)
+        {
+            Log(Debug::Warning) << "Failed to create chunk cache directory " << mPath << ": " << ec.message();
+            return;
+        }
+
+        mWorkQueue->addWorkItem(new RemoveStaleFilesWorkItem(mPath));
+    }
+
+    DiskCache::~DiskCache() = default;
+
+    std::string DiskCache::getFileName(std::string_view key, std::string_view extension) const
+    {
+        std::string fullKey = mContentKey;
+        fullKey += '\0';
+        fullKey += key;
+
+        Files::IMemStream stream(fullKey.data(), fullKey.size());
+        const std::array<std::uint64_t, 2> hash = Files::getHash("chunk", stream);
+
+        std::ostringstream fileName;
+        fileName << std::hex << std::setfill('0') << std::setw(16) << hash[0] << std::setw(16) << hash[1] << extension;
+        return fileName.str();
+    }
+
+    bool DiskCache::read(const std::string& fileName, std::string& data) const
+    {
+        std::ifstream stream(mPath / fileName, std::ios::binary);
+        if (!stream.is_open())
+            return false;
+
+        data.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+        return !stream.bad();
+    }
+
+    void DiskCache::write(const std::string& fileName, std::string&& data)
+    {
+        mWorkQueue->addWorkItem(new WriteFileWorkItem(mPath / fileName, std::move(data), nullptr));
+    }
+
+    osg::ref_ptr<osg::Image> DiskCache::readImage(const std::string& fileName) const
+    {
+        std::ifstream stream(mPath / fileName, std::ios::binary);
+        if (!stream.is_open())
+            return nullptr;
+
+        osgDB::ReaderWriter* reader = getReaderWriter(fileName);
+        if (!reader)
+            return nullptr;
+
+        osgDB::ReaderWriter::ReadResult result = reader->readImage(stream);
+        if (!result.success() || !result.getImage())
+        {
+            Log(Debug::Warning) << "Failed to read cached chunk " << (mPath / fileName) << ": " << result.message();
+            return nullptr;
+        }
+        return result.getImage();
+    }
+
+    void DiskCache::writeImage(const std::string& fileName, osg::ref_ptr<osg::Image> image)
+    {
+        mWorkQueue->addWorkItem(new WriteFileWorkItem(mPath / fileName, std::string(), std::move(image)));
+    }
+
+}
@@ -0,0 +1,65 @@
+#ifndef OPENMW_COMPONENTS_TERRAIN_DISKCACHE_H
+#define OPENMW_COMPONENTS_TERRAIN_DISKCACHE_H
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+#include <osg/Referenced>
+#include <osg/ref_ptr>
+
+namespace osg
+{
+    class Image;
+}
+
+namespace SceneUtil
+{
+    class WorkQueue;
+}
+
+namespace Terrain
+{
+
+    /// @brief Keeps the results of expensive chunk builds in files, so later sessions can load them instead of building them again.
+    /// @par File names are hashes of a key describing the chunk and of the loaded content, so changing the content files
+    /// never picks up stale files. Files are written on a background thread.
+    /// @par The files of each content are kept in a subdirectory named after the content hash. The subdirectories of
+    /// other content are removed on creation, so the cache only ever holds the chunks of the content last played.
+    class DiskCache : public osg::Referenced
+    {
+    public:
+        /// @param path Directory of the cache, created if missing. Anything in it that belongs to other content is removed.
+        /// @param contentKey Describes the loaded content, changing it invalidates all cached chunks.
+        DiskCache(const std::string& path, std::string_view contentKey);
+        ~DiskCache();
+
+        /// Get the file name for a chunk described by \a key.
+        /// @note Thread safe.
+        std::string getFileName(std::string_view key, std::string_view extension) const;
+
+        /// @return false if the file does not exist or can not be read.
+        /// @note Thread safe.
+        bool read(const std::string& fileName, std::string& data) const;
+
+        /// Queue writing a file.
+        /// @note Thread safe.
+        void write(const std::string& fileName, std::string&& data);
+
+        /// @return nullptr if the file does not exist or can not be read.
+        /// @note Thread safe.
+        osg::ref_ptr<osg::Image> readImage(const std::string& fileName) const;
+
+        /// Queue writing an image, in a format chosen by the file name extension.
+        /// @note Thread safe.
+        void writeImage(const std::string& fileName, osg::ref_ptr<osg::Image> image);
+
+    private:
+        std::filesystem::path mPath;
+        std::string mContentKey;
+        osg::ref_ptr<SceneUtil::WorkQueue> mWorkQueue;
+    };
+
+}
+
+#endif
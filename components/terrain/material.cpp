@@ -7,6 +7,7 @@
 #include <osg/TexMat>
 #include <osg/BlendFunc>
 #include <osg/Capability>
+#include <osg/Program>
 
 #include <components/stereo/stereomanager.hpp>
 #include <components/resource/scenemanager.hpp>
@@ -197,11 +198,19 @@ namespace
 namespace Terrain
 {
     std::vector<osg::ref_ptr<osg::StateSet> > createPasses(bool useShaders, Resource::SceneManager* sceneManager, const std::vector<TextureLayer> &layers,
-                                                           const std::vector<osg::ref_ptr<osg::Texture2D> > &blendmaps, int blendmapScale, float layerTileSize)
+                                                           const std::vector<osg::ref_ptr<osg::Texture2D> > &blendmaps, int blendmapScale, float layerTileSize,
+                                                           bool compactVertices)
     {
         auto& shaderManager = sceneManager->getShaderManager();
         std::vector<osg::ref_ptr<osg::StateSet> > passes;
 
+        osg::ref_ptr<osg::Program> programTemplate;
+        if (useShaders && compactVertices)
+        {
+            programTemplate = shaderManager.getProgramTemplate() ? Shader::ShaderManager::cloneProgram(shaderManager.getProgramTemplate()) : osg::ref_ptr<osg::Program>(new osg::Program);
+            programTemplate->addBindAttribLocation("aCompactVertex", CompactVertexAttribute);
+        }
+
         unsigned int blendmapIndex = 0;
         for (std::vector<TextureLayer>::const_iterator it = layers.begin(); it != layers.end(); ++it)
         {
@@ -257,6 +266,7 @@ namespace Terrain
                 defineMap["specularMap"] = it->mSpecular ? "1" : "0";
                 defineMap["parallax"] = (it->mNormalMap && it->mParallax) ? "1" : "0";
                 defineMap["writeNormals"] = (it == layers.end() - 1) ? "1" : "0";
+                defineMap["compactVertices"] = compactVertices ? "1" : "0";
                 Stereo::Manager::instance().shaderStereoDefines(defineMap);
 
                 osg::ref_ptr<osg::Shader> vertexShader = shaderManager.getShader("terrain_vertex.glsl", defineMap, osg::Shader::VERTEX);
@@ -267,7 +277,7 @@ namespace Terrain
                     return createPasses(false, sceneManager, layers, blendmaps, blendmapScale, layerTileSize);
                 }
 
-                stateset->setAttributeAndModes(shaderManager.getProgram(vertexShader, fragmentShader));
+                stateset->setAttributeAndModes(shaderManager.getProgram(vertexShader, fragmentShader, programTemplate));
                 stateset->addUniform(UniformCollection::value().mColorMode);
             }
             else
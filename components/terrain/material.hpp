@@ -28,7 +28,8 @@ namespace Terrain
 
     std::vector<osg::ref_ptr<osg::StateSet> > createPasses(bool useShaders, Resource::SceneManager* sceneManager,
                                                            const std::vector<TextureLayer>& layers,
-                                                           const std::vector<osg::ref_ptr<osg::Texture2D> >& blendmaps, int blendmapScale, float layerTileSize);
+                                                           const std::vector<osg::ref_ptr<osg::Texture2D> >& blendmaps, int blendmapScale, float layerTileSize,
+                                                           bool compactVertices = false);
 
 }
 
@@ -254,7 +254,7 @@ class DebugChunkManager : public QuadTreeWorld::ChunkManager
 {
 public:
     DebugChunkManager(Resource::SceneManager* sceneManager, Storage* storage, unsigned int nodeMask) : mSceneManager(sceneManager), mStorage(storage), mNodeMask(nodeMask) {}
-    osg::ref_ptr<osg::Node> getChunk(float size, const osg::Vec2f& chunkCenter, unsigned char lod, unsigned int lodFlags, bool activeGrid, const osg::Vec3f& viewPoint, bool compile)
+    osg::ref_ptr<osg::Node> getChunk(float size, const osg::Vec2f& chunkCenter, unsigned char lod, unsigned int lodFlags, bool activeGrid, const osg::Vec3f& viewPoint, bool compile, const std::atomic<bool>* abort)
     {
         osg::Vec3f center = { chunkCenter.x(), chunkCenter.y(), 0 };
         auto chunkBorder = CellBorder::createBorderGeometry(center.x() - size / 2.f, center.y() - size / 2.f, size, mStorage, mSceneManager, mNodeMask, 5.f, { 1, 0, 0, 0 });
@@ -350,7 +350,7 @@ unsigned int getLodFlags(QuadTreeNode* node, unsigned int ourVertexLod, int vert
     return lodFlags;
 }
 
-void QuadTreeWorld::loadRenderingNode(ViewDataEntry& entry, ViewData* vd, float cellWorldSize, const osg::Vec4i &gridbounds, bool compile)
+void QuadTreeWorld::loadRenderingNode(ViewDataEntry& entry, ViewData* vd, float cellWorldSize, const osg::Vec4i &gridbounds, bool compile, const std::atomic<bool>* abort)
 {
     if (!vd->hasChanged() && entry.mRenderingNode)
         return;
@@ -377,9 +377,12 @@ void QuadTreeWorld::loadRenderingNode(ViewDataEntry& entry, ViewData* vd, float
 
         for (QuadTreeWorld::ChunkManager* m : mChunkManagers)
         {
-            osg::ref_ptr<osg::Node> n = m->getChunk(entry.mNode->getSize(), entry.mNode->getCenter(), DefaultLodCallback::getNativeLodLevel(entry.mNode, mMinSize), entry.mLodFlags, activeGrid, vd->getViewPoint(), compile);
+            osg::ref_ptr<osg::Node> n = m->getChunk(entry.mNode->getSize(), entry.mNode->getCenter(), DefaultLodCallback::getNativeLodLevel(entry.mNode, mMinSize), entry.mLodFlags, activeGrid, vd->getViewPoint(), compile, abort);
             if (n) pat->addChild(n);
         }
+        // Chunks may be incomplete once aborted
+        if (abort && *abort)
+            return;
         entry.mRenderingNode = pat;
     }
 }
@@ -459,7 +462,7 @@ void QuadTreeWorld::accept(osg::NodeVisitor &nv)
     for (unsigned int i=0; i<vd->getNumEntries(); ++i)
     {
         ViewDataEntry& entry = vd->getEntry(i);
-        loadRenderingNode(entry, vd, cellWorldSize, mActiveGrid, false);
+        loadRenderingNode(entry, vd, cellWorldSize, mActiveGrid, false, nullptr);
         entry.mRenderingNode->accept(nv);
     }
 
@@ -542,7 +545,7 @@ void QuadTreeWorld::preload(View *view, const osg::Vec3f &viewPoint, const osg::
         {
             ViewDataEntry& entry = vd->getEntry(i);
 
-            loadRenderingNode(entry, vd, cellWorldSize, grid, true);
+            loadRenderingNode(entry, vd, cellWorldSize, grid, true, &abort);
             if (pass==0) reporter.addProgress(entry.mNode->getSize());
             entry.mNode = nullptr; // Clear node lest we break the neighbours search for the next pass
         }
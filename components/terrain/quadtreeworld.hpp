@@ -51,7 +51,8 @@ namespace Terrain
         {
         public:
             virtual ~ChunkManager(){}
-            virtual osg::ref_ptr<osg::Node> getChunk(float size, const osg::Vec2f& center, unsigned char lod, unsigned int lodFlags, bool activeGrid, const osg::Vec3f& viewPoint, bool compile) = 0;
+            /// @param abort Set when the chunk is no longer needed, may be nullptr. Implementations may then return an incomplete chunk.
+            virtual osg::ref_ptr<osg::Node> getChunk(float size, const osg::Vec2f& center, unsigned char lod, unsigned int lodFlags, bool activeGrid, const osg::Vec3f& viewPoint, bool compile, const std::atomic<bool>* abort) = 0;
             virtual unsigned int getNodeMask() { return 0; }
 
             void setViewDistance(float viewDistance) { mViewDistance = viewDistance; }
@@ -68,7 +69,7 @@ namespace Terrain
 
     private:
         void ensureQuadTreeBuilt();
-        void loadRenderingNode(ViewDataEntry& entry, ViewData* vd, float cellWorldSize, const osg::Vec4i &gridbounds, bool compile);
+        void loadRenderingNode(ViewDataEntry& entry, ViewData* vd, float cellWorldSize, const osg::Vec4i &gridbounds, bool compile, const std::atomic<bool>* abort);
 
         osg::ref_ptr<RootNode> mRootNode;
 
@@ -23,6 +23,7 @@ TerrainDrawable::~TerrainDrawable()
 TerrainDrawable::TerrainDrawable(const TerrainDrawable &copy, const osg::CopyOp &copyop)
     : osg::Geometry(copy, copyop)
     , mPasses(copy.mPasses)
+    , mIntersectionVertices(copy.mIntersectionVertices)
     , mLightListCallback(copy.mLightListCallback)
 {
 
@@ -42,6 +43,19 @@ void TerrainDrawable::accept(osg::NodeVisitor &nv)
     }
 }
 
+void TerrainDrawable::accept(osg::PrimitiveFunctor& functor) const
+{
+    if (!mIntersectionVertices)
+    {
+        osg::Geometry::accept(functor);
+        return;
+    }
+
+    functor.setVertexArray(mIntersectionVertices->getNumElements(), static_cast<const osg::Vec3*>(mIntersectionVertices->getDataPointer()));
+    for (const osg::ref_ptr<osg::PrimitiveSet>& primitiveSet : getPrimitiveSetList())
+        primitiveSet->accept(functor);
+}
+
 inline float distance(const osg::Vec3& coord,const osg::Matrix& matrix)
 {
     return -((float)coord[0]*(float)matrix(0,2)+(float)coord[1]*(float)matrix(1,2)+(float)coord[2]*(float)matrix(2,2)+matrix(3,2));
@@ -124,6 +138,11 @@ void TerrainDrawable::createClusterCullingCallback()
     mClusterCullingCallback = new osg::ClusterCullingCallback(this);
 }
 
+void TerrainDrawable::setClusterCullingCallback(osg::ClusterCullingCallback* callback)
+{
+    mClusterCullingCallback = callback;
+}
+
 void TerrainDrawable::setPasses(const TerrainDrawable::PassVector &passes)
 {
     mPasses = passes;
@@ -134,12 +153,11 @@ void TerrainDrawable::setLightListCallback(SceneUtil::LightListCallback *lightLi
     mLightListCallback = lightListCallback;
 }
 
-void TerrainDrawable::setupWaterBoundingBox(float waterheight, float margin)
+void TerrainDrawable::setupWaterBoundingBox(const osg::Vec3Array& vertices, float waterheight, float margin)
 {
-    osg::Vec3Array* vertices = static_cast<osg::Vec3Array*>(getVertexArray());
-    for (unsigned int i=0; i<vertices->size(); ++i)
+    for (unsigned int i=0; i<vertices.size(); ++i)
     {
-        const osg::Vec3f& vertex = (*vertices)[i];
+        const osg::Vec3f& vertex = vertices[i];
         if (vertex.z() <= waterheight)
             mWaterBoundingBox.expandBy(vertex);
     }
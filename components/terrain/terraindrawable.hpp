@@ -43,6 +43,14 @@ namespace Terrain
         void accept(osg::NodeVisitor &nv) override;
         void cull(osgUtil::CullVisitor* cv);
 
+        /// Uses the intersection vertices if set, see setIntersectionVertices.
+        void accept(osg::PrimitiveFunctor& functor) const override;
+
+        /// Set the decoded vertices of a drawable that uses compact vertices. Its vertex array only holds the horizontal
+        /// positions, which the PrimitiveFunctors used for intersections and picking can not read.
+        void setIntersectionVertices(osg::ref_ptr<const osg::Vec3Array> vertices) { mIntersectionVertices = std::move(vertices); }
+        const osg::Vec3Array* getIntersectionVertices() const { return mIntersectionVertices; }
+
         typedef std::vector<osg::ref_ptr<osg::StateSet> > PassVector;
         void setPasses (const PassVector& passes);
         const PassVector& getPasses() const {  return mPasses; }
@@ -50,10 +58,14 @@ namespace Terrain
         void setLightListCallback(SceneUtil::LightListCallback* lightListCallback);
 
         void createClusterCullingCallback();
+        void setClusterCullingCallback(osg::ClusterCullingCallback* callback);
+        osg::ClusterCullingCallback* getClusterCullingCallback() { return mClusterCullingCallback; }
 
         void compileGLObjects(osg::RenderInfo& renderInfo) const override;
 
-        void setupWaterBoundingBox(float waterheight, float margin);
+        /// @param vertices The vertices of this drawable, or the decoded vertices if it uses compact vertices.
+        void setupWaterBoundingBox(const osg::Vec3Array& vertices, float waterheight, float margin);
+        void setWaterBoundingBox(const osg::BoundingBox& box) { mWaterBoundingBox = box; }
         const osg::BoundingBox& getWaterBoundingBox() const { return mWaterBoundingBox; }
 
         void setCompositeMap(CompositeMap* map) { mCompositeMap = map; }
@@ -63,6 +75,7 @@ namespace Terrain
     private:
         osg::BoundingBox mWaterBoundingBox;
         PassVector mPasses;
+        osg::ref_ptr<const osg::Vec3Array> mIntersectionVertices;
 
         osg::ref_ptr<osg::ClusterCullingCallback> mClusterCullingCallback;
 
@@ -45,7 +45,7 @@ osg::ref_ptr<osg::Texture2D> TextureManager::getTexture(const std::string &name)
         return static_cast<osg::Texture2D*>(obj.get());
     else
     {
-        osg::ref_ptr<osg::Texture2D> texture (new osg::Texture2D(mSceneManager->getImageManager()->getImage(name)));
+        osg::ref_ptr<osg::Texture2D> texture (new osg::Texture2D(mSceneManager->getImageManager()->getImage(name, false, true)));
         texture->setWrap(osg::Texture::WRAP_S, osg::Texture::REPEAT);
         texture->setWrap(osg::Texture::WRAP_T, osg::Texture::REPEAT);
         mSceneManager->applyFilterSettings(texture);
@@ -10,6 +10,7 @@
 #include "texturemanager.hpp"
 #include "chunkmanager.hpp"
 #include "compositemaprenderer.hpp"
+#include "diskcache.hpp"
 
 namespace Terrain
 {
@@ -118,6 +119,20 @@ void World::setTargetFrameRate(float rate)
     mCompositeMapRenderer->setTargetFrameRate(rate);
 }
 
+void World::setDiskCache(DiskCache* diskCache)
+{
+    if (mChunkManager)
+        mChunkManager->setDiskCache(diskCache);
+    if (mCompositeMapRenderer)
+        mCompositeMapRenderer->setDiskCache(diskCache);
+}
+
+void World::setCompactVertices(bool compact)
+{
+    if (mChunkManager)
+        mChunkManager->setCompactVertices(compact);
+}
+
 float World::getHeightAt(const osg::Vec3f &worldPos)
 {
     return mStorage->getHeightAt(worldPos);
@@ -40,6 +40,7 @@ namespace Terrain
     class TextureManager;
     class ChunkManager;
     class CompositeMapRenderer;
+    class DiskCache;
 
     class HeightCullCallback : public SceneUtil::NodeCallback<HeightCullCallback>
     {
@@ -113,6 +114,14 @@ namespace Terrain
         /// See CompositeMapRenderer::setTargetFrameRate
         void setTargetFrameRate(float rate);
 
+        /// Load and store composite maps in this cache.
+        /// @note Call before any chunk is loaded.
+        void setDiskCache(DiskCache* diskCache);
+
+        /// See ChunkManager::setCompactVertices
+        /// @note Call before any chunk is loaded.
+        void setCompactVertices(bool compact);
+
         /// Apply the scene manager's texture filtering settings to all cached textures.
         /// @note Thread safe.
         void updateTextureFiltering();
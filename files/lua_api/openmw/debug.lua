@@ -41,4 +41,39 @@
 -- @function [parent=#debug] setNavMeshRenderMode
 -- @param #NAV_MESH_RENDER_MODE value
 
+---
+-- Profiler of Lua scripts. Measures engine handlers, event handlers and timer callbacks of all scripts.
+-- @field [parent=#debug] #Profiler profiler
+
+---
+-- @type Profiler
+
+---
+-- Whether the profiler is enabled.
+-- @function [parent=#Profiler] isEnabled
+-- @return #boolean
+
+---
+-- Enables or disables the profiler. Applied at the end of the frame. Collected stats are kept when disabled.
+-- @function [parent=#Profiler] setEnabled
+-- @param #boolean enabled
+
+---
+-- Removes all collected stats.
+-- @function [parent=#Profiler] reset
+
+---
+-- Returns the collected stats as a list of #ProfilerEntry.
+-- @function [parent=#Profiler] getStats
+-- @return #table
+
+---
+-- Time of one handler of one script.
+-- @type ProfilerEntry
+-- @field #string script Path of the script
+-- @field #string type "engine", "event" or "timer"
+-- @field #string handler Name of the engine handler, event or timer callback
+-- @field #number calls Number of calls
+-- @field #number time Total time in seconds
+
 return nil
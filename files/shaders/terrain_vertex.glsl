@@ -28,21 +28,47 @@ varying vec3 passNormal;
 #include "lighting.glsl"
 #include "depth.glsl"
 
+#if @compactVertices
+// xy: octahedral encoded normal, zw: height in steps above the lowest step of the chunk, low byte first
+attribute vec4 aCompactVertex;
+// x: height of the lowest step of the chunk, y: height of a step, the same for all chunks
+uniform vec2 chunkHeightQuantization;
+
+vec3 decodeNormal(vec2 encoded)
+{
+    vec2 octahedral = encoded * 2.0 - 1.0;
+    vec3 normal = vec3(octahedral, 1.0 - abs(octahedral.x) - abs(octahedral.y));
+    if (normal.z < 0.0)
+        normal.xy = (1.0 - abs(normal.yx)) * vec2(normal.x >= 0.0 ? 1.0 : -1.0, normal.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(normal);
+}
+#endif
+
 void main(void)
 {
-    gl_Position = mw_modelToClip(gl_Vertex);
+#if @compactVertices
+    // Round to whole steps, so that the shared border vertices of two chunks decode to exactly the same height
+    float step = floor(dot(aCompactVertex.zw, vec2(255.0, 255.0 * 256.0)) + 0.5);
+    vec4 vertex = vec4(gl_Vertex.xy, chunkHeightQuantization.x + step * chunkHeightQuantization.y, 1.0);
+    vec3 normal = decodeNormal(aCompactVertex.xy);
+#else
+    vec4 vertex = gl_Vertex;
+    vec3 normal = gl_Normal.xyz;
+#endif
+
+    gl_Position = mw_modelToClip(vertex);
 
-    vec4 viewPos = mw_modelToView(gl_Vertex);
+    vec4 viewPos = mw_modelToView(vertex);
     gl_ClipVertex = viewPos;
     euclideanDepth = length(viewPos.xyz);
     linearDepth = getLinearDepth(gl_Position.z, viewPos.z);
 
 #if (!PER_PIXEL_LIGHTING || @shadows_enabled)
-    vec3 viewNormal = normalize((gl_NormalMatrix * gl_Normal).xyz);
+    vec3 viewNormal = normalize((gl_NormalMatrix * normal).xyz);
 #endif
 
     passColor = gl_Color;
-    passNormal = gl_Normal.xyz;
+    passNormal = normal;
     passViewPos = viewPos.xyz;
 
 #if !PER_PIXEL_LIGHTING